@@ -116,6 +116,78 @@ float GetIntensity(vec3 color)
     return dot(color, vec3(0.333));
 }
 
+#ifdef CLUSTERED
+vec4 GetLightCluster(vec3 worldPos, float depth)
+{
+    // Find the light cluster from the screen position and the exponential depth slice
+    vec4 clipPos = cClusterViewProj * vec4(worldPos, 1.0);
+    vec2 cell = clamp(floor((clipPos.xy / clipPos.w * 0.5 + 0.5) * cClusterParams.xy), vec2(0.0), cClusterParams.xy - 1.0);
+    float slice = clamp(floor(cClusterParams.z + cClusterParams.w * log(depth)), 0.0, cClusterParams.z - 1.0);
+    float index = (slice * cClusterParams.y + cell.y) * cClusterParams.x + cell.x;
+    float tableRow = floor(index * cClusterTexInvSize.x);
+    return texture2D(sLightClusters, (vec2(index - tableRow / cClusterTexInvSize.x, tableRow) + 0.5) * cClusterTexInvSize);
+}
+
+vec3 GetClusteredLight(vec3 worldPos, float depth, vec3 normal, vec3 diffColor, vec3 specColor, float specPower)
+{
+    vec4 cluster = GetLightCluster(worldPos, depth);
+    vec3 eyeVec = cCameraPosPS - worldPos;
+    vec3 result = vec3(0.0);
+
+    // The loop limit matches the maximum lights per cluster
+    for (int i = 0; i < 128; ++i)
+    {
+        if (float(i) >= cluster.z)
+            break;
+
+        vec2 lightTexCoord = (texture2D(sLightClusters, (vec2(cluster.x + float(i), cluster.y) + 0.5) *
+            cClusterTexInvSize).xy + 0.5) * cClusterTexInvSize;
+        vec4 lightColor = texture2D(sLightClusters, lightTexCoord);
+        vec4 lightDir = texture2D(sLightClusters, lightTexCoord + vec2(cClusterTexInvSize.x, 0.0));
+        vec4 lightPos = texture2D(sLightClusters, lightTexCoord + vec2(2.0 * cClusterTexInvSize.x, 0.0));
+        float specIntensity = texture2D(sLightClusters, lightTexCoord + vec2(3.0 * cClusterTexInvSize.x, 0.0)).r;
+
+        vec3 lightVec = (lightPos.xyz - worldPos) * lightColor.w;
+        float lightDist = length(lightVec);
+        vec3 localDir = lightVec / lightDist;
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0) * clamp((dot(localDir, lightDir.xyz) - lightDir.w) *
+            lightPos.w, 0.0, 1.0);
+        float diff = max(dot(normal, localDir), 0.0) * atten;
+        float spec = GetSpecular(normal, eyeVec, localDir, specPower);
+        result += diff * lightColor.rgb * (diffColor + spec * specColor * specIntensity);
+    }
+
+    return result;
+}
+
+vec3 GetClusteredLightVolumetric(vec3 worldPos, float depth, vec3 diffColor)
+{
+    vec4 cluster = GetLightCluster(worldPos, depth);
+    vec3 result = vec3(0.0);
+
+    for (int i = 0; i < 128; ++i)
+    {
+        if (float(i) >= cluster.z)
+            break;
+
+        vec2 lightTexCoord = (texture2D(sLightClusters, (vec2(cluster.x + float(i), cluster.y) + 0.5) *
+            cClusterTexInvSize).xy + 0.5) * cClusterTexInvSize;
+        vec4 lightColor = texture2D(sLightClusters, lightTexCoord);
+        vec4 lightDir = texture2D(sLightClusters, lightTexCoord + vec2(cClusterTexInvSize.x, 0.0));
+        vec4 lightPos = texture2D(sLightClusters, lightTexCoord + vec2(2.0 * cClusterTexInvSize.x, 0.0));
+
+        // Volumetric lighting has no normal, so only the attenuation applies
+        vec3 lightVec = (lightPos.xyz - worldPos) * lightColor.w;
+        float lightDist = length(lightVec);
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0) * clamp((dot(lightVec / lightDist, lightDir.xyz) -
+            lightDir.w) * lightPos.w, 0.0, 1.0);
+        result += atten * lightColor.rgb * diffColor;
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #if defined(DIRLIGHT) && !defined(GL_ES)
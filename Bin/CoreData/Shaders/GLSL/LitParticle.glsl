@@ -115,6 +115,11 @@ void PS()
         // Ambient & per-vertex lighting
         vec3 finalColor = vVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLightVolumetric(vWorldPos.xyz, vWorldPos.w, diffColor.rgb);
+        #endif
+
         gl_FragColor = vec4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
@@ -204,6 +204,11 @@ void PS()
             finalColor += texture2D(sEmissiveMap, vTexCoord2).rgb * cAmbientColor * diffColor.rgb;
         #endif
         
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLight(vWorldPos.xyz, vWorldPos.w, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
+        
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now
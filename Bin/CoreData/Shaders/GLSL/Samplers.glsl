@@ -18,6 +18,7 @@ uniform samplerCube sLightCubeMap;
     uniform sampler2DShadow sShadowMap;
     uniform samplerCube sFaceSelectCubeMap;
     uniform samplerCube sIndirectionCubeMap;
+    uniform sampler2D sLightClusters;
 #else
     uniform sampler2D sShadowMap;
 #endif
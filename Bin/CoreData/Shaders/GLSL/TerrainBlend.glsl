@@ -167,6 +167,11 @@ void PS()
         // Ambient & per-vertex lighting
         vec3 finalColor = vVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLight(vWorldPos.xyz, vWorldPos.w, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now
@@ -15,7 +15,28 @@ attribute vec4 iCubeTexCoord2;
     attribute vec4 iInstanceMatrix3;
 #endif
 
-#ifdef SKINNED
+#if defined(SKINNED) && defined(INSTANCED)
+uniform sampler2D sSkinMatrices;
+
+// The first row of the instance matrix holds the skinning texture coordinates of the skin matrices and the texel width
+mat4 GetInstanceSkinMatrix(float index)
+{
+    float u = iInstanceMatrix1.x + index * 3.0 * iInstanceMatrix1.z;
+    float v = iInstanceMatrix1.y;
+    const vec4 lastColumn = vec4(0.0, 0.0, 0.0, 1.0);
+    return mat4(texture2DLod(sSkinMatrices, vec2(u, v), 0.0),
+        texture2DLod(sSkinMatrices, vec2(u + iInstanceMatrix1.z, v), 0.0),
+        texture2DLod(sSkinMatrices, vec2(u + 2.0 * iInstanceMatrix1.z, v), 0.0), lastColumn);
+}
+
+mat4 GetSkinMatrix(vec4 blendWeights, vec4 blendIndices)
+{
+    return GetInstanceSkinMatrix(blendIndices.x) * blendWeights.x +
+        GetInstanceSkinMatrix(blendIndices.y) * blendWeights.y +
+        GetInstanceSkinMatrix(blendIndices.z) * blendWeights.z +
+        GetInstanceSkinMatrix(blendIndices.w) * blendWeights.w;
+}
+#elif defined(SKINNED)
 mat4 GetSkinMatrix(vec4 blendWeights, vec4 blendIndices)
 {
     ivec4 idx = ivec4(blendIndices) * 3;
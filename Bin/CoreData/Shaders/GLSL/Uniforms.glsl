@@ -42,6 +42,9 @@ uniform mat4 cZone;
 
 uniform vec3 cAmbientColor;
 uniform vec3 cCameraPosPS;
+uniform vec4 cClusterParams;
+uniform vec2 cClusterTexInvSize;
+uniform mat4 cClusterViewProj;
 uniform float cDeltaTimePS;
 uniform float cElapsedTimePS;
 uniform vec4 cFogParams;
@@ -129,6 +129,77 @@ float GetIntensity(float3 color)
     return dot(color, float3(0.333, 0.333, 0.333));
 }
 
+#ifdef CLUSTERED
+float4 GetLightCluster(float3 worldPos, float depth)
+{
+    // Find the light cluster from the screen position and the exponential depth slice
+    float4 clipPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+    float2 cell = clamp(floor((clipPos.xy / clipPos.w * 0.5 + 0.5) * cClusterParams.xy), 0.0, cClusterParams.xy - 1.0);
+    float slice = clamp(floor(cClusterParams.z + cClusterParams.w * log(depth)), 0.0, cClusterParams.z - 1.0);
+    float index = (slice * cClusterParams.y + cell.y) * cClusterParams.x + cell.x;
+    float tableRow = floor(index * cClusterTexInvSize.x);
+    return Sample(sLightClusters, (float2(index - tableRow / cClusterTexInvSize.x, tableRow) + 0.5) * cClusterTexInvSize);
+}
+
+float3 GetClusteredLight(float3 worldPos, float depth, float3 normal, float3 diffColor, float3 specColor, float specPower)
+{
+    float4 cluster = GetLightCluster(worldPos, depth);
+    float3 eyeVec = cCameraPosPS - worldPos;
+    float3 result = 0.0;
+
+    // The loop limit matches the maximum lights per cluster
+    for (int i = 0; i < 128; ++i)
+    {
+        if (i >= cluster.z)
+            break;
+
+        float2 lightTexCoord = (Sample(sLightClusters, (float2(cluster.x + i, cluster.y) + 0.5) * cClusterTexInvSize).xy +
+            0.5) * cClusterTexInvSize;
+        float4 lightColor = Sample(sLightClusters, lightTexCoord);
+        float4 lightDir = Sample(sLightClusters, lightTexCoord + float2(cClusterTexInvSize.x, 0.0));
+        float4 lightPos = Sample(sLightClusters, lightTexCoord + float2(2.0 * cClusterTexInvSize.x, 0.0));
+        float specIntensity = Sample(sLightClusters, lightTexCoord + float2(3.0 * cClusterTexInvSize.x, 0.0)).r;
+
+        float3 lightVec = (lightPos.xyz - worldPos) * lightColor.w;
+        float lightDist = length(lightVec);
+        float3 localDir = lightVec / lightDist;
+        float atten = saturate(1.0 - lightDist * lightDist) * saturate((dot(localDir, lightDir.xyz) - lightDir.w) * lightPos.w);
+        float diff = saturate(dot(normal, localDir)) * atten;
+        float spec = diff > 0.0 ? GetSpecular(normal, eyeVec, localDir, specPower) : 0.0;
+        result += diff * lightColor.rgb * (diffColor + spec * specColor * specIntensity);
+    }
+
+    return result;
+}
+
+float3 GetClusteredLightVolumetric(float3 worldPos, float depth, float3 diffColor)
+{
+    float4 cluster = GetLightCluster(worldPos, depth);
+    float3 result = 0.0;
+
+    for (int i = 0; i < 128; ++i)
+    {
+        if (i >= cluster.z)
+            break;
+
+        float2 lightTexCoord = (Sample(sLightClusters, (float2(cluster.x + i, cluster.y) + 0.5) * cClusterTexInvSize).xy +
+            0.5) * cClusterTexInvSize;
+        float4 lightColor = Sample(sLightClusters, lightTexCoord);
+        float4 lightDir = Sample(sLightClusters, lightTexCoord + float2(cClusterTexInvSize.x, 0.0));
+        float4 lightPos = Sample(sLightClusters, lightTexCoord + float2(2.0 * cClusterTexInvSize.x, 0.0));
+
+        // Volumetric lighting has no normal, so only the attenuation applies
+        float3 lightVec = (lightPos.xyz - worldPos) * lightColor.w;
+        float lightDist = length(lightVec);
+        float atten = saturate(1.0 - lightDist * lightDist) * saturate((dot(lightVec / lightDist, lightDir.xyz) - lightDir.w) *
+            lightPos.w);
+        result += atten * lightColor.rgb * diffColor;
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #ifdef DIRLIGHT
@@ -146,6 +146,11 @@ void PS(float2 iTexCoord : TEXCOORD0,
         // Ambient & per-vertex lighting
         float3 finalColor = iVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLightVolumetric(iWorldPos.xyz, iWorldPos.w, diffColor.rgb);
+        #endif
+
         oColor = float4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
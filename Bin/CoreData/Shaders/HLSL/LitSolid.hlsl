@@ -267,6 +267,11 @@ void PS(
             finalColor += tex2D(sEmissiveMap, iTexCoord2).rgb * cAmbientColor * diffColor.rgb;
         #endif
 
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLight(iWorldPos.xyz, iWorldPos.w, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now
@@ -194,6 +194,11 @@ void PS(float2 iTexCoord : TEXCOORD0,
         // Ambient & per-vertex lighting
         float3 finalColor = iVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add the lights of the light cluster
+            finalColor += GetClusteredLight(iWorldPos.xyz, iWorldPos.w, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now
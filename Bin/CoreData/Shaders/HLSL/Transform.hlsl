@@ -1,5 +1,26 @@
 #ifdef COMPILEVS
-#ifdef SKINNED
+#if defined(SKINNED) && defined(INSTANCED)
+sampler2D sSkinMatrices : register(s0);
+
+// The first row of the instance matrix holds the skinning texture coordinates of the skin matrices and the texel width
+float4x3 GetInstanceSkinMatrix(float4 palette, int index)
+{
+    float u = palette.x + index * 3 * palette.z;
+    float4 row0 = tex2Dlod(sSkinMatrices, float4(u, palette.y, 0.0, 0.0));
+    float4 row1 = tex2Dlod(sSkinMatrices, float4(u + palette.z, palette.y, 0.0, 0.0));
+    float4 row2 = tex2Dlod(sSkinMatrices, float4(u + 2.0 * palette.z, palette.y, 0.0, 0.0));
+    return transpose(float3x4(row0, row1, row2));
+}
+
+float4x3 GetSkinMatrix(float4 blendWeights, int4 blendIndices, float4x3 modelInstance)
+{
+    float4 palette = transpose(modelInstance)[0];
+    return GetInstanceSkinMatrix(palette, blendIndices.x) * blendWeights.x +
+        GetInstanceSkinMatrix(palette, blendIndices.y) * blendWeights.y +
+        GetInstanceSkinMatrix(palette, blendIndices.z) * blendWeights.z +
+        GetInstanceSkinMatrix(palette, blendIndices.w) * blendWeights.w;
+}
+#elif defined(SKINNED)
 float4x3 GetSkinMatrix(float4 blendWeights, int4 blendIndices)
 {
     return cSkinMatrices[blendIndices.x] * blendWeights.x +
@@ -39,7 +60,9 @@ float3 GetBillboardNormal()
     return float3(-cBillboardRot[2][0], -cBillboardRot[2][1], -cBillboardRot[2][2]);
 }
 
-#if defined(SKINNED)
+#if defined(SKINNED) && defined(INSTANCED)
+    #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices, iModelInstance);
+#elif defined(SKINNED)
     #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices);
 #elif defined(INSTANCED)
     #define iModelMatrix iModelInstance
@@ -32,6 +32,9 @@ uniform float4x4 cLightMatrices[4];
 // Pixel shader uniforms
 uniform float3 cAmbientColor;
 uniform float3 cCameraPosPS;
+uniform float4 cClusterParams;
+uniform float2 cClusterTexInvSize;
+uniform float4x4 cClusterViewProj;
 uniform float cDeltaTimePS;
 uniform float cElapsedTimePS;
 uniform float4 cFogParams;
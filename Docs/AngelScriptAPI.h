@@ -1995,6 +1995,8 @@ String downloadName;
 /* readonly */
 float downloadProgress;
 VariantMap identity;
+/* readonly */
+float interpolationDelay;
 bool logStatistics;
 /* readonly */
 uint numDownloads;
@@ -5115,6 +5117,7 @@ class Log
 void Close();
 void Debug(const String&);
 void Error(const String&);
+void Flush();
 void Info(const String&);
 void Open(const String&);
 void SendEvent(const String&, VariantMap& = VariantMap ( ));
@@ -6302,6 +6305,8 @@ float minVelocity;
 /* readonly */
 Node node;
 /* readonly */
+uint numActiveParticles;
+/* readonly */
 uint numAttributes;
 uint numColors;
 uint numParticles;
@@ -6882,6 +6887,7 @@ void SetDefaultRenderPath(XMLFile);
 /* readonly */
 ShortStringHash baseType;
 /* readonly */
+bool cacheShadowMaps;
 String category;
 /* readonly */
 Material defaultLightRamp;
@@ -7362,6 +7368,8 @@ float elapsedTime;
 String fileName;
 /* readonly */
 uint id;
+float interpolationDelay;
+float maxExtrapolation;
 String name;
 /* readonly */
 uint numAllChildren;
@@ -7390,8 +7398,11 @@ Quaternion rotation;
 Vector3 scale;
 /* readonly */
 ScriptObject scriptObject;
+/* readonly */
+uint serverTick;
 float smoothingConstant;
 float snapThreshold;
+bool snapshotInterpolation;
 bool temporary;
 float timeScale;
 /* readonly */
@@ -8279,6 +8290,7 @@ class SmoothedTransform
 {
 // Methods:
 void ApplyAttributes();
+void ClearSnapshots();
 void DrawDebugGeometry(DebugRenderer, bool);
 Variant GetAttribute(const String&) const;
 ValueAnimation GetAttributeAnimation(const String&) const;
@@ -8324,6 +8336,8 @@ bool inProgress;
 Node node;
 /* readonly */
 uint numAttributes;
+/* readonly */
+uint numSnapshots;
 ObjectAnimation objectAnimation;
 /* readonly */
 int refs;
@@ -9308,6 +9322,7 @@ bool SetAttribute(const String&, const Variant&);
 void SetAttributeAnimation(const String&, ValueAnimation, WrapMode = WM_LOOP, float = 1.0f);
 void SetAttributeAnimationSpeed(const String&, float);
 void SetAttributeAnimationWrapMode(const String&, WrapMode);
+void SetPagedHeightMap(const String&, const IntVector2&, int);
 
 // Properties:
 bool animationEnabled;
@@ -9332,17 +9347,29 @@ uint lightMask;
 float lodBias;
 Material material;
 uint maxLights;
+uint maxPages;
 /* readonly */
 Node node;
 /* readonly */
 uint numAttributes;
 /* readonly */
+IntVector2 numPages;
+/* readonly */
 IntVector2 numPatches;
 /* readonly */
+uint numResidentPages;
+/* readonly */
 IntVector2 numVertices;
 ObjectAnimation objectAnimation;
 bool occludee;
 bool occluder;
+float pageLoadDistance;
+/* readonly */
+String pageNamePattern;
+/* readonly */
+int pageSize;
+/* readonly */
+bool paged;
 int patchSize;
 /* readonly */
 Array<TerrainPatch> patches;
@@ -43,7 +43,9 @@ if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
 endif ()
 option (URHO3D_PROFILING "Enable profiling support" TRUE)
 option (URHO3D_LOGGING "Enable logging support" TRUE)
+option (URHO3D_THREADSAFE_REFCOUNT "Use atomic reference counts, so that shared and weak pointers to the same object can be used from several threads")
 option (URHO3D_TESTING "Enable testing support")
+option (URHO3D_NULL_GRAPHICS "Use the null graphics backend, which records rendering commands and statistics without a GPU, for headless testing and benchmarking")
 if (URHO3D_TESTING)
     set (URHO3D_TEST_TIME_OUT 5 CACHE STRING "Number of seconds to test run the executables")
 else ()
@@ -125,12 +127,20 @@ if (URHO3D_LOGGING)
     add_definitions (-DURHO3D_LOGGING)
 endif ()
 
+# Atomic reference counts are opt-in, as they make copying shared and weak pointers slower also in single-threaded code.
+if (URHO3D_THREADSAFE_REFCOUNT)
+    add_definitions (-DURHO3D_THREADSAFE_REFCOUNT)
+endif ()
+
 # If not on MSVC, enable use of OpenGL instead of Direct3D9 (either not compiling on Windows or
 # with a compiler that may not have an up-to-date DirectX SDK). This can also be unconditionally
 # enabled, but Windows graphics card drivers are usually better optimized for Direct3D. Direct3D can
 # be manually enabled for MinGW with -DURHO3D_OPENGL=0, but is likely to fail due to missing headers
-# and libraries, unless the MinGW-w64 distribution is used.
-if (NOT MSVC)
+# and libraries, unless the MinGW-w64 distribution is used. The null graphics backend replaces both.
+if (URHO3D_NULL_GRAPHICS)
+    set (URHO3D_OPENGL 0)
+    add_definitions (-DURHO3D_NULL_GRAPHICS)
+elseif (NOT MSVC)
     if (NOT WIN32 OR NOT DEFINED URHO3D_OPENGL)
         set (URHO3D_OPENGL 1)
     endif ()
@@ -177,7 +187,7 @@ endif ()
 # Find DirectX SDK include & library directories for Visual Studio. It is also possible to compile
 # without if a recent Windows SDK is installed. The SDK is not searched for with MinGW as it is
 # incompatible; rather, it is assumed that MinGW itself comes with the necessary headers & libraries.
-if (MSVC)
+if (MSVC AND NOT URHO3D_NULL_GRAPHICS)
     find_package (Direct3D)
     if (DIRECT3D_FOUND)
         include_directories (${DIRECT3D_INCLUDE_DIRS})
@@ -649,7 +659,9 @@ macro (define_dependency_libs TARGET)
         endif ()
 
         # Graphics
-        if (URHO3D_OPENGL)
+        if (URHO3D_NULL_GRAPHICS)
+            # The null graphics backend does not link to any graphics API
+        elseif (URHO3D_OPENGL)
             if (WIN32)
                 list (APPEND LINK_LIBS_ONLY opengl32)
             elseif (ANDROID)
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+
+#include <cassert>
+
+namespace Urho3D
+{
+
+/// Dense array of unique object pointers with constant time removal. Objects removed while the array is being iterated are replaced with null, and the array is compacted in order when the iteration ends.
+template <class T> class DenseList
+{
+public:
+    /// Construct.
+    DenseList() :
+        iterating_(0),
+        dirty_(false)
+    {
+    }
+
+    /// Add an object. Does nothing if already added. Objects added during iteration are placed at the end.
+    void Add(T* object)
+    {
+        if (!object || indices_.Contains(object))
+            return;
+
+        indices_[object] = items_.Size();
+        items_.Push(object);
+    }
+
+    /// Remove an object. Leaves a null entry if the list is being iterated, otherwise moves the last object in its place.
+    void Remove(T* object)
+    {
+        typename HashMap<T*, unsigned>::Iterator i = indices_.Find(object);
+        if (i == indices_.End())
+            return;
+
+        unsigned index = i->second_;
+        indices_.Erase(i);
+
+        if (iterating_)
+        {
+            items_[index] = 0;
+            dirty_ = true;
+        }
+        else
+        {
+            unsigned last = items_.Size() - 1;
+            if (index != last)
+            {
+                items_[index] = items_[last];
+                indices_[items_[index]] = index;
+            }
+            items_.Pop();
+        }
+    }
+
+    /// Begin iteration. Iterations may be nested. Removals leave null entries until the outermost iteration ends.
+    void BeginIteration() { ++iterating_; }
+
+    /// End iteration. Compact the list if objects were removed.
+    void EndIteration()
+    {
+        assert(iterating_ > 0);
+        if (--iterating_ || !dirty_)
+            return;
+
+        unsigned dest = 0;
+        for (unsigned i = 0; i < items_.Size(); ++i)
+        {
+            T* object = items_[i];
+            if (!object)
+                continue;
+
+            if (dest != i)
+            {
+                items_[dest] = object;
+                indices_[object] = dest;
+            }
+            ++dest;
+        }
+        items_.Resize(dest);
+        dirty_ = false;
+    }
+
+    /// Return object at index. May be null during iteration.
+    T* operator [] (unsigned index) const { return items_[index]; }
+    /// Return number of entries, including null entries during iteration.
+    unsigned Size() const { return items_.Size(); }
+    /// Return whether the list has no entries.
+    bool Empty() const { return items_.Empty(); }
+    /// Return whether an object has been added.
+    bool Contains(T* object) const { return indices_.Contains(object); }
+    /// Return all entries.
+    const PODVector<T*>& GetItems() const { return items_; }
+
+private:
+    /// Objects. May contain null entries during iteration.
+    PODVector<T*> items_;
+    /// Object indices for constant time removal.
+    HashMap<T*, unsigned> indices_;
+    /// Iteration nesting level.
+    unsigned iterating_;
+    /// Null entries exist flag.
+    bool dirty_;
+};
+
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "FlatHashBase.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned FlatHashBase::AllocateSlots(unsigned numSlots)
+{
+    delete[] slots_;
+    slots_ = new FlatHashSlot[numSlots];
+    numSlots_ = numSlots;
+
+    shift_ = 32;
+    while (numSlots > 1)
+    {
+        numSlots >>= 1;
+        --shift_;
+    }
+
+    ResetSlots();
+
+    // Keep the load factor at most 3/4
+    return numSlots_ - (numSlots_ >> 2);
+}
+
+void FlatHashBase::ResetSlots()
+{
+    for (unsigned i = 0; i < numSlots_; ++i)
+        slots_[i].index_ = EMPTY_SLOT;
+}
+
+void FlatHashBase::InsertSlot(unsigned hash, unsigned index)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned pos = HomeSlot(hash);
+    unsigned distance = 0;
+
+    for (;;)
+    {
+        FlatHashSlot& slot = slots_[pos];
+        if (slot.index_ == EMPTY_SLOT)
+        {
+            slot.hash_ = hash;
+            slot.index_ = index;
+            return;
+        }
+
+        // Take the slot from an element that is closer to its preferred slot, and continue by inserting that element instead.
+        // This keeps the probe sequences short and lets lookups stop early
+        unsigned slotDistance = ProbeDistance(pos, slot.hash_);
+        if (slotDistance < distance)
+        {
+            Urho3D::Swap(slot.hash_, hash);
+            Urho3D::Swap(slot.index_, index);
+            distance = slotDistance;
+        }
+
+        pos = (pos + 1) & mask;
+        ++distance;
+    }
+}
+
+void FlatHashBase::EraseSlot(unsigned pos)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned next = (pos + 1) & mask;
+
+    while (slots_[next].index_ != EMPTY_SLOT && ProbeDistance(next, slots_[next].hash_))
+    {
+        slots_[pos] = slots_[next];
+        pos = next;
+        next = (next + 1) & mask;
+    }
+
+    slots_[pos].index_ = EMPTY_SLOT;
+}
+
+unsigned FlatHashBase::FindSlotByIndex(unsigned hash, unsigned index) const
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned pos = HomeSlot(hash);
+
+    while (slots_[pos].index_ != index)
+        pos = (pos + 1) & mask;
+
+    return pos;
+}
+
+unsigned FlatHashBase::SlotsForSize(unsigned size)
+{
+    unsigned numSlots = MIN_SLOTS;
+    while (numSlots - (numSlots >> 2) < size)
+        numSlots <<= 1;
+
+    return numSlots;
+}
+
+}
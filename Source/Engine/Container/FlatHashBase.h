@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Urho3D.h"
+#include "Hash.h"
+#include "Swap.h"
+
+namespace Urho3D
+{
+
+/// Flat hash set/map index slot.
+struct FlatHashSlot
+{
+    /// Hash value of the element.
+    unsigned hash_;
+    /// Index of the element in the element storage, or FlatHashBase::EMPTY_SLOT if the slot is free.
+    unsigned index_;
+};
+
+/// Flat hash set/map base class. Keeps an open-addressing index of the elements, which are stored contiguously in insertion order by the subclass. Collisions are resolved by linear probing with Robin Hood insertion and backward shift deletion.
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Initial amount of index slots.
+    static const unsigned MIN_SLOTS = 8;
+    /// Element index of a free slot.
+    static const unsigned EMPTY_SLOT = 0xffffffff;
+
+    /// Construct.
+    FlatHashBase() :
+        slots_(0),
+        buffer_(0),
+        size_(0),
+        capacity_(0),
+        numSlots_(0),
+        shift_(32)
+    {
+    }
+
+    /// Destruct.
+    ~FlatHashBase()
+    {
+        delete[] slots_;
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(buffer_, rhs.buffer_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(numSlots_, rhs.numSlots_);
+        Urho3D::Swap(shift_, rhs.shift_);
+    }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+    /// Return number of index slots.
+    unsigned NumBuckets() const { return numSlots_; }
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Allocate a power of two amount of index slots and set them free. Return the maximum number of elements that fit.
+    unsigned AllocateSlots(unsigned numSlots);
+    /// Set all index slots free.
+    void ResetSlots();
+    /// Insert an element index. The element must not already be in the index.
+    void InsertSlot(unsigned hash, unsigned index);
+    /// Remove an index slot and shift the following slots back.
+    void EraseSlot(unsigned pos);
+    /// Return the slot of an element index. The element must be in the index.
+    unsigned FindSlotByIndex(unsigned hash, unsigned index) const;
+    /// Return the preferred slot of a hash value.
+    unsigned HomeSlot(unsigned hash) const { return (hash * 2654435769u) >> shift_; }
+    /// Return how far a slot is from the preferred slot of its hash value.
+    unsigned ProbeDistance(unsigned pos, unsigned hash) const { return (pos - HomeSlot(hash)) & (numSlots_ - 1); }
+    /// Return the slot count needed for an element count.
+    static unsigned SlotsForSize(unsigned size);
+
+    /// Index slots.
+    FlatHashSlot* slots_;
+    /// Element storage.
+    unsigned char* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Element storage capacity.
+    unsigned capacity_;
+    /// Number of index slots.
+    unsigned numSlots_;
+    /// Shift for computing the preferred slot from a hash value.
+    unsigned shift_;
+};
+
+}
@@ -0,0 +1,391 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "FlatHashBase.h"
+#include "Pair.h"
+#include "Sort.h"
+#include "Vector.h"
+
+#include <cassert>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Hash map template class with flat storage. The pairs are stored contiguously and found through an open-addressing index, which avoids a memory allocation per pair and makes lookups and iteration cache-friendly. Unlike HashMap, inserting may move the pairs in memory and invalidates iterators and pointers to them, and erasing moves the last pair into the erased position. Best suited for small keys and values that are cheap to copy.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator == (const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator != (const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+    };
+
+    typedef RandomAccessIterator<KeyValue> Iterator;
+    typedef RandomAccessConstIterator<KeyValue> ConstIterator;
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        *this = map;
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        delete[] buffer_;
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator = (const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator += (const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator += (const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator == (const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator != (const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [] (const T& key)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned pos = FindSlot(key, hash);
+        unsigned index = pos != EMPTY_SLOT ? slots_[pos].index_ : InsertElement(key, U(), hash);
+        return Buffer()[index].second_;
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        unsigned index = InsertElement(pair.first_, pair.second_);
+        return Iterator(Buffer() + index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        if (!size_)
+            Reserve(map.Size());
+
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            InsertElement(i->first_, i->second_);
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it)
+    {
+        unsigned index = InsertElement(it->first_, it->second_);
+        return Iterator(Buffer() + index);
+    }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator i = start; i != end; ++i)
+            InsertElement(i->first_, i->second_);
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindSlot(key, MakeHash(key));
+        if (pos == EMPTY_SLOT)
+            return false;
+
+        EraseElement(pos);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair, which is the last pair moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Buffer());
+        if (index >= size_)
+            return End();
+
+        EraseElement(FindSlotByIndex(MakeHash(it->first_), index));
+        return Iterator(Buffer() + index);
+    }
+
+    /// Clear the map. Keeps the allocated storage.
+    void Clear()
+    {
+        KeyValue* elements = Buffer();
+        for (unsigned i = 0; i < size_; ++i)
+            (elements + i)->~KeyValue();
+        size_ = 0;
+
+        ResetSlots();
+    }
+
+    /// Sort pairs. After sorting the map can be iterated in order until new elements are inserted or erased.
+    void Sort()
+    {
+        if (size_ < 2)
+            return;
+
+        KeyValue** ptrs = new KeyValue*[size_];
+        for (unsigned i = 0; i < size_; ++i)
+            ptrs[i] = Buffer() + i;
+
+        Urho3D::Sort(RandomAccessIterator<KeyValue*>(ptrs), RandomAccessIterator<KeyValue*>(ptrs + size_), CompareElements);
+
+        unsigned char* newBuffer = new unsigned char[capacity_ * sizeof(KeyValue)];
+        KeyValue* newElements = reinterpret_cast<KeyValue*>(newBuffer);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(newElements + i) KeyValue(*ptrs[i]);
+            ptrs[i]->~KeyValue();
+        }
+
+        delete[] ptrs;
+        delete[] buffer_;
+        buffer_ = newBuffer;
+
+        ResetSlots();
+        for (unsigned i = 0; i < size_; ++i)
+            InsertSlot(MakeHash(newElements[i].first_), i);
+    }
+
+    /// Rehash to a specific index slot count, which must be a power of two and leave room for the current pairs. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets == numSlots_)
+            return true;
+        if (numBuckets < MIN_SLOTS || numBuckets - (numBuckets >> 2) < size_ || (numBuckets & (numBuckets - 1)))
+            return false;
+
+        Reallocate(numBuckets);
+        return true;
+    }
+
+    /// Allocate storage for at least the specified amount of pairs.
+    void Reserve(unsigned size)
+    {
+        if (size > capacity_)
+            Reallocate(SlotsForSize(size));
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned pos = FindSlot(key, MakeHash(key));
+        return pos != EMPTY_SLOT ? Iterator(Buffer() + slots_[pos].index_) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned pos = FindSlot(key, MakeHash(key));
+        return pos != EMPTY_SLOT ? ConstIterator(Buffer() + slots_[pos].index_) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindSlot(key, MakeHash(key)) != EMPTY_SLOT; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(size_);
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(Buffer()); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Buffer()); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(Buffer() + size_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Buffer() + size_); }
+    /// Return first pair.
+    const KeyValue& Front() const { return *Begin(); }
+    /// Return last pair.
+    const KeyValue& Back() const { return *(--End()); }
+
+private:
+    /// Return the pair storage.
+    KeyValue* Buffer() const { return reinterpret_cast<KeyValue*>(buffer_); }
+
+    /// Find the index slot of a key. Return EMPTY_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return EMPTY_SLOT;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned pos = HomeSlot(hash);
+        KeyValue* elements = Buffer();
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[pos];
+            // The key can not be further than an element that is closer to its preferred slot
+            if (slot.index_ == EMPTY_SLOT || ProbeDistance(pos, slot.hash_) < distance)
+                return EMPTY_SLOT;
+            if (slot.hash_ == hash && elements[slot.index_].first_ == key)
+                return pos;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    /// Insert a key and value, or change the value if the key exists. Return the pair index.
+    unsigned InsertElement(const T& key, const U& value)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned pos = FindSlot(key, hash);
+        if (pos != EMPTY_SLOT)
+        {
+            unsigned index = slots_[pos].index_;
+            Buffer()[index].second_ = value;
+            return index;
+        }
+        else
+            return InsertElement(key, value, hash);
+    }
+
+    /// Insert a key and value that is not in the map yet. Return the pair index.
+    unsigned InsertElement(const T& key, const U& value, unsigned hash)
+    {
+        if (size_ == capacity_)
+            Reallocate(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+
+        new(Buffer() + size_) KeyValue(key, value);
+        InsertSlot(hash, size_);
+        return size_++;
+    }
+
+    /// Erase the pair of an index slot. The last pair is moved into its position.
+    void EraseElement(unsigned pos)
+    {
+        KeyValue* elements = Buffer();
+        unsigned index = slots_[pos].index_;
+        unsigned last = size_ - 1;
+
+        EraseSlot(pos);
+
+        if (index != last)
+        {
+            slots_[FindSlotByIndex(MakeHash(elements[last].first_), last)].index_ = index;
+            (elements + index)->~KeyValue();
+            new(elements + index) KeyValue(elements[last]);
+        }
+
+        (elements + last)->~KeyValue();
+        --size_;
+    }
+
+    /// Reallocate the index and the pair storage.
+    void Reallocate(unsigned numSlots)
+    {
+        unsigned newCapacity = AllocateSlots(numSlots);
+
+        unsigned char* newBuffer = new unsigned char[newCapacity * sizeof(KeyValue)];
+        KeyValue* elements = Buffer();
+        KeyValue* newElements = reinterpret_cast<KeyValue*>(newBuffer);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(newElements + i) KeyValue(elements[i]);
+            (elements + i)->~KeyValue();
+            InsertSlot(MakeHash(newElements[i].first_), i);
+        }
+
+        delete[] buffer_;
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+
+    /// Compare two pairs.
+    static bool CompareElements(KeyValue*& lhs, KeyValue*& rhs) { return lhs->first_ < rhs->first_; }
+};
+
+}
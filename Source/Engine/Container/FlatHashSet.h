@@ -0,0 +1,284 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "FlatHashBase.h"
+#include "Sort.h"
+#include "Vector.h"
+
+#include <cassert>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Hash set template class with flat storage. The keys are stored contiguously and found through an open-addressing index. Unlike HashSet, inserting may move the keys in memory and invalidates iterators and pointers to them, and erasing moves the last key into the erased position.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    typedef RandomAccessConstIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        *this = set;
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        Clear();
+        delete[] buffer_;
+    }
+
+    /// Assign a hash set.
+    FlatHashSet& operator = (const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator += (const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator += (const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator == (const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator != (const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned pos = FindSlot(key, hash);
+        if (pos != EMPTY_SLOT)
+            return Iterator(Buffer() + slots_[pos].index_);
+
+        if (size_ == capacity_)
+            Reallocate(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+
+        new(Buffer() + size_) T(key);
+        InsertSlot(hash, size_);
+        return Iterator(Buffer() + size_++);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        if (!size_)
+            Reserve(set.Size());
+
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindSlot(key, MakeHash(key));
+        if (pos == EMPTY_SLOT)
+            return false;
+
+        EraseElement(pos);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key, which is the last key moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Buffer());
+        if (index >= size_)
+            return End();
+
+        EraseElement(FindSlotByIndex(MakeHash(*it), index));
+        return Iterator(Buffer() + index);
+    }
+
+    /// Clear the set. Keeps the allocated storage.
+    void Clear()
+    {
+        T* elements = Buffer();
+        for (unsigned i = 0; i < size_; ++i)
+            (elements + i)->~T();
+        size_ = 0;
+
+        ResetSlots();
+    }
+
+    /// Sort keys. After sorting the set can be iterated in order until new elements are inserted or erased.
+    void Sort()
+    {
+        if (size_ < 2)
+            return;
+
+        T* elements = Buffer();
+        Urho3D::Sort(RandomAccessIterator<T>(elements), RandomAccessIterator<T>(elements + size_));
+
+        ResetSlots();
+        for (unsigned i = 0; i < size_; ++i)
+            InsertSlot(MakeHash(elements[i]), i);
+    }
+
+    /// Rehash to a specific index slot count, which must be a power of two and leave room for the current keys. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets == numSlots_)
+            return true;
+        if (numBuckets < MIN_SLOTS || numBuckets - (numBuckets >> 2) < size_ || (numBuckets & (numBuckets - 1)))
+            return false;
+
+        Reallocate(numBuckets);
+        return true;
+    }
+
+    /// Allocate storage for at least the specified amount of keys.
+    void Reserve(unsigned size)
+    {
+        if (size > capacity_)
+            Reallocate(SlotsForSize(size));
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned pos = FindSlot(key, MakeHash(key));
+        return pos != EMPTY_SLOT ? ConstIterator(Buffer() + slots_[pos].index_) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindSlot(key, MakeHash(key)) != EMPTY_SLOT; }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Buffer()); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Buffer() + size_); }
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+    /// Return last key.
+    const T& Back() const { return *(--End()); }
+
+private:
+    /// Return the key storage.
+    T* Buffer() const { return reinterpret_cast<T*>(buffer_); }
+
+    /// Find the index slot of a key. Return EMPTY_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return EMPTY_SLOT;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned pos = HomeSlot(hash);
+        T* elements = Buffer();
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[pos];
+            // The key can not be further than an element that is closer to its preferred slot
+            if (slot.index_ == EMPTY_SLOT || ProbeDistance(pos, slot.hash_) < distance)
+                return EMPTY_SLOT;
+            if (slot.hash_ == hash && elements[slot.index_] == key)
+                return pos;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    /// Erase the key of an index slot. The last key is moved into its position.
+    void EraseElement(unsigned pos)
+    {
+        T* elements = Buffer();
+        unsigned index = slots_[pos].index_;
+        unsigned last = size_ - 1;
+
+        EraseSlot(pos);
+
+        if (index != last)
+        {
+            slots_[FindSlotByIndex(MakeHash(elements[last]), last)].index_ = index;
+            elements[index] = elements[last];
+        }
+
+        (elements + last)->~T();
+        --size_;
+    }
+
+    /// Reallocate the index and the key storage.
+    void Reallocate(unsigned numSlots)
+    {
+        unsigned newCapacity = AllocateSlots(numSlots);
+
+        unsigned char* newBuffer = new unsigned char[newCapacity * sizeof(T)];
+        T* elements = Buffer();
+        T* newElements = reinterpret_cast<T*>(newBuffer);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(newElements + i) T(elements[i]);
+            (elements + i)->~T();
+            InsertSlot(MakeHash(newElements[i]), i);
+        }
+
+        delete[] buffer_;
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+};
+
+}
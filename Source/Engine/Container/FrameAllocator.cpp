@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "FrameAllocator.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Size of the block header, rounded up so that the data area can be aligned.
+static const unsigned BLOCK_HEADER_SIZE = (sizeof(FrameAllocatorBlock) + FrameAllocator::ALIGNMENT - 1) & ~(FrameAllocator::ALIGNMENT - 1);
+
+FrameAllocator::FrameAllocator(unsigned initialSize) :
+    first_(0),
+    current_(0),
+    position_(0),
+    lastPosition_(0),
+    usedSize_(0),
+    peakUsedSize_(0),
+    capacity_(0),
+    initialSize_(AlignSize(initialSize))
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    FreeBlocks();
+}
+
+void* FrameAllocator::Allocate(unsigned size)
+{
+    size = AlignSize(size);
+    if (!current_ || position_ + size > current_->size_)
+        AddBlock(size);
+    
+    unsigned char* ptr = GetBlockData(current_) + position_;
+    lastPosition_ = position_;
+    position_ += size;
+    usedSize_ += size;
+    if (usedSize_ > peakUsedSize_)
+        peakUsedSize_ = usedSize_;
+    
+    return ptr;
+}
+
+void* FrameAllocator::Reallocate(void* ptr, unsigned oldSize, unsigned newSize)
+{
+    if (!ptr)
+        return Allocate(newSize);
+    
+    // If this is the latest allocation, try to resize it in place
+    if (ptr == GetBlockData(current_) + lastPosition_)
+    {
+        unsigned alignedSize = AlignSize(newSize);
+        if (lastPosition_ + alignedSize <= current_->size_)
+        {
+            usedSize_ = usedSize_ - (position_ - lastPosition_) + alignedSize;
+            if (usedSize_ > peakUsedSize_)
+                peakUsedSize_ = usedSize_;
+            position_ = lastPosition_ + alignedSize;
+            return ptr;
+        }
+    }
+    
+    void* newPtr = Allocate(newSize);
+    memcpy(newPtr, ptr, oldSize < newSize ? oldSize : newSize);
+    return newPtr;
+}
+
+void FrameAllocator::Reset()
+{
+    // If the memory did not fit in one block, replace the blocks with a single block that fits everything
+    if (first_ && first_->next_)
+    {
+        unsigned totalSize = capacity_;
+        FreeBlocks();
+        AddBlock(totalSize);
+    }
+    
+    current_ = first_;
+    position_ = 0;
+    lastPosition_ = 0;
+    usedSize_ = 0;
+}
+
+unsigned FrameAllocator::GetNumBlocks() const
+{
+    unsigned numBlocks = 0;
+    for (FrameAllocatorBlock* block = first_; block; block = block->next_)
+        ++numBlocks;
+    return numBlocks;
+}
+
+void FrameAllocator::AddBlock(unsigned size)
+{
+    // Grow the total capacity at least by half each time
+    unsigned blockSize = first_ ? capacity_ / 2 : initialSize_;
+    if (blockSize < size)
+        blockSize = size;
+    
+    // Over-allocate so that the data area can be aligned regardless of the heap alignment
+    unsigned char* memory = new unsigned char[BLOCK_HEADER_SIZE + blockSize + ALIGNMENT];
+    FrameAllocatorBlock* block = reinterpret_cast<FrameAllocatorBlock*>(memory);
+    block->size_ = blockSize;
+    block->next_ = 0;
+    
+    if (current_)
+        current_->next_ = block;
+    else
+        first_ = block;
+    current_ = block;
+    position_ = 0;
+    lastPosition_ = 0;
+    capacity_ += blockSize;
+}
+
+void FrameAllocator::FreeBlocks()
+{
+    FrameAllocatorBlock* block = first_;
+    while (block)
+    {
+        FrameAllocatorBlock* next = block->next_;
+        delete[] reinterpret_cast<unsigned char*>(block);
+        block = next;
+    }
+    
+    first_ = 0;
+    current_ = 0;
+    capacity_ = 0;
+}
+
+unsigned char* FrameAllocator::GetBlockData(FrameAllocatorBlock* block)
+{
+    size_t address = reinterpret_cast<size_t>(block) + BLOCK_HEADER_SIZE;
+    return reinterpret_cast<unsigned char*>((address + ALIGNMENT - 1) & ~((size_t)ALIGNMENT - 1));
+}
+
+}
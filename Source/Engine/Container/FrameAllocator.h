@@ -0,0 +1,282 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "VectorBase.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// %Frame allocator memory block.
+struct FrameAllocatorBlock
+{
+    /// Size of the data area.
+    unsigned size_;
+    /// Next block.
+    FrameAllocatorBlock* next_;
+    /// Data follows.
+};
+
+/// Linear allocator for transient data that is discarded all at once, for example at the end of the frame. An allocation only advances a position in the current memory block. Allocations can not be freed individually, instead Reset() releases all of them and keeps the memory for reuse. Not thread-safe, so each thread should use its own allocator.
+class URHO3D_API FrameAllocator
+{
+public:
+    /// Construct with the initial block size. No memory is allocated until first needed.
+    FrameAllocator(unsigned initialSize = DEFAULT_BLOCK_SIZE);
+    /// Destruct. Free all memory blocks.
+    ~FrameAllocator();
+    
+    /// Allocate memory aligned to ALIGNMENT bytes.
+    void* Allocate(unsigned size);
+    /// Resize an allocation. Grows or shrinks in place if it is the latest allocation and fits, otherwise allocates new memory and copies the data.
+    void* Reallocate(void* ptr, unsigned oldSize, unsigned newSize);
+    /// Release all allocations. If more than one memory block was needed, replace them with a single block large enough for all.
+    void Reset();
+    
+    /// Return bytes allocated since the last reset.
+    unsigned GetUsedSize() const { return usedSize_; }
+    /// Return the highest number of bytes allocated between resets.
+    unsigned GetPeakUsedSize() const { return peakUsedSize_; }
+    /// Return the total size of the memory blocks.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return the number of memory blocks.
+    unsigned GetNumBlocks() const;
+    
+    /// Default initial block size.
+    static const unsigned DEFAULT_BLOCK_SIZE = 16384;
+    /// Alignment of allocations.
+    static const unsigned ALIGNMENT = 16;
+    
+private:
+    /// Prevent copy construction.
+    FrameAllocator(const FrameAllocator& rhs);
+    /// Prevent assignment.
+    FrameAllocator& operator = (const FrameAllocator& rhs);
+    
+    /// Add a memory block with at least the specified data size and make it current.
+    void AddBlock(unsigned size);
+    /// Free all memory blocks.
+    void FreeBlocks();
+    /// Return the aligned data area of a block.
+    static unsigned char* GetBlockData(FrameAllocatorBlock* block);
+    /// Round a size up to the alignment.
+    static unsigned AlignSize(unsigned size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+    
+    /// First memory block.
+    FrameAllocatorBlock* first_;
+    /// Current memory block.
+    FrameAllocatorBlock* current_;
+    /// Allocation position in the current block.
+    unsigned position_;
+    /// Position of the latest allocation in the current block.
+    unsigned lastPosition_;
+    /// Bytes allocated since the last reset.
+    unsigned usedSize_;
+    /// Highest number of bytes allocated between resets.
+    unsigned peakUsedSize_;
+    /// Total size of the memory blocks.
+    unsigned capacity_;
+    /// Size for the first memory block.
+    unsigned initialSize_;
+};
+
+/// %Vector template class for POD types that allocates from a frame allocator. The contents are valid only until the allocator is reset, after which the vector may only be cleared, destroyed or assigned to. Without an allocator, the heap is used like in PODVector.
+template <class T> class FramePODVector
+{
+public:
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+    
+    /// Construct empty.
+    FramePODVector(FrameAllocator* allocator = 0) :
+        allocator_(allocator),
+        buffer_(0),
+        size_(0),
+        capacity_(0)
+    {
+    }
+    
+    /// Construct from another vector. Allocates from the same allocator.
+    FramePODVector(const FramePODVector<T>& vector) :
+        allocator_(vector.allocator_),
+        buffer_(0),
+        size_(0),
+        capacity_(0)
+    {
+        *this = vector;
+    }
+    
+    /// Destruct.
+    ~FramePODVector()
+    {
+        if (!allocator_)
+            delete[] reinterpret_cast<unsigned char*>(buffer_);
+    }
+    
+    /// Assign from another vector.
+    FramePODVector<T>& operator = (const FramePODVector<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Push(rhs);
+        }
+        return *this;
+    }
+    
+    /// Return element at index.
+    T& operator [] (unsigned index) { return buffer_[index]; }
+    /// Return const element at index.
+    const T& operator [] (unsigned index) const { return buffer_[index]; }
+    
+    /// Set the allocator. Empties the vector.
+    void SetAllocator(FrameAllocator* allocator)
+    {
+        if (!allocator_)
+            delete[] reinterpret_cast<unsigned char*>(buffer_);
+        allocator_ = allocator;
+        buffer_ = 0;
+        size_ = 0;
+        capacity_ = 0;
+    }
+    
+    /// Move the contents to memory allocated from another allocator, or from the heap if null.
+    void MoveToAllocator(FrameAllocator* allocator)
+    {
+        if (allocator == allocator_)
+            return;
+        
+        T* newBuffer = 0;
+        if (size_)
+        {
+            if (allocator)
+                newBuffer = reinterpret_cast<T*>(allocator->Allocate(size_ * sizeof(T)));
+            else
+                newBuffer = reinterpret_cast<T*>(new unsigned char[size_ * sizeof(T)]);
+            memcpy(newBuffer, buffer_, size_ * sizeof(T));
+        }
+        if (!allocator_)
+            delete[] reinterpret_cast<unsigned char*>(buffer_);
+        allocator_ = allocator;
+        buffer_ = newBuffer;
+        capacity_ = size_;
+    }
+    
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ >= capacity_)
+            Reserve(capacity_ ? capacity_ + (capacity_ + 1) / 2 : 4);
+        buffer_[size_++] = value;
+    }
+    
+    /// Add another vector at the end.
+    void Push(const FramePODVector<T>& vector)
+    {
+        unsigned newSize = size_ + vector.size_;
+        if (newSize > capacity_)
+            Reserve(newSize);
+        if (vector.size_)
+            memcpy(buffer_ + size_, vector.buffer_, vector.size_ * sizeof(T));
+        size_ = newSize;
+    }
+    
+    /// Resize the vector. New elements are left uninitialized.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_)
+            Reserve(newSize);
+        size_ = newSize;
+    }
+    
+    /// Set new capacity.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity <= capacity_)
+            return;
+        
+        if (allocator_)
+            buffer_ = reinterpret_cast<T*>(allocator_->Reallocate(buffer_, capacity_ * sizeof(T), newCapacity * sizeof(T)));
+        else
+        {
+            T* newBuffer = reinterpret_cast<T*>(new unsigned char[newCapacity * sizeof(T)]);
+            if (size_)
+                memcpy(newBuffer, buffer_, size_ * sizeof(T));
+            delete[] reinterpret_cast<unsigned char*>(buffer_);
+            buffer_ = newBuffer;
+        }
+        capacity_ = newCapacity;
+    }
+    
+    /// Clear the vector. Keeps the capacity only when allocating from the heap, as the frame allocator may have been reset.
+    void Clear()
+    {
+        size_ = 0;
+        if (allocator_)
+        {
+            buffer_ = 0;
+            capacity_ = 0;
+        }
+    }
+    
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+    /// Return first element.
+    T& Front() { return buffer_[0]; }
+    /// Return const first element.
+    const T& Front() const { return buffer_[0]; }
+    /// Return last element.
+    T& Back() { return buffer_[size_ - 1]; }
+    /// Return const last element.
+    const T& Back() const { return buffer_[size_ - 1]; }
+    /// Return size of vector.
+    unsigned Size() const { return size_; }
+    /// Return capacity of vector.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+    /// Return the buffer.
+    T* Buffer() const { return buffer_; }
+    /// Return the allocator.
+    FrameAllocator* GetAllocator() const { return allocator_; }
+    
+private:
+    /// Frame allocator, or null to use the heap.
+    FrameAllocator* allocator_;
+    /// Element buffer.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Capacity in elements.
+    unsigned capacity_;
+};
+
+}
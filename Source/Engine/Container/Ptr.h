@@ -110,9 +110,9 @@ public:
         if (ptr_)
         {
             RefCount* refCount = RefCountPtr();
-            ++refCount->refs_; // 2 refs
+            IncrementRefCount(refCount->refs_); // 2 refs
             Reset(); // 1 ref
-            --refCount->refs_; // 0 refs
+            DecrementRefCount(refCount->refs_); // 0 refs
         }
     }
     
@@ -276,10 +276,20 @@ public:
     /// Convert to a shared pointer. If expired, return a null shared pointer.
     SharedPtr<T> Lock() const
     {
+        #ifdef URHO3D_THREADSAFE_REFCOUNT
+        // Another thread may be releasing the last reference, so take a temporary reference only while references remain
+        if (!refCount_ || !TryIncrementRefCount(refCount_->refs_))
+            return SharedPtr<T>();
+        SharedPtr<T> ret(ptr_);
+        // The returned pointer holds a reference, so the temporary reference can be released without checking for zero
+        DecrementRefCount(refCount_->refs_);
+        return ret;
+        #else
         if (Expired())
             return SharedPtr<T>();
         else
             return SharedPtr<T>(ptr_);
+        #endif
     }
     
     /// Return raw pointer. If expired, return null.
@@ -384,7 +394,7 @@ private:
         if (refCount_)
         {
             assert(refCount_->weakRefs_ >= 0);
-            ++(refCount_->weakRefs_);
+            IncrementRefCount(refCount_->weakRefs_);
         }
     }
     
@@ -394,9 +404,8 @@ private:
         if (refCount_)
         {
             assert(refCount_->weakRefs_ > 0);
-            --(refCount_->weakRefs_);
-            
-            if (Expired() && !refCount_->weakRefs_)
+            // The object holds a weak reference to itself while alive, so the count reaches zero only after it has expired
+            if (!DecrementRefCount(refCount_->weakRefs_) && Expired())
                 delete refCount_;
         }
         
@@ -45,8 +45,7 @@ RefCounted::~RefCounted()
     
     // Mark object as expired, release the self weak ref and delete the refcount if no other weak refs exist
     refCount_->refs_ = -1;
-    (refCount_->weakRefs_)--;
-    if (!refCount_->weakRefs_)
+    if (!DecrementRefCount(refCount_->weakRefs_))
         delete refCount_;
     
     refCount_ = 0;
@@ -55,14 +54,13 @@ RefCounted::~RefCounted()
 void RefCounted::AddRef()
 {
     assert(refCount_->refs_ >= 0);
-    (refCount_->refs_)++;
+    IncrementRefCount(refCount_->refs_);
 }
 
 void RefCounted::ReleaseRef()
 {
     assert(refCount_->refs_ > 0);
-    (refCount_->refs_)--;
-    if (!refCount_->refs_)
+    if (!DecrementRefCount(refCount_->refs_))
         delete this;
 }
 
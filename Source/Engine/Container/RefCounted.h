@@ -24,6 +24,10 @@
 
 #include "Urho3D.h"
 
+#ifdef URHO3D_THREADSAFE_REFCOUNT
+#include "Atomic.h"
+#endif
+
 namespace Urho3D
 {
 
@@ -51,6 +55,44 @@ struct RefCount
     int weakRefs_;
 };
 
+/// Increment a reference count and return the new value. Atomic if URHO3D_THREADSAFE_REFCOUNT is defined.
+inline int IncrementRefCount(int& count)
+{
+    #ifdef URHO3D_THREADSAFE_REFCOUNT
+    // A new reference is always taken through an existing one, so the increment needs no ordering
+    return AtomicAddRelaxed(&count, 1);
+    #else
+    return ++count;
+    #endif
+}
+
+/// Decrement a reference count and return the new value. Atomic if URHO3D_THREADSAFE_REFCOUNT is defined.
+inline int DecrementRefCount(int& count)
+{
+    #ifdef URHO3D_THREADSAFE_REFCOUNT
+    // Order the accesses through the released reference before the decrement, so that the thread which releases the last reference sees them before deleting
+    return AtomicAddAcquireRelease(&count, -1);
+    #else
+    return --count;
+    #endif
+}
+
+#ifdef URHO3D_THREADSAFE_REFCOUNT
+/// Increment a reference count only if it is above zero. Return true if incremented.
+inline bool TryIncrementRefCount(int& count)
+{
+    for (;;)
+    {
+        // The compare-exchange is a full barrier, so a plain read is enough for the expected value
+        int oldCount = *(volatile int*)&count;
+        if (oldCount <= 0)
+            return false;
+        if (AtomicCompareExchange(&count, oldCount + 1, oldCount) == oldCount)
+            return true;
+    }
+}
+#endif
+
 /// Base class for intrusively reference-counted objects. These are noncopyable and non-assignable.
 class URHO3D_API RefCounted
 {
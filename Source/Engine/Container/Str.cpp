@@ -31,123 +31,121 @@
 namespace Urho3D
 {
 
-char String::endZero = 0;
-
 const String String::EMPTY;
 
 String::String(const WString& str) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     SetUTF8FromWChar(str.CString());
 }
 
 String::String(int value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
     *this = tempBuffer;
 }
 
 String::String(short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
     *this = tempBuffer;
 }
 
 String::String(long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%ld", value);
     *this = tempBuffer;
 }
     
 String::String(long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lld", value);
     *this = tempBuffer;
 }
 
 String::String(unsigned value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
     *this = tempBuffer;
 }
 
 String::String(unsigned short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
     *this = tempBuffer;
 }
 
 String::String(unsigned long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lu", value);
     *this = tempBuffer;
 }
     
 String::String(unsigned long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%llu", value);
     *this = tempBuffer;
 }
 
 String::String(float value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
     *this = tempBuffer;
 }
 
 String::String(double value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
     *this = tempBuffer;
 }
 
 String::String(bool value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     if (value)
         *this = "true";
     else
@@ -155,19 +153,19 @@ String::String(bool value) :
 }
 
 String::String(char value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     Resize(1);
     buffer_[0] = value;
 }
 
 String::String(char value, unsigned length) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(localBuffer_),
+    length_(0)
 {
+    localBuffer_[0] = 0;
     Resize(length);
     for (unsigned i = 0; i < length; ++i)
         buffer_[i] = value;
@@ -393,35 +391,22 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    unsigned capacity = Capacity();
+    if (capacity < newLength + 1)
     {
-        // If zero length requested, do not allocate buffer yet
-        if (!newLength)
-            return;
-        
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
+        // Increase the capacity with half each time it is exceeded. Short strings stay in the inline buffer
+        while (capacity < newLength + 1)
+            capacity += (capacity + 1) >> 1;
         
-        buffer_ = new char[capacity_];
-    }
-    else
-    {
-        if (newLength && capacity_ < newLength + 1)
-        {
-            // Increase the capacity with half each time it is exceeded
-            while (capacity_ < newLength + 1)
-                capacity_ += (capacity_ + 1) >> 1;
-            
-            char* newBuffer = new char[capacity_];
-            // Move the existing data to the new buffer, then delete the old buffer
-            if (length_)
-                CopyChars(newBuffer, buffer_, length_);
+        char* newBuffer = new char[capacity];
+        // Move the existing data to the new buffer, then delete the old buffer
+        if (length_)
+            CopyChars(newBuffer, buffer_, length_);
+        if (buffer_ != localBuffer_)
             delete[] buffer_;
-            
-            buffer_ = newBuffer;
-        }
+        
+        buffer_ = newBuffer;
+        capacity_ = capacity;
     }
     
     buffer_[newLength] = 0;
@@ -432,13 +417,27 @@ void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    
+    if (newCapacity <= LOCAL_CAPACITY)
+    {
+        // Fits in the inline buffer: move back from the dynamic buffer if necessary
+        if (buffer_ != localBuffer_)
+        {
+            char* oldBuffer = buffer_;
+            CopyChars(localBuffer_, oldBuffer, length_ + 1);
+            delete[] oldBuffer;
+            buffer_ = localBuffer_;
+        }
+        return;
+    }
+    
+    if (newCapacity == Capacity())
         return;
     
     char* newBuffer = new char[newCapacity];
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    if (buffer_ != localBuffer_)
         delete[] buffer_;
     
     capacity_ = newCapacity;
@@ -447,7 +446,7 @@ void String::Reserve(unsigned newCapacity)
 
 void String::Compact()
 {
-    if (capacity_)
+    if (buffer_ != localBuffer_)
         Reserve(length_ + 1);
 }
 
@@ -458,9 +457,17 @@ void String::Clear()
 
 void String::Swap(String& str)
 {
+    // Swapping the inline buffers also swaps the capacities. Buffer pointers to the inline buffers must then be redirected
+    char tempBuffer[LOCAL_CAPACITY];
+    CopyChars(tempBuffer, localBuffer_, LOCAL_CAPACITY);
+    CopyChars(localBuffer_, str.localBuffer_, LOCAL_CAPACITY);
+    CopyChars(str.localBuffer_, tempBuffer, LOCAL_CAPACITY);
     Urho3D::Swap(length_, str.length_);
-    Urho3D::Swap(capacity_, str.capacity_);
     Urho3D::Swap(buffer_, str.buffer_);
+    if (buffer_ == str.localBuffer_)
+        buffer_ = localBuffer_;
+    if (str.buffer_ == localBuffer_)
+        str.buffer_ = str.localBuffer_;
 }
 
 String String::Substring(unsigned pos) const
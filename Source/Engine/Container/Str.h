@@ -45,64 +45,64 @@ public:
     
     /// Construct empty.
     String() :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
     }
     
     /// Construct from another string.
     String(const String& str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         *this = str;
     }
     
     /// Construct from a C string.
     String(const char* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         *this = str;
     }
     
     /// Construct from a C string.
     String(char* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         *this = (const char*)str;
     }
     
     /// Construct from a char array and length.
     String(const char* str, unsigned length) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         Resize(length);
         CopyChars(buffer_, str, length);
     }
     
     /// Construct from a null-terminated wide character array.
     String(const wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         SetUTF8FromWChar(str);
     }
     
     /// Construct from a null-terminated wide character array.
     String(wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         SetUTF8FromWChar(str);
     }
     
@@ -138,17 +138,17 @@ public:
     
     /// Construct from a convertable value.
     template <class T> explicit String(const T& value) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(localBuffer_),
+        length_(0)
     {
+        localBuffer_[0] = 0;
         *this = value.ToString();
     }
     
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (buffer_ != localBuffer_)
             delete[] buffer_;
     }
     
@@ -365,8 +365,8 @@ public:
     const char* CString() const { return buffer_; }
     /// Return length.
     unsigned Length() const { return length_; }
-    /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    /// Return buffer capacity, including the terminating zero.
+    unsigned Capacity() const { return buffer_ != localBuffer_ ? capacity_ : LOCAL_CAPACITY; }
     /// Return whether the string is empty.
     bool Empty() const { return length_ == 0; }
     /// Return comparision result with a string.
@@ -453,8 +453,8 @@ public:
     
     /// Position for "not found."
     static const unsigned NPOS = 0xffffffff;
-    /// Initial dynamic allocation size.
-    static const unsigned MIN_CAPACITY = 8;
+    /// Size of the inline buffer for short strings, including the terminating zero. Sized so that the string still fits inside a Variant.
+    static const unsigned LOCAL_CAPACITY = 4 * sizeof(void*) - sizeof(char*) - sizeof(unsigned);
     /// Empty string.
     static const String EMPTY;
     
@@ -486,15 +486,17 @@ private:
     /// Replace a substring with another substring.
     void Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength);
     
+    /// String buffer, points to the inline buffer for short strings.
+    char* buffer_;
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
-    unsigned capacity_;
-    /// String buffer, null if not allocated.
-    char* buffer_;
-    
-    /// End zero for empty strings.
-    static char endZero;
+    union
+    {
+        /// Capacity of the dynamically allocated buffer.
+        unsigned capacity_;
+        /// Inline buffer for short strings.
+        char localBuffer_[LOCAL_CAPACITY];
+    };
 };
 
 /// Add a string to a C string.
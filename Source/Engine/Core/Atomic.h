@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Urho3D.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Add to an integer atomically and return the new value. Acts as a full memory barrier.
+inline int AtomicAdd(volatile int* value, int amount)
+{
+    #ifdef _MSC_VER
+    return (int)_InterlockedExchangeAdd((volatile long*)value, amount) + amount;
+    #else
+    return __sync_add_and_fetch(value, amount);
+    #endif
+}
+
+/// Add to an integer atomically and return the new value. Other memory accesses may be reordered around it, so it is suited only for counters which do not publish data, such as when incrementing a reference count.
+inline int AtomicAddRelaxed(volatile int* value, int amount)
+{
+    #if defined(_MSC_VER)
+    return (int)_InterlockedExchangeAdd((volatile long*)value, amount) + amount;
+    #elif defined(__ATOMIC_RELAXED)
+    return __atomic_add_fetch(value, amount, __ATOMIC_RELAXED);
+    #else
+    return __sync_add_and_fetch(value, amount);
+    #endif
+}
+
+/// Add to an integer atomically and return the new value. Memory accesses before it are not moved after it and accesses after it are not moved before it, as needed when decrementing a reference count.
+inline int AtomicAddAcquireRelease(volatile int* value, int amount)
+{
+    #if defined(_MSC_VER)
+    return (int)_InterlockedExchangeAdd((volatile long*)value, amount) + amount;
+    #elif defined(__ATOMIC_ACQ_REL)
+    return __atomic_add_fetch(value, amount, __ATOMIC_ACQ_REL);
+    #else
+    return __sync_add_and_fetch(value, amount);
+    #endif
+}
+
+/// Set an integer atomically to a new value if it equals the comparand. Return the previous value. Acts as a full memory barrier.
+inline int AtomicCompareExchange(volatile int* value, int newValue, int comparand)
+{
+    #ifdef _MSC_VER
+    return (int)_InterlockedCompareExchange((volatile long*)value, newValue, comparand);
+    #else
+    return __sync_val_compare_and_swap(value, comparand, newValue);
+    #endif
+}
+
+/// Prevent the compiler and the CPU from reordering memory accesses across the barrier.
+inline void AtomicBarrier()
+{
+    #ifdef _MSC_VER
+    // MSVC is only used for x86 and x64, where ordinary loads and stores are not reordered with each other except for stores followed by loads
+    _ReadWriteBarrier();
+    #else
+    __sync_synchronize();
+    #endif
+}
+
+/// Read an integer written by another thread. Memory accesses after the read are not moved before it.
+inline int AtomicLoad(const volatile int* value)
+{
+    int ret = *value;
+    AtomicBarrier();
+    return ret;
+}
+
+/// Write an integer read by another thread. Memory accesses before the write are not moved after it.
+inline void AtomicStore(volatile int* value, int newValue)
+{
+    AtomicBarrier();
+    *value = newValue;
+}
+
+}
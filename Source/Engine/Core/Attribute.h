@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "InternedString.h"
 #include "Ptr.h"
 #include "Variant.h"
 
@@ -124,8 +125,8 @@ struct AttributeInfo
     
     /// Attribute type.
     VariantType type_;
-    /// Name.
-    String name_;
+    /// Name. Interned, as the same names are registered for many object types and attribute descriptions get copied.
+    InternedString name_;
     /// Byte offset from start of object.
     unsigned offset_;
     /// Enum names.
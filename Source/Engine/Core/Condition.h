@@ -47,6 +47,8 @@ private:
     #ifndef WIN32
     /// Mutex for the event, necessary for pthreads-based implementation.
     void* mutex_;
+    /// Set flag, necessary for pthreads-based implementation so that a set before the wait is not lost.
+    bool signaled_;
     #endif
     /// Operating system specific event.
     void* event_;
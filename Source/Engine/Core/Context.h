@@ -23,12 +23,31 @@
 #pragma once
 
 #include "Attribute.h"
+#include "DenseList.h"
 #include "Object.h"
+#include "FlatHashMap.h"
 #include "HashSet.h"
 
 namespace Urho3D
 {
 
+/// Tracking structure for event receivers. Stores the receivers of one event type in a dense array for fast iteration. Receivers removed during an event send are replaced with null and compacted afterward.
+class URHO3D_API EventReceiverGroup : public RefCounted
+{
+public:
+    /// Begin event send. When receivers are removed during send, the array is compacted only after the send has finished.
+    void BeginSendEvent() { receivers_.BeginIteration(); }
+    /// End event send. Compact the receiver array if receivers were removed.
+    void EndSendEvent() { receivers_.EndIteration(); }
+    /// Add receiver. Does nothing if already added.
+    void Add(Object* object) { receivers_.Add(object); }
+    /// Remove receiver. Leave a null entry if in the middle of an event send, otherwise move the last receiver in its place.
+    void Remove(Object* object) { receivers_.Remove(object); }
+
+    /// Receivers. May contain null entries during event send.
+    DenseList<Object> receivers_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -115,23 +134,23 @@ public:
     const HashMap<ShortStringHash, Vector<AttributeInfo> >& GetAllAttributes() const { return attributes_; }
 
     /// Return event receivers for a sender and event type, or null if they do not exist.
-    HashSet<Object*>* GetEventReceivers(Object* sender, StringHash eventType)
+    EventReceiverGroup* GetEventReceivers(Object* sender, StringHash eventType)
     {
-        HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Find(sender);
+        HashMap<Object*, FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
         if (i != specificEventReceivers_.End())
         {
-            HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Find(eventType);
-            return j != i->second_.End() ? &j->second_ : 0;
+            FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator j = i->second_.Find(eventType);
+            return j != i->second_.End() ? j->second_ : (EventReceiverGroup*)0;
         }
         else
             return 0;
     }
 
     /// Return event receivers for an event type, or null if they do not exist.
-    HashSet<Object*>* GetEventReceivers(StringHash eventType)
+    EventReceiverGroup* GetEventReceivers(StringHash eventType)
     {
-        HashMap<StringHash, HashSet<Object*> >::Iterator i = eventReceivers_.Find(eventType);
-        return i != eventReceivers_.End() ? &i->second_ : 0;
+        FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator i = eventReceivers_.Find(eventType);
+        return i != eventReceivers_.End() ? i->second_ : (EventReceiverGroup*)0;
     }
 
 private:
@@ -149,7 +168,7 @@ private:
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
     /// Begin event send.
     void BeginSendEvent(Object* sender) { eventSenders_.Push(sender); }
-    /// End event send. Clean up event receivers removed in the meanwhile.
+    /// End event send.
     void EndSendEvent() { eventSenders_.Pop(); }
 
     /// Object factories.
@@ -161,9 +180,9 @@ private:
     /// Network replication attribute descriptions per object type.
     HashMap<ShortStringHash, Vector<AttributeInfo> > networkAttributes_;
     /// Event receivers for non-specific events.
-    HashMap<StringHash, HashSet<Object*> > eventReceivers_;
+    FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> > eventReceivers_;
     /// Event receivers for specific senders' events.
-    HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    HashMap<Object*, FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> > > specificEventReceivers_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
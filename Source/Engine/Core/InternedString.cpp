@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "InternedString.h"
+#include "Mutex.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Global table of interned strings. Entries are never removed, so their addresses remain valid.
+static HashMap<String, StringHash> internedStrings;
+/// Mutex for accessing the table from resource background loading and worker threads.
+static Mutex internedStringsMutex;
+
+const InternedString InternedString::EMPTY;
+
+InternedString::InternedString(const String& str) :
+    entry_(0)
+{
+    Intern(str.CString(), str.Length());
+}
+
+InternedString::InternedString(const char* str) :
+    entry_(0)
+{
+    Intern(str, String::CStringLength(str));
+}
+
+unsigned InternedString::GetNumInterned()
+{
+    MutexLock lock(internedStringsMutex);
+    return internedStrings.Size();
+}
+
+void InternedString::Intern(const char* str, unsigned length)
+{
+    // Empty strings are represented by a null entry
+    if (!length)
+        return;
+    
+    // Short strings do not allocate when constructing the lookup key
+    String key(str, length);
+    
+    MutexLock lock(internedStringsMutex);
+    HashMap<String, StringHash>::Iterator i = internedStrings.Find(key);
+    if (i == internedStrings.End())
+        i = internedStrings.Insert(MakePair(key, StringHash(key)));
+    entry_ = &(*i);
+}
+
+}
@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "StringHash.h"
+
+namespace Urho3D
+{
+
+/// Immutable string stored once in a global table. Copies share the same storage, comparison between interned strings is a pointer comparison and the string hash is calculated only once.
+class URHO3D_API InternedString
+{
+public:
+    /// Construct empty.
+    InternedString() :
+        entry_(0)
+    {
+    }
+    
+    /// Copy-construct from another interned string.
+    InternedString(const InternedString& rhs) :
+        entry_(rhs.entry_)
+    {
+    }
+    
+    /// Construct from a string. Adds it to the table if not interned yet.
+    InternedString(const String& str);
+    /// Construct from a C string. Adds it to the table if not interned yet.
+    InternedString(const char* str);
+    
+    /// Assign from another interned string.
+    InternedString& operator = (const InternedString& rhs)
+    {
+        entry_ = rhs.entry_;
+        return *this;
+    }
+    
+    /// Test for equality with another interned string.
+    bool operator == (const InternedString& rhs) const { return entry_ == rhs.entry_; }
+    /// Test for inequality with another interned string.
+    bool operator != (const InternedString& rhs) const { return entry_ != rhs.entry_; }
+    /// Test for equality with a string.
+    bool operator == (const String& rhs) const { return GetString() == rhs; }
+    /// Test for inequality with a string.
+    bool operator != (const String& rhs) const { return GetString() != rhs; }
+    /// Test for equality with a C string.
+    bool operator == (const char* rhs) const { return GetString() == rhs; }
+    /// Test for inequality with a C string.
+    bool operator != (const char* rhs) const { return GetString() != rhs; }
+    /// Test if less than another interned string.
+    bool operator < (const InternedString& rhs) const { return GetString() < rhs.GetString(); }
+    /// Test if greater than another interned string.
+    bool operator > (const InternedString& rhs) const { return GetString() > rhs.GetString(); }
+    /// Return the string.
+    operator const String& () const { return GetString(); }
+    
+    /// Return the string.
+    const String& GetString() const { return entry_ ? entry_->first_ : String::EMPTY; }
+    /// Return the C string.
+    const char* CString() const { return GetString().CString(); }
+    /// Return length.
+    unsigned Length() const { return GetString().Length(); }
+    /// Return whether the string is empty.
+    bool Empty() const { return entry_ == 0; }
+    /// Return comparision result with a string.
+    int Compare(const String& str, bool caseSensitive = true) const { return GetString().Compare(str, caseSensitive); }
+    /// Return comparision result with a C string.
+    int Compare(const char* str, bool caseSensitive = true) const { return GetString().Compare(str, caseSensitive); }
+    /// Return the case-insensitive string hash.
+    StringHash GetHash() const { return entry_ ? entry_->second_ : StringHash::ZERO; }
+    /// Return hash value for HashSet & HashMap.
+    unsigned ToHash() const { return GetHash().Value(); }
+    
+    /// Return number of strings in the global table.
+    static unsigned GetNumInterned();
+    
+    /// Empty interned string.
+    static const InternedString EMPTY;
+    
+private:
+    /// Find or add a string to the global table.
+    void Intern(const char* str, unsigned length);
+    
+    /// Table entry: the string and its hash.
+    const HashMap<String, StringHash>::KeyValue* entry_;
+};
+
+/// Add an interned string to a C string.
+inline String operator + (const char* lhs, const InternedString& rhs) { return lhs + rhs.GetString(); }
+
+}
@@ -22,6 +22,7 @@
 
 #include "Precompiled.h"
 #include "Context.h"
+#include "FlatHashSet.h"
 
 #include "DebugNew.h"
 
@@ -94,7 +95,9 @@ void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler)
     
     eventHandlers_.InsertFront(handler);
     
-    context_->AddEventReceiver(this, eventType);
+    // If replacing an old handler, the receiver is already registered
+    if (!oldHandler)
+        context_->AddEventReceiver(this, eventType);
 }
 
 void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler* handler)
@@ -115,7 +118,8 @@ void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler
     
     eventHandlers_.InsertFront(handler);
     
-    context_->AddEventReceiver(this, sender, eventType);
+    if (!oldHandler)
+        context_->AddEventReceiver(this, sender, eventType);
 }
 
 void Object::UnsubscribeFromEvent(StringHash eventType)
@@ -215,9 +219,8 @@ void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& excepti
 
 void Object::SendEvent(StringHash eventType)
 {
-    VariantMap noEventData;
-    
-    SendEvent(eventType, noEventData);
+    // Use the context's reusable map for the current nesting level instead of constructing an empty map on each send
+    SendEvent(eventType, context_->GetEventDataMap());
 }
 
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
@@ -225,95 +228,95 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
+    
+    // Hold references to the receiver groups, as they may be erased from the context during event handling
+    SharedPtr<EventReceiverGroup> specificGroup(context->GetEventReceivers(this, eventType));
+    SharedPtr<EventReceiverGroup> group(context->GetEventReceivers(eventType));
+    if (group && group->receivers_.Empty())
+        group.Reset();
+    if (!specificGroup && !group)
+        return;
+    
+    FlatHashSet<Object*> processed;
     
     context->BeginSendEvent(this);
     
-    // Check first the specific event receivers
-    const HashSet<Object*>* group = context->GetEventReceivers(this, eventType);
-    if (group)
+    // Check first the specific event receivers. Receivers added during the send are not invoked, and removed receivers
+    // leave null entries which are skipped
+    if (specificGroup)
     {
-        for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
+        specificGroup->BeginSendEvent();
+        
+        unsigned numReceivers = specificGroup->receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
         {
-            HashSet<Object*>::ConstIterator current = i++;
-            Object* receiver = *current;
-            Object* next = 0;
-            if (i != group->End())
-                next = *i;
+            Object* receiver = specificGroup->receivers_[i];
+            if (!receiver)
+                continue;
             
-            unsigned oldSize = group->Size();
             receiver->OnEvent(this, eventType, eventData);
             
             // If self has been destroyed as a result of event handling, exit
             if (self.Expired())
             {
+                specificGroup->EndSendEvent();
                 context->EndSendEvent();
                 return;
             }
             
-            // If group has changed size during iteration (removed/added subscribers) try to recover
-            /// \todo This is not entirely foolproof, as a subscriber could have been added to make up for the removed one
-            if (group->Size() != oldSize)
-                i = group->Find(next);
-            
-            processed.Insert(receiver);
+            // Remember the receiver only if it could be found again among the non-specific receivers
+            if (group)
+                processed.Insert(receiver);
         }
+        
+        specificGroup->EndSendEvent();
     }
     
     // Then the non-specific receivers
-    group = context->GetEventReceivers(eventType);
     if (group)
     {
+        group->BeginSendEvent();
+        
+        unsigned numReceivers = group->receivers_.Size();
         if (processed.Empty())
         {
-            for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
+            for (unsigned i = 0; i < numReceivers; ++i)
             {
-                HashSet<Object*>::ConstIterator current = i++;
-                Object* receiver = *current;
-                Object* next = 0;
-                if (i != group->End())
-                    next = *i;
+                Object* receiver = group->receivers_[i];
+                if (!receiver)
+                    continue;
                 
-                unsigned oldSize = group->Size();
                 receiver->OnEvent(this, eventType, eventData);
                 
                 if (self.Expired())
                 {
+                    group->EndSendEvent();
                     context->EndSendEvent();
                     return;
                 }
-                
-                if (group->Size() != oldSize)
-                    i = group->Find(next);
             }
         }
         else
         {
             // If there were specific receivers, check that the event is not sent doubly to them
-            for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
+            for (unsigned i = 0; i < numReceivers; ++i)
             {
-                HashSet<Object*>::ConstIterator current = i++;
-                Object* receiver = *current;
-                Object* next = 0;
-                if (i != group->End())
-                    next = *i;
+                Object* receiver = group->receivers_[i];
+                if (!receiver || processed.Contains(receiver))
+                    continue;
+                
+                receiver->OnEvent(this, eventType, eventData);
                 
-                if (!processed.Contains(receiver))
+                if (self.Expired())
                 {
-                    unsigned oldSize = group->Size();
-                    receiver->OnEvent(this, eventType, eventData);
-                    
-                    if (self.Expired())
-                    {
-                        context->EndSendEvent();
-                        return;
-                    }
-                    
-                    if (group->Size() != oldSize)
-                        i = group->Find(next);
+                    group->EndSendEvent();
+                    context->EndSendEvent();
+                    return;
                 }
             }
         }
+        
+        group->EndSendEvent();
     }
     
     context->EndSendEvent();
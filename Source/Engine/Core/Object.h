@@ -265,8 +265,8 @@ private:
     HandlerFunctionPtr function_;
 };
 
-#define EVENT(eventID, eventName) static const Urho3D::StringHash eventID(#eventName); namespace eventName
-#define PARAM(paramID, paramName) static const Urho3D::ShortStringHash paramID(#paramName)
+#define EVENT(eventID, eventName) static const Urho3D::StringHash eventID(Urho3D::StringHash::CalculateLiteral(#eventName)); namespace eventName
+#define PARAM(paramID, paramName) static const Urho3D::ShortStringHash paramID(Urho3D::ShortStringHash::CalculateLiteral(#paramName))
 #define HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 #define HANDLER_USERDATA(className, function, userData) (new Urho3D::EventHandlerImpl<className>(this, &className::function, userData))
 
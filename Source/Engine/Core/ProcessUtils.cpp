@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Log.h"
 #include "Mutex.h"
 #include "ProcessUtils.h"
 #include "MathDefs.h"
@@ -129,6 +130,9 @@ void ErrorDialog(const String& title, const String& message)
 
 void ErrorExit(const String& message, int exitCode)
 {
+    // Write the queued log messages first, so that they are not lost and appear before the exit message
+    Log::FlushQueued();
+
     if (!message.Empty())
         PrintLine(message, true);
 
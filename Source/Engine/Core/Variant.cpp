@@ -35,6 +35,9 @@ const ResourceRefList Variant::emptyResourceRefList;
 const VariantMap Variant::emptyVariantMap;
 const VariantVector Variant::emptyVariantVector;
 
+/// Size of the header of a heap memory block for variant map pairs, which keeps the pairs after it aligned.
+static const unsigned VARIANTMAP_BLOCK_HEADER_SIZE = 16;
+
 static const char* typeNames[] =
 {
     "None",
@@ -96,14 +99,6 @@ Variant& Variant::operator = (const Variant& rhs)
         *(reinterpret_cast<WeakPtr<RefCounted>*>(&value_)) = *(reinterpret_cast<const WeakPtr<RefCounted>*>(&rhs.value_));
         break;
         
-    case VAR_MATRIX3:
-        *(reinterpret_cast<Matrix3*>(value_.ptr_)) = *(reinterpret_cast<const Matrix3*>(rhs.value_.ptr_));
-        break;
-        
-    case VAR_MATRIX3X4:
-        *(reinterpret_cast<Matrix3x4*>(value_.ptr_)) = *(reinterpret_cast<const Matrix3x4*>(rhs.value_.ptr_));
-        break;
-        
     case VAR_MATRIX4:
         *(reinterpret_cast<Matrix4*>(value_.ptr_)) = *(reinterpret_cast<const Matrix4*>(rhs.value_.ptr_));
         break;
@@ -171,10 +166,10 @@ bool Variant::operator == (const Variant& rhs) const
         return *(reinterpret_cast<const IntVector2*>(&value_)) == *(reinterpret_cast<const IntVector2*>(&rhs.value_));
 
     case VAR_MATRIX3:
-        return *(reinterpret_cast<const Matrix3*>(value_.ptr_)) == *(reinterpret_cast<const Matrix3*>(rhs.value_.ptr_));
+        return *(reinterpret_cast<const Matrix3*>(&value_)) == *(reinterpret_cast<const Matrix3*>(&rhs.value_));
 
     case VAR_MATRIX3X4:
-        return *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) == *(reinterpret_cast<const Matrix3x4*>(rhs.value_.ptr_));
+        return *(reinterpret_cast<const Matrix3x4*>(&value_)) == *(reinterpret_cast<const Matrix3x4*>(&rhs.value_));
 
     case VAR_MATRIX4:
         return *(reinterpret_cast<const Matrix4*>(value_.ptr_)) == *(reinterpret_cast<const Matrix4*>(rhs.value_.ptr_));
@@ -322,6 +317,41 @@ void Variant::SetBuffer(const void* data, unsigned size)
         memcpy(&buffer[0], data, size);
 }
 
+void Variant::Swap(Variant& rhs)
+{
+    // Strings and resource references may point to their own inline buffers, so they can not be swapped as raw memory
+    bool inlineBuffer = type_ == VAR_STRING || type_ == VAR_RESOURCEREF;
+    bool rhsInlineBuffer = rhs.type_ == VAR_STRING || rhs.type_ == VAR_RESOURCEREF;
+    
+    if (type_ == rhs.type_ && inlineBuffer)
+    {
+        if (type_ == VAR_STRING)
+            Swap(*reinterpret_cast<String*>(&rhs.value_));
+        else
+            Swap(*reinterpret_cast<ResourceRef*>(&rhs.value_));
+    }
+    else if (!inlineBuffer && !rhsInlineBuffer)
+    {
+        Urho3D::Swap(type_, rhs.type_);
+        Urho3D::Swap(value_, rhs.value_);
+    }
+    else
+    {
+        // Move the other value out as raw memory, swap the string or resource reference into an empty one of the same type,
+        // then move the other value in
+        Variant& other = inlineBuffer ? rhs : *this;
+        Variant& stringLike = inlineBuffer ? *this : rhs;
+        VariantType otherType = other.type_;
+        VariantValue otherValue = other.value_;
+        other.type_ = VAR_NONE;
+        other.SetType(stringLike.type_);
+        other.Swap(stringLike);
+        stringLike.SetType(VAR_NONE);
+        stringLike.type_ = otherType;
+        stringLike.value_ = otherValue;
+    }
+}
+
 String Variant::GetTypeName() const
 {
     return typeNames[type_];
@@ -384,10 +414,10 @@ String Variant::ToString() const
         return String::EMPTY;
 
     case VAR_MATRIX3:
-        return (reinterpret_cast<const Matrix3*>(value_.ptr_))->ToString();
+        return (reinterpret_cast<const Matrix3*>(&value_))->ToString();
 
     case VAR_MATRIX3X4:
-        return (reinterpret_cast<const Matrix3x4*>(value_.ptr_))->ToString();
+        return (reinterpret_cast<const Matrix3x4*>(&value_))->ToString();
         
     case VAR_MATRIX4:
         return (reinterpret_cast<const Matrix4*>(value_.ptr_))->ToString();
@@ -462,10 +492,10 @@ bool Variant::IsZero() const
         return *reinterpret_cast<const WeakPtr<RefCounted>*>(&value_) == (RefCounted*)0;
         
     case VAR_MATRIX3:
-        return *reinterpret_cast<const Matrix3*>(value_.ptr_) == Matrix3::IDENTITY;
+        return *reinterpret_cast<const Matrix3*>(&value_) == Matrix3::IDENTITY;
         
     case VAR_MATRIX3X4:
-        return *reinterpret_cast<const Matrix3x4*>(value_.ptr_) == Matrix3x4::IDENTITY;
+        return *reinterpret_cast<const Matrix3x4*>(&value_) == Matrix3x4::IDENTITY;
         
     case VAR_MATRIX4:
         return *reinterpret_cast<const Matrix4*>(value_.ptr_) == Matrix4::IDENTITY;
@@ -510,14 +540,6 @@ void Variant::SetType(VariantType newType)
         (reinterpret_cast<WeakPtr<RefCounted>*>(&value_))->~WeakPtr<RefCounted>();
         break;
         
-    case VAR_MATRIX3:
-        delete reinterpret_cast<Matrix3*>(value_.ptr_);
-        break;
-        
-    case VAR_MATRIX3X4:
-        delete reinterpret_cast<Matrix3x4*>(value_.ptr_);
-        break;
-        
     case VAR_MATRIX4:
         delete reinterpret_cast<Matrix4*>(value_.ptr_);
         break;
@@ -559,11 +581,11 @@ void Variant::SetType(VariantType newType)
         break;
         
     case VAR_MATRIX3:
-        value_.ptr_ = new Matrix3();
+        new(reinterpret_cast<Matrix3*>(&value_)) Matrix3();
         break;
         
     case VAR_MATRIX3X4:
-        value_.ptr_ = new Matrix3x4();
+        new(reinterpret_cast<Matrix3x4*>(&value_)) Matrix3x4();
         break;
         
     case VAR_MATRIX4:
@@ -675,6 +697,26 @@ template<> const Matrix4& Variant::Get<const Matrix4&>() const
     return GetMatrix4();
 }
 
+template<> const ResourceRef& Variant::Get<const ResourceRef&>() const
+{
+    return GetResourceRef();
+}
+
+template<> const ResourceRefList& Variant::Get<const ResourceRefList&>() const
+{
+    return GetResourceRefList();
+}
+
+template<> const VariantVector& Variant::Get<const VariantVector&>() const
+{
+    return GetVariantVector();
+}
+
+template<> const VariantMap& Variant::Get<const VariantMap&>() const
+{
+    return GetVariantMap();
+}
+
 template<> ResourceRef Variant::Get<ResourceRef>() const
 {
     return GetResourceRef();
@@ -770,4 +812,206 @@ VariantType Variant::GetTypeFromName(const char* typeName)
     return (VariantType)GetStringListIndex(typeName, typeNames, VAR_NONE);
 }
 
+VariantMap::VariantMap(const VariantMap& map) :
+    pairs_(0),
+    size_(0),
+    capacity_(0),
+    inlinePairs_(0),
+    blocks_(0)
+{
+    *this = map;
+}
+
+VariantMap::VariantMap(KeyValue** inlinePairs, KeyValue* inlineStorage, unsigned inlineCapacity) :
+    pairs_(inlinePairs),
+    size_(0),
+    capacity_(inlineCapacity),
+    inlinePairs_(inlinePairs),
+    blocks_(0)
+{
+    for (unsigned i = 0; i < inlineCapacity; ++i)
+        inlinePairs[i] = inlineStorage + i;
+}
+
+VariantMap::~VariantMap()
+{
+    Clear();
+    if (pairs_ != inlinePairs_)
+        delete[] pairs_;
+    
+    while (blocks_)
+    {
+        void* next = *reinterpret_cast<void**>(blocks_);
+        delete[] reinterpret_cast<unsigned char*>(blocks_);
+        blocks_ = next;
+    }
+}
+
+VariantMap& VariantMap::operator = (const VariantMap& rhs)
+{
+    if (&rhs != this)
+    {
+        Clear();
+        Reserve(rhs.size_);
+        // The source is already sorted, so the pairs can be copied in order
+        for (unsigned i = 0; i < rhs.size_; ++i)
+            new(pairs_[i]) KeyValue(*rhs.pairs_[i]);
+        size_ = rhs.size_;
+    }
+    return *this;
+}
+
+VariantMap& VariantMap::operator += (const Pair<ShortStringHash, Variant>& rhs)
+{
+    Insert(rhs);
+    return *this;
+}
+
+VariantMap& VariantMap::operator += (const VariantMap& rhs)
+{
+    Insert(rhs);
+    return *this;
+}
+
+bool VariantMap::operator == (const VariantMap& rhs) const
+{
+    if (rhs.size_ != size_)
+        return false;
+    
+    // Both maps are sorted by key, so equal maps have equal pairs at each index
+    for (unsigned i = 0; i < size_; ++i)
+    {
+        if (*pairs_[i] != *rhs.pairs_[i])
+            return false;
+    }
+    
+    return true;
+}
+
+VariantMap::Iterator VariantMap::Insert(const Pair<ShortStringHash, Variant>& pair)
+{
+    unsigned index = LowerBound(pair.first_);
+    if (index == size_ || pairs_[index]->first_ != pair.first_)
+        InsertEmpty(index, pair.first_);
+    pairs_[index]->second_ = pair.second_;
+    return Iterator(pairs_ + index);
+}
+
+void VariantMap::Insert(const VariantMap& map)
+{
+    for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+        (*this)[i->first_] = i->second_;
+}
+
+VariantMap::Iterator VariantMap::Insert(const ConstIterator& it)
+{
+    return Insert(MakePair(it->first_, it->second_));
+}
+
+void VariantMap::Insert(const ConstIterator& start, const ConstIterator& end)
+{
+    for (ConstIterator i = start; i != end; ++i)
+        (*this)[i->first_] = i->second_;
+}
+
+bool VariantMap::Erase(ShortStringHash key)
+{
+    unsigned index = LowerBound(key);
+    if (index == size_ || pairs_[index]->first_ != key)
+        return false;
+    
+    EraseAt(index);
+    return true;
+}
+
+VariantMap::Iterator VariantMap::Erase(const Iterator& it)
+{
+    unsigned index = it - Begin();
+    if (index < size_)
+        EraseAt(index);
+    return Iterator(pairs_ + index);
+}
+
+void VariantMap::Clear()
+{
+    // The pair memory stays in the pointer array for reuse
+    for (unsigned i = 0; i < size_; ++i)
+        pairs_[i]->~KeyValue();
+    size_ = 0;
+}
+
+void VariantMap::Reserve(unsigned newCapacity)
+{
+    if (newCapacity <= capacity_)
+        return;
+    
+    KeyValue** newPairs = new KeyValue*[newCapacity];
+    if (capacity_)
+        memcpy(newPairs, pairs_, capacity_ * sizeof(KeyValue*));
+    if (pairs_ != inlinePairs_)
+        delete[] pairs_;
+    pairs_ = newPairs;
+    
+    // Allocate memory for the additional pairs in one block. The existing pairs stay where they are
+    unsigned numNewPairs = newCapacity - capacity_;
+    unsigned char* block = new unsigned char[VARIANTMAP_BLOCK_HEADER_SIZE + numNewPairs * sizeof(KeyValue)];
+    *reinterpret_cast<void**>(block) = blocks_;
+    blocks_ = block;
+    
+    KeyValue* newStorage = reinterpret_cast<KeyValue*>(block + VARIANTMAP_BLOCK_HEADER_SIZE);
+    for (unsigned i = 0; i < numNewPairs; ++i)
+        pairs_[capacity_ + i] = newStorage + i;
+    capacity_ = newCapacity;
+}
+
+void VariantMap::Swap(VariantMap& rhs)
+{
+    // Memory owned by a subclass can not change owner, so copy in that case
+    if (inlinePairs_ || rhs.inlinePairs_)
+    {
+        VariantMap temp(*this);
+        *this = rhs;
+        rhs = temp;
+    }
+    else
+    {
+        Urho3D::Swap(pairs_, rhs.pairs_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(blocks_, rhs.blocks_);
+    }
+}
+
+Vector<ShortStringHash> VariantMap::Keys() const
+{
+    Vector<ShortStringHash> result;
+    result.Reserve(size_);
+    for (unsigned i = 0; i < size_; ++i)
+        result.Push(pairs_[i]->first_);
+    return result;
+}
+
+void VariantMap::InsertEmpty(unsigned index, ShortStringHash key)
+{
+    if (size_ == capacity_)
+        Reserve(capacity_ ? capacity_ + (capacity_ + 1) / 2 : 8);
+    
+    // Take the first unused pair memory and move the following pointers one step forward to make room for it
+    KeyValue* pair = pairs_[size_];
+    memmove(pairs_ + index + 1, pairs_ + index, (size_ - index) * sizeof(KeyValue*));
+    new(pair) KeyValue(key, Variant::EMPTY);
+    pairs_[index] = pair;
+    ++size_;
+}
+
+void VariantMap::EraseAt(unsigned index)
+{
+    // Move the pointers after the erased pair back, and return its memory to the unused part of the array
+    KeyValue* pair = pairs_[index];
+    pair->~KeyValue();
+    memmove(pairs_ + index, pairs_ + index + 1, (size_ - index - 1) * sizeof(KeyValue*));
+    --size_;
+    pairs_[size_] = pair;
+}
+
 }
@@ -61,37 +61,15 @@ enum VariantType
     MAX_VAR_TYPES
 };
 
-/// Union for the possible variant values. Also stores non-POD objects such as String which must not exceed 16 bytes in size.
-struct VariantValue
+/// Union for the possible variant values. Also stores non-POD objects such as String and ResourceRef, and the math objects up to Matrix3x4, which must not exceed the size of the storage. Only Matrix4 is allocated separately.
+union VariantValue
 {
-    union
-    {
-        int int_;
-        bool bool_;
-        float float_;
-        void* ptr_;
-    };
-
-    union
-    {
-        int int2_;
-        float float2_;
-        void* ptr2_;
-    };
-
-    union
-    {
-        int int3_;
-        float float3_;
-        void* ptr3_;
-    };
-
-    union
-    {
-        int int4_;
-        float float4_;
-        void* ptr4_;
-    };
+    int int_;
+    bool bool_;
+    float float_;
+    void* ptr_;
+    /// Storage sized for a Matrix3x4 and aligned for pointers.
+    float storage_[12];
 };
 
 /// Typed resource reference.
@@ -169,8 +147,203 @@ class Variant;
 /// Vector of variants.
 typedef Vector<Variant> VariantVector;
 
-/// Map of variants.
-typedef HashMap<ShortStringHash, Variant> VariantMap;
+/// Map of variants, used for example for event parameters. Keeps pointers to the pairs in an array sorted by key, so that a lookup is a binary search over a few contiguous keys, and clearing keeps the memory for reuse. Has the same interface as HashMap, but the pairs are iterated in key order. Like in HashMap, the pairs never move in memory, so references to them stay valid until they are erased, but inserting or erasing invalidates iterators.
+class URHO3D_API VariantMap
+{
+public:
+    class KeyValue;
+    
+    /// %Variant map iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(0)
+        {
+        }
+        
+        /// Construct with an object pointer.
+        explicit Iterator(KeyValue** ptr) :
+            ptr_(ptr)
+        {
+        }
+        
+        /// Point to the pair.
+        KeyValue* operator -> () const { return *ptr_; }
+        /// Dereference the pair.
+        KeyValue& operator * () const { return **ptr_; }
+        /// Preincrement the pointer.
+        Iterator& operator ++ () { ++ptr_; return *this; }
+        /// Postincrement the pointer.
+        Iterator operator ++ (int) { Iterator it = *this; ++ptr_; return it; }
+        /// Predecrement the pointer.
+        Iterator& operator -- () { --ptr_; return *this; }
+        /// Postdecrement the pointer.
+        Iterator operator -- (int) { Iterator it = *this; --ptr_; return it; }
+        /// Test for equality with another iterator.
+        bool operator == (const Iterator& rhs) const { return ptr_ == rhs.ptr_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const Iterator& rhs) const { return ptr_ != rhs.ptr_; }
+        /// Calculate offset to another iterator.
+        int operator - (const Iterator& rhs) const { return (int)(ptr_ - rhs.ptr_); }
+        
+        /// Pointer to the pair pointer.
+        KeyValue** ptr_;
+    };
+    
+    /// %Variant map const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator() :
+            ptr_(0)
+        {
+        }
+        
+        /// Construct with an object pointer.
+        explicit ConstIterator(KeyValue* const* ptr) :
+            ptr_(ptr)
+        {
+        }
+        
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            ptr_(rhs.ptr_)
+        {
+        }
+        
+        /// Point to the pair.
+        const KeyValue* operator -> () const { return *ptr_; }
+        /// Dereference the pair.
+        const KeyValue& operator * () const { return **ptr_; }
+        /// Preincrement the pointer.
+        ConstIterator& operator ++ () { ++ptr_; return *this; }
+        /// Postincrement the pointer.
+        ConstIterator operator ++ (int) { ConstIterator it = *this; ++ptr_; return it; }
+        /// Predecrement the pointer.
+        ConstIterator& operator -- () { --ptr_; return *this; }
+        /// Postdecrement the pointer.
+        ConstIterator operator -- (int) { ConstIterator it = *this; --ptr_; return it; }
+        /// Test for equality with another iterator.
+        bool operator == (const ConstIterator& rhs) const { return ptr_ == rhs.ptr_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const ConstIterator& rhs) const { return ptr_ != rhs.ptr_; }
+        /// Calculate offset to another iterator.
+        int operator - (const ConstIterator& rhs) const { return (int)(ptr_ - rhs.ptr_); }
+        
+        /// Pointer to the pair pointer.
+        KeyValue* const* ptr_;
+    };
+    
+    /// Construct empty.
+    VariantMap() :
+        pairs_(0),
+        size_(0),
+        capacity_(0),
+        inlinePairs_(0),
+        blocks_(0)
+    {
+    }
+    
+    /// Construct from another map.
+    VariantMap(const VariantMap& map);
+    /// Destruct.
+    ~VariantMap();
+    
+    /// Assign a map.
+    VariantMap& operator = (const VariantMap& rhs);
+    /// Add-assign a pair.
+    VariantMap& operator += (const Pair<ShortStringHash, Variant>& rhs);
+    /// Add-assign a map.
+    VariantMap& operator += (const VariantMap& rhs);
+    /// Test for equality with another map.
+    bool operator == (const VariantMap& rhs) const;
+    /// Test for inequality with another map.
+    bool operator != (const VariantMap& rhs) const { return !(*this == rhs); }
+    /// Index the map. Create a new pair if key not found.
+    Variant& operator [] (ShortStringHash key);
+    
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<ShortStringHash, Variant>& pair);
+    /// Insert a map.
+    void Insert(const VariantMap& map);
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it);
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end);
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(ShortStringHash key);
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it);
+    /// Clear the map. Keeps the memory for reuse.
+    void Clear();
+    /// Sort pairs by key. They are always sorted, so this does nothing and exists for compatibility with HashMap.
+    void Sort() {}
+    /// Set new capacity. Allocates the memory for the additional pairs at once.
+    void Reserve(unsigned newCapacity);
+    /// Swap with another map.
+    void Swap(VariantMap& rhs);
+    
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(ShortStringHash key);
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(ShortStringHash key) const;
+    /// Return whether contains a pair with key.
+    bool Contains(ShortStringHash key) const;
+    /// Return all the keys.
+    Vector<ShortStringHash> Keys() const;
+    /// Return iterator to the beginning.
+    Iterator Begin();
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const;
+    /// Return iterator to the end.
+    Iterator End();
+    /// Return const iterator to the end.
+    ConstIterator End() const;
+    /// Return first key.
+    const ShortStringHash& Front() const;
+    /// Return last key.
+    const ShortStringHash& Back() const;
+    /// Return number of pairs.
+    unsigned Size() const { return size_; }
+    /// Return capacity.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether map is empty.
+    bool Empty() const { return size_ == 0; }
+    
+protected:
+    /// Construct with a pointer array and memory for the pairs which are owned by a subclass.
+    VariantMap(KeyValue** inlinePairs, KeyValue* inlineStorage, unsigned inlineCapacity);
+    
+private:
+    /// Return index of the first pair with key not less than the given key.
+    unsigned LowerBound(ShortStringHash key) const;
+    /// Insert a pair with an empty value at index. Moves the following pair pointers.
+    void InsertEmpty(unsigned index, ShortStringHash key);
+    /// Erase the pair at index. Moves the following pair pointers.
+    void EraseAt(unsigned index);
+    
+    /// Pointers to the pairs sorted by key, followed by pointers to the unused pair memory up to the capacity.
+    KeyValue** pairs_;
+    /// Number of pairs.
+    unsigned size_;
+    /// Capacity of the pointer array and the pair memory.
+    unsigned capacity_;
+    /// Pointer array owned by a subclass, or null. Not freed by the map.
+    KeyValue** inlinePairs_;
+    /// Heap memory blocks for the pairs, linked through their first bytes.
+    void* blocks_;
+};
+
+// Compile-time checks that the types constructed in place fit the variant value. A negative array size fails the build
+typedef char VariantStringSizeCheck[sizeof(String) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantBufferSizeCheck[sizeof(PODVector<unsigned char>) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantResourceRefSizeCheck[sizeof(ResourceRef) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantResourceRefListSizeCheck[sizeof(ResourceRefList) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantVectorSizeCheck[sizeof(VariantVector) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantMapSizeCheck[sizeof(VariantMap) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantPtrSizeCheck[sizeof(WeakPtr<RefCounted>) <= sizeof(VariantValue) ? 1 : -1];
+typedef char VariantMatrix3x4SizeCheck[sizeof(Matrix3x4) <= sizeof(VariantValue) ? 1 : -1];
 
 /// Variable that supports a fixed set of types.
 class URHO3D_API Variant
@@ -507,7 +680,7 @@ public:
     Variant& operator = (const char* rhs)
     {
         SetType(VAR_STRING);
-        *(reinterpret_cast<String*>(&value_)) = String(rhs);
+        *(reinterpret_cast<String*>(&value_)) = rhs;
         return *this;
     }
 
@@ -587,7 +760,7 @@ public:
     Variant& operator = (const Matrix3& rhs)
     {
         SetType(VAR_MATRIX3);
-        *(reinterpret_cast<Matrix3*>(value_.ptr_)) = rhs;
+        *(reinterpret_cast<Matrix3*>(&value_)) = rhs;
         return *this;
     }
     
@@ -595,7 +768,7 @@ public:
     Variant& operator = (const Matrix3x4& rhs)
     {
         SetType(VAR_MATRIX3X4);
-        *(reinterpret_cast<Matrix3x4*>(value_.ptr_)) = rhs;
+        *(reinterpret_cast<Matrix3x4*>(&value_)) = rhs;
         return *this;
     }
     
@@ -672,9 +845,9 @@ public:
     }
     
     /// Test for equality with a Matrix3. To return true, both the type and value must match.
-    bool operator == (const Matrix3& rhs) const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(value_.ptr_)) == rhs : false; }
+    bool operator == (const Matrix3& rhs) const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(&value_)) == rhs : false; }
     /// Test for equality with a Matrix3x4. To return true, both the type and value must match.
-    bool operator == (const Matrix3x4& rhs) const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) == rhs : false; }
+    bool operator == (const Matrix3x4& rhs) const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(&value_)) == rhs : false; }
     /// Test for equality with a Matrix4. To return true, both the type and value must match.
     bool operator == (const Matrix4& rhs) const { return type_ == VAR_MATRIX4 ? *(reinterpret_cast<const Matrix4*>(value_.ptr_)) == rhs : false; }
     
@@ -737,6 +910,54 @@ public:
     void FromString(VariantType type, const char* value);
     /// Set buffer type from a memory area.
     void SetBuffer(const void* data, unsigned size);
+    /// Swap with another variant.
+    void Swap(Variant& rhs);
+    
+    /// Set to a string by swapping with it, to avoid copying a temporary. The string is left with the previous value if the variant held a string, otherwise empty.
+    void Swap(String& rhs)
+    {
+        SetType(VAR_STRING);
+        reinterpret_cast<String*>(&value_)->Swap(rhs);
+    }
+    
+    /// Set to a buffer by swapping with it. The buffer is left with the previous value if the variant held a buffer, otherwise empty.
+    void Swap(PODVector<unsigned char>& rhs)
+    {
+        SetType(VAR_BUFFER);
+        reinterpret_cast<PODVector<unsigned char>*>(&value_)->Swap(rhs);
+    }
+    
+    /// Set to a resource reference by swapping with it. The reference is left with the previous value if the variant held a resource reference, otherwise empty.
+    void Swap(ResourceRef& rhs)
+    {
+        SetType(VAR_RESOURCEREF);
+        ResourceRef& ref = *reinterpret_cast<ResourceRef*>(&value_);
+        Urho3D::Swap(ref.type_, rhs.type_);
+        ref.name_.Swap(rhs.name_);
+    }
+    
+    /// Set to a resource reference list by swapping with it. The list is left with the previous value if the variant held a resource reference list, otherwise empty.
+    void Swap(ResourceRefList& rhs)
+    {
+        SetType(VAR_RESOURCEREFLIST);
+        ResourceRefList& refList = *reinterpret_cast<ResourceRefList*>(&value_);
+        Urho3D::Swap(refList.type_, rhs.type_);
+        refList.names_.Swap(rhs.names_);
+    }
+    
+    /// Set to a variant vector by swapping with it. The vector is left with the previous value if the variant held a variant vector, otherwise empty.
+    void Swap(VariantVector& rhs)
+    {
+        SetType(VAR_VARIANTVECTOR);
+        reinterpret_cast<VariantVector*>(&value_)->Swap(rhs);
+    }
+    
+    /// Set to a variant map by swapping with it. The map is left with the previous value if the variant held a variant map, otherwise empty.
+    void Swap(VariantMap& rhs)
+    {
+        SetType(VAR_VARIANTMAP);
+        reinterpret_cast<VariantMap*>(&value_)->Swap(rhs);
+    }
 
     /// Return int or zero on type mismatch.
     int GetInt() const { return type_ == VAR_INT ? value_.int_ : 0; }
@@ -791,9 +1012,9 @@ public:
     /// Return a RefCounted pointer or null on type mismatch. Will return null if holding a void pointer, as it can not be safely verified that the object is a RefCounted.
     RefCounted* GetPtr() const { return type_ == VAR_PTR ? *reinterpret_cast<const WeakPtr<RefCounted>*>(&value_) : (RefCounted*)0; }
     /// Return a Matrix3 or identity on type mismatch.
-    const Matrix3& GetMatrix3() const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(value_.ptr_)) : Matrix3::IDENTITY; }
+    const Matrix3& GetMatrix3() const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(&value_)) : Matrix3::IDENTITY; }
     /// Return a Matrix3x4 or identity on type mismatch.
-    const Matrix3x4& GetMatrix3x4() const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) : Matrix3x4::IDENTITY; }
+    const Matrix3x4& GetMatrix3x4() const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(&value_)) : Matrix3x4::IDENTITY; }
     /// Return a Matrix4 or identity on type mismatch.
     const Matrix4& GetMatrix4() const { return type_ == VAR_MATRIX4 ? *(reinterpret_cast<const Matrix4*>(value_.ptr_)) : Matrix4::IDENTITY; }
     /// Return value's type.
@@ -846,4 +1067,128 @@ private:
     VariantValue value_;
 };
 
+/// %Variant map key-value pair with const key.
+class VariantMap::KeyValue
+{
+public:
+    /// Construct with key and value.
+    KeyValue(ShortStringHash first, const Variant& second) :
+        first_(first),
+        second_(second)
+    {
+    }
+    
+    /// Test for equality with another pair.
+    bool operator == (const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+    /// Test for inequality with another pair.
+    bool operator != (const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+    
+    /// Key.
+    const ShortStringHash first_;
+    /// Value.
+    Variant second_;
+};
+
+inline unsigned VariantMap::LowerBound(ShortStringHash key) const
+{
+    unsigned first = 0;
+    unsigned count = size_;
+    while (count)
+    {
+        unsigned step = count >> 1;
+        if (pairs_[first + step]->first_ < key)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+inline Variant& VariantMap::operator [] (ShortStringHash key)
+{
+    unsigned index = LowerBound(key);
+    if (index == size_ || pairs_[index]->first_ != key)
+        InsertEmpty(index, key);
+    return pairs_[index]->second_;
+}
+
+inline VariantMap::Iterator VariantMap::Find(ShortStringHash key)
+{
+    unsigned index = LowerBound(key);
+    return Iterator(index < size_ && pairs_[index]->first_ == key ? pairs_ + index : pairs_ + size_);
+}
+
+inline VariantMap::ConstIterator VariantMap::Find(ShortStringHash key) const
+{
+    unsigned index = LowerBound(key);
+    return ConstIterator(index < size_ && pairs_[index]->first_ == key ? pairs_ + index : pairs_ + size_);
+}
+
+inline bool VariantMap::Contains(ShortStringHash key) const
+{
+    unsigned index = LowerBound(key);
+    return index < size_ && pairs_[index]->first_ == key;
+}
+
+inline VariantMap::Iterator VariantMap::Begin() { return Iterator(pairs_); }
+inline VariantMap::ConstIterator VariantMap::Begin() const { return ConstIterator(pairs_); }
+inline VariantMap::Iterator VariantMap::End() { return Iterator(pairs_ + size_); }
+inline VariantMap::ConstIterator VariantMap::End() const { return ConstIterator(pairs_ + size_); }
+inline const ShortStringHash& VariantMap::Front() const { return pairs_[0]->first_; }
+inline const ShortStringHash& VariantMap::Back() const { return pairs_[size_ - 1]->first_; }
+
+/// %Variant map with storage for a fixed number of pairs inside the object, so that it can be filled on the stack without memory allocation, for example for event parameters. More pairs are stored on the heap. Can be used wherever a VariantMap is expected.
+template <unsigned N> class InlineVariantMap : public VariantMap
+{
+public:
+    /// Construct empty.
+    InlineVariantMap() :
+        VariantMap(inlinePairs_, reinterpret_cast<KeyValue*>(storage_), N)
+    {
+    }
+    
+    /// Construct from another map.
+    InlineVariantMap(const VariantMap& map) :
+        VariantMap(inlinePairs_, reinterpret_cast<KeyValue*>(storage_), N)
+    {
+        VariantMap::operator = (map);
+    }
+    
+    /// Construct from another inline map.
+    InlineVariantMap(const InlineVariantMap<N>& map) :
+        VariantMap(inlinePairs_, reinterpret_cast<KeyValue*>(storage_), N)
+    {
+        VariantMap::operator = (map);
+    }
+    
+    /// Destruct. Destroy the pairs while the storage still exists.
+    ~InlineVariantMap()
+    {
+        Clear();
+    }
+    
+    /// Assign a map.
+    InlineVariantMap<N>& operator = (const VariantMap& rhs)
+    {
+        VariantMap::operator = (rhs);
+        return *this;
+    }
+    
+    /// Assign an inline map.
+    InlineVariantMap<N>& operator = (const InlineVariantMap<N>& rhs)
+    {
+        VariantMap::operator = (rhs);
+        return *this;
+    }
+    
+private:
+    /// Pointer array for the pairs.
+    KeyValue* inlinePairs_[N];
+    /// Storage for the pairs, aligned for pointers.
+    void* storage_[(N * sizeof(KeyValue) + sizeof(void*) - 1) / sizeof(void*)];
+};
+
 }
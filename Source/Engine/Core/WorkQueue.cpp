@@ -71,7 +71,10 @@ WorkQueue::WorkQueue(Context* context) :
     tolerance_(10),
     lastSize_(0)
 {
+    frameAllocators_.Push(new FrameAllocator());
+    
     SubscribeToEvent(E_BEGINFRAME, HANDLER(WorkQueue, HandleBeginFrame));
+    SubscribeToEvent(E_ENDFRAME, HANDLER(WorkQueue, HandleEndFrame));
 }
 
 WorkQueue::~WorkQueue()
@@ -82,6 +85,9 @@ WorkQueue::~WorkQueue()
     
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+    
+    for (unsigned i = 0; i < frameAllocators_.Size(); ++i)
+        delete frameAllocators_[i];
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -96,6 +102,8 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     
     for (unsigned i = 0; i < numThreads; ++i)
     {
+        frameAllocators_.Push(new FrameAllocator());
+        
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
         thread->Run();
         threads_.Push(thread);
@@ -357,4 +365,10 @@ void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     PurgePool();
 }
 
+void WorkQueue::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    for (unsigned i = 0; i < frameAllocators_.Size(); ++i)
+        frameAllocators_[i]->Reset();
+}
+
 }
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "FrameAllocator.h"
 #include "List.h"
 #include "Mutex.h"
 #include "Object.h"
@@ -105,6 +106,8 @@ public:
     bool IsCompleted(unsigned priority) const;
     /// Return the pool tolerance.
     int GetTolerance() const { return tolerance_; }
+    /// Return the frame allocator of a thread (0 = main thread.) It is reset at the end of each frame, so it may only be used for work that completes within the frame.
+    FrameAllocator* GetFrameAllocator(unsigned threadIndex) const { return threadIndex < frameAllocators_.Size() ? frameAllocators_[threadIndex] : 0; }
     
 private:
     /// Process work items until shut down. Called by the worker threads.
@@ -115,6 +118,8 @@ private:
     void PurgePool();
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event. Reset the frame allocators.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
     
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
@@ -124,6 +129,8 @@ private:
     List<SharedPtr<WorkItem> > workItems_;
     /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
     List<WorkItem*> queue_;
+    /// Frame allocators for the main thread and the worker threads.
+    PODVector<FrameAllocator*> frameAllocators_;
     /// Worker queue mutex.
     Mutex queueMutex_;
     /// Shutting down flag.
@@ -84,6 +84,11 @@ void Application::ErrorExit(const String& message)
     engine_->Exit(); // Close the rendering window
     exitCode_ = EXIT_FAILURE;
 
+    // Deliver the queued log messages now, as no more frames will begin
+    Log* log = GetSubsystem<Log>();
+    if (log)
+        log->Flush();
+
     // Only for WIN32, otherwise the error messages would be double posted on Mac OS X and Linux platforms
     if (!message.Length())
     {
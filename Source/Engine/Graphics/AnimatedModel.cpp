@@ -109,6 +109,13 @@ bool AnimatedModel::Load(Deserializer& source, bool setInstanceDefault)
     return success;
 }
 
+void AnimatedModel::SetFlatAttributes(const FlatSceneTypeInfo& type, const Variant* values)
+{
+    loading_ = true;
+    Component::SetFlatAttributes(type, values);
+    loading_ = false;
+}
+
 bool AnimatedModel::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
     loading_ = true;
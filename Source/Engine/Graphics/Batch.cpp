@@ -25,6 +25,7 @@
 #include "Geometry.h"
 #include "Graphics.h"
 #include "GraphicsImpl.h"
+#include "Light.h"
 #include "Material.h"
 #include "Node.h"
 #include "Renderer.h"
@@ -38,33 +39,62 @@
 #include "View.h"
 #include "Zone.h"
 
+#include <cstring>
+
 #include "DebugNew.h"
 
 namespace Urho3D
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
-{
-    if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
-}
-
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Convert a float to an unsigned integer with the same sorting order.
+inline unsigned FloatToSortKey(float value)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned bits = *((unsigned*)&value);
+    return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Sort by key with a stable LSD radix sort, 8 bits per pass. Passes in which all keys share the digit are skipped, so short
+/// keys only cost as many passes as they have significant bytes.
+static void RadixSort(PODVector<BatchSortItem>& items, PODVector<BatchSortItem>& scratch)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned count = items.Size();
+    if (count < 2)
+        return;
+    
+    unsigned histograms[8][256];
+    memset(histograms, 0, sizeof histograms);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned long long key = items[i].key_;
+        for (unsigned j = 0; j < 8; ++j)
+            ++histograms[j][(key >> (j * 8)) & 0xff];
+    }
+    
+    scratch.Resize(count);
+    
+    for (unsigned j = 0; j < 8; ++j)
+    {
+        unsigned* histogram = histograms[j];
+        unsigned shift = j * 8;
+        if (histogram[(items[0].key_ >> shift) & 0xff] == count)
+            continue;
+        
+        // Convert counts to output offsets
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            unsigned digitCount = histogram[k];
+            histogram[k] = offset;
+            offset += digitCount;
+        }
+        
+        const BatchSortItem* src = &items[0];
+        BatchSortItem* dest = &scratch[0];
+        for (unsigned k = 0; k < count; ++k)
+            dest[histogram[(src[k].key_ >> shift) & 0xff]++] = src[k];
+        
+        items.Swap(scratch);
+    }
 }
 
 inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
@@ -156,15 +186,20 @@ void CalculateSpotMatrix(Matrix4& dest, Light* light, const Vector3& translation
 
 void Batch::CalculateSortKey()
 {
-    unsigned shaderID = ((*((unsigned*)&vertexShader_) / sizeof(ShaderVariation)) + (*((unsigned*)&pixelShader_) / sizeof(ShaderVariation))) & 0x3fff;
+    // Use the resources' creation order IDs instead of their addresses. The IDs are truncated to their key fields, so different
+    // states may share a key; they are then just not grouped together. The creation order can depend on the timing of
+    // background loading, so the order is only guaranteed to stay the same within a run
+    unsigned vertexShaderID = vertexShader_ ? vertexShader_->GetSortID() : 0;
+    unsigned pixelShaderID = pixelShader_ ? pixelShader_->GetSortID() : 0;
+    unsigned shaderID = ((vertexShaderID << 7) ^ pixelShaderID) & 0x3fff;
     if (!isBase_)
         shaderID |= 0x8000;
     if (pass_ && pass_->GetAlphaMask())
         shaderID |= 0x4000;
     
-    unsigned lightQueueID = (*((unsigned*)&lightQueue_) / sizeof(LightBatchQueue)) & 0xffff;
-    unsigned materialID = (*((unsigned*)&material_) / sizeof(Material)) & 0xffff;
-    unsigned geometryID = (*((unsigned*)&geometry_) / sizeof(Geometry)) & 0xffff;
+    unsigned lightQueueID = lightQueue_ && lightQueue_->light_ ? lightQueue_->light_->GetID() & 0xffff : 0;
+    unsigned materialID = material_ ? material_->GetSortID() & 0xffff : 0;
+    unsigned geometryID = geometry_ ? geometry_->GetSortID() & 0xffff : 0;
     
     sortKey_ = (((unsigned long long)shaderID) << 48) | (((unsigned long long)lightQueueID) << 32) |
         (((unsigned long long)materialID) << 16) | geometryID;
@@ -588,6 +623,10 @@ void Batch::Prepare(View* view, bool setModelTransform) const
             graphics->SetTexture(TU_LIGHTSHAPE, shapeTexture);
         }
     }
+    
+    // Set the light cluster texture for clustered forward lighting
+    if (clusteredLights_ && graphics->HasTextureUnit(TU_LIGHTCLUSTERS))
+        graphics->SetTexture(TU_LIGHTCLUSTERS, renderer->GetLightClusterTexture());
 }
 
 void Batch::Draw(View* view) const
@@ -602,7 +641,7 @@ void Batch::Draw(View* view) const
 void BatchGroup::SetTransforms(void* lockedData, unsigned& freeIndex)
 {
     // Do not use up buffer space if not going to draw as instanced
-    if (geometryType_ != GEOM_INSTANCED)
+    if (geometryType_ != GEOM_INSTANCED && geometryType_ != GEOM_SKINNED_INSTANCED)
         return;
     
     startIndex_ = freeIndex;
@@ -624,7 +663,7 @@ void BatchGroup::Draw(View* view) const
     {
         // Draw as individual objects if instancing not supported
         VertexBuffer* instanceBuffer = renderer->GetInstancingBuffer();
-        if (!instanceBuffer || geometryType_ != GEOM_INSTANCED)
+        if (!instanceBuffer || (geometryType_ != GEOM_INSTANCED && geometryType_ != GEOM_SKINNED_INSTANCED))
         {
             Batch::Prepare(view, false);
             
@@ -634,7 +673,15 @@ void BatchGroup::Draw(View* view) const
             for (unsigned i = 0; i < instances_.Size(); ++i)
             {
                 if (graphics->NeedParameterUpdate(SP_OBJECTTRANSFORM, instances_[i].worldTransform_))
-                    graphics->SetShaderParameter(VSP_MODEL, *instances_[i].worldTransform_);
+                {
+                    if (geometryType_ == GEOM_SKINNED)
+                    {
+                        graphics->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(instances_[i].worldTransform_),
+                            12 * numWorldTransforms_);
+                    }
+                    else
+                        graphics->SetShaderParameter(VSP_MODEL, *instances_[i].worldTransform_);
+                }
                 
                 graphics->Draw(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
                     geometry_->GetVertexStart(), geometry_->GetVertexCount());
@@ -644,6 +691,10 @@ void BatchGroup::Draw(View* view) const
         {
             Batch::Prepare(view, false);
             
+            // Skinned instances fetch their skin matrices from the skinning texture
+            if (geometryType_ == GEOM_SKINNED_INSTANCED)
+                graphics->SetTexture(TU_SKINMATRICES, renderer->GetSkinningTexture());
+            
             // Get the geometry vertex buffers, then add the instancing stream buffer
             // Hack: use a const_cast to avoid dynamic allocation of new temp vectors
             Vector<SharedPtr<VertexBuffer> >& vertexBuffers = const_cast<Vector<SharedPtr<VertexBuffer> >&>
@@ -714,32 +765,45 @@ void BatchQueue::Clear(int maxSortedInstances)
 
 void BatchQueue::SortBackToFront()
 {
-    sortedBatches_.Resize(batches_.Size());
+    unsigned count = batches_.Size();
     
-    for (unsigned i = 0; i < batches_.Size(); ++i)
-        sortedBatches_[i] = &batches_[i];
+    // Sort by state first, then by descending distance. The radix sort is stable, so batches at equal distance remain
+    // in state order
+    sortItems_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        sortItems_[i].key_ = batches_[i].sortKey_;
+        sortItems_[i].index_ = i;
+    }
+    RadixSort(sortItems_, sortScratch_);
+    
+    for (unsigned i = 0; i < count; ++i)
+        sortItems_[i].key_ = ~FloatToSortKey(batches_[sortItems_[i].index_].distance_);
+    RadixSort(sortItems_, sortScratch_);
     
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    sortedBatches_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        sortedBatches_[i] = &batches_[sortItems_[i].index_];
     
     // Do not actually sort batch groups, just list them
     sortedBatchGroups_.Resize(batchGroups_.Size());
     
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 }
 
 void BatchQueue::SortFrontToBack()
 {
-    sortedBatches_.Clear();
+    sortedBatches_.Resize(batches_.Size());
     
     for (unsigned i = 0; i < batches_.Size(); ++i)
-        sortedBatches_.Push(&batches_[i]);
+        sortedBatches_[i] = &batches_[i];
     
     SortFrontToBack2Pass(sortedBatches_);
     
     // Sort each group front to back
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
         if (i->second_.instances_.Size() <= maxSortedInstances_)
         {
@@ -750,7 +814,7 @@ void BatchQueue::SortFrontToBack()
         else
         {
             float minDistance = M_INFINITY;
-            for (PODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (FramePODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
             i->second_.distance_ = minDistance;
         }
@@ -759,7 +823,7 @@ void BatchQueue::SortFrontToBack()
     sortedBatchGroups_.Resize(batchGroups_.Size());
     
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
     
     SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
@@ -767,24 +831,37 @@ void BatchQueue::SortFrontToBack()
 
 void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
 {
-    // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
-    // method is also time consuming, so just sort with state having priority
+    unsigned count = batches.Size();
+    if (count < 2)
+        return;
+    
+    // First sort by distance
+    sortItems_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        sortItems_[i].key_ = FloatToSortKey(batches[i]->distance_);
+        sortItems_[i].index_ = i;
+    }
+    RadixSort(sortItems_, sortScratch_);
+    
+    // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The remapping
+    // is also time consuming, so just sort with state having priority
     #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    for (unsigned i = 0; i < count; ++i)
+        sortItems_[i].key_ = batches[sortItems_[i].index_]->sortKey_;
     #else
-    // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
-    
+    // For desktop, remap shader/material/geometry IDs in the order of distance, so that the state sort keeps the
+    // state groups closest to the camera first
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
     unsigned short freeGeometryID = 0;
     
-    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    for (unsigned i = 0; i < count; ++i)
     {
-        Batch* batch = *i;
+        Batch* batch = batches[sortItems_[i].index_];
         
-        unsigned shaderID = (batch->sortKey_ >> 32);
-        HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
+        unsigned shaderID = (unsigned)(batch->sortKey_ >> 32);
+        FlatHashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
         if (j != shaderRemapping_.End())
             shaderID = j->second_;
         else
@@ -793,8 +870,8 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
             ++freeShaderID;
         }
         
-        unsigned short materialID = (unsigned short)(batch->sortKey_ & 0xffff0000);
-        HashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
+        unsigned short materialID = (unsigned short)(batch->sortKey_ >> 16);
+        FlatHashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
         if (k != materialRemapping_.End())
             materialID = k->second_;
         else
@@ -804,7 +881,7 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
         }
         
         unsigned short geometryID = (unsigned short)(batch->sortKey_ & 0xffff);
-        HashMap<unsigned short, unsigned short>::ConstIterator l = geometryRemapping_.Find(geometryID);
+        FlatHashMap<unsigned short, unsigned short>::ConstIterator l = geometryRemapping_.Find(geometryID);
         if (l != geometryRemapping_.End())
             geometryID = l->second_;
         else
@@ -813,21 +890,26 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
             ++freeGeometryID;
         }
         
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32) || (((unsigned long long)materialID) << 16) | geometryID;
+        sortItems_[i].key_ = (((unsigned long long)shaderID) << 32) | (((unsigned long long)materialID) << 16) | geometryID;
     }
     
     shaderRemapping_.Clear();
     materialRemapping_.Clear();
     geometryRemapping_.Clear();
-    
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
     #endif
+    
+    // Finally sort by state. Batches with equal state remain in distance order
+    RadixSort(sortItems_, sortScratch_);
+    
+    batchScratch_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        batchScratch_[i] = batches[sortItems_[i].index_];
+    batches.Swap(batchScratch_);
 }
 
 void BatchQueue::SetTransforms(void* lockedData, unsigned& freeIndex)
 {
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         i->second_.SetTransforms(lockedData, freeIndex);
 }
 
@@ -878,9 +960,9 @@ unsigned BatchQueue::GetNumInstances() const
 {
     unsigned total = 0;
     
-    for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
-       if (i->second_.geometryType_ == GEOM_INSTANCED)
+       if (i->second_.geometryType_ == GEOM_INSTANCED || i->second_.geometryType_ == GEOM_SKINNED_INSTANCED)
             total += i->second_.instances_.Size();
     }
     
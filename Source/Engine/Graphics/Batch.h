@@ -23,6 +23,8 @@
 #pragma once
 
 #include "Drawable.h"
+#include "FlatHashMap.h"
+#include "FrameAllocator.h"
 #include "MathDefs.h"
 #include "Matrix3x4.h"
 #include "Ptr.h"
@@ -44,6 +46,7 @@ class VertexBuffer;
 class View;
 class Zone;
 struct LightBatchQueue;
+struct ShadowMapCache;
 
 /// Queued 3D geometry draw call.
 struct Batch
@@ -51,7 +54,8 @@ struct Batch
     /// Construct with defaults.
     Batch() :
         lightQueue_(0),
-        isBase_(false)
+        isBase_(false),
+        clusteredLights_(false)
     {
     }
     
@@ -65,11 +69,12 @@ struct Batch
         lightQueue_(0),
         geometryType_(rhs.geometryType_),
         overrideView_(rhs.overrideView_),
-        isBase_(false)
+        isBase_(false),
+        clusteredLights_(false)
     {
     }
     
-    /// Calculate state sorting key, which consists of base pass flag, light, pass and geometry.
+    /// Calculate state sorting key, which consists of base pass flag, shaders, light, material and geometry. The IDs are truncated to fit, so different states may share a key.
     void CalculateSortKey();
     /// Prepare for rendering.
     void Prepare(View* view, bool setModelTransform = true) const;
@@ -106,6 +111,8 @@ struct Batch
     bool overrideView_;
     /// Base batch flag. This tells to draw the object fully without light optimizations.
     bool isBase_;
+    /// Clustered lights flag. When set, the lights of the view's light clusters are added per pixel.
+    bool clusteredLights_;
     /// 8-bit light mask for stencil marking in deferred rendering.
     unsigned char lightMask_;
 };
@@ -125,7 +132,7 @@ struct InstanceData
     {
     }
     
-    /// World transform.
+    /// World transform, or the skin matrices of a skinned instance.
     const Matrix3x4* worldTransform_;
     /// Distance from camera.
     float distance_;
@@ -152,17 +159,25 @@ struct BatchGroup : public Batch
     {
     }
     
-    /// Add world transform(s) from a batch.
+    /// Add world transform(s) from a batch. The skin matrices of a skinned batch form a single instance.
     void AddTransforms(const Batch& batch)
     {
         InstanceData newInstance;
         newInstance.distance_ = batch.distance_;
         
-        for (unsigned i = 0; i < batch.numWorldTransforms_; ++i)
+        if (batch.geometryType_ == GEOM_SKINNED_INSTANCED)
         {
-            newInstance.worldTransform_ = &batch.worldTransform_[i];
+            newInstance.worldTransform_ = batch.worldTransform_;
             instances_.Push(newInstance);
         }
+        else
+        {
+            for (unsigned i = 0; i < batch.numWorldTransforms_; ++i)
+            {
+                newInstance.worldTransform_ = &batch.worldTransform_[i];
+                instances_.Push(newInstance);
+            }
+        }
     }
     
     /// Pre-set the instance transforms. Buffer must be big enough to hold all transforms.
@@ -170,8 +185,8 @@ struct BatchGroup : public Batch
     /// Prepare and draw.
     void Draw(View* view) const;
     
-    /// Instance data.
-    PODVector<InstanceData> instances_;
+    /// Instance data. Allocated from the frame allocator of the thread that created the group.
+    FramePODVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -214,6 +229,15 @@ struct BatchGroupKey
     unsigned ToHash() const;
 };
 
+/// Batch sort key and index for radix sorting.
+struct BatchSortItem
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Index of the batch in the array being sorted.
+    unsigned index_;
+};
+
 /// Queue that contains both instanced and non-instanced draw calls.
 struct BatchQueue
 {
@@ -224,7 +248,7 @@ public:
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
     void SortFrontToBack();
-    /// Sort batches front to back while also maintaining state sorting.
+    /// Sort batches front to back while also maintaining state sorting. Uses a radix sort that is stable for equal keys.
     void SortFrontToBack2Pass(PODVector<Batch*>& batches);
     /// Pre-set instance transforms of all groups. The vertex buffer must be big enough to hold all transforms.
     void SetTransforms(void* lockedData, unsigned& freeIndex);
@@ -236,13 +260,19 @@ public:
     bool IsEmpty() const { return batches_.Empty() && batchGroups_.Empty(); }
     
     /// Instanced draw calls.
-    HashMap<BatchGroupKey, BatchGroup> batchGroups_;
+    FlatHashMap<BatchGroupKey, BatchGroup> batchGroups_;
     /// Shader remapping table for 2-pass state and distance sort.
-    HashMap<unsigned, unsigned> shaderRemapping_;
+    FlatHashMap<unsigned, unsigned> shaderRemapping_;
     /// Material remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> materialRemapping_;
+    FlatHashMap<unsigned short, unsigned short> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> geometryRemapping_;
+    FlatHashMap<unsigned short, unsigned short> geometryRemapping_;
+    /// Sort keys and indices.
+    PODVector<BatchSortItem> sortItems_;
+    /// Scratch buffer for the radix sort.
+    PODVector<BatchSortItem> sortScratch_;
+    /// Scratch buffer for reordering sorted batch pointers.
+    PODVector<Batch*> batchScratch_;
     
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
@@ -276,6 +306,8 @@ struct LightBatchQueue
     Light* light_;
     /// Shadow map depth texture.
     Texture2D* shadowMap_;
+    /// Shadow map cache if the shadow map is cached between frames.
+    ShadowMapCache* shadowMapCache_;
     /// Lit geometry draw calls, base (replace blend mode)
     BatchQueue litBaseBatches_;
     /// Lit geometry draw calls, non-base (additive)
@@ -69,10 +69,10 @@ BillboardSet::BillboardSet(Context* context) :
     scaled_(true),
     sorted_(false),
     faceCameraMode_(FC_ROTATE_XYZ),
-    geometry_(new Geometry(context)),
     vertexBuffer_(new VertexBuffer(context_)),
-    indexBuffer_(new IndexBuffer(context_)),
     bufferSizeDirty_(true),
+    geometry_(new Geometry(context)),
+    indexBuffer_(new IndexBuffer(context_)),
     bufferDirty_(true),
     forceUpdate_(false),
     sortFrameNumber_(0),
@@ -405,7 +405,7 @@ void BillboardSet::OnWorldBoundingBoxUpdate()
 
 void BillboardSet::UpdateBufferSize()
 {
-    unsigned numBillboards = billboards_.Size();
+    unsigned numBillboards = GetBufferCapacity();
     
     if (vertexBuffer_->GetVertexCount() != numBillboards * 4)
         vertexBuffer_->SetSize(numBillboards * 4, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1 | MASK_TEXCOORD2, true);
@@ -440,19 +440,8 @@ void BillboardSet::UpdateBufferSize()
 
 void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
 {
-    // If using animation LOD, accumulate time and see if it is time to update
-    if (animationLodBias_ > 0.0f && lodDistance_ > 0.0f)
-    {
-        animationLodTimer_ += animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
-        if (animationLodTimer_ >= lodDistance_)
-            animationLodTimer_ = fmodf(animationLodTimer_, lodDistance_);
-        else
-        {
-            // No LOD if immediate update forced
-            if (!forceUpdate_)
-                return;
-        }
-    }
+    if (!CheckVertexBufferUpdate(frame))
+        return;
     
     unsigned numBillboards = billboards_.Size();
     unsigned enabledBillboards = 0;
@@ -484,8 +473,6 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     
     batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, enabledBillboards * 6, false);
     
-    bufferDirty_ = false;
-    forceUpdate_ = false;
     if (!enabledBillboards)
         return;
     
@@ -501,45 +488,70 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
         Billboard& billboard = *sortedBillboards_[i];
         
         Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-        unsigned color = billboard.color_.ToUInt();
-        
-        float rotationMatrix[2][2];
-        rotationMatrix[0][0] = Cos(billboard.rotation_);
-        rotationMatrix[0][1] = Sin(billboard.rotation_);
-        rotationMatrix[1][0] = -rotationMatrix[0][1];
-        rotationMatrix[1][1] = rotationMatrix[0][0];
-        
-        dest[0] = billboard.position_.x_; dest[1] = billboard.position_.y_; dest[2] = billboard.position_.z_;
-        ((unsigned&)dest[3]) = color;
-        dest[4] = billboard.uv_.min_.x_; dest[5] = billboard.uv_.min_.y_;
-        dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-        dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-        
-        dest[8] = billboard.position_.x_; dest[9] = billboard.position_.y_; dest[10] = billboard.position_.z_;
-        ((unsigned&)dest[11]) = color;
-        dest[12] = billboard.uv_.max_.x_; dest[13] = billboard.uv_.min_.y_;
-        dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-        dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-        
-        dest[16] = billboard.position_.x_; dest[17] = billboard.position_.y_; dest[18] = billboard.position_.z_;
-        ((unsigned&)dest[19]) = color;
-        dest[20] = billboard.uv_.max_.x_; dest[21] = billboard.uv_.max_.y_;
-        dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-        dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-        
-        dest[24] = billboard.position_.x_; dest[25] = billboard.position_.y_; dest[26] = billboard.position_.z_;
-        ((unsigned&)dest[27]) = color;
-        dest[28] = billboard.uv_.min_.x_; dest[29] = billboard.uv_.max_.y_;
-        dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-        dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-        dest += 32;
+        dest = WriteBillboardVertices(dest, billboard.position_, size, billboard.uv_, billboard.color_.ToUInt(), billboard.rotation_);
     }
     
     vertexBuffer_->Unlock();
     vertexBuffer_->ClearDataLost();
 }
 
+bool BillboardSet::CheckVertexBufferUpdate(const FrameInfo& frame)
+{
+    // If using animation LOD, accumulate time and see if it is time to update
+    if (animationLodBias_ > 0.0f && lodDistance_ > 0.0f)
+    {
+        animationLodTimer_ += animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
+        if (animationLodTimer_ >= lodDistance_)
+            animationLodTimer_ = fmodf(animationLodTimer_, lodDistance_);
+        else
+        {
+            // No LOD if immediate update forced
+            if (!forceUpdate_)
+                return false;
+        }
+    }
+    
+    bufferDirty_ = false;
+    forceUpdate_ = false;
+    return true;
+}
+
+float* BillboardSet::WriteBillboardVertices(float* dest, const Vector3& position, const Vector2& size, const Rect& uv, unsigned color,
+    float rotation)
+{
+    float rotationMatrix[2][2];
+    rotationMatrix[0][0] = Cos(rotation);
+    rotationMatrix[0][1] = Sin(rotation);
+    rotationMatrix[1][0] = -rotationMatrix[0][1];
+    rotationMatrix[1][1] = rotationMatrix[0][0];
+    
+    dest[0] = position.x_; dest[1] = position.y_; dest[2] = position.z_;
+    ((unsigned&)dest[3]) = color;
+    dest[4] = uv.min_.x_; dest[5] = uv.min_.y_;
+    dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+    dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+    
+    dest[8] = position.x_; dest[9] = position.y_; dest[10] = position.z_;
+    ((unsigned&)dest[11]) = color;
+    dest[12] = uv.max_.x_; dest[13] = uv.min_.y_;
+    dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+    dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+    
+    dest[16] = position.x_; dest[17] = position.y_; dest[18] = position.z_;
+    ((unsigned&)dest[19]) = color;
+    dest[20] = uv.max_.x_; dest[21] = uv.max_.y_;
+    dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+    dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+    
+    dest[24] = position.x_; dest[25] = position.y_; dest[26] = position.z_;
+    ((unsigned&)dest[27]) = color;
+    dest[28] = uv.min_.x_; dest[29] = uv.max_.y_;
+    dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+    dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+    
+    return dest + 32;
+}
+
 void BillboardSet::MarkPositionsDirty()
 {
     Drawable::OnMarkedDirty(node_);
@@ -131,6 +131,14 @@ protected:
     virtual void OnWorldBoundingBoxUpdate();
     /// Mark billboard vertex buffer to need an update.
     void MarkPositionsDirty();
+    /// Return number of billboards the vertex and index buffers should have room for.
+    virtual unsigned GetBufferCapacity() const { return billboards_.Size(); }
+    /// Rewrite billboard vertex buffer.
+    virtual void UpdateVertexBuffer(const FrameInfo& frame);
+    /// Advance the animation LOD timer and clear the vertex buffer dirty state if it should be rewritten now. Return true if should rewrite.
+    bool CheckVertexBufferUpdate(const FrameInfo& frame);
+    /// Write the four vertices of one billboard and return the destination pointer after them.
+    static float* WriteBillboardVertices(float* dest, const Vector3& position, const Vector2& size, const Rect& uv, unsigned color, float rotation);
     
     /// Billboards.
     PODVector<Billboard> billboards_;
@@ -148,23 +156,21 @@ protected:
     bool sorted_;
     /// Billboard rotation mode in relation to the camera.
     FaceCameraMode faceCameraMode_;
+    /// Vertex buffer.
+    SharedPtr<VertexBuffer> vertexBuffer_;
+    /// Buffers need resize flag.
+    bool bufferSizeDirty_;
     
 private:
     /// Resize billboard vertex and index buffers.
     void UpdateBufferSize();
-    /// Rewrite billboard vertex buffer.
-    void UpdateVertexBuffer(const FrameInfo& frame);
     
     /// Geometry.
     SharedPtr<Geometry> geometry_;
-    /// Vertex buffer.
-    SharedPtr<VertexBuffer> vertexBuffer_;
     /// Index buffer.
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Transform matrices for position and billboard orientation.
     Matrix3x4 transforms_[2];
-    /// Buffers need resize flag.
-    bool bufferSizeDirty_;
     /// Vertex buffer needs rewrite flag.
     bool bufferDirty_;
     /// Force update flag (ignore animation LOD momentarily.)
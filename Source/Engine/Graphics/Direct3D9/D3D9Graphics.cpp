@@ -228,6 +228,7 @@ Graphics::Graphics(Context* context) :
     deferredSupport_(false),
     hardwareShadowSupport_(false),
     streamOffsetSupport_(false),
+    vertexTextureSupport_(false),
     sRGBSupport_(false),
     sRGBWriteSupport_(false),
     hasSM3_(false),
@@ -1452,12 +1453,15 @@ void Graphics::SetTexture(unsigned index, Texture* texture)
             texture = texture->GetBackupTexture();
     }
     
+    // Textures for the vertex shader are bound to the separate vertex texture sampler
+    DWORD sampler = index == TU_SKINMATRICES ? D3DVERTEXTEXTURESAMPLER0 : index;
+    
     if (texture != textures_[index])
     {
         if (texture)
-            impl_->device_->SetTexture(index, (IDirect3DBaseTexture9*)texture->GetGPUObject());
+            impl_->device_->SetTexture(sampler, (IDirect3DBaseTexture9*)texture->GetGPUObject());
         else
-            impl_->device_->SetTexture(index, 0);
+            impl_->device_->SetTexture(sampler, 0);
         
         textures_[index] = texture;
     }
@@ -1472,27 +1476,27 @@ void Graphics::SetTexture(unsigned index, Texture* texture)
         minMag = d3dMinMagFilter[filterMode];
         if (minMag != impl_->minMagFilters_[index])
         {
-            impl_->device_->SetSamplerState(index, D3DSAMP_MAGFILTER, minMag);
-            impl_->device_->SetSamplerState(index, D3DSAMP_MINFILTER, minMag);
+            impl_->device_->SetSamplerState(sampler, D3DSAMP_MAGFILTER, minMag);
+            impl_->device_->SetSamplerState(sampler, D3DSAMP_MINFILTER, minMag);
             impl_->minMagFilters_[index] = minMag;
         }
         mip = d3dMipFilter[filterMode];
         if (mip != impl_->mipFilters_[index])
         {
-            impl_->device_->SetSamplerState(index, D3DSAMP_MIPFILTER, mip);
+            impl_->device_->SetSamplerState(sampler, D3DSAMP_MIPFILTER, mip);
             impl_->mipFilters_[index] = mip;
         }
         D3DTEXTUREADDRESS u, v;
         u = d3dAddressMode[texture->GetAddressMode(COORD_U)];
         if (u != impl_->uAddressModes_[index])
         {
-            impl_->device_->SetSamplerState(index, D3DSAMP_ADDRESSU, u);
+            impl_->device_->SetSamplerState(sampler, D3DSAMP_ADDRESSU, u);
             impl_->uAddressModes_[index] = u;
         }
         v = d3dAddressMode[texture->GetAddressMode(COORD_V)];
         if (v != impl_->vAddressModes_[index])
         {
-            impl_->device_->SetSamplerState(index, D3DSAMP_ADDRESSV, v);
+            impl_->device_->SetSamplerState(sampler, D3DSAMP_ADDRESSV, v);
             impl_->vAddressModes_[index] = v;
         }
         if (texture->GetType() == TextureCube::GetTypeStatic())
@@ -1500,7 +1504,7 @@ void Graphics::SetTexture(unsigned index, Texture* texture)
             D3DTEXTUREADDRESS w = d3dAddressMode[texture->GetAddressMode(COORD_W)];
             if (w != impl_->wAddressModes_[index])
             {
-                impl_->device_->SetSamplerState(index, D3DSAMP_ADDRESSW, w);
+                impl_->device_->SetSamplerState(sampler, D3DSAMP_ADDRESSW, w);
                 impl_->wAddressModes_[index] = w;
             }
         }
@@ -1509,7 +1513,7 @@ void Graphics::SetTexture(unsigned index, Texture* texture)
             const Color& borderColor = texture->GetBorderColor();
             if (borderColor != impl_->borderColors_[index])
             {
-                impl_->device_->SetSamplerState(index, D3DSAMP_BORDERCOLOR, GetD3DColor(borderColor));
+                impl_->device_->SetSamplerState(sampler, D3DSAMP_BORDERCOLOR, GetD3DColor(borderColor));
                 impl_->borderColors_[index] = borderColor;
             }
         }
@@ -1518,7 +1522,7 @@ void Graphics::SetTexture(unsigned index, Texture* texture)
             bool sRGB = texture->GetSRGB();
             if (sRGB != impl_->sRGBModes_[index])
             {
-                impl_->device_->SetSamplerState(index, D3DSAMP_SRGBTEXTURE, sRGB ? TRUE : FALSE);
+                impl_->device_->SetSamplerState(sampler, D3DSAMP_SRGBTEXTURE, sRGB ? TRUE : FALSE);
                 impl_->sRGBModes_[index] = sRGB;
             }
         }
@@ -2540,6 +2544,7 @@ void Graphics::CheckFeatureSupport()
     deferredSupport_ = false;
     hardwareShadowSupport_ = false;
     streamOffsetSupport_ = false;
+    vertexTextureSupport_ = false;
     hasSM3_ = false;
     depthStencilFormat = D3DFMT_D24S8;
     
@@ -2614,6 +2619,10 @@ void Graphics::CheckFeatureSupport()
     if (impl_->deviceCaps_.DevCaps2 & D3DDEVCAPS2_STREAMOFFSET)
         streamOffsetSupport_ = true;
     
+    // Check for floating point vertex texture fetch (needed for skinned instancing)
+    if (hasSM3_ && impl_->CheckFormatSupport(D3DFMT_A32B32G32R32F, D3DUSAGE_QUERY_VERTEXTEXTURE, D3DRTYPE_TEXTURE))
+        vertexTextureSupport_ = true;
+    
     // Check for sRGB read & write
     /// \todo Should be checked for each texture format separately
     sRGBSupport_ = impl_->CheckFormatSupport(D3DFMT_X8R8G8B8, D3DUSAGE_QUERY_SRGBREAD, D3DRTYPE_TEXTURE);
@@ -2754,6 +2763,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["FaceSelectCubeMap"] = TU_FACESELECT;
     textureUnits_["IndirectionCubeMap"] = TU_INDIRECTION;
     textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
+    textureUnits_["SkinMatrices"] = TU_SKINMATRICES;
+    textureUnits_["LightClusters"] = TU_LIGHTCLUSTERS;
 }
 
 void RegisterGraphicsLibrary(Context* context)
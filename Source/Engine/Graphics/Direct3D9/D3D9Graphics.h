@@ -280,6 +280,8 @@ public:
     bool GetHardwareShadowSupport() const { return hardwareShadowSupport_; }
     /// Return whether stream offset is supported.
     bool GetStreamOffsetSupport() const { return streamOffsetSupport_; }
+    /// Return whether floating point textures can be sampled in vertex shaders.
+    bool GetVertexTextureSupport() const { return vertexTextureSupport_; }
     /// Return whether sRGB conversion on texture sampling is supported.
     bool GetSRGBSupport() const { return sRGBSupport_; }
     /// Return whether sRGB conversion on rendertarget writing is supported.
@@ -481,6 +483,8 @@ private:
     bool hardwareShadowSupport_;
     /// Stream offset support flag.
     bool streamOffsetSupport_;
+    /// Vertex texture fetch support flag.
+    bool vertexTextureSupport_;
     /// sRGB conversion on read support flag.
     bool sRGBSupport_;
     /// sRGB conversion on write support flag.
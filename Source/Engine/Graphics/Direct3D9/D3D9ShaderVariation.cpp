@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "File.h"
 #include "FileSystem.h"
 #include "Graphics.h"
@@ -39,10 +40,14 @@
 namespace Urho3D
 {
 
+/// Last assigned sort ID. Incremented atomically, as objects may be constructed in background loading threads.
+static volatile int lastSortID = 0;
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_((unsigned)AtomicAddRelaxed(&lastSortID, 1))
 {
     for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
         useTextureUnit_[i] = false;
@@ -342,6 +347,10 @@ void ShaderVariation::ParseParameters(unsigned char* bufData, unsigned bufSize)
         
         if (isSampler)
         {
+            // Vertex shader samplers have their own registers, so map them to texture units by name
+            if (type_ == VS)
+                reg = graphics_->GetTextureUnit(name);
+            
             // Skip if it's a G-buffer sampler, which are aliases for the standard texture units
             if (reg < MAX_TEXTURE_UNITS)
             {
@@ -94,6 +94,8 @@ public:
     String GetFullName() const { return name_ + "(" + defines_ + ")"; }
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
+    /// Return ID for batch state sorting. Assigned in creation order, which may differ between runs.
+    unsigned GetSortID() const { return sortID_; }
     /// Return whether uses a parameter.
     bool HasParameter(StringHash param) const { return parameters_.Contains(param); }
     /// Return whether uses a texture unit (only for pixel shaders.)
@@ -123,6 +125,8 @@ private:
     String defines_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
     /// Shader parameters.
     HashMap<StringHash, ShaderParameter> parameters_;
     /// Texture unit use flags.
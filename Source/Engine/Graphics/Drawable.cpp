@@ -190,6 +190,9 @@ void Drawable::SetLightMask(unsigned mask)
 
 void Drawable::SetShadowMask(unsigned mask)
 {
+    if (mask != shadowMask_ && octant_ && castShadows_)
+        octant_->GetRoot()->MarkShadowCasterChanged(this);
+    
     shadowMask_ = mask;
     MarkNetworkUpdate();
 }
@@ -210,6 +213,9 @@ void Drawable::SetMaxLights(unsigned num)
 
 void Drawable::SetCastShadows(bool enable)
 {
+    if (enable != castShadows_ && octant_)
+        octant_->GetRoot()->MarkShadowCasterChanged(this);
+    
     castShadows_ = enable;
     MarkNetworkUpdate();
 }
@@ -372,7 +378,11 @@ void Drawable::AddToOctree()
     {
         Octree* octree = scene->GetComponent<Octree>();
         if (octree)
+        {
             octree->InsertDrawable(this);
+            if (castShadows_)
+                octree->MarkShadowCasterChanged(this);
+        }
         else
             LOGERROR("No Octree component in scene, drawable will not render");
     }
@@ -390,6 +400,7 @@ void Drawable::RemoveFromOctree()
         Octree* octree = octant_->GetRoot();
         if (updateQueued_)
             octree->CancelUpdate(this);
+        octree->MarkShadowCasterChanged(this, true);
         
         // Perform subclass specific deinitialization if necessary
         OnRemoveFromOctree();
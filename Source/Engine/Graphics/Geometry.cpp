@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Geometry.h"
 #include "Graphics.h"
 #include "IndexBuffer.h"
@@ -33,6 +34,9 @@
 namespace Urho3D
 {
 
+/// Last assigned sort ID. Incremented atomically, as objects may be constructed in background loading threads.
+static volatile int lastSortID = 0;
+
 Geometry::Geometry(Context* context) :
     Object(context),
     primitiveType_(TRIANGLE_LIST),
@@ -44,7 +48,8 @@ Geometry::Geometry(Context* context) :
     rawVertexSize_(0),
     rawElementMask_(0),
     rawIndexSize_(0),
-    lodDistance_(0.0f)
+    lodDistance_(0.0f),
+    sortID_((unsigned)AtomicAddRelaxed(&lastSortID, 1))
 {
     SetNumVertexBuffers(1);
 }
@@ -100,6 +100,8 @@ public:
     bool IsInside(const Ray& ray) const;
     /// Return whether has empty draw range.
     bool IsEmpty() const { return indexCount_ == 0 && vertexCount_ == 0; }
+    /// Return ID for batch state sorting. Assigned in creation order, which may differ between runs.
+    unsigned GetSortID() const { return sortID_; }
     
 private:
     /// Locate vertex buffer with position data.
@@ -135,6 +137,8 @@ private:
     unsigned rawIndexSize_;
     /// LOD distance.
     float lodDistance_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
 };
 
 }
@@ -22,7 +22,9 @@
 
 #pragma once
 
-#ifdef URHO3D_OPENGL
+#if defined(URHO3D_NULL_GRAPHICS)
+#include "Null/NullGraphics.h"
+#elif defined(URHO3D_OPENGL)
 #include "OpenGL/OGLGraphics.h"
 #else
 #include "Direct3D9/D3D9Graphics.h"
@@ -29,63 +29,66 @@
 namespace Urho3D
 {
 
-StringHash VSP_AMBIENTSTARTCOLOR("AmbientStartColor");
-StringHash VSP_AMBIENTENDCOLOR("AmbientEndColor");
-StringHash VSP_BILLBOARDROT("BillboardRot");
-StringHash VSP_CAMERAPOS("CameraPos");
-StringHash VSP_CAMERAROT("CameraRot");
-StringHash VSP_NEARCLIP("NearClip");
-StringHash VSP_FARCLIP("FarClip");
-StringHash VSP_DEPTHMODE("DepthMode");
-StringHash VSP_DELTATIME("DeltaTime");
-StringHash VSP_ELAPSEDTIME("ElapsedTime");
-StringHash VSP_FRUSTUMSIZE("FrustumSize");
-StringHash VSP_GBUFFEROFFSETS("GBufferOffsets");
-StringHash VSP_LIGHTDIR("LightDir");
-StringHash VSP_LIGHTPOS("LightPos");
-StringHash VSP_MODEL("Model");
-StringHash VSP_VIEWPROJ("ViewProj");
-StringHash VSP_UOFFSET("UOffset");
-StringHash VSP_VOFFSET("VOffset");
-StringHash VSP_ZONE("Zone");
-StringHash VSP_LIGHTMATRICES("LightMatrices");
-StringHash VSP_SKINMATRICES("SkinMatrices");
-StringHash VSP_VERTEXLIGHTS("VertexLights");
-StringHash PSP_AMBIENTCOLOR("AmbientColor");
-StringHash PSP_CAMERAPOS("CameraPosPS");
-StringHash PSP_DELTATIME("DeltaTimePS");
-StringHash PSP_ELAPSEDTIME("ElapsedTimePS");
-StringHash PSP_FOGCOLOR("FogColor");
-StringHash PSP_FOGPARAMS("FogParams");
-StringHash PSP_GBUFFERINVSIZE("GBufferInvSize");
-StringHash PSP_LIGHTCOLOR("LightColor");
-StringHash PSP_LIGHTDIR("LightDirPS");
-StringHash PSP_LIGHTPOS("LightPosPS");
-StringHash PSP_MATDIFFCOLOR("MatDiffColor");
-StringHash PSP_MATEMISSIVECOLOR("MatEmissiveColor");
-StringHash PSP_MATENVMAPECOLOR("MatEnvMapColor");
-StringHash PSP_MATSPECCOLOR("MatSpecColor");
-StringHash PSP_NEARCLIP("NearClipPS");
-StringHash PSP_FARCLIP("FarClipPS");
-StringHash PSP_SHADOWCUBEADJUST("ShadowCubeAdjust");
-StringHash PSP_SHADOWDEPTHFADE("ShadowDepthFade");
-StringHash PSP_SHADOWINTENSITY("ShadowIntensity");
-StringHash PSP_SHADOWMAPINVSIZE("ShadowMapInvSize");
-StringHash PSP_SHADOWSPLITS("ShadowSplits");
-StringHash PSP_LIGHTMATRICES("LightMatricesPS");
+StringHash VSP_AMBIENTSTARTCOLOR(StringHash::CalculateLiteral("AmbientStartColor"));
+StringHash VSP_AMBIENTENDCOLOR(StringHash::CalculateLiteral("AmbientEndColor"));
+StringHash VSP_BILLBOARDROT(StringHash::CalculateLiteral("BillboardRot"));
+StringHash VSP_CAMERAPOS(StringHash::CalculateLiteral("CameraPos"));
+StringHash VSP_CAMERAROT(StringHash::CalculateLiteral("CameraRot"));
+StringHash VSP_NEARCLIP(StringHash::CalculateLiteral("NearClip"));
+StringHash VSP_FARCLIP(StringHash::CalculateLiteral("FarClip"));
+StringHash VSP_DEPTHMODE(StringHash::CalculateLiteral("DepthMode"));
+StringHash VSP_DELTATIME(StringHash::CalculateLiteral("DeltaTime"));
+StringHash VSP_ELAPSEDTIME(StringHash::CalculateLiteral("ElapsedTime"));
+StringHash VSP_FRUSTUMSIZE(StringHash::CalculateLiteral("FrustumSize"));
+StringHash VSP_GBUFFEROFFSETS(StringHash::CalculateLiteral("GBufferOffsets"));
+StringHash VSP_LIGHTDIR(StringHash::CalculateLiteral("LightDir"));
+StringHash VSP_LIGHTPOS(StringHash::CalculateLiteral("LightPos"));
+StringHash VSP_MODEL(StringHash::CalculateLiteral("Model"));
+StringHash VSP_VIEWPROJ(StringHash::CalculateLiteral("ViewProj"));
+StringHash VSP_UOFFSET(StringHash::CalculateLiteral("UOffset"));
+StringHash VSP_VOFFSET(StringHash::CalculateLiteral("VOffset"));
+StringHash VSP_ZONE(StringHash::CalculateLiteral("Zone"));
+StringHash VSP_LIGHTMATRICES(StringHash::CalculateLiteral("LightMatrices"));
+StringHash VSP_SKINMATRICES(StringHash::CalculateLiteral("SkinMatrices"));
+StringHash VSP_VERTEXLIGHTS(StringHash::CalculateLiteral("VertexLights"));
+StringHash PSP_AMBIENTCOLOR(StringHash::CalculateLiteral("AmbientColor"));
+StringHash PSP_CAMERAPOS(StringHash::CalculateLiteral("CameraPosPS"));
+StringHash PSP_DELTATIME(StringHash::CalculateLiteral("DeltaTimePS"));
+StringHash PSP_ELAPSEDTIME(StringHash::CalculateLiteral("ElapsedTimePS"));
+StringHash PSP_FOGCOLOR(StringHash::CalculateLiteral("FogColor"));
+StringHash PSP_FOGPARAMS(StringHash::CalculateLiteral("FogParams"));
+StringHash PSP_GBUFFERINVSIZE(StringHash::CalculateLiteral("GBufferInvSize"));
+StringHash PSP_LIGHTCOLOR(StringHash::CalculateLiteral("LightColor"));
+StringHash PSP_LIGHTDIR(StringHash::CalculateLiteral("LightDirPS"));
+StringHash PSP_LIGHTPOS(StringHash::CalculateLiteral("LightPosPS"));
+StringHash PSP_MATDIFFCOLOR(StringHash::CalculateLiteral("MatDiffColor"));
+StringHash PSP_MATEMISSIVECOLOR(StringHash::CalculateLiteral("MatEmissiveColor"));
+StringHash PSP_MATENVMAPECOLOR(StringHash::CalculateLiteral("MatEnvMapColor"));
+StringHash PSP_MATSPECCOLOR(StringHash::CalculateLiteral("MatSpecColor"));
+StringHash PSP_NEARCLIP(StringHash::CalculateLiteral("NearClipPS"));
+StringHash PSP_FARCLIP(StringHash::CalculateLiteral("FarClipPS"));
+StringHash PSP_SHADOWCUBEADJUST(StringHash::CalculateLiteral("ShadowCubeAdjust"));
+StringHash PSP_SHADOWDEPTHFADE(StringHash::CalculateLiteral("ShadowDepthFade"));
+StringHash PSP_SHADOWINTENSITY(StringHash::CalculateLiteral("ShadowIntensity"));
+StringHash PSP_SHADOWMAPINVSIZE(StringHash::CalculateLiteral("ShadowMapInvSize"));
+StringHash PSP_SHADOWSPLITS(StringHash::CalculateLiteral("ShadowSplits"));
+StringHash PSP_LIGHTMATRICES(StringHash::CalculateLiteral("LightMatricesPS"));
+StringHash PSP_CLUSTERVIEWPROJ(StringHash::CalculateLiteral("ClusterViewProj"));
+StringHash PSP_CLUSTERPARAMS(StringHash::CalculateLiteral("ClusterParams"));
+StringHash PSP_CLUSTERTEXINVSIZE(StringHash::CalculateLiteral("ClusterTexInvSize"));
 
-StringHash PASS_BASE("base");
-StringHash PASS_LITBASE("litbase");
-StringHash PASS_LIGHT("light");
-StringHash PASS_ALPHA("alpha");
-StringHash PASS_LITALPHA("litalpha");
-StringHash PASS_SHADOW("shadow");
-StringHash PASS_DEFERRED("deferred");
-StringHash PASS_PREPASS("prepass");
-StringHash PASS_MATERIAL("material");
-StringHash PASS_POSTOPAQUE("postopaque");
-StringHash PASS_REFRACT("refract");
-StringHash PASS_POSTALPHA("postalpha");
+StringHash PASS_BASE(StringHash::CalculateLiteral("base"));
+StringHash PASS_LITBASE(StringHash::CalculateLiteral("litbase"));
+StringHash PASS_LIGHT(StringHash::CalculateLiteral("light"));
+StringHash PASS_ALPHA(StringHash::CalculateLiteral("alpha"));
+StringHash PASS_LITALPHA(StringHash::CalculateLiteral("litalpha"));
+StringHash PASS_SHADOW(StringHash::CalculateLiteral("shadow"));
+StringHash PASS_DEFERRED(StringHash::CalculateLiteral("deferred"));
+StringHash PASS_PREPASS(StringHash::CalculateLiteral("prepass"));
+StringHash PASS_MATERIAL(StringHash::CalculateLiteral("material"));
+StringHash PASS_POSTOPAQUE(StringHash::CalculateLiteral("postopaque"));
+StringHash PASS_REFRACT(StringHash::CalculateLiteral("refract"));
+StringHash PASS_POSTALPHA(StringHash::CalculateLiteral("postalpha"));
 
 Vector3 DOT_SCALE(1 / 3.0f, 1 / 3.0f, 1 / 3.0f);
 
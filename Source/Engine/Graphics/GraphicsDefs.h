@@ -44,8 +44,9 @@ enum GeometryType
     GEOM_SKINNED = 1,
     GEOM_INSTANCED = 2,
     GEOM_BILLBOARD = 3,
-    GEOM_STATIC_NOINSTANCING = 4,
-    MAX_GEOMETRYTYPES = 4,
+    GEOM_SKINNED_INSTANCED = 4,
+    GEOM_STATIC_NOINSTANCING = 5,
+    MAX_GEOMETRYTYPES = 5,
 };
 
 /// Blending mode.
@@ -230,7 +231,9 @@ enum TextureUnit
     TU_DEPTHBUFFER = 10,
     TU_LIGHTBUFFER = 11,
     TU_VOLUMEMAP = 12,
-    MAX_TEXTURE_UNITS = 13
+    TU_SKINMATRICES = 13,
+    TU_LIGHTCLUSTERS = 14,
+    MAX_TEXTURE_UNITS = 15
 };
 
 /// Billboard camera facing modes.
@@ -288,6 +291,9 @@ extern StringHash PSP_SHADOWINTENSITY;
 extern StringHash PSP_SHADOWMAPINVSIZE;
 extern StringHash PSP_SHADOWSPLITS;
 extern StringHash PSP_LIGHTMATRICES;
+extern StringHash PSP_CLUSTERVIEWPROJ;
+extern StringHash PSP_CLUSTERPARAMS;
+extern StringHash PSP_CLUSTERTEXINVSIZE;
 
 // Inbuilt pass types
 extern StringHash PASS_BASE;
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Context.h"
 #include "FileSystem.h"
 #include "Graphics.h"
@@ -57,6 +58,8 @@ static const char* textureUnitNames[] =
     "depth",
     "light",
     "volume",
+    "skinmatrices",
+    "lightclusters",
     0
 };
 
@@ -145,12 +148,16 @@ void ShaderParameterAnimationInfo::ApplyValue(const Variant& newValue)
     static_cast<Material*>(target_.Get())->SetShaderParameter(name_, newValue);
 }
 
+/// Last assigned sort ID. Incremented atomically, as objects may be constructed in background loading threads.
+static volatile int lastSortID = 0;
+
 Material::Material(Context* context) :
     Resource(context),
     auxViewFrameNumber_(0),
     occlusion_(true),
     specular_(false),
-    animationFrameNumber_(0)
+    animationFrameNumber_(0),
+    sortID_((unsigned)AtomicAddRelaxed(&lastSortID, 1))
 {
     ResetToDefaults();
 }
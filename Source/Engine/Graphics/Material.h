@@ -184,6 +184,8 @@ public:
     bool GetOcclusion() const { return occlusion_; }
     /// Return whether should render specular.
     bool GetSpecular() const { return specular_; }
+    /// Return ID for batch state sorting. Assigned in creation order, which may differ between runs.
+    unsigned GetSortID() const { return sortID_; }
 
     /// Return name for texture unit.
     static String GetTextureUnitName(TextureUnit unit);
@@ -222,6 +224,8 @@ private:
     bool specular_;
     /// Last animation update frame number.
     unsigned animationFrameNumber_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
 };
 
 }
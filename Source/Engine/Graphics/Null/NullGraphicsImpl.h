@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "GraphicsDefs.h"
+
+#include <SDL.h>
+
+namespace Urho3D
+{
+
+/// Texture formats of the null graphics backend.
+enum NullTextureFormat
+{
+    NULLFMT_UNKNOWN = 0,
+    NULLFMT_A8,
+    NULLFMT_L8,
+    NULLFMT_L8A8,
+    NULLFMT_RGB8,
+    NULLFMT_RGBA8,
+    NULLFMT_RGBA16,
+    NULLFMT_RGBA16F,
+    NULLFMT_RGBA32F,
+    NULLFMT_RG16,
+    NULLFMT_RG16F,
+    NULLFMT_RG32F,
+    NULLFMT_R16F,
+    NULLFMT_R32F,
+    NULLFMT_D16,
+    NULLFMT_D24X8,
+    NULLFMT_D24S8,
+    NULLFMT_DXT1,
+    NULLFMT_DXT3,
+    NULLFMT_DXT5
+};
+
+/// %Graphics implementation. Holds the sampler state which the null backend tracks instead of an API device.
+class URHO3D_API GraphicsImpl
+{
+    friend class Graphics;
+    
+public:
+    /// Construct.
+    GraphicsImpl();
+    
+    /// Return window. Always null, as the null backend does not open a window.
+    SDL_Window* GetWindow() const { return 0; }
+    
+private:
+    /// Texture filter modes in use.
+    TextureFilterMode filterModes_[MAX_TEXTURE_UNITS];
+    /// Texture U coordinate addressing modes in use.
+    TextureAddressMode uAddressModes_[MAX_TEXTURE_UNITS];
+    /// Texture V coordinate addressing modes in use.
+    TextureAddressMode vAddressModes_[MAX_TEXTURE_UNITS];
+    /// Texture W coordinate addressing modes in use.
+    TextureAddressMode wAddressModes_[MAX_TEXTURE_UNITS];
+    /// sRGB mode in use.
+    bool sRGBModes_[MAX_TEXTURE_UNITS];
+    /// sRGB write flag.
+    bool sRGBWrite_;
+};
+
+}
@@ -0,0 +1,402 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Atomic.h"
+#include "Graphics.h"
+#include "GraphicsImpl.h"
+#include "HashSet.h"
+#include "Log.h"
+#include "Shader.h"
+#include "ShaderVariation.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static bool IsIdentifierChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/// Remove // and /* */ comments from a source line, tracking block comments that span lines.
+static String StripComments(const String& line, bool& inBlockComment)
+{
+    String ret;
+    
+    for (unsigned i = 0; i < line.Length(); ++i)
+    {
+        if (inBlockComment)
+        {
+            if (line[i] == '*' && i + 1 < line.Length() && line[i + 1] == '/')
+            {
+                inBlockComment = false;
+                ++i;
+            }
+        }
+        else if (line[i] == '/' && i + 1 < line.Length() && line[i + 1] == '/')
+            break;
+        else if (line[i] == '/' && i + 1 < line.Length() && line[i + 1] == '*')
+        {
+            inBlockComment = true;
+            ++i;
+        }
+        else
+            ret += line[i];
+    }
+    
+    return ret;
+}
+
+/// Return whether the code references an identifier as a whole word.
+static bool ContainsIdentifier(const String& code, const String& name)
+{
+    unsigned pos = 0;
+    
+    for (;;)
+    {
+        pos = code.Find(name, pos);
+        if (pos == String::NPOS)
+            return false;
+        
+        unsigned end = pos + name.Length();
+        if ((!pos || !IsIdentifierChar(code[pos - 1])) && (end >= code.Length() || !IsIdentifierChar(code[end])))
+            return true;
+        
+        pos = end;
+    }
+}
+
+/// Evaluate a preprocessor condition consisting of defined() tests combined with !, && and ||.
+static bool EvaluateCondition(const String& condition, const HashSet<String>& defines)
+{
+    String expression = condition;
+    expression.Replace("(", " ( ");
+    expression.Replace(")", " ) ");
+    expression.Replace("!", " ! ");
+    expression.Replace("||", " | ");
+    expression.Replace("&&", " & ");
+    
+    Vector<String> tokens = expression.Split(' ');
+    bool result = false;
+    bool term = true;
+    bool negate = false;
+    bool testDefined = false;
+    
+    for (unsigned i = 0; i < tokens.Size(); ++i)
+    {
+        const String& token = tokens[i];
+        if (token == "(" || token == ")")
+            continue;
+        else if (token == "!")
+            negate = !negate;
+        else if (token == "defined")
+            testDefined = true;
+        else if (token == "&")
+            continue;
+        else if (token == "|")
+        {
+            result |= term;
+            term = true;
+        }
+        else
+        {
+            bool value;
+            if (testDefined || !IsDigit(token[0]))
+                value = defines.Contains(token);
+            else
+                value = ToInt(token) != 0;
+            
+            term &= negate ? !value : value;
+            negate = false;
+            testDefined = false;
+        }
+    }
+    
+    return result || term;
+}
+
+/// Return number of constant registers used by an HLSL type.
+static unsigned GetRegisterCount(const String& type)
+{
+    if (type.EndsWith("4x4"))
+        return 4;
+    else if (type.EndsWith("4x3") || type.EndsWith("3x3"))
+        return 3;
+    else if (type.EndsWith("2x2"))
+        return 2;
+    else
+        return 1;
+}
+
+/// Evaluate an array size, which may be written as a product such as 4*3.
+static unsigned GetArraySize(const String& size)
+{
+    Vector<String> factors = size.Split('*');
+    unsigned ret = 1;
+    for (unsigned i = 0; i < factors.Size(); ++i)
+        ret *= ToUInt(factors[i].Trimmed());
+    return ret;
+}
+
+/// Last assigned sort ID. Incremented atomically, as objects may be constructed in background loading threads.
+static volatile int lastSortID = 0;
+
+ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
+    GPUObject(owner->GetSubsystem<Graphics>()),
+    owner_(owner),
+    type_(type),
+    sortID_((unsigned)AtomicAddRelaxed(&lastSortID, 1))
+{
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        useTextureUnit_[i] = false;
+}
+
+ShaderVariation::~ShaderVariation()
+{
+    Release();
+}
+
+bool ShaderVariation::Create()
+{
+    Release();
+    
+    if (!graphics_)
+        return false;
+    
+    if (!owner_)
+    {
+        compilerOutput_ = "Owner shader has expired";
+        return false;
+    }
+    
+    ParseParameters(owner_->GetSourceCode(type_));
+    
+    // There is no API object; point to self so that the variation counts as created
+    object_ = this;
+    return true;
+}
+
+void ShaderVariation::Release()
+{
+    if (object_)
+    {
+        if (!graphics_)
+            return;
+        
+        if (type_ == VS)
+        {
+            if (graphics_->GetVertexShader() == this)
+                graphics_->SetShaders(0, 0);
+        }
+        else
+        {
+            if (graphics_->GetPixelShader() == this)
+                graphics_->SetShaders(0, 0);
+        }
+        
+        object_ = 0;
+    }
+    
+    compilerOutput_.Clear();
+    
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        useTextureUnit_[i] = false;
+    parameters_.Clear();
+}
+
+void ShaderVariation::SetName(const String& name)
+{
+    name_ = name;
+}
+
+void ShaderVariation::SetDefines(const String& defines)
+{
+    defines_ = defines;
+}
+
+Shader* ShaderVariation::GetOwner() const
+{
+    return owner_;
+}
+
+void ShaderVariation::ParseParameters(const String& sourceCode)
+{
+    // Use the same defines the HLSL compiler would receive
+    HashSet<String> defines;
+    defines.Insert(type_ == VS ? "COMPILEVS" : "COMPILEPS");
+    if (graphics_->GetSM3Support())
+        defines.Insert("SM3");
+    Vector<String> defineVec = defines_.Split(' ');
+    for (unsigned i = 0; i < defineVec.Size(); ++i)
+    {
+        Vector<String> nameAndValue = defineVec[i].Split('=');
+        if (!nameAndValue.Empty())
+            defines.Insert(nameAndValue[0]);
+    }
+    
+    // Evaluate the conditional blocks and sort the active lines into declarations and code
+    Vector<String> uniforms;
+    Vector<String> samplers;
+    String code;
+    PODVector<bool> active;
+    PODVector<bool> taken;
+    bool inBlockComment = false;
+    
+    Vector<String> lines = sourceCode.Split('\n');
+    for (unsigned i = 0; i < lines.Size(); ++i)
+    {
+        String line = StripComments(lines[i], inBlockComment).Trimmed();
+        if (line.Empty())
+            continue;
+        
+        bool parentActive = active.Size() < 2 ? true : active[active.Size() - 2];
+        bool isActive = active.Empty() ? true : active.Back();
+        
+        if (line[0] == '#')
+        {
+            String directive = line.Substring(1).Trimmed();
+            unsigned space = directive.Find(' ');
+            String argument = space != String::NPOS ? directive.Substring(space + 1).Trimmed() : String::EMPTY;
+            if (space != String::NPOS)
+                directive = directive.Substring(0, space);
+            
+            if (directive == "ifdef" || directive == "ifndef" || directive == "if")
+            {
+                bool value;
+                if (directive == "ifdef")
+                    value = defines.Contains(argument);
+                else if (directive == "ifndef")
+                    value = !defines.Contains(argument);
+                else
+                    value = EvaluateCondition(argument, defines);
+                
+                active.Push(isActive && value);
+                taken.Push(value);
+            }
+            else if (directive == "elif" && !active.Empty())
+            {
+                bool value = !taken.Back() && EvaluateCondition(argument, defines);
+                active.Back() = parentActive && value;
+                taken.Back() |= value;
+            }
+            else if (directive == "else" && !active.Empty())
+            {
+                active.Back() = parentActive && !taken.Back();
+                taken.Back() = true;
+            }
+            else if (directive == "endif" && !active.Empty())
+            {
+                active.Pop();
+                taken.Pop();
+            }
+            else if (directive == "define" && isActive)
+            {
+                Vector<String> defineTokens = argument.Split(' ');
+                if (!defineTokens.Empty())
+                    defines.Insert(defineTokens[0]);
+            }
+            
+            continue;
+        }
+        
+        if (!isActive)
+            continue;
+        
+        if (line.StartsWith("uniform "))
+            uniforms.Push(line);
+        else if (line.StartsWith("sampler") && line.Contains("register("))
+            samplers.Push(line);
+        else
+        {
+            code += line;
+            code += '\n';
+        }
+    }
+    
+    // Assign constant registers in declaration order to the uniforms the code refers to. The compiler would likewise
+    // eliminate unreferenced uniforms, though it could additionally drop ones that are only referenced by unused functions
+    unsigned reg = 0;
+    for (unsigned i = 0; i < uniforms.Size(); ++i)
+    {
+        String declaration = uniforms[i].Substring(8).Trimmed();
+        declaration.Replace(";", "");
+        unsigned space = declaration.Find(' ');
+        if (space == String::NPOS)
+            continue;
+        
+        String type = declaration.Substring(0, space);
+        String name = declaration.Substring(space + 1).Trimmed();
+        unsigned regCount = GetRegisterCount(type);
+        
+        unsigned bracket = name.Find('[');
+        if (bracket != String::NPOS)
+        {
+            unsigned closeBracket = name.Find(']', bracket);
+            regCount *= GetArraySize(name.Substring(bracket + 1, closeBracket - bracket - 1));
+            name = name.Substring(0, bracket).Trimmed();
+        }
+        
+        if (name.Length() < 2 || !ContainsIdentifier(code, name))
+            continue;
+        
+        name = name.Substring(1);
+        ShaderParameter newParam(type_, name, reg, regCount);
+        HashMap<StringHash, ShaderParameter>::Iterator j = parameters_.Insert(MakePair(StringHash(name), newParam));
+        
+        // Register the parameter globally
+        graphics_->RegisterShaderParameter(j->first_, j->second_);
+        reg += regCount;
+    }
+    
+    if (reg > (unsigned)MAX_CONSTANT_REGISTERS)
+        LOGWARNING("Shader " + name_ + " uses " + String(reg) + " constant registers, more than the hardware limit");
+    
+    for (unsigned i = 0; i < samplers.Size(); ++i)
+    {
+        const String& declaration = samplers[i];
+        unsigned space = declaration.Find(' ');
+        unsigned colon = declaration.Find(':');
+        unsigned regStart = declaration.Find("register(");
+        if (space == String::NPOS || colon == String::NPOS || colon < space)
+            continue;
+        
+        String name = declaration.Substring(space + 1, colon - space - 1).Trimmed();
+        if (name.Length() < 2 || !ContainsIdentifier(code, name))
+            continue;
+        
+        // Skip the G-buffer samplers, which are aliases for the standard texture units
+        name = name.Substring(1);
+        if (name == "AlbedoBuffer" || name == "NormalBuffer" || name == "DepthBuffer" || name == "LightBuffer")
+            continue;
+        
+        unsigned unit = ToUInt(declaration.Substring(regStart + 10));
+        if (unit < MAX_TEXTURE_UNITS)
+            useTextureUnit_[unit] = true;
+    }
+    
+    // Optimize shader parameter lookup by rehashing to next power of two
+    parameters_.Rehash(NextPowerOfTwo(parameters_.Size()));
+}
+
+}
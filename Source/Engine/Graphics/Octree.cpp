@@ -450,6 +450,10 @@ void Octree::Update(const FrameInfo& frame)
         scene->SendEvent(E_SCENEDRAWABLEUPDATEFINISHED, eventData);
     }
     
+    // Begin collecting the shadow caster changes of this frame
+    changedShadowCasters_.Clear();
+    changedShadowCasterBoxes_.Clear();
+    
     // Reinsert drawables that have been moved or resized, or that have been newly added to the octree and do not sit inside
     // the proper octant yet
     if (!drawableUpdates_.Empty())
@@ -466,6 +470,12 @@ void Octree::Update(const FrameInfo& frame)
             // Skip if no octant or does not belong to this octree anymore
             if (!octant || octant->GetRoot() != this)
                 continue;
+            // Record moved shadow casters for invalidating cached shadow maps
+            if (drawable->GetCastShadows() && (drawable->GetDrawableFlags() & (DRAWABLE_GEOMETRY | DRAWABLE_PROXYGEOMETRY)))
+            {
+                changedShadowCasters_.Push(drawable);
+                changedShadowCasterBoxes_.Push(box);
+            }
             // Skip if still fits the current octant
             if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
                 continue;
@@ -485,6 +495,17 @@ void Octree::Update(const FrameInfo& frame)
     }
     
     drawableUpdates_.Clear();
+    
+    // Add the shadow casters that were added, removed or changed outside the update
+    for (PODVector<Drawable*>::ConstIterator i = pendingShadowCasters_.Begin(); i != pendingShadowCasters_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        changedShadowCasters_.Push(drawable);
+        changedShadowCasterBoxes_.Push(drawable->GetWorldBoundingBox());
+    }
+    changedShadowCasters_.Push(removedShadowCasters_);
+    pendingShadowCasters_.Clear();
+    removedShadowCasters_.Clear();
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -629,6 +650,21 @@ void Octree::CancelUpdate(Drawable* drawable)
     drawable->updateQueued_ = false;
 }
 
+void Octree::MarkShadowCasterChanged(Drawable* drawable, bool removed)
+{
+    if (!(drawable->GetDrawableFlags() & (DRAWABLE_GEOMETRY | DRAWABLE_PROXYGEOMETRY)))
+        return;
+    
+    if (removed)
+    {
+        // Also record if the drawable just stopped casting shadows, as it may still be in a cached shadow map
+        if (pendingShadowCasters_.Remove(drawable) || drawable->GetCastShadows())
+            removedShadowCasters_.Push(drawable);
+    }
+    else if (!pendingShadowCasters_.Contains(drawable))
+        pendingShadowCasters_.Push(drawable);
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     DebugRenderer* debug = GetComponent<DebugRenderer>();
@@ -192,6 +192,12 @@ public:
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Record a shadow caster being added, removed or changing its shadowing parameters. Used to invalidate cached shadow maps.
+    void MarkShadowCasterChanged(Drawable* drawable, bool removed = false);
+    /// Return shadow casters that were added, removed, moved or changed before the last update.
+    const PODVector<Drawable*>& GetChangedShadowCasters() const { return changedShadowCasters_; }
+    /// Return world bounding boxes of the changed shadow casters that remain in the octree after the last update.
+    const PODVector<BoundingBox>& GetChangedShadowCasterBoxes() const { return changedShadowCasterBoxes_; }
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
     
@@ -203,6 +209,14 @@ private:
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that require reinsertion.
     PODVector<Drawable*> drawableReinsertions_;
+    /// Shadow casters added or changed since the last update.
+    PODVector<Drawable*> pendingShadowCasters_;
+    /// Shadow casters removed since the last update. Only compared as pointers, as they may already be destroyed.
+    PODVector<Drawable*> removedShadowCasters_;
+    /// Shadow casters added, removed, moved or changed before the last update.
+    PODVector<Drawable*> changedShadowCasters_;
+    /// World bounding boxes of the changed shadow casters that remain in the octree.
+    PODVector<BoundingBox> changedShadowCasterBoxes_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Current threaded ray query.
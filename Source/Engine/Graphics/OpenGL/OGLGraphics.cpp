@@ -194,6 +194,7 @@ Graphics::Graphics(Context* context_) :
     tripleBuffer_(false),
     sRGB_(false),
     instancingSupport_(false),
+    vertexTextureSupport_(false),
     lightPrepassSupport_(false),
     deferredSupport_(false),
     anisotropySupport_(false),
@@ -463,6 +464,11 @@ bool Graphics::SetMode(int width, int height, bool fullscreen, bool borderless,
         sRGBSupport_ = GLEW_EXT_texture_sRGB != 0;
         sRGBWriteSupport_ = GLEW_EXT_framebuffer_sRGB != 0;
         
+        // Check for floating point vertex texture fetch (needed for skinned instancing)
+        GLint vertexTextureUnits = 0;
+        glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits);
+        vertexTextureSupport_ = vertexTextureUnits > 0 && GLEW_ARB_texture_float != 0;
+        
         // Set up instancing divisors if supported
         if (instancingSupport_)
         {
@@ -2942,6 +2948,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["DepthBuffer"] = TU_DEPTHBUFFER;
     textureUnits_["LightBuffer"] = TU_LIGHTBUFFER;
     textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
+    textureUnits_["SkinMatrices"] = TU_SKINMATRICES;
+    textureUnits_["LightClusters"] = TU_LIGHTCLUSTERS;
 }
 
 void RegisterGraphicsLibrary(Context* context)
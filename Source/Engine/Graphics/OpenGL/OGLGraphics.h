@@ -286,6 +286,8 @@ public:
     bool GetHardwareShadowSupport() const { return true; }
     /// Return whether stream offset is supported. Always true on OpenGL.
     bool GetStreamOffsetSupport() const { return true; }
+    /// Return whether floating point textures can be sampled in vertex shaders.
+    bool GetVertexTextureSupport() const { return vertexTextureSupport_; }
     /// Return whether sRGB conversion on texture sampling is supported.
     bool GetSRGBSupport() const { return sRGBSupport_; }
     /// Return whether sRGB conversion on rendertarget writing is supported.
@@ -477,6 +479,8 @@ private:
     bool sRGB_;
     /// Instancing support flag.
     bool instancingSupport_;
+    /// Vertex texture fetch support flag.
+    bool vertexTextureSupport_;
     /// Light prepass support flag.
     bool lightPrepassSupport_;
     /// Deferred rendering support flag.
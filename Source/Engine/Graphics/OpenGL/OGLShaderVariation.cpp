@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Graphics.h"
 #include "GraphicsImpl.h"
 #include "Log.h"
@@ -33,10 +34,14 @@
 namespace Urho3D
 {
 
+/// Last assigned sort ID. Incremented atomically, as objects may be constructed in background loading threads.
+static volatile int lastSortID = 0;
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_((unsigned)AtomicAddRelaxed(&lastSortID, 1))
 {
 }
 
@@ -66,6 +66,8 @@ public:
     String GetFullName() const { return name_ + "(" + defines_ + ")"; }
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
+    /// Return ID for batch state sorting. Assigned in creation order, which may differ between runs.
+    unsigned GetSortID() const { return sortID_; }
     
 private:
     /// Shader this variation belongs to.
@@ -78,6 +80,8 @@ private:
     String defines_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
 };
 
 }
@@ -21,17 +21,28 @@
 //
 
 #include "Precompiled.h"
+#include "Camera.h"
 #include "Context.h"
+#include "Geometry.h"
 #include "Log.h"
 #include "Material.h"
+#include "OctreeQuery.h"
 #include "ParticleEmitter.h"
 #include "Profiler.h"
 #include "ResourceCache.h"
 #include "ResourceEvents.h"
 #include "Scene.h"
 #include "SceneEvents.h"
+#include "Sort.h"
+#include "VertexBuffer.h"
 #include "XMLFile.h"
 
+// URHO3D_SSE is also defined by default when targeting ARM, so check the compiler's own definition as well
+#if defined(URHO3D_SSE) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define PARTICLE_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "DebugNew.h"
 
 namespace Urho3D
@@ -56,14 +67,108 @@ static const float DEFAULT_TIME_TO_LIVE = 1.0f;
 static const float DEFAULT_VELOCITY = 1.0f;
 static const Vector3 DEFAULT_DIRECTION_MIN(-1.0f, -1.0f, -1.0f);
 static const Vector3 DEFAULT_DIRECTION_MAX(1.0f, 1.0f, 1.0f);
+static const float INV_SQRT_TWO = 1.0f / sqrtf(2.0f);
 
 template<> EmitterType Variant::Get<EmitterType>() const
 {
     return (EmitterType)GetInt();
 }
 
+/// Particle sort distance comparison functor. Sorts back to front.
+struct CompareParticleDistances
+{
+    /// Construct with the distance array.
+    CompareParticleDistances(const float* distances) :
+        distances_(distances)
+    {
+    }
+    
+    /// Compare two particle indices.
+    bool operator () (unsigned lhs, unsigned rhs) const { return distances_[lhs] > distances_[rhs]; }
+    
+    /// Distances indexed by particle.
+    const float* distances_;
+};
+
+/// Apply constant force and damping to the velocity of particles on one axis, then integrate the position.
+static void IntegrateParticleAxis(float* position, float* velocity, unsigned count, float velocityAdd, float damping, float timeStep,
+    float positionScale)
+{
+    unsigned i = 0;
+    
+    #ifdef PARTICLE_SSE
+    __m128 add = _mm_set1_ps(velocityAdd);
+    __m128 negDamping = _mm_set1_ps(-damping);
+    __m128 step = _mm_set1_ps(timeStep);
+    __m128 scale = _mm_set1_ps(positionScale);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(velocity + i), add);
+        v = _mm_add_ps(v, _mm_mul_ps(step, _mm_mul_ps(negDamping, v)));
+        __m128 p = _mm_add_ps(_mm_loadu_ps(position + i), _mm_mul_ps(_mm_mul_ps(step, v), scale));
+        _mm_storeu_ps(velocity + i, v);
+        _mm_storeu_ps(position + i, p);
+    }
+    #endif
+    
+    for (; i < count; ++i)
+    {
+        float v = velocity[i] + velocityAdd;
+        v += timeStep * (-damping * v);
+        velocity[i] = v;
+        position[i] += timeStep * v * positionScale;
+    }
+}
+
+/// Add a value multiplied by the time step to an array of values, for example rotation speed to rotation.
+static void IntegrateParticleValues(float* values, const float* rates, unsigned count, float timeStep)
+{
+    unsigned i = 0;
+    
+    #ifdef PARTICLE_SSE
+    __m128 step = _mm_set1_ps(timeStep);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), _mm_mul_ps(step, _mm_loadu_ps(rates + i))));
+    #endif
+    
+    for (; i < count; ++i)
+        values[i] += timeStep * rates[i];
+}
+
+/// Advance particle timers by the time step.
+static void AdvanceParticleTimers(float* timers, unsigned count, float timeStep)
+{
+    unsigned i = 0;
+    
+    #ifdef PARTICLE_SSE
+    __m128 step = _mm_set1_ps(timeStep);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(timers + i, _mm_add_ps(_mm_loadu_ps(timers + i), step));
+    #endif
+    
+    for (; i < count; ++i)
+        timers[i] += timeStep;
+}
+
+/// Apply the additive and multiplicative size modifiers to particle scales.
+static void ScaleParticles(float* scales, unsigned count, float scaleAdd, float scaleMul)
+{
+    unsigned i = 0;
+    
+    #ifdef PARTICLE_SSE
+    __m128 add = _mm_set1_ps(scaleAdd);
+    __m128 mul = _mm_set1_ps(scaleMul);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(scales + i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(scales + i), add), mul));
+    #endif
+    
+    for (; i < count; ++i)
+        scales[i] = (scales[i] + scaleAdd) * scaleMul;
+}
+
 ParticleEmitter::ParticleEmitter(Context* context) :
     BillboardSet(context),
+    numActiveParticles_(0),
     emitterType_(EMITTER_SPHERE),
     emitterSize_(Vector3::ZERO),
     directionMin_(DEFAULT_DIRECTION_MIN),
@@ -149,6 +254,46 @@ void ParticleEmitter::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE(ParticleEmitter, VAR_VARIANTVECTOR, "Billboards", GetBillboardsAttr, SetBillboardsAttr, VariantVector, Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
 }
 
+void ParticleEmitter::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
+{
+    // If no particle-level testing, use the Drawable test
+    if (query.level_ < RAY_TRIANGLE)
+    {
+        Drawable::ProcessRayQuery(query, results);
+        return;
+    }
+    
+    // Check ray hit distance to AABB before proceeding with particle-level tests
+    if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
+        return;
+    
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    
+    for (unsigned i = 0; i < numActiveParticles_; ++i)
+    {
+        // Approximate the particles as spheres for raycasting
+        float size = INV_SQRT_TWO * scales_[i] * (sizes_[i].x_ * billboardScale.x_ + sizes_[i].y_ * billboardScale.y_);
+        Vector3 center = billboardTransform * Vector3(positionX_[i], positionY_[i], positionZ_[i]);
+        Sphere particleSphere(center, size);
+        
+        float distance = query.ray_.HitDistance(particleSphere);
+        if (distance < query.maxDistance_)
+        {
+            // If the code reaches here then we have a hit
+            RayQueryResult result;
+            result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+            result.normal_ = -query.ray_.direction_;
+            result.distance_ = distance;
+            result.drawable_ = this;
+            result.node_ = node_;
+            result.subObject_ = i;
+            results.Push(result);
+        }
+    }
+}
+
 void ParticleEmitter::OnSetEnabled()
 {
     BillboardSet::OnSetEnabled();
@@ -169,10 +314,6 @@ void ParticleEmitter::Update(const FrameInfo& frame)
     if (!needUpdate_)
         return;
     
-    // If there is an amount mismatch between particles and billboards, correct it
-    if (particles_.Size() != billboards_.Size())
-        SetNumBillboards(particles_.Size());
-    
     bool needCommit = false;
     
     // Check active/inactive period switching
@@ -224,79 +365,77 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         }
     }
     
-    // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * constantForce_;
-    // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
-    if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
+    // Remove particles whose time to live has run out
+    for (unsigned i = 0; i < numActiveParticles_;)
+    {
+        if (timers_[i] >= timesToLive_[i])
+        {
+            RemoveParticle(i);
+            needCommit = true;
+        }
+        else
+            ++i;
+    }
     
-    for (unsigned i = 0; i < particles_.Size(); ++i)
+    // Update existing particles. The live particles are contiguous, so each quantity is updated with a tight loop over its array
+    unsigned numParticles = numActiveParticles_;
+    if (numParticles)
     {
-        Particle& particle = particles_[i];
-        Billboard& billboard = billboards_[i];
+        needCommit = true;
+        
+        Vector3 force = relative_ ? node_->GetWorldRotation().Inverse() * constantForce_ : constantForce_;
+        Vector3 velocityAdd = lastTimeStep_ * force;
+        // If billboards are not relative, apply scaling to the position update
+        Vector3 scaleVector = Vector3::ONE;
+        if (scaled_ && !relative_)
+            scaleVector = node_->GetWorldScale();
+        
+        AdvanceParticleTimers(&timers_[0], numParticles, lastTimeStep_);
+        
+        // Velocity & position
+        IntegrateParticleAxis(&positionX_[0], &velocityX_[0], numParticles, velocityAdd.x_, dampingForce_, lastTimeStep_, scaleVector.x_);
+        IntegrateParticleAxis(&positionY_[0], &velocityY_[0], numParticles, velocityAdd.y_, dampingForce_, lastTimeStep_, scaleVector.y_);
+        IntegrateParticleAxis(&positionZ_[0], &velocityZ_[0], numParticles, velocityAdd.z_, dampingForce_, lastTimeStep_, scaleVector.z_);
+        
+        // Rotation
+        IntegrateParticleValues(&rotations_[0], &rotationSpeeds_[0], numParticles, lastTimeStep_);
         
-        if (billboard.enabled_)
+        // Scaling
+        if (sizeAdd_ != 0.0f || sizeMul_ != 1.0f)
+            ScaleParticles(&scales_[0], numParticles, lastTimeStep_ * sizeAdd_, (lastTimeStep_ * (sizeMul_ - 1.0f)) + 1.0f);
+        
+        // Color interpolation
+        unsigned numColorFrames = colorFrames_.Size();
+        if (numColorFrames)
         {
-            needCommit = true;
-            
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
-            
-            // Velocity & position
-            if (constantForce_ != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce_;
-            }
-            if (dampingForce_ != 0.0f)
+            for (unsigned i = 0; i < numParticles; ++i)
             {
-                Vector3 force = -dampingForce_ * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
-            
-            // Scaling
-            if (sizeAdd_ != 0.0f || sizeMul_ != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd_;
-                if (sizeMul_ != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul_ - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
-            
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            if (index < colorFrames_.Size())
-            {
-                if (index < colorFrames_.Size() - 1)
+                unsigned& index = colorIndices_[i];
+                if (index < numColorFrames)
                 {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
+                    if (index < numColorFrames - 1)
+                    {
+                        if (timers_[i] >= colorFrames_[index + 1].time_)
+                            ++index;
+                    }
+                    if (index < numColorFrames - 1)
+                        colors_[i] = colorFrames_[index].Interpolate(colorFrames_[index + 1], timers_[i]);
+                    else
+                        colors_[i] = colorFrames_[index].color_;
                 }
-                if (index < colorFrames_.Size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
             }
-            
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            if (textureFrames_.Size() && texIndex < textureFrames_.Size() - 1)
+        }
+        
+        // Texture animation
+        unsigned numTextureFrames = textureFrames_.Size();
+        if (numTextureFrames > 1)
+        {
+            for (unsigned i = 0; i < numParticles; ++i)
             {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
+                unsigned& texIndex = texIndices_[i];
+                if (texIndex < numTextureFrames - 1 && timers_[i] >= textureFrames_[texIndex + 1].time_)
                 {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
+                    uvs_[i] = textureFrames_[texIndex + 1].uv_;
                     ++texIndex;
                 }
             }
@@ -472,7 +611,7 @@ bool ParticleEmitter::Save(XMLFile* file) const
     childElem.SetAttribute("name", GetResourceName(batches_[0].material_));
     
     childElem = rootElem.CreateChild("numparticles");
-    childElem.SetInt("value", particles_.Size());
+    childElem.SetInt("value", timers_.Size());
     
     childElem = rootElem.CreateChild("updateinvisible");
     childElem.SetBool("enable", updateInvisible_);
@@ -573,8 +712,30 @@ void ParticleEmitter::SetNumParticles(unsigned num)
     if (num > MAX_BILLBOARDS)
         num = MAX_BILLBOARDS;
     
-    particles_.Resize(num);
-    SetNumBillboards(num);
+    positionX_.Resize(num);
+    positionY_.Resize(num);
+    positionZ_.Resize(num);
+    velocityX_.Resize(num);
+    velocityY_.Resize(num);
+    velocityZ_.Resize(num);
+    sizes_.Resize(num);
+    scales_.Resize(num);
+    timers_.Resize(num);
+    timesToLive_.Resize(num);
+    rotations_.Resize(num);
+    rotationSpeeds_.Resize(num);
+    colorIndices_.Resize(num);
+    texIndices_.Resize(num);
+    colors_.Resize(num);
+    uvs_.Resize(num);
+    sortDistances_.Resize(num);
+    sortedParticles_.Resize(num);
+    
+    if (numActiveParticles_ > num)
+        numActiveParticles_ = num;
+    
+    bufferSizeDirty_ = true;
+    Commit();
 }
 
 void ParticleEmitter::SetEmissionRate(float rate)
@@ -801,9 +962,7 @@ void ParticleEmitter::ResetEmissionTimer()
 
 void ParticleEmitter::RemoveAllParticles()
 {
-    for (PODVector<Billboard>::Iterator i = billboards_.Begin(); i != billboards_.End(); ++i)
-        i->enabled_ = false;
-    
+    numActiveParticles_ = 0;
     Commit();
 }
 
@@ -819,34 +978,37 @@ void ParticleEmitter::SetParticlesAttr(VariantVector value)
     unsigned index = 0;
     SetNumParticles(index < value.Size() ? value[index++].GetUInt() : 0);
     
-    for (PODVector<Particle>::Iterator i = particles_.Begin(); i != particles_.End() && index < value.Size(); ++i)
+    for (unsigned i = 0; i < timers_.Size() && index < value.Size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = value[index++].GetInt();
-        i->texIndex_ = value[index++].GetInt();
+        Vector3 velocity = value[index++].GetVector3();
+        velocityX_[i] = velocity.x_;
+        velocityY_[i] = velocity.y_;
+        velocityZ_[i] = velocity.z_;
+        sizes_[i] = value[index++].GetVector2();
+        timers_[i] = value[index++].GetFloat();
+        timesToLive_[i] = value[index++].GetFloat();
+        scales_[i] = value[index++].GetFloat();
+        rotationSpeeds_[i] = value[index++].GetFloat();
+        colorIndices_[i] = value[index++].GetInt();
+        texIndices_[i] = value[index++].GetInt();
     }
 }
 
 VariantVector ParticleEmitter::GetParticlesAttr() const
 {
     VariantVector ret;
-    ret.Reserve(particles_.Size() * 8 + 1);
-    ret.Push(particles_.Size());
-    for (PODVector<Particle>::ConstIterator i = particles_.Begin(); i != particles_.End(); ++i)
+    ret.Reserve(timers_.Size() * 8 + 1);
+    ret.Push(timers_.Size());
+    for (unsigned i = 0; i < timers_.Size(); ++i)
     {
-        ret.Push(i->velocity_);
-        ret.Push(i->size_);
-        ret.Push(i->timer_);
-        ret.Push(i->timeToLive_);
-        ret.Push(i->scale_);
-        ret.Push(i->rotationSpeed_);
-        ret.Push(i->colorIndex_);
-        ret.Push(i->texIndex_);
+        ret.Push(Vector3(velocityX_[i], velocityY_[i], velocityZ_[i]));
+        ret.Push(sizes_[i]);
+        ret.Push(timers_[i]);
+        ret.Push(timesToLive_[i]);
+        ret.Push(scales_[i]);
+        ret.Push(rotationSpeeds_[i]);
+        ret.Push(colorIndices_[i]);
+        ret.Push(texIndices_[i]);
     }
     return ret;
 }
@@ -909,6 +1071,59 @@ VariantVector ParticleEmitter::GetTextureFramesAttr() const
     return ret;
 }
 
+void ParticleEmitter::SetBillboardsAttr(VariantVector value)
+{
+    unsigned index = 0;
+    unsigned numBillboards = index < value.Size() ? value[index++].GetUInt() : 0;
+    unsigned numParticles = timers_.Size();
+    
+    // Live particles are compacted to the beginning of the arrays in the order they appear
+    numActiveParticles_ = 0;
+    for (unsigned i = 0; i < numBillboards && i < numParticles && index + 6 <= value.Size(); ++i)
+    {
+        Vector3 position = value[index++].GetVector3();
+        // The current size is derived from the original size and scale, so it is not read
+        ++index;
+        Vector4 uv = value[index++].GetVector4();
+        Color color = value[index++].GetColor();
+        float rotation = value[index++].GetFloat();
+        bool enabled = value[index++].GetBool();
+        if (!enabled)
+            continue;
+        
+        unsigned dest = numActiveParticles_++;
+        if (dest != i)
+            CopyParticle(dest, i);
+        positionX_[dest] = position.x_;
+        positionY_[dest] = position.y_;
+        positionZ_[dest] = position.z_;
+        uvs_[dest] = Rect(uv.x_, uv.y_, uv.z_, uv.w_);
+        colors_[dest] = color;
+        rotations_[dest] = rotation;
+    }
+    
+    Commit();
+}
+
+VariantVector ParticleEmitter::GetBillboardsAttr() const
+{
+    VariantVector ret;
+    ret.Reserve(timers_.Size() * 6 + 1);
+    ret.Push(timers_.Size());
+    
+    for (unsigned i = 0; i < timers_.Size(); ++i)
+    {
+        ret.Push(Vector3(positionX_[i], positionY_[i], positionZ_[i]));
+        ret.Push(sizes_[i] * scales_[i]);
+        ret.Push(uvs_[i].ToVector4());
+        ret.Push(colors_[i]);
+        ret.Push(rotations_[i]);
+        ret.Push(i < numActiveParticles_);
+    }
+    
+    return ret;
+}
+
 void ParticleEmitter::OnNodeSet(Node* node)
 {
     BillboardSet::OnNodeSet(node);
@@ -921,14 +1136,74 @@ void ParticleEmitter::OnNodeSet(Node* node)
     }
 }
 
+void ParticleEmitter::OnWorldBoundingBoxUpdate()
+{
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    BoundingBox worldBox;
+    
+    for (unsigned i = 0; i < numActiveParticles_; ++i)
+    {
+        float size = INV_SQRT_TWO * scales_[i] * (sizes_[i].x_ * billboardScale.x_ + sizes_[i].y_ * billboardScale.y_);
+        Vector3 center = billboardTransform * Vector3(positionX_[i], positionY_[i], positionZ_[i]);
+        Vector3 edge = Vector3::ONE * size;
+        worldBox.Merge(BoundingBox(center - edge, center + edge));
+    }
+    
+    // Always merge the node's own position to ensure particle emitter updates continue when the relative mode is switched
+    worldBox.Merge(node_->GetWorldPosition());
+    
+    worldBoundingBox_ = worldBox;
+}
+
+void ParticleEmitter::UpdateVertexBuffer(const FrameInfo& frame)
+{
+    if (!CheckVertexBufferUpdate(frame))
+        return;
+    
+    unsigned numParticles = numActiveParticles_;
+    batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, numParticles * 6, false);
+    if (!numParticles)
+        return;
+    
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    
+    if (sorted_)
+    {
+        for (unsigned i = 0; i < numParticles; ++i)
+        {
+            sortDistances_[i] = frame.camera_->GetDistanceSquared(billboardTransform * Vector3(positionX_[i], positionY_[i],
+                positionZ_[i]));
+            sortedParticles_[i] = i;
+        }
+        Sort(sortedParticles_.Begin(), sortedParticles_.Begin() + numParticles, CompareParticleDistances(&sortDistances_[0]));
+    }
+    
+    float* dest = (float*)vertexBuffer_->Lock(0, numParticles * 4, true);
+    if (!dest)
+        return;
+    
+    for (unsigned i = 0; i < numParticles; ++i)
+    {
+        unsigned index = sorted_ ? sortedParticles_[i] : i;
+        float scale = scales_[index];
+        Vector2 size(sizes_[index].x_ * scale * billboardScale.x_, sizes_[index].y_ * scale * billboardScale.y_);
+        dest = WriteBillboardVertices(dest, Vector3(positionX_[index], positionY_[index], positionZ_[index]), size, uvs_[index],
+            colors_[index].ToUInt(), rotations_[index]);
+    }
+    
+    vertexBuffer_->Unlock();
+    vertexBuffer_->ClearDataLost();
+}
+
 bool ParticleEmitter::EmitNewParticle()
 {
-    unsigned index = GetFreeParticle();
-    if (index == M_MAX_UNSIGNED)
+    if (numActiveParticles_ >= timers_.Size())
         return false;
-    assert(index < particles_.Size());
-    Particle& particle = particles_[index];
-    Billboard& billboard = billboards_[index];
+    unsigned index = numActiveParticles_;
     
     Vector3 startPos;
     Vector3 startDir;
@@ -969,34 +1244,54 @@ bool ParticleEmitter::EmitNewParticle()
         startDir = node_->GetWorldRotation() * startDir;
     };
     
-    particle.velocity_ = Lerp(velocityMin_, velocityMax_, Random(1.0f)) * startDir;
-    particle.size_ = sizeMin_.Lerp(sizeMax_, Random(1.0f));
-    particle.timer_ = 0.0f;
-    particle.timeToLive_ = Lerp(timeToLiveMin_, timeToLiveMax_, Random(1.0f));
-    particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = Lerp(rotationSpeedMin_, rotationSpeedMax_, Random(1.0f));
-    particle.colorIndex_ = 0;
-    particle.texIndex_ = 0;
-    
-    billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
-    billboard.uv_ = textureFrames_.Size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
-    billboard.rotation_ = Lerp(rotationMin_, rotationMax_, Random(1.0f));
-    billboard.color_ = colorFrames_[0].color_;
-    billboard.enabled_ = true;
-    
+    Vector3 velocity = Lerp(velocityMin_, velocityMax_, Random(1.0f)) * startDir;
+    velocityX_[index] = velocity.x_;
+    velocityY_[index] = velocity.y_;
+    velocityZ_[index] = velocity.z_;
+    sizes_[index] = sizeMin_.Lerp(sizeMax_, Random(1.0f));
+    timers_[index] = 0.0f;
+    timesToLive_[index] = Lerp(timeToLiveMin_, timeToLiveMax_, Random(1.0f));
+    scales_[index] = 1.0f;
+    rotationSpeeds_[index] = Lerp(rotationSpeedMin_, rotationSpeedMax_, Random(1.0f));
+    colorIndices_[index] = 0;
+    texIndices_[index] = 0;
+    
+    positionX_[index] = startPos.x_;
+    positionY_[index] = startPos.y_;
+    positionZ_[index] = startPos.z_;
+    uvs_[index] = textureFrames_.Size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
+    rotations_[index] = Lerp(rotationMin_, rotationMax_, Random(1.0f));
+    colors_[index] = colorFrames_[0].color_;
+    
+    ++numActiveParticles_;
     return true;
 }
 
-unsigned ParticleEmitter::GetFreeParticle() const
+void ParticleEmitter::RemoveParticle(unsigned index)
 {
-    for (unsigned i = 0; i < billboards_.Size(); ++i)
-    {
-        if (!billboards_[i].enabled_)
-            return i;
-    }
-    
-    return M_MAX_UNSIGNED;
+    unsigned last = --numActiveParticles_;
+    if (index != last)
+        CopyParticle(index, last);
+}
+
+void ParticleEmitter::CopyParticle(unsigned dest, unsigned src)
+{
+    positionX_[dest] = positionX_[src];
+    positionY_[dest] = positionY_[src];
+    positionZ_[dest] = positionZ_[src];
+    velocityX_[dest] = velocityX_[src];
+    velocityY_[dest] = velocityY_[src];
+    velocityZ_[dest] = velocityZ_[src];
+    sizes_[dest] = sizes_[src];
+    scales_[dest] = scales_[src];
+    timers_[dest] = timers_[src];
+    timesToLive_[dest] = timesToLive_[src];
+    rotations_[dest] = rotations_[src];
+    rotationSpeeds_[dest] = rotationSpeeds_[src];
+    colorIndices_[dest] = colorIndices_[src];
+    texIndices_[dest] = texIndices_[src];
+    colors_[dest] = colors_[src];
+    uvs_[dest] = uvs_[src];
 }
 
 void ParticleEmitter::GetFloatMinMax(const XMLElement& element, float& minValue, float& maxValue)
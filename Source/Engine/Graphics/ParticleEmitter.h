@@ -34,27 +34,6 @@ enum EmitterType
     EMITTER_BOX
 };
 
-/// One particle in the particle system.
-struct Particle
-{
-    /// Velocity.
-    Vector3 velocity_;
-    /// Original billboard size.
-    Vector2 size_;
-    /// Time elapsed from creation.
-    float timer_;
-    /// Lifetime.
-    float timeToLive_;
-    /// Size scaling value.
-    float scale_;
-    /// Rotation speed.
-    float rotationSpeed_;
-    /// Current color animation index.
-    unsigned colorIndex_;
-    /// Current texture animation index.
-    unsigned texIndex_;
-};
-
 /// %Color animation frame definition.
 struct ColorFrame
 {
@@ -131,6 +110,8 @@ public:
     
     /// Handle enabled/disabled state change.
     virtual void OnSetEnabled();
+    /// Process octree raycast. May be called from a worker thread.
+    virtual void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
     /// Update before octree reinsertion. Is called from a worker thread.
     virtual void Update(const FrameInfo& frame);
     
@@ -218,7 +199,9 @@ public:
     void Reset();
     
     /// Return maximum number of particles.
-    unsigned GetNumParticles() const { return particles_.Size(); }
+    unsigned GetNumParticles() const { return timers_.Size(); }
+    /// Return number of currently live particles.
+    unsigned GetNumActiveParticles() const { return numActiveParticles_; }
     /// Return whether is currently emitting.
     bool IsEmitting() const { return emitting_; }
     /// Return whether to update when particles are not visible.
@@ -292,15 +275,27 @@ public:
     void SetTextureFramesAttr(VariantVector value);
     /// Return texture animation attribute.
     VariantVector GetTextureFramesAttr() const;
+    /// Set billboards attribute. The particles' visual state is stored in the same format as in BillboardSet.
+    void SetBillboardsAttr(VariantVector value);
+    /// Return billboards attribute.
+    VariantVector GetBillboardsAttr() const;
     
 protected:
     /// Handle node being assigned.
     virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+    /// Return number of billboards the vertex and index buffers should have room for.
+    virtual unsigned GetBufferCapacity() const { return timers_.Size(); }
+    /// Rewrite the billboard vertex buffer directly from the particle arrays.
+    virtual void UpdateVertexBuffer(const FrameInfo& frame);
     
     /// Create a new particle. Return true if there was room.
     bool EmitNewParticle();
-    /// Return a free particle index.
-    unsigned GetFreeParticle() const;
+    /// Remove a live particle by moving the last live particle into its place.
+    void RemoveParticle(unsigned index);
+    /// Copy all state of a particle to another index.
+    void CopyParticle(unsigned dest, unsigned src);
     /// Read a float range from an XML element.
     void GetFloatMinMax(const XMLElement& element, float& minValue, float& maxValue);
     /// Read a Vector2 range from an XML element.
@@ -312,8 +307,44 @@ private:
     /// Handle scene post-update event.
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
     
-    /// Particles.
-    PODVector<Particle> particles_;
+    /// Particle position X coordinates.
+    PODVector<float> positionX_;
+    /// Particle position Y coordinates.
+    PODVector<float> positionY_;
+    /// Particle position Z coordinates.
+    PODVector<float> positionZ_;
+    /// Particle velocity X components.
+    PODVector<float> velocityX_;
+    /// Particle velocity Y components.
+    PODVector<float> velocityY_;
+    /// Particle velocity Z components.
+    PODVector<float> velocityZ_;
+    /// Particle original sizes.
+    PODVector<Vector2> sizes_;
+    /// Particle size scaling values.
+    PODVector<float> scales_;
+    /// Particle times elapsed from creation.
+    PODVector<float> timers_;
+    /// Particle lifetimes.
+    PODVector<float> timesToLive_;
+    /// Particle rotations.
+    PODVector<float> rotations_;
+    /// Particle rotation speeds.
+    PODVector<float> rotationSpeeds_;
+    /// Particle current color animation indices.
+    PODVector<unsigned> colorIndices_;
+    /// Particle current texture animation indices.
+    PODVector<unsigned> texIndices_;
+    /// Particle colors.
+    PODVector<Color> colors_;
+    /// Particle UV coordinates.
+    PODVector<Rect> uvs_;
+    /// Particle sort distances.
+    PODVector<float> sortDistances_;
+    /// Particle indices in drawing order when sorting.
+    PODVector<unsigned> sortedParticles_;
+    /// Number of live particles. These occupy the beginning of the particle arrays.
+    unsigned numActiveParticles_;
     /// Particle color animation frames.
     Vector<ColorFrame> colorFrames_;
     /// Texture animation frames.
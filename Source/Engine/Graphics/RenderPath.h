@@ -107,7 +107,8 @@ struct RenderPathCommand
         useFogColor_(false),
         markToStencil_(false),
         useLitBase_(true),
-        vertexLights_(false)
+        vertexLights_(false),
+        clusteredLights_(false)
     {
     }
     
@@ -175,6 +176,8 @@ struct RenderPathCommand
     bool useLitBase_;
     /// Vertex lights flag.
     bool vertexLights_;
+    /// Clustered lights flag.
+    bool clusteredLights_;
 };
 
 /// Rendering path definition.
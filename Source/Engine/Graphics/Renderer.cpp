@@ -191,7 +191,8 @@ static const char* geometryVSVariations[] =
     "",
     "SKINNED ",
     "INSTANCED ",
-    "BILLBOARD "
+    "BILLBOARD ",
+    "SKINNED INSTANCED "
 };
 
 static const char* lightVSVariations[] =
@@ -247,6 +248,12 @@ static const char* heightFogVariations[] =
     "HEIGHTFOG "
 };
 
+static const char* clusteredLightVariations[] =
+{
+    "",
+    "CLUSTERED "
+};
+
 static const unsigned INSTANCING_BUFFER_MASK = MASK_INSTANCEMATRIX1 | MASK_INSTANCEMATRIX2 | MASK_INSTANCEMATRIX3;
 static const unsigned MAX_BUFFER_AGE = 1000;
 
@@ -276,6 +283,7 @@ Renderer::Renderer(Context* context) :
     specularLighting_(true),
     drawShadows_(true),
     reuseShadowMaps_(true),
+    cacheShadowMaps_(false),
     dynamicInstancing_(true),
     shadersDirty_(true),
     initialized_(false)
@@ -412,6 +420,19 @@ void Renderer::SetReuseShadowMaps(bool enable)
     reuseShadowMaps_ = enable;
 }
 
+void Renderer::SetCacheShadowMaps(bool enable)
+{
+    if (enable == cacheShadowMaps_)
+        return;
+    
+    cacheShadowMaps_ = enable;
+    if (!cacheShadowMaps_)
+    {
+        for (unsigned i = 0; i < views_.Size(); ++i)
+            views_[i]->ResetShadowMapCache();
+    }
+}
+
 void Renderer::SetMaxShadowMaps(int shadowMaps)
 {
     if (shadowMaps < 1)
@@ -791,6 +812,41 @@ Geometry* Renderer::GetQuadGeometry()
 }
 
 Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight)
+{
+    IntVector2 size = GetLightShadowMapSize(light, camera, viewWidth, viewHeight);
+    int width = size.x_;
+    int height = size.y_;
+    
+    int searchKey = (width << 16) | height;
+    if (shadowMaps_.Contains(searchKey))
+    {
+        // If shadow maps are reused, always return the first
+        if (reuseShadowMaps_)
+            return shadowMaps_[searchKey][0];
+        else
+        {
+            // If not reused, check allocation count and return existing shadow map if possible
+            unsigned allocated = shadowMapAllocations_[searchKey].Size();
+            if (allocated < shadowMaps_[searchKey].Size())
+            {
+                shadowMapAllocations_[searchKey].Push(light);
+                return shadowMaps_[searchKey][allocated];
+            }
+            else if ((int)allocated >= maxShadowMaps_)
+                return 0;
+        }
+    }
+    
+    // If failed to create, store a null pointer so that we will not retry
+    SharedPtr<Texture2D> newShadowMap = CreateShadowMap(width, height);
+    shadowMaps_[searchKey].Push(newShadowMap);
+    if (!reuseShadowMaps_)
+        shadowMapAllocations_[searchKey].Push(light);
+    
+    return newShadowMap;
+}
+
+IntVector2 Renderer::GetLightShadowMapSize(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight) const
 {
     LightType type = light->GetLightType();
     const FocusParameters& parameters = light->GetShadowFocus();
@@ -846,30 +902,15 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         height *= 3;
     }
     
-    int searchKey = (width << 16) | height;
-    if (shadowMaps_.Contains(searchKey))
-    {
-        // If shadow maps are reused, always return the first
-        if (reuseShadowMaps_)
-            return shadowMaps_[searchKey][0];
-        else
-        {
-            // If not reused, check allocation count and return existing shadow map if possible
-            unsigned allocated = shadowMapAllocations_[searchKey].Size();
-            if (allocated < shadowMaps_[searchKey].Size())
-            {
-                shadowMapAllocations_[searchKey].Push(light);
-                return shadowMaps_[searchKey][allocated];
-            }
-            else if ((int)allocated >= maxShadowMaps_)
-                return 0;
-        }
-    }
-    
+    return IntVector2(width, height);
+}
+
+SharedPtr<Texture2D> Renderer::CreateShadowMap(int width, int height)
+{
     unsigned shadowMapFormat = (shadowQuality_ & SHADOWQUALITY_LOW_24BIT) ? graphics_->GetHiresShadowMapFormat() :
         graphics_->GetShadowMapFormat();
     if (!shadowMapFormat)
-        return 0;
+        return SharedPtr<Texture2D>();
     
     SharedPtr<Texture2D> newShadowMap(new Texture2D(context_));
     int retries = 3;
@@ -901,6 +942,7 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
             if (dummyColorFormat)
             {
                 // If no dummy color rendertarget for this size exists yet, create one now
+                int searchKey = (width << 16) | height;
                 if (!colorShadowMaps_.Contains(searchKey))
                 {
                     colorShadowMaps_[searchKey] = new Texture2D(context_);
@@ -913,14 +955,9 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         }
     }
     
-    // If failed to set size, store a null pointer so that we will not retry
     if (!retries)
         newShadowMap.Reset();
     
-    shadowMaps_[searchKey].Push(newShadowMap);
-    if (!reuseShadowMaps_)
-        shadowMapAllocations_[searchKey].Push(light);
-    
     return newShadowMap;
 }
 
@@ -1034,7 +1071,7 @@ Camera* Renderer::GetShadowCamera()
     return camera;
 }
 
-void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
+bool Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, bool mainThread)
 {
     // Check if shaders are unloaded or need reloading
     Pass* pass = batch.pass_;
@@ -1043,6 +1080,10 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
     if (!vertexShaders.Size() || !pixelShaders.Size() || pass->GetShadersLoadedFrameNumber() !=
         shadersChangedFrameNumber_)
     {
+        // Shaders can only be loaded in the main thread
+        if (!mainThread)
+            return false;
+        
         // First release all previous shaders, then load
         pass->ReleaseShaders();
         LoadPassShaders(tech, pass->GetType());
@@ -1059,6 +1100,11 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
             (unsigned)maxInstanceTriangles_ * 3))
             batch.geometryType_ = GEOM_STATIC;
         
+        // Skinned geometry needs the skinning texture to be instanced. It is not limited by triangle count, as uploading
+        // the skin matrices of each object separately is expensive
+        if (batch.geometryType_ == GEOM_SKINNED_INSTANCED && !GetSkinningTexture())
+            batch.geometryType_ = GEOM_SKINNED;
+        
         if (batch.geometryType_ == GEOM_STATIC_NOINSTANCING)
             batch.geometryType_ = GEOM_STATIC;
         
@@ -1071,7 +1117,7 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
                 // Do not log error, as it would result in a lot of spam
                 batch.vertexShader_ = 0;
                 batch.pixelShader_ = 0;
-                return;
+                return true;
             }
             
             Light* light = lightQueue->light_;
@@ -1132,19 +1178,29 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
                 batch.vertexShader_ = vertexShaders[vsi];
             }
             
-            batch.pixelShader_ = pixelShaders[heightFog ? 1 : 0];
+            // Vertex lit passes may also add the clustered lights per pixel
+            unsigned psi = heightFog ? 1 : 0;
+            if (batch.clusteredLights_ && pixelShaders.Size() > 2)
+                psi += 2;
+            
+            batch.pixelShader_ = pixelShaders[psi];
         }
     }
     
     // Log error if shaders could not be assigned, but only once per technique
     if (!batch.vertexShader_ || !batch.pixelShader_)
     {
+        if (!mainThread)
+            return false;
+        
         if (!shaderErrorDisplayed_.Contains(tech))
         {
             shaderErrorDisplayed_.Insert(tech);
             LOGERROR("Technique " + tech->GetName() + " has missing shaders");
         }
     }
+    
+    return true;
 }
 
 void Renderer::SetLightVolumeBatchShaders(Batch& batch, const String& vsName, const String& psName)
@@ -1228,6 +1284,57 @@ bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
     return true;
 }
 
+bool Renderer::ResizeSkinningTexture(unsigned numRows)
+{
+    if (!skinningTexture_ || !dynamicInstancing_)
+        return false;
+    
+    int oldHeight = skinningTexture_->GetHeight();
+    if (numRows <= (unsigned)oldHeight)
+        return true;
+    
+    int newHeight = SKINNING_TEXTURE_DEFAULT_HEIGHT;
+    while ((unsigned)newHeight < numRows)
+        newHeight <<= 1;
+    
+    if (!skinningTexture_->SetSize(SKINNING_TEXTURE_WIDTH, newHeight, Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC))
+    {
+        LOGERROR("Failed to resize skinning texture to " + String(newHeight) + " rows");
+        // If failed, try to restore the old size
+        skinningTexture_->SetSize(SKINNING_TEXTURE_WIDTH, oldHeight, Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC);
+        return false;
+    }
+    
+    LOGDEBUG("Resized skinning texture to " + String(newHeight) + " rows");
+    return true;
+}
+
+bool Renderer::ResizeLightClusterTexture(unsigned numRows)
+{
+    if (!lightClusterTexture_)
+        return false;
+    
+    int oldHeight = lightClusterTexture_->GetHeight();
+    if (numRows <= (unsigned)oldHeight)
+        return true;
+    
+    int newHeight = LIGHT_CLUSTER_TEXTURE_DEFAULT_HEIGHT;
+    while ((unsigned)newHeight < numRows)
+        newHeight <<= 1;
+    
+    if (!lightClusterTexture_->SetSize(LIGHT_CLUSTER_TEXTURE_WIDTH, newHeight, Graphics::GetRGBAFloat32Format(),
+        TEXTURE_DYNAMIC))
+    {
+        LOGERROR("Failed to resize light cluster texture to " + String(newHeight) + " rows");
+        // If failed, try to restore the old size
+        lightClusterTexture_->SetSize(LIGHT_CLUSTER_TEXTURE_WIDTH, oldHeight, Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC);
+        return false;
+    }
+    
+    LOGDEBUG("Resized light cluster texture to " + String(newHeight) + " rows");
+    return true;
+}
+
 void Renderer::SaveScreenBufferAllocations()
 {
     savedScreenBufferAllocations_ = screenBufferAllocations_;
@@ -1419,6 +1526,7 @@ void Renderer::Initialize()
     
     CreateGeometries();
     CreateInstancingBuffer();
+    CreateLightClusterTexture();
     
     viewports_.Resize(1);
     ResetViews();
@@ -1533,11 +1641,13 @@ void Renderer::LoadPassShaders(Technique* tech, StringHash type)
             }
         }
         
-        pixelShaders.Resize(2);
-        for (unsigned j = 0; j < 2; ++j)
+        // Vertex lit passes get additional variations for clustered lights, if supported
+        unsigned numPixelShaders = pass->GetLightingMode() == LIGHTING_PERVERTEX && lightClusterTexture_ ? 4 : 2;
+        pixelShaders.Resize(numPixelShaders);
+        for (unsigned j = 0; j < numPixelShaders; ++j)
         {
             pixelShaders[j] = graphics_->GetShader(PS, pass->GetPixelShader(), pass->GetPixelShaderDefines() + " " +
-                heightFogVariations[j]);
+                heightFogVariations[j & 1] + clusteredLightVariations[j >> 1]);
         }
     }
     
@@ -1684,6 +1794,8 @@ void Renderer::SetIndirectionTextureData()
 
 void Renderer::CreateInstancingBuffer()
 {
+    skinningTexture_.Reset();
+    
     // Do not create buffer if instancing not supported
     if (!graphics_->GetInstancingSupport())
     {
@@ -1700,7 +1812,41 @@ void Renderer::CreateInstancingBuffer()
     {
         instancingBuffer_.Reset();
         dynamicInstancing_ = false;
+        return;
     }
+    
+    // Skinned geometry is instanced by reading the skin matrices from a texture in the vertex shader
+    if (graphics_->GetVertexTextureSupport())
+    {
+        skinningTexture_ = new Texture2D(context_);
+        skinningTexture_->SetNumLevels(1);
+        skinningTexture_->SetFilterMode(FILTER_NEAREST);
+        skinningTexture_->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+        skinningTexture_->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+        if (!skinningTexture_->SetSize(SKINNING_TEXTURE_WIDTH, SKINNING_TEXTURE_DEFAULT_HEIGHT,
+            Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC))
+            skinningTexture_.Reset();
+    }
+}
+
+void Renderer::CreateLightClusterTexture()
+{
+    lightClusterTexture_.Reset();
+    
+    // Clustered lights are looped over in the pixel shader, which needs SM3 and floating point textures
+    #ifndef GL_ES_VERSION_2_0
+    if (!graphics_->GetSM3Support())
+        return;
+    
+    lightClusterTexture_ = new Texture2D(context_);
+    lightClusterTexture_->SetNumLevels(1);
+    lightClusterTexture_->SetFilterMode(FILTER_NEAREST);
+    lightClusterTexture_->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+    lightClusterTexture_->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+    if (!lightClusterTexture_->SetSize(LIGHT_CLUSTER_TEXTURE_WIDTH, LIGHT_CLUSTER_TEXTURE_DEFAULT_HEIGHT,
+        Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC))
+        lightClusterTexture_.Reset();
+    #endif
 }
 
 void Renderer::ResetShadowMaps()
@@ -1708,6 +1854,10 @@ void Renderer::ResetShadowMaps()
     shadowMaps_.Clear();
     shadowMapAllocations_.Clear();
     colorShadowMaps_.Clear();
+    
+    // Also release the views' cached shadow maps, as their size or format is no longer valid
+    for (unsigned i = 0; i < views_.Size(); ++i)
+        views_[i]->ResetShadowMapCache();
 }
 
 void Renderer::ResetBuffers()
@@ -52,6 +52,15 @@ class Zone;
 
 static const int SHADOW_MIN_PIXELS = 64;
 static const int INSTANCING_BUFFER_DEFAULT_SIZE = 1024;
+static const int SKINNING_TEXTURE_WIDTH = 1024;
+static const int SKINNING_TEXTURE_DEFAULT_HEIGHT = 16;
+static const int LIGHT_CLUSTER_TEXTURE_WIDTH = 1024;
+static const int LIGHT_CLUSTER_TEXTURE_DEFAULT_HEIGHT = 16;
+static const int LIGHT_CLUSTERS_X = 16;
+static const int LIGHT_CLUSTERS_Y = 8;
+static const int LIGHT_CLUSTERS_Z = 24;
+static const int MAX_CLUSTERED_LIGHTS = 1024;
+static const int MAX_LIGHTS_PER_CLUSTER = 128;
 
 /// Light vertex shader variations.
 enum LightVSVariation
@@ -187,6 +196,8 @@ public:
     void SetReuseShadowMaps(bool enable);
     /// Set maximum number of shadow maps created for one resolution. Only has effect if reuse of shadow maps is disabled.
     void SetMaxShadowMaps(int shadowMaps);
+    /// Set caching of point and spot light shadow maps between frames. Default is false. If enabled, a shadow map is only rendered again when the light or a shadow caster inside its range changes.
+    void SetCacheShadowMaps(bool enable);
     /// Set dynamic instancing on/off.
     void SetDynamicInstancing(bool enable);
     /// Set minimum number of instances required in a batch group to render as instanced.
@@ -236,6 +247,8 @@ public:
     bool GetReuseShadowMaps() const { return reuseShadowMaps_; }
     /// Return maximum number of shadow maps per resolution.
     int GetMaxShadowMaps() const { return maxShadowMaps_; }
+    /// Return whether point and spot light shadow maps are cached between frames.
+    bool GetCacheShadowMaps() const { return cacheShadowMaps_; }
     /// Return whether dynamic instancing is in use.
     bool GetDynamicInstancing() const { return dynamicInstancing_; }
     /// Return minimum number of instances required in a batch group to render as instanced.
@@ -282,6 +295,10 @@ public:
     TextureCube* GetIndirectionCubeMap() const { return indirectionCubeMap_; }
     /// Return the instancing vertex buffer
     VertexBuffer* GetInstancingBuffer() const { return dynamicInstancing_ ? instancingBuffer_ : (VertexBuffer*)0; }
+    /// Return the skin matrix texture for instanced skinned geometry, or null if skinned geometry can not be instanced.
+    Texture2D* GetSkinningTexture() const { return dynamicInstancing_ ? skinningTexture_ : (Texture2D*)0; }
+    /// Return the light cluster texture for clustered forward lighting, or null if not supported.
+    Texture2D* GetLightClusterTexture() const { return lightClusterTexture_; }
     /// Return the frame update parameters.
     const FrameInfo& GetFrameInfo() const { return frame_; }
     
@@ -302,6 +319,10 @@ public:
     Geometry* GetQuadGeometry();
     /// Allocate a shadow map. If shadow map reuse is disabled, a different map is returned each time.
     Texture2D* GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight);
+    /// Return the shadow map size a light would use in a view.
+    IntVector2 GetLightShadowMapSize(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight) const;
+    /// Create a shadow map texture outside the shared shadow map pool. Used for cached shadow maps. Return null if failed.
+    SharedPtr<Texture2D> CreateShadowMap(int width, int height);
     /// Allocate a rendertarget or depth-stencil texture for deferred rendering or postprocessing. Should only be called during actual rendering, not before.
     Texture2D* GetScreenBuffer(int width, int height, unsigned format, bool filtered, bool srgb, unsigned persistentKey = 0);
     /// Allocate a depth-stencil surface that does not need to be readable. Should only be called during actual rendering, not before.
@@ -310,14 +331,18 @@ public:
     OcclusionBuffer* GetOcclusionBuffer(Camera* camera);
     /// Allocate a temporary shadow camera and a scene node for it. Is thread-safe.
     Camera* GetShadowCamera();
-    /// Choose shaders for a forward rendering batch.
-    void SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows = true);
+    /// Choose shaders for a forward rendering batch. Outside the main thread shaders are not loaded and errors are not logged; return false if the batch must be finished on the main thread instead.
+    bool SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows = true, bool mainThread = true);
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders(Batch& batch, const String& vsName, const String& psName);
     /// Set cull mode while taking possible projection flipping into account.
     void SetCullMode(CullMode mode, Camera* camera);
     /// Ensure sufficient size of the instancing vertex buffer. Return true if successful.
     bool ResizeInstancingBuffer(unsigned numInstances);
+    /// Ensure sufficient size of the skinning texture. Return true if successful.
+    bool ResizeSkinningTexture(unsigned numRows);
+    /// Ensure sufficient size of the light cluster texture. Return true if successful.
+    bool ResizeLightClusterTexture(unsigned numRows);
     /// Save the screen buffer allocation status. Called by View.
     void SaveScreenBufferAllocations();
     /// Restore the screen buffer allocation status. Called by View.
@@ -344,8 +369,10 @@ private:
     void ReloadTextures();
     /// Create light volume geometries.
     void CreateGeometries();
-    /// Create instancing vertex buffer.
+    /// Create instancing vertex buffer and skinning texture.
     void CreateInstancingBuffer();
+    /// Create the light cluster texture.
+    void CreateLightClusterTexture();
     /// Create point light shadow indirection texture data.
     void SetIndirectionTextureData();
     /// Prepare for rendering of a new view.
@@ -381,6 +408,10 @@ private:
     SharedPtr<Geometry> pointLightGeometry_;
     /// Instance stream vertex buffer.
     SharedPtr<VertexBuffer> instancingBuffer_;
+    /// Skin matrix texture for instanced skinned geometry.
+    SharedPtr<Texture2D> skinningTexture_;
+    /// Light cluster and light data texture for clustered forward lighting.
+    SharedPtr<Texture2D> lightClusterTexture_;
     /// Default material.
     SharedPtr<Material> defaultMaterial_;
     /// Default range attenuation texture.
@@ -477,6 +508,8 @@ private:
     bool drawShadows_;
     /// Shadow map reuse flag.
     bool reuseShadowMaps_;
+    /// Shadow map caching flag.
+    bool cacheShadowMaps_;
     /// Dynamic instancing flag.
     bool dynamicInstancing_;
     /// Shaders need reloading flag.
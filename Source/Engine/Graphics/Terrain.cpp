@@ -21,9 +21,12 @@
 //
 
 #include "Precompiled.h"
+#include "Camera.h"
 #include "Context.h"
 #include "DrawableEvents.h"
+#include "File.h"
 #include "Geometry.h"
+#include "GraphicsEvents.h"
 #include "Image.h"
 #include "IndexBuffer.h"
 #include "Log.h"
@@ -34,9 +37,12 @@
 #include "ResourceCache.h"
 #include "ResourceEvents.h"
 #include "Scene.h"
+#include "SceneEvents.h"
+#include "Sort.h"
 #include "Terrain.h"
 #include "TerrainPatch.h"
 #include "VertexBuffer.h"
+#include "WorkQueue.h"
 
 #include "DebugNew.h"
 
@@ -54,6 +60,97 @@ static const unsigned STITCH_NORTH = 1;
 static const unsigned STITCH_SOUTH = 2;
 static const unsigned STITCH_WEST = 4;
 static const unsigned STITCH_EAST = 8;
+static const int DEFAULT_PAGE_SIZE = 256;
+static const unsigned DEFAULT_MAX_PAGES = 16;
+static const unsigned MAX_PAGE_LOADS = 2;
+static const float PAGE_UNLOAD_DISTANCE_FACTOR = 1.25f;
+static const unsigned PATCH_VERTEX_FLOATS = 12;
+static const int MAX_BATCH_VERTICES = 256 * 1024;
+
+/// Patch vertex data generated by the worker threads, waiting to be uploaded by the main thread.
+struct TerrainPatchGeometry
+{
+    /// Patch.
+    TerrainPatch* patch_;
+    /// Vertex data for the vertex buffer.
+    SharedArrayPtr<float> vertexData_;
+    /// CPU-side position data for raycasts and occlusion.
+    SharedArrayPtr<unsigned char> cpuVertexData_;
+    /// Bounding box.
+    BoundingBox box_;
+    /// Whether to also calculate LOD errors.
+    bool calculateLodErrors_;
+};
+
+void CreatePatchGeometryWork(const WorkItem* item, unsigned threadIndex)
+{
+    const Terrain* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    TerrainPatchGeometry* start = reinterpret_cast<TerrainPatchGeometry*>(item->start_);
+    TerrainPatchGeometry* end = reinterpret_cast<TerrainPatchGeometry*>(item->end_);
+
+    while (start != end)
+    {
+        terrain->GeneratePatchVertices(start->patch_, start->vertexData_.Get(), (float*)start->cpuVertexData_.Get(),
+            start->box_);
+        if (start->calculateLodErrors_)
+            terrain->CalculateLodErrors(start->patch_);
+        ++start;
+    }
+}
+
+static void CopyHeightData(float* dest, const unsigned char* src, unsigned imgComps, unsigned imgRow, const IntVector2& size,
+    float heightScale)
+{
+    if (imgComps == 1)
+    {
+        for (int z = 0; z < size.y_; ++z)
+        {
+            for (int x = 0; x < size.x_; ++x)
+                *dest++ = (float)src[imgRow * (size.y_ - 1 - z) + x] * heightScale;
+        }
+    }
+    else
+    {
+        // If more than 1 component, use the green channel for more accuracy
+        for (int z = 0; z < size.y_; ++z)
+        {
+            for (int x = 0; x < size.x_; ++x)
+                *dest++ = ((float)src[imgRow * (size.y_ - 1 - z) + imgComps * x] + (float)src[imgRow *
+                    (size.y_ - 1 - z) + imgComps * x + 1] / 256.0f) * heightScale;
+        }
+    }
+}
+
+static void LoadTerrainPageWork(const WorkItem* item, unsigned threadIndex)
+{
+    TerrainPage* page = reinterpret_cast<TerrainPage*>(item->aux_);
+    int width, height;
+    unsigned components;
+    unsigned char* pixelData = Image::GetImageData(*page->file_, width, height, components);
+
+    if (pixelData && width == page->size_ && height == page->size_)
+    {
+        page->loadedHeightData_ = new float[width * height];
+        CopyHeightData(page->loadedHeightData_.Get(), pixelData, components, width * components, IntVector2(width, height),
+            page->heightScale_);
+    }
+    else
+        page->failed_ = true;
+
+    Image::FreeImageData(pixelData);
+}
+
+TerrainPage::TerrainPage(const IntVector2& coordinates) :
+    coordinates_(coordinates),
+    size_(0),
+    heightScale_(0.0f),
+    failed_(false)
+{
+}
+
+TerrainPage::~TerrainPage()
+{
+}
 
 Terrain::Terrain(Context* context) :
     Component(context),
@@ -64,6 +161,11 @@ Terrain::Terrain(Context* context) :
     numVertices_(IntVector2::ZERO),
     numPatches_(IntVector2::ZERO),
     patchSize_(DEFAULT_PATCH_SIZE),
+    numPages_(IntVector2::ZERO),
+    pageSize_(DEFAULT_PAGE_SIZE),
+    pageLoadDistance_(0.0f),
+    maxPages_(DEFAULT_MAX_PAGES),
+    numResidentPages_(0),
     numLodLevels_(1),
     smoothing_(false),
     visible_(true),
@@ -85,6 +187,7 @@ Terrain::Terrain(Context* context) :
 
 Terrain::~Terrain()
 {
+    WaitForPageLoads();
 }
 
 void Terrain::RegisterObject(Context* context)
@@ -108,6 +211,11 @@ void Terrain::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE(Terrain, VAR_INT, "Light Mask", GetLightMask, SetLightMask, unsigned, DEFAULT_LIGHTMASK, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE(Terrain, VAR_INT, "Shadow Mask", GetShadowMask, SetShadowMask, unsigned, DEFAULT_SHADOWMASK, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE(Terrain, VAR_INT, "Zone Mask", GetZoneMask, SetZoneMask, unsigned, DEFAULT_ZONEMASK, AM_DEFAULT);
+    ATTRIBUTE(Terrain, VAR_STRING, "Page Name Pattern", pageNamePattern_, String::EMPTY, AM_DEFAULT);
+    ATTRIBUTE(Terrain, VAR_INTVECTOR2, "Number of Pages", numPages_, IntVector2::ZERO, AM_DEFAULT);
+    ATTRIBUTE(Terrain, VAR_INT, "Page Size", pageSize_, DEFAULT_PAGE_SIZE, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(Terrain, VAR_FLOAT, "Page Load Distance", GetPageLoadDistance, SetPageLoadDistance, float, 0.0f, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(Terrain, VAR_INT, "Max Pages", GetMaxPages, SetMaxPages, unsigned, DEFAULT_MAX_PAGES, AM_DEFAULT);
 }
 
 void Terrain::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
@@ -180,6 +288,28 @@ bool Terrain::SetHeightMap(Image* image)
     return success;
 }
 
+void Terrain::SetPagedHeightMap(const String& namePattern, const IntVector2& numPages, int pageSize)
+{
+    pageNamePattern_ = namePattern;
+    numPages_ = numPages;
+    pageSize_ = pageSize;
+
+    CreateGeometry();
+    MarkNetworkUpdate();
+}
+
+void Terrain::SetPageLoadDistance(float distance)
+{
+    pageLoadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void Terrain::SetMaxPages(unsigned num)
+{
+    maxPages_ = Max((int)num, 1);
+    MarkNetworkUpdate();
+}
+
 void Terrain::SetMaterial(Material* material)
 {
     material_ = material;
@@ -343,6 +473,15 @@ TerrainPatch* Terrain::GetPatch(int x, int z) const
 {
     if (x < 0 || x >= numPatches_.x_ || z < 0 || z >= numPatches_.y_)
         return 0;
+    else if (pages_.Size())
+    {
+        int pagePatches = pageSize_ / patchSize_;
+        TerrainPage* page = pages_[(z / pagePatches) * numPages_.x_ + x / pagePatches];
+        if (!page || page->patches_.Empty())
+            return 0;
+        else
+            return page->patches_[(z % pagePatches) * pagePatches + x % pagePatches];
+    }
     else
         return GetPatch(z * numPatches_.x_ + x);
 }
@@ -419,65 +558,123 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
     PROFILE(CreatePatchGeometry);
 
     unsigned row = patchSize_ + 1;
-    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
-    Geometry* geometry = patch->GetGeometry();
-    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
-    Geometry* minLodGeometry = patch->GetMinLodGeometry();
+    SharedArrayPtr<float> vertexData(new float[row * row * PATCH_VERTEX_FLOATS]);
+    SharedArrayPtr<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
+    BoundingBox box;
 
-    if (vertexBuffer->GetVertexCount() != row * row)
-        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+    GeneratePatchVertices(patch, vertexData.Get(), (float*)cpuVertexData.Get(), box);
+    SetPatchGeometry(patch, vertexData.Get(), cpuVertexData, box);
+}
 
-    SharedArrayPtr<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
+void Terrain::CreatePatchGeometries(const PODVector<TerrainPatch*>& patches, bool calculateLodErrors)
+{
+    PROFILE(CreatePatchGeometries);
 
-    float* vertexData = (float*)vertexBuffer->Lock(0, vertexBuffer->GetVertexCount());
-    float* positionData = (float*)cpuVertexData.Get();
-    BoundingBox box;
+    if (patches.Empty())
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned row = patchSize_ + 1;
+    unsigned numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
 
-    if (vertexData)
+    // Generate the vertex data in batches to bound the temporary memory use
+    unsigned batchSize = Min(Max(MAX_BATCH_VERTICES / (int)(row * row), 1), (int)patches.Size());
+    Vector<TerrainPatchGeometry> geometries(batchSize);
+    for (unsigned i = 0; i < batchSize; ++i)
     {
-        const IntVector2& coords = patch->GetCoordinates();
+        geometries[i].vertexData_ = new float[row * row * PATCH_VERTEX_FLOATS];
+        geometries[i].calculateLodErrors_ = calculateLodErrors;
+    }
 
-        for (int z1 = 0; z1 <= patchSize_; ++z1)
+    for (unsigned batchStart = 0; batchStart < patches.Size(); batchStart += batchSize)
+    {
+        unsigned count = Min((int)batchSize, (int)(patches.Size() - batchStart));
+        for (unsigned i = 0; i < count; ++i)
         {
-            for (int x1 = 0; x1 <= patchSize_; ++x1)
-            {
-                int xPos = coords.x_ * patchSize_ + x1;
-                int zPos = coords.y_ * patchSize_ + z1;
-
-                // Position
-                Vector3 position((float)x1 * spacing_.x_, GetRawHeight(xPos, zPos), (float)z1 * spacing_.z_);
-                *vertexData++ = position.x_;
-                *vertexData++ = position.y_;
-                *vertexData++ = position.z_;
-                *positionData++ = position.x_;
-                *positionData++ = position.y_;
-                *positionData++ = position.z_;
-
-                box.Merge(position);
-
-                // Normal
-                Vector3 normal = GetRawNormal(xPos, zPos);
-                *vertexData++ = normal.x_;
-                *vertexData++ = normal.y_;
-                *vertexData++ = normal.z_;
-
-                // Texture coordinate
-                Vector2 texCoord((float)xPos / (float)numVertices_.x_, 1.0f - (float)zPos / (float)numVertices_.y_);
-                *vertexData++ = texCoord.x_;
-                *vertexData++ = texCoord.y_;
-
-                // Tangent
-                Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
-                *vertexData++ = xyz.x_;
-                *vertexData++ = xyz.y_;
-                *vertexData++ = xyz.z_;
-                *vertexData++ = 1.0f;
-            }
+            geometries[i].patch_ = patches[batchStart + i];
+            geometries[i].cpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+        }
+
+        unsigned patchesPerItem = (count + numWorkItems - 1) / numWorkItems;
+        for (unsigned start = 0; start < count; start += patchesPerItem)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = CreatePatchGeometryWork;
+            item->aux_ = this;
+            item->start_ = &geometries[0] + start;
+            item->end_ = &geometries[0] + Min((int)(start + patchesPerItem), (int)count);
+            queue->AddWorkItem(item);
         }
 
-        vertexBuffer->Unlock();
-        vertexBuffer->ClearDataLost();
+        queue->Complete(M_MAX_UNSIGNED);
+
+        // GPU buffers can only be accessed from the main thread
+        for (unsigned i = 0; i < count; ++i)
+        {
+            SetPatchGeometry(geometries[i].patch_, geometries[i].vertexData_.Get(), geometries[i].cpuVertexData_,
+                geometries[i].box_);
+            geometries[i].cpuVertexData_.Reset();
+        }
+    }
+}
+
+void Terrain::GeneratePatchVertices(TerrainPatch* patch, float* vertexData, float* positionData, BoundingBox& box) const
+{
+    const IntVector2& coords = patch->GetCoordinates();
+    box.Clear();
+
+    for (int z1 = 0; z1 <= patchSize_; ++z1)
+    {
+        for (int x1 = 0; x1 <= patchSize_; ++x1)
+        {
+            int xPos = coords.x_ * patchSize_ + x1;
+            int zPos = coords.y_ * patchSize_ + z1;
+
+            // Position
+            Vector3 position((float)x1 * spacing_.x_, GetRawHeight(xPos, zPos), (float)z1 * spacing_.z_);
+            *vertexData++ = position.x_;
+            *vertexData++ = position.y_;
+            *vertexData++ = position.z_;
+            *positionData++ = position.x_;
+            *positionData++ = position.y_;
+            *positionData++ = position.z_;
+
+            box.Merge(position);
+
+            // Normal
+            Vector3 normal = GetRawNormal(xPos, zPos);
+            *vertexData++ = normal.x_;
+            *vertexData++ = normal.y_;
+            *vertexData++ = normal.z_;
+
+            // Texture coordinate
+            Vector2 texCoord((float)xPos / (float)numVertices_.x_, 1.0f - (float)zPos / (float)numVertices_.y_);
+            *vertexData++ = texCoord.x_;
+            *vertexData++ = texCoord.y_;
+
+            // Tangent
+            Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
+            *vertexData++ = xyz.x_;
+            *vertexData++ = xyz.y_;
+            *vertexData++ = xyz.z_;
+            *vertexData++ = 1.0f;
+        }
     }
+}
+
+void Terrain::SetPatchGeometry(TerrainPatch* patch, const float* vertexData, SharedArrayPtr<unsigned char> cpuVertexData,
+    const BoundingBox& box)
+{
+    unsigned row = patchSize_ + 1;
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    Geometry* geometry = patch->GetGeometry();
+    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
+    Geometry* minLodGeometry = patch->GetMinLodGeometry();
+
+    if (vertexBuffer->GetVertexCount() != row * row)
+        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+    vertexBuffer->SetData(vertexData);
 
     patch->SetBoundingBox(box);
 
@@ -575,6 +772,18 @@ void Terrain::CreateGeometry()
 
     unsigned prevNumPatches = patches_.Size();
 
+    // Discard old pages. Any pending loads refer to them, so must finish first
+    WaitForPageLoads();
+    pages_.Clear();
+    numResidentPages_ = 0;
+
+    bool paged = !pageNamePattern_.Empty() && numPages_.x_ > 0 && numPages_.y_ > 0;
+    if (paged && (pageSize_ < patchSize_ || pageSize_ % patchSize_))
+    {
+        LOGERROR("Terrain page size must be a multiple of the patch size");
+        paged = false;
+    }
+
     // Determine number of LOD levels
     unsigned lodSize = patchSize_;
     numLodLevels_ = 1;
@@ -586,13 +795,20 @@ void Terrain::CreateGeometry()
 
     // Determine total terrain size
     patchWorldSize_ = Vector2(spacing_.x_ * (float)patchSize_, spacing_.z_ * (float)patchSize_);
-    if (heightMap_)
+    if (paged || heightMap_)
     {
-        numPatches_ = IntVector2((heightMap_->GetWidth() - 1) / patchSize_, (heightMap_->GetHeight() - 1) / patchSize_);
+        if (paged)
+            numPatches_ = IntVector2(numPages_.x_ * pageSize_ / patchSize_, numPages_.y_ * pageSize_ / patchSize_);
+        else
+            numPatches_ = IntVector2((heightMap_->GetWidth() - 1) / patchSize_, (heightMap_->GetHeight() - 1) / patchSize_);
         numVertices_ = IntVector2(numPatches_.x_ * patchSize_ + 1, numPatches_.y_ * patchSize_ + 1);
         patchWorldOrigin_ = Vector2(-0.5f * (float)numPatches_.x_ * patchWorldSize_.x_, -0.5f * (float)numPatches_.y_ *
             patchWorldSize_.y_);
-        heightData_ = new float[numVertices_.x_ * numVertices_.y_];
+        // Paged terrain keeps the height data in the pages
+        if (paged)
+            heightData_.Reset();
+        else
+            heightData_ = new float[numVertices_.x_ * numVertices_.y_];
     }
     else
     {
@@ -602,7 +818,7 @@ void Terrain::CreateGeometry()
         heightData_.Reset();
     }
 
-    // Remove old patch nodes which are not needed
+    // Remove old patch nodes which are not needed. Paged terrain creates its patches on demand, so remove all
     PODVector<Node*> oldPatchNodes;
     node_->GetChildrenWithComponent<TerrainPatch>(oldPatchNodes);
     for (PODVector<Node*>::Iterator i = oldPatchNodes.Begin(); i != oldPatchNodes.End(); ++i)
@@ -617,38 +833,36 @@ void Terrain::CreateGeometry()
                 nodeOk = true;
         }
 
-        if (!nodeOk)
+        if (!nodeOk || paged)
             node_->RemoveChild(*i);
     }
 
     patches_.Clear();
 
-    if (heightMap_)
+    if (paged)
+    {
+        // Pages and their patches are created as cameras approach them
+        pages_.Resize(numPages_.x_ * numPages_.y_);
+        CreateIndexData();
+
+        SubscribeToEvent(E_BEGINVIEWUPDATE, HANDLER(Terrain, HandleBeginViewUpdate));
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(Terrain, HandleScenePostUpdate));
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_BEGINVIEWUPDATE);
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        viewPositions_.Clear();
+    }
+
+    if (heightMap_ && !paged)
     {
         // Copy heightmap data
-        const unsigned char* src = heightMap_->GetData();
-        float* dest = heightData_;
         unsigned imgComps = heightMap_->GetComponents();
-        unsigned imgRow = heightMap_->GetWidth() * imgComps;
-
-        if (imgComps == 1)
-        {
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                    *dest++ = (float)src[imgRow * (numVertices_.y_ - 1 - z) + x] * spacing_.y_;
-            }
-        }
-        else
-        {
-            // If more than 1 component, use the green channel for more accuracy
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                    *dest++ = ((float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x] + (float)src[imgRow *
-                        (numVertices_.y_ - 1 - z) + imgComps * x + 1] / 256.0f) * spacing_.y_;
-            }
-        }
+        CopyHeightData(heightData_.Get(), heightMap_->GetData(), imgComps, heightMap_->GetWidth() * imgComps, numVertices_,
+            spacing_.y_);
 
         if (smoothing_)
             SmoothHeightMap();
@@ -661,58 +875,23 @@ void Terrain::CreateGeometry()
         for (int z = 0; z < numPatches_.y_; ++z)
         {
             for (int x = 0; x < numPatches_.x_; ++x)
-            {
-                String nodeName = "Patch_" + String(x) + "_" + String(z);
-                Node* patchNode = node_->GetChild(nodeName);
-                
-                if (!patchNode)
-                {
-                    // Create the patch scene node as local and temporary so that it is not unnecessarily serialized to either
-                    // file or replicated over the network
-                    patchNode = node_->CreateChild(nodeName, LOCAL);
-                    patchNode->SetTemporary(true);
-                }
-                
-                patchNode->SetPosition(Vector3(patchWorldOrigin_.x_ + (float)x * patchWorldSize_.x_, 0.0f, patchWorldOrigin_.y_ +
-                    (float)z * patchWorldSize_.y_));
-
-                TerrainPatch* patch = patchNode->GetOrCreateComponent<TerrainPatch>();
-                patch->SetOwner(this);
-                patch->SetCoordinates(IntVector2(x, z));
-
-                // Copy initial drawable parameters
-                patch->SetEnabled(enabled);
-                patch->SetMaterial(material_);
-                patch->SetDrawDistance(drawDistance_);
-                patch->SetShadowDistance(shadowDistance_);
-                patch->SetLodBias(lodBias_);
-                patch->SetViewMask(viewMask_);
-                patch->SetLightMask(lightMask_);
-                patch->SetShadowMask(shadowMask_);
-                patch->SetZoneMask(zoneMask_);
-                patch->SetMaxLights(maxLights_);
-                patch->SetCastShadows(castShadows_);
-                patch->SetOccluder(occluder_);
-                patch->SetOccludee(occludee_);
-
-                patches_.Push(WeakPtr<TerrainPatch>(patch));
-            }
+                patches_.Push(WeakPtr<TerrainPatch>(CreatePatch(x, z, enabled)));
         }
 
         // Create the shared index data
         CreateIndexData();
 
         // Create vertex data for patches
+        PODVector<TerrainPatch*> newPatches(patches_.Size());
+        for (unsigned i = 0; i < patches_.Size(); ++i)
+            newPatches[i] = patches_[i];
+        CreatePatchGeometries(newPatches, true);
         for (Vector<WeakPtr<TerrainPatch> >::Iterator i = patches_.Begin(); i != patches_.End(); ++i)
-        {
-            CreatePatchGeometry(*i);
-            CalculateLodErrors(*i);
             SetNeighbors(*i);
-        }
     }
 
     // Send event only if new geometry was generated, or the old was cleared
-    if (patches_.Size() || prevNumPatches)
+    if (patches_.Size() || prevNumPatches || paged)
     {
         using namespace TerrainCreated;
 
@@ -910,8 +1089,48 @@ void Terrain::CreateIndexData()
     }
 }
 
+TerrainPatch* Terrain::CreatePatch(int x, int z, bool enabled)
+{
+    String nodeName = "Patch_" + String(x) + "_" + String(z);
+    Node* patchNode = node_->GetChild(nodeName);
+
+    if (!patchNode)
+    {
+        // Create the patch scene node as local and temporary so that it is not unnecessarily serialized to either
+        // file or replicated over the network
+        patchNode = node_->CreateChild(nodeName, LOCAL);
+        patchNode->SetTemporary(true);
+    }
+
+    patchNode->SetPosition(Vector3(patchWorldOrigin_.x_ + (float)x * patchWorldSize_.x_, 0.0f, patchWorldOrigin_.y_ +
+        (float)z * patchWorldSize_.y_));
+
+    TerrainPatch* patch = patchNode->GetOrCreateComponent<TerrainPatch>();
+    patch->SetOwner(this);
+    patch->SetCoordinates(IntVector2(x, z));
+
+    // Copy initial drawable parameters
+    patch->SetEnabled(enabled);
+    patch->SetMaterial(material_);
+    patch->SetDrawDistance(drawDistance_);
+    patch->SetShadowDistance(shadowDistance_);
+    patch->SetLodBias(lodBias_);
+    patch->SetViewMask(viewMask_);
+    patch->SetLightMask(lightMask_);
+    patch->SetShadowMask(shadowMask_);
+    patch->SetZoneMask(zoneMask_);
+    patch->SetMaxLights(maxLights_);
+    patch->SetCastShadows(castShadows_);
+    patch->SetOccluder(occluder_);
+    patch->SetOccludee(occludee_);
+
+    return patch;
+}
+
 float Terrain::GetRawHeight(int x, int z) const
 {
+    if (pages_.Size())
+        return GetPagedHeight(x, z);
     if (!heightData_)
         return 0.0f;
 
@@ -920,6 +1139,43 @@ float Terrain::GetRawHeight(int x, int z) const
     return heightData_[z * numVertices_.x_ + x];
 }
 
+float Terrain::GetPagedHeight(int x, int z) const
+{
+    static const int offsets[] = { 0, -1, 1 };
+
+    x = Clamp(x, 0, numVertices_.x_ - 1);
+    z = Clamp(z, 0, numVertices_.y_ - 1);
+    int pageX = Min(x / pageSize_, numPages_.x_ - 1);
+    int pageZ = Min(z / pageSize_, numPages_.y_ - 1);
+    int row = pageSize_ + 1;
+
+    // Vertices on the page edges are shared with the neighbor pages, so any of them can be used. If the position is not on
+    // a loaded page, clamp to the nearest loaded neighbor page
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        int z1 = pageZ + offsets[i];
+        if (z1 < 0 || z1 >= numPages_.y_)
+            continue;
+
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            int x1 = pageX + offsets[j];
+            if (x1 < 0 || x1 >= numPages_.x_)
+                continue;
+
+            const TerrainPage* page = pages_[z1 * numPages_.x_ + x1];
+            if (page && page->heightData_)
+            {
+                int localX = Clamp(x - x1 * pageSize_, 0, pageSize_);
+                int localZ = Clamp(z - z1 * pageSize_, 0, pageSize_);
+                return page->heightData_[localZ * row + localX];
+            }
+        }
+    }
+
+    return 0.0f;
+}
+
 float Terrain::GetLodHeight(int x, int z, unsigned lodLevel) const
 {
     unsigned offset = 1 << lodLevel;
@@ -969,10 +1225,8 @@ Vector3 Terrain::GetRawNormal(int x, int z) const
         Vector3(nwSlope, up, nwSlope)).Normalized();
 }
 
-void Terrain::CalculateLodErrors(TerrainPatch* patch)
+void Terrain::CalculateLodErrors(TerrainPatch* patch) const
 {
-    PROFILE(CalculateLodErrors);
-
     const IntVector2& coords = patch->GetCoordinates();
     PODVector<float>& lodErrors = patch->GetLodErrors();
     lodErrors.Clear();
@@ -1046,4 +1300,270 @@ void Terrain::HandleHeightMapReloadFinished(StringHash eventType, VariantMap& ev
     CreateGeometry();
 }
 
+void Terrain::WaitForPageLoads()
+{
+    for (Vector<SharedPtr<TerrainPage> >::ConstIterator i = pages_.Begin(); i != pages_.End(); ++i)
+    {
+        if (*i && (*i)->loadItem_)
+        {
+            GetSubsystem<WorkQueue>()->Complete(0);
+            break;
+        }
+    }
+}
+
+void Terrain::UpdatePages()
+{
+    PROFILE(UpdateTerrainPages);
+
+    unsigned numLoading = 0;
+    bool patchesCreated = false;
+
+    // Finish completed loads. Create the patches of at most one page per frame to limit the frame time spike
+    for (Vector<SharedPtr<TerrainPage> >::Iterator i = pages_.Begin(); i != pages_.End(); ++i)
+    {
+        TerrainPage* page = *i;
+        if (!page)
+            continue;
+
+        if (page->loadItem_)
+        {
+            if (!page->loadItem_->completed_)
+            {
+                ++numLoading;
+                continue;
+            }
+
+            page->loadItem_.Reset();
+            page->file_.Reset();
+            if (page->failed_)
+                LOGERROR("Failed to load terrain page " + GetPageName(page->coordinates_) + ", dimensions must be " +
+                    String(pageSize_ + 1) + "x" + String(pageSize_ + 1));
+            else
+            {
+                page->heightData_ = page->loadedHeightData_;
+                page->loadedHeightData_.Reset();
+            }
+        }
+
+        if (page->heightData_ && page->patches_.Empty() && !patchesCreated)
+        {
+            CreatePagePatches(page);
+            patchesCreated = true;
+        }
+    }
+
+    // If nothing was rendered since the last update, keep the current pages
+    if (viewPositions_.Empty())
+        return;
+
+    float loadDistance = pageLoadDistance_ > 0.0f ? pageLoadDistance_ : (float)pageSize_ * Max(spacing_.x_, spacing_.z_);
+    float unloadDistance = loadDistance * PAGE_UNLOAD_DISTANCE_FACTOR;
+
+    // Find the pages within load distance of any camera, and the distances of the resident pages
+    PODVector<Pair<float, unsigned> > wantedPages;
+    PODVector<Pair<float, unsigned> > residentPages;
+    for (int z = 0; z < numPages_.y_; ++z)
+    {
+        for (int x = 0; x < numPages_.x_; ++x)
+        {
+            unsigned index = z * numPages_.x_ + x;
+            float distance = M_INFINITY;
+            for (unsigned i = 0; i < viewPositions_.Size(); ++i)
+                distance = Min(distance, GetPageDistance(IntVector2(x, z), viewPositions_[i]));
+
+            if (distance <= loadDistance)
+                wantedPages.Push(MakePair(distance, index));
+            if (pages_[index])
+                residentPages.Push(MakePair(distance, index));
+        }
+    }
+
+    viewPositions_.Clear();
+
+    // If more pages are wanted than can be resident, prefer the nearest
+    Sort(wantedPages.Begin(), wantedPages.End());
+    if (wantedPages.Size() > maxPages_)
+        wantedPages.Resize(maxPages_);
+
+    HashSet<unsigned> wantedSet;
+    unsigned numMissing = 0;
+    for (unsigned i = 0; i < wantedPages.Size(); ++i)
+    {
+        wantedSet.Insert(wantedPages[i].second_);
+        if (!pages_[wantedPages[i].second_])
+            ++numMissing;
+    }
+
+    // Unload pages beyond the unload distance, and the furthest unneeded pages if the wanted pages would not fit. Pages
+    // still loading can not be unloaded before the load finishes
+    Sort(residentPages.Begin(), residentPages.End());
+    for (int i = (int)residentPages.Size() - 1; i >= 0; --i)
+    {
+        unsigned index = residentPages[i].second_;
+        TerrainPage* page = pages_[index];
+        if (page->loadItem_ || wantedSet.Contains(index))
+            continue;
+
+        if (residentPages[i].first_ > unloadDistance || numResidentPages_ + numMissing > maxPages_)
+            RemovePage(page);
+    }
+
+    // Start loading the missing pages, nearest first. Without worker threads the pages are loaded immediately, so load
+    // at most one per frame
+    bool threaded = GetSubsystem<WorkQueue>()->GetNumThreads() > 0;
+    for (unsigned i = 0; i < wantedPages.Size() && numLoading < MAX_PAGE_LOADS && numResidentPages_ < maxPages_; ++i)
+    {
+        unsigned index = wantedPages[i].second_;
+        if (pages_[index])
+            continue;
+
+        SharedPtr<TerrainPage> page(new TerrainPage(IntVector2(index % numPages_.x_, index / numPages_.x_)));
+        pages_[index] = page;
+        ++numResidentPages_;
+        if (LoadPage(page))
+        {
+            ++numLoading;
+            if (!threaded)
+                break;
+        }
+    }
+}
+
+bool Terrain::LoadPage(TerrainPage* page)
+{
+    page->file_ = GetSubsystem<ResourceCache>()->GetFile(GetPageName(page->coordinates_));
+    if (!page->file_)
+    {
+        page->failed_ = true;
+        return false;
+    }
+
+    page->size_ = pageSize_ + 1;
+    page->heightScale_ = spacing_.y_;
+
+    // Use a low priority so that the rendering work does not wait for the load, and an unpooled work item so that it can
+    // be polled for completion
+    SharedPtr<WorkItem> item(new WorkItem());
+    item->workFunction_ = LoadTerrainPageWork;
+    item->aux_ = page;
+    item->priority_ = 0;
+    page->loadItem_ = item;
+
+    // Without worker threads the work queue would run the item only when the next frame begins, possibly together with
+    // other page loads, and not at all if no frames are run. Decode the page now instead, it is finished on the next update
+    // like a background load
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads())
+        queue->AddWorkItem(item);
+    else
+    {
+        LoadTerrainPageWork(item, 0);
+        item->completed_ = true;
+    }
+
+    return true;
+}
+
+void Terrain::CreatePagePatches(TerrainPage* page)
+{
+    PROFILE(CreatePagePatches);
+
+    int pagePatches = pageSize_ / patchSize_;
+    int xStart = page->coordinates_.x_ * pagePatches;
+    int zStart = page->coordinates_.y_ * pagePatches;
+    int xEnd = xStart + pagePatches;
+    int zEnd = zStart + pagePatches;
+    bool enabled = IsEnabledEffective();
+
+    PODVector<TerrainPatch*> newPatches;
+    newPatches.Reserve(pagePatches * pagePatches);
+    page->patches_.Reserve(pagePatches * pagePatches);
+    for (int z = zStart; z < zEnd; ++z)
+    {
+        for (int x = xStart; x < xEnd; ++x)
+        {
+            TerrainPatch* patch = CreatePatch(x, z, enabled);
+            newPatches.Push(patch);
+            page->patches_.Push(WeakPtr<TerrainPatch>(patch));
+            patches_.Push(WeakPtr<TerrainPatch>(patch));
+        }
+    }
+
+    CreatePatchGeometries(newPatches, true);
+    for (PODVector<TerrainPatch*>::Iterator i = newPatches.Begin(); i != newPatches.End(); ++i)
+        SetNeighbors(*i);
+
+    // Connect the surrounding patches of the neighbor pages for LOD stitching, and regenerate them so that their edge normals
+    // use the heights of this page
+    PODVector<TerrainPatch*> neighborPatches;
+    for (int z = zStart - 1; z <= zEnd; ++z)
+    {
+        for (int x = xStart - 1; x <= xEnd; ++x)
+        {
+            if (x >= xStart && x < xEnd && z >= zStart && z < zEnd)
+                continue;
+
+            TerrainPatch* patch = GetPatch(x, z);
+            if (patch)
+                neighborPatches.Push(patch);
+        }
+    }
+
+    CreatePatchGeometries(neighborPatches, false);
+    for (PODVector<TerrainPatch*>::Iterator i = neighborPatches.Begin(); i != neighborPatches.End(); ++i)
+        SetNeighbors(*i);
+}
+
+void Terrain::RemovePage(TerrainPage* page)
+{
+    // The neighbor patches refer to the removed patches through weak pointers, so they stop stitching to them automatically
+    for (Vector<WeakPtr<TerrainPatch> >::Iterator i = page->patches_.Begin(); i != page->patches_.End(); ++i)
+    {
+        TerrainPatch* patch = *i;
+        if (patch)
+        {
+            patches_.Remove(*i);
+            node_->RemoveChild(patch->GetNode());
+        }
+    }
+
+    pages_[page->coordinates_.y_ * numPages_.x_ + page->coordinates_.x_].Reset();
+    --numResidentPages_;
+}
+
+String Terrain::GetPageName(const IntVector2& coords) const
+{
+    return pageNamePattern_.Replaced("{X}", String(coords.x_)).Replaced("{Z}", String(coords.y_));
+}
+
+float Terrain::GetPageDistance(const IntVector2& coords, const Vector3& position) const
+{
+    Vector2 pageWorldSize((float)pageSize_ * spacing_.x_, (float)pageSize_ * spacing_.z_);
+    float minX = patchWorldOrigin_.x_ + (float)coords.x_ * pageWorldSize.x_;
+    float minZ = patchWorldOrigin_.y_ + (float)coords.y_ * pageWorldSize.y_;
+    float dx = Max(Max(minX - position.x_, position.x_ - minX - pageWorldSize.x_), 0.0f);
+    float dz = Max(Max(minZ - position.z_, position.z_ - minZ - pageWorldSize.y_), 0.0f);
+
+    return sqrtf(dx * dx + dz * dz);
+}
+
+void Terrain::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace BeginViewUpdate;
+
+    // Check that we are updating the correct scene
+    if (!node_ || GetScene() != eventData[P_SCENE].GetPtr())
+        return;
+
+    Camera* camera = static_cast<Camera*>(eventData[P_CAMERA].GetPtr());
+    if (camera && camera->GetNode())
+        viewPositions_.Push(node_->GetWorldTransform().Inverse() * camera->GetNode()->GetWorldPosition());
+}
+
+void Terrain::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    UpdatePages();
+}
+
 }
@@ -27,14 +27,47 @@
 namespace Urho3D
 {
 
+class BoundingBox;
+class File;
 class Image;
 class Material;
 class Node;
 class TerrainPatch;
+struct WorkItem;
+
+/// %Terrain heightmap page for paged terrain.
+struct TerrainPage : public RefCounted
+{
+    /// Construct.
+    TerrainPage(const IntVector2& coordinates);
+    /// Destruct.
+    ~TerrainPage();
+
+    /// Page coordinates.
+    IntVector2 coordinates_;
+    /// Heightmap file being loaded.
+    SharedPtr<File> file_;
+    /// Background load work item. Null when not loading.
+    SharedPtr<WorkItem> loadItem_;
+    /// Height data written by the background load. Only accessed by the main thread after the load has completed.
+    SharedArrayPtr<float> loadedHeightData_;
+    /// Height data. Null until loaded.
+    SharedArrayPtr<float> heightData_;
+    /// Patches created from the page.
+    Vector<WeakPtr<TerrainPatch> > patches_;
+    /// Page size in vertices per side.
+    int size_;
+    /// Height scale applied on load.
+    float heightScale_;
+    /// Load failed flag.
+    bool failed_;
+};
 
 /// Heightmap terrain component.
 class URHO3D_API Terrain : public Component
 {
+    friend void CreatePatchGeometryWork(const WorkItem* item, unsigned threadIndex);
+
     OBJECT(Terrain);
 
 public:
@@ -60,6 +93,12 @@ public:
     void SetSmoothing(bool enable);
     /// Set heightmap image. Dimensions should be a power of two + 1. Uses 8-bit grayscale, or optionally red as MSB and green as LSB for 16-bit accuracy. Return true if successful.
     bool SetHeightMap(Image* image);
+    /// Set paged heightmap. Page images are loaded on demand around the cameras; their names are formed from the pattern by replacing {X} and {Z} with the page coordinates. Page size is quads per side and must be a multiple of the patch size; page image dimensions must be page size + 1. A non-empty pattern overrides the heightmap image.
+    void SetPagedHeightMap(const String& namePattern, const IntVector2& numPages, int pageSize);
+    /// Set distance from the cameras within which pages are loaded. Default 0 uses the page size.
+    void SetPageLoadDistance(float distance);
+    /// Set maximum number of resident pages.
+    void SetMaxPages(unsigned num);
     /// Set material.
     void SetMaterial(Material* material);
     /// Set draw distance for patches.
@@ -97,9 +136,23 @@ public:
     bool GetSmoothing() const { return smoothing_; }
     /// Return heightmap image.
     Image* GetHeightMap() const;
+    /// Return whether is using a paged heightmap.
+    bool IsPaged() const { return !pages_.Empty(); }
+    /// Return paged heightmap name pattern.
+    const String& GetPageNamePattern() const { return pageNamePattern_; }
+    /// Return number of heightmap pages.
+    const IntVector2& GetNumPages() const { return numPages_; }
+    /// Return page size, quads per side.
+    int GetPageSize() const { return pageSize_; }
+    /// Return page load distance.
+    float GetPageLoadDistance() const { return pageLoadDistance_; }
+    /// Return maximum number of resident pages.
+    unsigned GetMaxPages() const { return maxPages_; }
+    /// Return number of resident pages, including those still loading.
+    unsigned GetNumResidentPages() const { return numResidentPages_; }
     /// Return material.
     Material* GetMaterial() const;
-    /// Return patch by index.
+    /// Return patch by index. For paged terrain only the patches of loaded pages are included.
     TerrainPatch* GetPatch(unsigned index) const;
     /// Return patch by patch coordinates.
     TerrainPatch* GetPatch(int x, int z) const;
@@ -107,7 +160,7 @@ public:
     float GetHeight(const Vector3& worldPosition) const;
     /// Return normal at world coordinates.
     Vector3 GetNormal(const Vector3& worldPosition) const;
-    /// Return raw height data.
+    /// Return raw height data. Null for paged terrain.
     SharedArrayPtr<float> GetHeightData() const { return heightData_; }
     /// Return draw distance.
     float GetDrawDistance() const { return drawDistance_; }
@@ -156,20 +209,48 @@ private:
     void SmoothHeightMap();
     /// Create index data shared by all patches.
     void CreateIndexData();
+    /// Create or reuse a patch scene node and patch component and copy the drawable parameters to it.
+    TerrainPatch* CreatePatch(int x, int z, bool enabled);
+    /// Regenerate geometry of several patches, optionally also calculating LOD errors. Vertex data is generated in the worker threads.
+    void CreatePatchGeometries(const PODVector<TerrainPatch*>& patches, bool calculateLodErrors);
+    /// Generate vertex data, CPU-side position data and bounding box for a patch. Can be called from worker threads.
+    void GeneratePatchVertices(TerrainPatch* patch, float* vertexData, float* positionData, BoundingBox& box) const;
+    /// Upload generated vertex data to a patch and set up its geometries.
+    void SetPatchGeometry(TerrainPatch* patch, const float* vertexData, SharedArrayPtr<unsigned char> cpuVertexData, const BoundingBox& box);
     /// Return an uninterpolated terrain height value, clamping to edges.
     float GetRawHeight(int x, int z) const;
+    /// Return an uninterpolated height value from the loaded pages. Clamps to the nearest loaded page if the page at the position is not loaded.
+    float GetPagedHeight(int x, int z) const;
     /// Return interpolated height for a specific LOD level.
     float GetLodHeight(int x, int z, unsigned lodLevel) const;
     /// Get slope-based terrain normal at position.
     Vector3 GetRawNormal(int x, int z) const;
-    /// Calculate LOD errors for a patch.
-    void CalculateLodErrors(TerrainPatch* patch);
+    /// Calculate LOD errors for a patch. Can be called from worker threads.
+    void CalculateLodErrors(TerrainPatch* patch) const;
     /// Set neighbors for a patch.
     void SetNeighbors(TerrainPatch* patch);
     /// Set heightmap image and optionally recreate the geometry immediately. Return true if successful.
     bool SetHeightMapInternal(Image* image, bool recreateNow);
     /// Handle heightmap image reload finished.
     void HandleHeightMapReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Wait for background page loads to finish.
+    void WaitForPageLoads();
+    /// Load and unload pages based on the camera positions, and create patches for loaded pages.
+    void UpdatePages();
+    /// Start loading a page in the background. Return true if the page file was found.
+    bool LoadPage(TerrainPage* page);
+    /// Create the patches of a loaded page and connect them to the neighbor pages.
+    void CreatePagePatches(TerrainPage* page);
+    /// Remove a page and its patches.
+    void RemovePage(TerrainPage* page);
+    /// Return resource name of a page.
+    String GetPageName(const IntVector2& coords) const;
+    /// Return distance from a local space position to a page on the XZ-plane.
+    float GetPageDistance(const IntVector2& coords, const Vector3& position) const;
+    /// Handle view update begin event. Record the camera position.
+    void HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle scene post-update event. Update the resident pages.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
 
     /// Shared index buffer.
     SharedPtr<IndexBuffer> indexBuffer_;
@@ -181,6 +262,10 @@ private:
     SharedPtr<Material> material_;
     /// Terrain patches.
     Vector<WeakPtr<TerrainPatch> > patches_;
+    /// Heightmap pages indexed by page coordinates. Null if not resident.
+    Vector<SharedPtr<TerrainPage> > pages_;
+    /// Camera positions in local space recorded during the last rendering.
+    PODVector<Vector3> viewPositions_;
     /// Draw ranges for different LODs and stitching combinations.
     PODVector<Pair<unsigned, unsigned> > drawRanges_;
     /// Vertex and height spacing.
@@ -195,6 +280,18 @@ private:
     IntVector2 numPatches_;
     /// Patch size, quads per side.
     int patchSize_;
+    /// Paged heightmap name pattern.
+    String pageNamePattern_;
+    /// Number of heightmap pages.
+    IntVector2 numPages_;
+    /// Page size, quads per side.
+    int pageSize_;
+    /// Page load distance.
+    float pageLoadDistance_;
+    /// Maximum resident pages.
+    unsigned maxPages_;
+    /// Number of resident pages.
+    unsigned numResidentPages_;
     /// Number of terrain LOD levels.
     unsigned numLodLevels_;
     /// Smoothing enable flag.
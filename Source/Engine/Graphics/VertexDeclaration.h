@@ -22,6 +22,6 @@
 
 #pragma once
 
-#ifndef URHO3D_OPENGL
+#if !defined(URHO3D_OPENGL) && !defined(URHO3D_NULL_GRAPHICS)
 #include "Direct3D9/D3D9VertexDeclaration.h"
 #endif
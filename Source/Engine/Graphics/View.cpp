@@ -244,6 +244,80 @@ void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
     view->ProcessLight(*query, threadIndex);
 }
 
+void AssignLightClustersWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    
+    view->AssignLightClusters((unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+static void DeferBatch(BatchWorkResult& result, BatchQueue& queue, const Batch& batch, Technique* tech, bool allowInstancing,
+    bool allowShadows)
+{
+    DeferredBatch deferred;
+    deferred.batch_ = batch;
+    deferred.tech_ = tech;
+    deferred.queue_ = &queue;
+    deferred.allowInstancing_ = allowInstancing;
+    deferred.allowShadows_ = allowShadows;
+    result.deferredBatches_.Push(deferred);
+}
+
+static void CollectSkinnedGroups(BatchQueue& queue, PODVector<BatchGroup*>& dest)
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = queue.batchGroups_.Begin(); i != queue.batchGroups_.End(); ++i)
+    {
+        if (i->second_.geometryType_ == GEOM_SKINNED_INSTANCED)
+            dest.Push(&i->second_);
+    }
+}
+
+static unsigned HashBytes(unsigned hash, const void* data, unsigned size)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (unsigned i = 0; i < size; ++i)
+        hash = SDBMHash(hash, bytes[i]);
+    return hash;
+}
+
+static unsigned GetShadowMapCacheHash(Light* light)
+{
+    // Hash the light parameters that affect the shadow map contents. The shadow map size is checked separately
+    const BiasParameters& bias = light->GetShadowBias();
+    const FocusParameters& focus = light->GetShadowFocus();
+    float parameters[] = { light->GetRange(), light->GetFov(), light->GetAspectRatio(), light->GetShadowNearFarRatio(),
+        bias.constantBias_, bias.slopeScaledBias_, focus.focus_ ? focus.quantize_ : 0.0f, focus.focus_ ? focus.minView_ : 0.0f };
+    
+    unsigned lightMask = light->GetLightMask();
+    unsigned hash = light->GetLightType();
+    hash = HashBytes(hash, &lightMask, sizeof lightMask);
+    hash = HashBytes(hash, light->GetNode()->GetWorldTransform().Data(), sizeof(Matrix3x4));
+    hash = HashBytes(hash, parameters, sizeof parameters);
+    return hash;
+}
+
+void GetLightBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    BatchWorkResult& result = *(reinterpret_cast<BatchWorkResult*>(item->aux_));
+    LightQueryResult* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    View* view = result.view_;
+    
+    result.frameAllocator_ = view->frameAllocators_[threadIndex];
+    view->GetLightBatches(*query, result);
+}
+
+void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    BatchWorkResult& result = *(reinterpret_cast<BatchWorkResult*>(item->aux_));
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    View* view = result.view_;
+    
+    result.frameAllocator_ = view->frameAllocators_[threadIndex];
+    while (start != end)
+        view->GetBaseBatches(*start++, &result);
+}
+
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -295,7 +369,9 @@ View::View(Context* context) :
     cameraZone_(0),
     farClipZone_(0),
     renderTarget_(0),
-    substituteRenderTarget_(0)
+    substituteRenderTarget_(0),
+    useClusteredLights_(false),
+    numBatchResults_(0)
 {
     // Create octree query and scene results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
@@ -333,6 +409,7 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             info.allowInstancing_ = command.sortMode_ != SORT_BACKTOFRONT;
             info.markToStencil_ = command.markToStencil_;
             info.vertexLights_ = command.vertexLights_;
+            info.clusteredLights_ = command.clusteredLights_;
             
             // Check scenepass metadata for defining custom passes which interact with lighting
             if (!command.metadata_.Empty())
@@ -426,6 +503,25 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             useLitBase_ = command.useLitBase_;
     }
     
+    // Clustered lights are only used in forward rendering. When in use, the base pass must be rendered for all objects so
+    // that the clustered lights are added, so combining the first light with it is not possible
+    useClusteredLights_ = false;
+    if (!deferred_ && renderer_->GetLightClusterTexture())
+    {
+        for (unsigned i = 0; i < scenePasses_.Size(); ++i)
+        {
+            if (scenePasses_[i].clusteredLights_)
+                useClusteredLights_ = true;
+        }
+    }
+    if (useClusteredLights_)
+        useLitBase_ = false;
+    else
+    {
+        for (unsigned i = 0; i < scenePasses_.Size(); ++i)
+            scenePasses_[i].clusteredLights_ = false;
+    }
+    
     // Validate the rect and calculate size. If zero rect, use whole rendertarget size
     int rtWidth = renderTarget ? renderTarget->GetWidth() : graphics_->GetWidth();
     int rtHeight = renderTarget ? renderTarget->GetHeight() : graphics_->GetHeight();
@@ -488,6 +584,7 @@ void View::Update(const FrameInfo& frame)
     geometries_.Clear();
     shadowGeometries_.Clear();
     lights_.Clear();
+    clusteredLights_.Clear();
     zones_.Clear();
     occluders_.Clear();
     vertexLightQueues_.Clear();
@@ -519,6 +616,15 @@ void View::Render()
     // Forget parameter sources from the previous view
     graphics_->ClearParameterSources();
     
+    // The instance data of skinned geometry refers to the skinning texture, so it must be filled first. This is needed
+    // also when the instancing buffer is locked for each batch group
+    if (renderer_->GetSkinningTexture())
+        PrepareSkinningTexture();
+    
+    // The light cluster texture is shared by all views, so fill it only now
+    if (useClusteredLights_)
+        PrepareLightClusterTexture();
+    
     // If stream offset is supported, write all instance transforms to a single large buffer
     // Else we must lock the instance buffer for each batch group
     if (renderer_->GetDynamicInstancing() && graphics_->GetStreamOffsetSupport())
@@ -665,6 +771,15 @@ void View::SetCameraShaderParameters(Camera* camera, bool setProjection, bool ov
         else
             graphics_->SetShaderParameter(VSP_VIEWPROJ, projection * camera->GetView());
     }
+    
+    if (useClusteredLights_ && camera == camera_)
+    {
+        Texture2D* lightClusterTexture = renderer_->GetLightClusterTexture();
+        graphics_->SetShaderParameter(PSP_CLUSTERVIEWPROJ, clusterViewProj_);
+        graphics_->SetShaderParameter(PSP_CLUSTERPARAMS, clusterParams_);
+        graphics_->SetShaderParameter(PSP_CLUSTERTEXINVSIZE, Vector4(1.0f / (float)lightClusterTexture->GetWidth(), 1.0f /
+            (float)lightClusterTexture->GetHeight(), 0.0f, 0.0f));
+    }
 }
 
 void View::SetGBufferShaderParameters(const IntVector2& texSize, const IntRect& viewRect)
@@ -688,6 +803,11 @@ void View::SetGBufferShaderParameters(const IntVector2& texSize, const IntRect&
     graphics_->SetShaderParameter(PSP_GBUFFERINVSIZE, Vector4(invSizeX, invSizeY, 0.0f, 0.0f));
 }
 
+void View::ResetShadowMapCache()
+{
+    shadowMapCache_.Clear();
+}
+
 void View::GetDrawables()
 {
     PROFILE(GetDrawables);
@@ -857,15 +977,33 @@ void View::GetDrawables()
 void View::GetBatches()
 {
     WorkQueue* queue = GetSubsystem<WorkQueue>();
-    PODVector<Light*> vertexLights;
     BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassName_) ? &batchQueues_[alphaPassName_] : (BatchQueue*)0;
+    unsigned maxSortedInstances = renderer_->GetMaxSortedInstances();
+    
+    frameAllocators_.Resize(queue->GetNumThreads() + 1);
+    for (unsigned i = 0; i < frameAllocators_.Size(); ++i)
+        frameAllocators_[i] = queue->GetFrameAllocator(i);
     
     // Process lit geometries and shadow casters for each light
     {
         PROFILE(ProcessLights);
         
+        // Remove the clustered lights first, as they do not need light queries
+        if (useClusteredLights_)
+            GetClusteredLights();
+        
         lightQueryResults_.Resize(lights_.Size());
         
+        // Release cached shadow maps that were not in use on the previous frame, as they have missed scene changes
+        bool cacheShadowMaps = renderer_->GetCacheShadowMaps() && drawShadows_;
+        for (HashMap<Light*, ShadowMapCache>::Iterator i = shadowMapCache_.Begin(); i != shadowMapCache_.End();)
+        {
+            if (!cacheShadowMaps || i->second_.light_.Expired() || i->second_.frameNumber_ + 1 < frame_.frameNumber_)
+                i = shadowMapCache_.Erase(i);
+            else
+                ++i;
+        }
+        
         for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
         {
             SharedPtr<WorkItem> item = queue->GetFreeItem();
@@ -875,11 +1013,30 @@ void View::GetBatches()
 
             LightQueryResult& query = lightQueryResults_[i];
             query.light_ = lights_[i];
+            query.shadowMapCache_ = cacheShadowMaps ? GetShadowMapCache(lights_[i]) : 0;
             
             item->start_ = &query;
             queue->AddWorkItem(item);
         }
         
+        // Assign the clustered lights to the light clusters at the same time, divided by depth slices
+        if (clusteredLights_.Size())
+        {
+            unsigned numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+            unsigned slicesPerItem = (LIGHT_CLUSTERS_Z + numWorkItems - 1) / numWorkItems;
+            
+            for (unsigned start = 0; start < LIGHT_CLUSTERS_Z; start += slicesPerItem)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = AssignLightClustersWork;
+                item->aux_ = this;
+                item->start_ = (void*)(size_t)start;
+                item->end_ = (void*)(size_t)Min((int)(start + slicesPerItem), LIGHT_CLUSTERS_Z);
+                queue->AddWorkItem(item);
+            }
+        }
+        
         // Ensure all lights have been processed before proceeding
         queue->Complete(M_MAX_UNSIGNED);
     }
@@ -899,8 +1056,9 @@ void View::GetBatches()
         
         lightQueues_.Resize(numLightQueues);
         maxLightsDrawables_.Clear();
-        unsigned maxSortedInstances = renderer_->GetMaxSortedInstances();
         
+        // Set up the light queues and shadow cameras, and store the lights to the lit geometries. This is done for all lights
+        // before building any batches, as the batches depend on each drawable's complete light list
         for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
         {
             LightQueryResult& query = *i;
@@ -921,14 +1079,22 @@ void View::GetBatches()
                 light->SetLightQueue(&lightQueue);
                 lightQueue.light_ = light;
                 lightQueue.shadowMap_ = 0;
+                lightQueue.shadowMapCache_ = 0;
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
                 lightQueue.volumeBatches_.Clear();
                 
-                // Allocate shadow map now
+                // Allocate shadow map now. Use the light's own shadow map if it is cached
                 if (shadowSplits > 0)
                 {
-                    lightQueue.shadowMap_ = renderer_->GetShadowMap(light, camera_, viewSize_.x_, viewSize_.y_);
+                    if (query.shadowMapCache_)
+                    {
+                        lightQueue.shadowMap_ = GetCachedShadowMap(query);
+                        if (lightQueue.shadowMap_)
+                            lightQueue.shadowMapCache_ = query.shadowMapCache_;
+                    }
+                    if (!lightQueue.shadowMap_)
+                        lightQueue.shadowMap_ = renderer_->GetShadowMap(light, camera_, viewSize_.x_, viewSize_.y_);
                     // If did not manage to get a shadow map, convert the light to unshadowed
                     if (!lightQueue.shadowMap_)
                         shadowSplits = 0;
@@ -949,7 +1115,7 @@ void View::GetBatches()
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
                     
-                    // Loop through shadow casters
+                    // Store shadow casters that are not otherwise visible for geometry update
                     for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
                         k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
                     {
@@ -959,44 +1125,16 @@ void View::GetBatches()
                             drawable->MarkInView(frame_.frameNumber_, 0);
                             shadowGeometries_.Push(drawable);
                         }
-                        
-                        Zone* zone = GetZone(drawable);
-                        const Vector<SourceBatch>& batches = drawable->GetBatches();
-                        
-                        for (unsigned l = 0; l < batches.Size(); ++l)
-                        {
-                            const SourceBatch& srcBatch = batches[l];
-                            
-                            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-                            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                                continue;
-                            
-                            Pass* pass = tech->GetSupportedPass(PASS_SHADOW);
-                            // Skip if material has no shadow pass
-                            if (!pass)
-                                continue;
-                            
-                            Batch destBatch(srcBatch);
-                            destBatch.pass_ = pass;
-                            destBatch.camera_ = shadowCamera;
-                            destBatch.zone_ = zone;
-                            destBatch.lightQueue_ = &lightQueue;
-                            
-                            AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
-                        }
                     }
                 }
                 
-                // Process lit geometries
+                // Record the light to lit geometries. If drawable limits maximum lights, check maximum count / build
+                // batches later
                 for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddLight(light);
-                    
-                    // If drawable limits maximum lights, only record the light, and check maximum count / build batches later
-                    if (!drawable->GetMaxLights())
-                        GetLitBatches(drawable, lightQueue, alphaQueue);
-                    else
+                    if (drawable->GetMaxLights())
                         maxLightsDrawables_.Insert(drawable);
                 }
                 
@@ -1030,6 +1168,26 @@ void View::GetBatches()
                 }
             }
         }
+        
+        // Build the shadow and lit batches of each per-pixel light in worker threads. Each light fills its own queues
+        PrepareBatchResults(numLightQueues);
+        unsigned numLightItems = 0;
+        for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+        {
+            LightQueryResult& query = *i;
+            if (query.litGeometries_.Empty() || query.light_->GetPerVertex())
+                continue;
+            
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = GetLightBatchesWork;
+            item->aux_ = &batchResults_[numLightItems++];
+            item->start_ = &query;
+            queue->AddWorkItem(item);
+        }
+        
+        queue->Complete(M_MAX_UNSIGNED);
+        FinishThreadBatches();
     }
     
     // Process drawables with limited per-pixel light count
@@ -1054,96 +1212,291 @@ void View::GetBatches()
         }
     }
     
-    // Build base pass batches
+    // Build base pass batches in worker threads
     {
         PROFILE(GetBaseBatches);
         
-        for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+        int drawablesPerItem = geometries_.Size() / numWorkItems;
+        PrepareBatchResults(numWorkItems);
+        
+        PODVector<Drawable*>::Iterator start = geometries_.Begin();
+        for (int i = 0; i < numWorkItems; ++i)
         {
-            Drawable* drawable = *i;
+            PODVector<Drawable*>::Iterator end = geometries_.End();
+            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
+                end = start + drawablesPerItem;
+            
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = GetBaseBatchesWork;
+            item->aux_ = &batchResults_[i];
+            item->start_ = &(*start);
+            item->end_ = &(*end);
+            queue->AddWorkItem(item);
+            
+            start = end;
+        }
+        
+        queue->Complete(M_MAX_UNSIGNED);
+        FinishThreadBatches();
+    }
+}
+
+void View::GetLightBatches(LightQueryResult& query, BatchWorkResult& threadResult)
+{
+    Light* light = query.light_;
+    LightBatchQueue& lightQueue = *light->GetLightQueue();
+    // Lit transparent batches go to a per-thread queue, as the view's alpha queue is shared by all lights
+    BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassName_) ? &threadResult.alphaQueue_ : (BatchQueue*)0;
+    
+    // Loop through shadow casters of each split
+    for (unsigned i = 0; i < lightQueue.shadowSplits_.Size(); ++i)
+    {
+        ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[i];
+        Camera* shadowCamera = shadowQueue.shadowCamera_;
+        
+        for (PODVector<Drawable*>::ConstIterator j = query.shadowCasters_.Begin() + query.shadowCasterBegin_[i];
+            j < query.shadowCasters_.Begin() + query.shadowCasterEnd_[i]; ++j)
+        {
+            Drawable* drawable = *j;
             Zone* zone = GetZone(drawable);
             const Vector<SourceBatch>& batches = drawable->GetBatches();
             
-            const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
-            if (!drawableVertexLights.Empty())
-                drawable->LimitVertexLights();
-            
-            for (unsigned j = 0; j < batches.Size(); ++j)
+            for (unsigned k = 0; k < batches.Size(); ++k)
             {
-                const SourceBatch& srcBatch = batches[j];
-                
-                // Check here if the material refers to a rendertarget texture with camera(s) attached
-                // Only check this for backbuffer views (null rendertarget)
-                if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
-                    CheckMaterialForAuxView(srcBatch.material_);
+                const SourceBatch& srcBatch = batches[k];
                 
                 Technique* tech = GetTechnique(drawable, srcBatch.material_);
                 if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
                     continue;
                 
+                Pass* pass = tech->GetSupportedPass(PASS_SHADOW);
+                // Skip if material has no shadow pass
+                if (!pass)
+                    continue;
+                
                 Batch destBatch(srcBatch);
-                destBatch.camera_ = camera_;
+                destBatch.pass_ = pass;
+                destBatch.camera_ = shadowCamera;
                 destBatch.zone_ = zone;
-                destBatch.isBase_ = true;
-                destBatch.pass_ = 0;
-                destBatch.lightMask_ = GetLightMask(drawable);
+                destBatch.lightQueue_ = &lightQueue;
                 
-                // Check each of the scene passes
-                for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+                AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech, true, true, &threadResult);
+            }
+        }
+    }
+    
+    // Process lit geometries. Drawables that limit their light count are processed later
+    for (PODVector<Drawable*>::ConstIterator i = query.litGeometries_.Begin(); i != query.litGeometries_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if (!drawable->GetMaxLights())
+            GetLitBatches(drawable, lightQueue, alphaQueue, &threadResult);
+    }
+}
+
+void View::GetBaseBatches(Drawable* drawable, BatchWorkResult* threadResult)
+{
+    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+    
+    // Vertex light queues are shared between drawables, so build the batches of vertex lit drawables in the main thread
+    if (threadResult && !drawableVertexLights.Empty())
+    {
+        threadResult->vertexLitDrawables_.Push(drawable);
+        return;
+    }
+    
+    Zone* zone = GetZone(drawable);
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    
+    if (!drawableVertexLights.Empty())
+        drawable->LimitVertexLights();
+    
+    for (unsigned j = 0; j < batches.Size(); ++j)
+    {
+        const SourceBatch& srcBatch = batches[j];
+        
+        // Check here if the material refers to a rendertarget texture with camera(s) attached
+        // Only check this for backbuffer views (null rendertarget). Rendertarget updates can only be queued in the main thread
+        if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
+        {
+            if (threadResult)
+                threadResult->auxViewMaterials_.Push(srcBatch.material_);
+            else
+                CheckMaterialForAuxView(srcBatch.material_);
+        }
+        
+        Technique* tech = GetTechnique(drawable, srcBatch.material_);
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
+        
+        Batch destBatch(srcBatch);
+        destBatch.camera_ = camera_;
+        destBatch.zone_ = zone;
+        destBatch.isBase_ = true;
+        destBatch.pass_ = 0;
+        destBatch.lightMask_ = GetLightMask(drawable);
+        
+        // Check each of the scene passes
+        for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+        {
+            ScenePassInfo& info = scenePasses_[k];
+            destBatch.pass_ = tech->GetSupportedPass(info.pass_);
+            if (!destBatch.pass_)
+                continue;
+            
+            destBatch.clusteredLights_ = info.clusteredLights_ && !clusteredLights_.Empty();
+            
+            // Skip forward base pass if the corresponding litbase pass already exists
+            if (info.pass_ == basePassName_ && j < 32 && drawable->HasBasePass(j))
+                continue;
+            
+            if (info.vertexLights_ && !drawableVertexLights.Empty())
+            {
+                // For a deferred opaque batch, check if the vertex lights include converted per-pixel lights, and remove
+                // them to prevent double-lighting
+                if (deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE)
                 {
-                    ScenePassInfo& info = scenePasses_[k];
-                    destBatch.pass_ = tech->GetSupportedPass(info.pass_);
-                    if (!destBatch.pass_)
-                        continue;
-                    
-                    // Skip forward base pass if the corresponding litbase pass already exists
-                    if (info.pass_ == basePassName_ && j < 32 && drawable->HasBasePass(j))
-                        continue;
-                    
-                    if (info.vertexLights_ && !drawableVertexLights.Empty())
+                    tempVertexLights_.Clear();
+                    for (unsigned i = 0; i < drawableVertexLights.Size(); ++i)
                     {
-                        // For a deferred opaque batch, check if the vertex lights include converted per-pixel lights, and remove
-                        // them to prevent double-lighting
-                        if (deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE)
-                        {
-                            vertexLights.Clear();
-                            for (unsigned i = 0; i < drawableVertexLights.Size(); ++i)
-                            {
-                                if (drawableVertexLights[i]->GetPerVertex())
-                                    vertexLights.Push(drawableVertexLights[i]);
-                            }
-                        }
-                        else
-                            vertexLights = drawableVertexLights;
-                        
-                        if (!vertexLights.Empty())
-                        {
-                            // Find a vertex light queue. If not found, create new
-                            unsigned long long hash = GetVertexLightQueueHash(vertexLights);
-                            HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
-                            if (i == vertexLightQueues_.End())
-                            {
-                                i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
-                                i->second_.light_ = 0;
-                                i->second_.shadowMap_ = 0;
-                                i->second_.vertexLights_ = vertexLights;
-                            }
-                            
-                            destBatch.lightQueue_ = &(i->second_);
-                        }
+                        if (drawableVertexLights[i]->GetPerVertex())
+                            tempVertexLights_.Push(drawableVertexLights[i]);
+                    }
+                }
+                else
+                    tempVertexLights_ = drawableVertexLights;
+                
+                if (!tempVertexLights_.Empty())
+                {
+                    // Find a vertex light queue. If not found, create new
+                    unsigned long long hash = GetVertexLightQueueHash(tempVertexLights_);
+                    HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
+                    if (i == vertexLightQueues_.End())
+                    {
+                        i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                        i->second_.light_ = 0;
+                        i->second_.shadowMap_ = 0;
+                        i->second_.vertexLights_ = tempVertexLights_;
                     }
-                    else
-                        destBatch.lightQueue_ = 0;
-                    
-                    bool allowInstancing = info.allowInstancing_;
-                    if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (zone->GetLightMask() & 0xff))
-                        allowInstancing = false;
                     
-                    AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+                    destBatch.lightQueue_ = &(i->second_);
                 }
             }
+            else
+                destBatch.lightQueue_ = 0;
+            
+            bool allowInstancing = info.allowInstancing_;
+            if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (zone->GetLightMask() & 0xff))
+                allowInstancing = false;
+            
+            BatchQueue& batchQueue = threadResult ? threadResult->baseQueues_[k] : *info.batchQueue_;
+            AddBatchToQueue(batchQueue, destBatch, tech, allowInstancing, true, threadResult);
+        }
+    }
+}
+
+void View::PrepareBatchResults(unsigned count)
+{
+    unsigned maxSortedInstances = renderer_->GetMaxSortedInstances();
+    
+    if (batchResults_.Size() < count)
+        batchResults_.Resize(count);
+    numBatchResults_ = count;
+    
+    for (unsigned i = 0; i < count; ++i)
+    {
+        BatchWorkResult& result = batchResults_[i];
+        
+        result.view_ = this;
+        result.baseQueues_.Resize(scenePasses_.Size());
+        for (unsigned j = 0; j < result.baseQueues_.Size(); ++j)
+            result.baseQueues_[j].Clear(maxSortedInstances);
+        result.alphaQueue_.Clear(maxSortedInstances);
+        result.deferredBatches_.Clear();
+        result.auxViewMaterials_.Clear();
+        result.vertexLitDrawables_.Clear();
+        result.frameAllocator_ = 0;
+    }
+}
+
+void View::FinishThreadBatches()
+{
+    BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassName_) ? &batchQueues_[alphaPassName_] : (BatchQueue*)0;
+    
+    // Merge in work item order, regardless of which thread executed each item
+    for (unsigned i = 0; i < numBatchResults_; ++i)
+    {
+        BatchWorkResult& result = batchResults_[i];
+        
+        for (PODVector<Material*>::ConstIterator j = result.auxViewMaterials_.Begin(); j != result.auxViewMaterials_.End(); ++j)
+        {
+            Material* material = *j;
+            if (material->GetAuxViewFrameNumber() != frame_.frameNumber_)
+                CheckMaterialForAuxView(material);
+        }
+        
+        // Load missing shaders and report errors for the batches the worker threads could not finish
+        for (PODVector<DeferredBatch>::Iterator j = result.deferredBatches_.Begin(); j != result.deferredBatches_.End(); ++j)
+            AddBatchToQueue(*j->queue_, j->batch_, j->tech_, j->allowInstancing_, j->allowShadows_);
+        
+        for (unsigned j = 0; j < result.baseQueues_.Size() && j < scenePasses_.Size(); ++j)
+            MergeBatchQueue(*scenePasses_[j].batchQueue_, result.baseQueues_[j]);
+        if (alphaQueue)
+            MergeBatchQueue(*alphaQueue, result.alphaQueue_);
+        
+        for (PODVector<Drawable*>::ConstIterator j = result.vertexLitDrawables_.Begin(); j != result.vertexLitDrawables_.End(); ++j)
+            GetBaseBatches(*j);
+        
+        result.auxViewMaterials_.Clear();
+        result.deferredBatches_.Clear();
+        result.vertexLitDrawables_.Clear();
+    }
+}
+
+void View::MergeBatchQueue(BatchQueue& dest, BatchQueue& src)
+{
+    // The merged groups may still receive instances on the main thread, so their instance data is moved from the worker
+    // thread's frame allocator to the main thread's. The groups already in the destination use the main thread's allocator
+    FrameAllocator* allocator = frameAllocators_[0];
+    
+    // If the destination is still empty, just exchange the contents
+    if (dest.batches_.Empty() && dest.batchGroups_.Empty())
+    {
+        dest.batches_.Swap(src.batches_);
+        dest.batchGroups_.Swap(src.batchGroups_);
+        
+        for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = dest.batchGroups_.Begin(); i != dest.batchGroups_.End(); ++i)
+            i->second_.instances_.MoveToAllocator(allocator);
+    }
+    else
+    {
+        dest.batches_.Push(src.batches_);
+        
+        for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = src.batchGroups_.Begin(); i != src.batchGroups_.End(); ++i)
+        {
+            FlatHashMap<BatchGroupKey, BatchGroup>::Iterator j = dest.batchGroups_.Find(i->first_);
+            if (j == dest.batchGroups_.End())
+            {
+                // Move before inserting, as copying the group allocates from the allocator of the source instances
+                i->second_.instances_.MoveToAllocator(allocator);
+                dest.batchGroups_.Insert(MakePair(i->first_, i->second_));
+            }
+            else
+            {
+                BatchGroup& group = j->second_;
+                int oldSize = group.instances_.Size();
+                group.instances_.Push(i->second_.instances_);
+                // The pass shaders have been loaded already, so the technique is not needed
+                if (oldSize < minInstances_ && (int)group.instances_.Size() >= minInstances_)
+                    SetInstancingShaders(group, 0, true, false);
+            }
         }
     }
+    
+    src.batches_.Clear();
+    src.batchGroups_.Clear();
 }
 
 void View::UpdateGeometries()
@@ -1247,7 +1600,7 @@ void View::UpdateGeometries()
     queue->Complete(M_MAX_UNSIGNED);
 }
 
-void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue)
+void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, BatchWorkResult* threadResult)
 {
     Light* light = lightQueue.light_;
     Zone* zone = GetZone(drawable);
@@ -1308,14 +1661,14 @@ void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQ
         if (!isLitAlpha)
         {
             if (destBatch.isBase_)
-                AddBatchToQueue(lightQueue.litBaseBatches_, destBatch, tech);
+                AddBatchToQueue(lightQueue.litBaseBatches_, destBatch, tech, true, true, threadResult);
             else
-                AddBatchToQueue(lightQueue.litBatches_, destBatch, tech);
+                AddBatchToQueue(lightQueue.litBatches_, destBatch, tech, true, true, threadResult);
         }
         else if (alphaQueue)
         {
             // Transparent batches can not be instanced
-            AddBatchToQueue(*alphaQueue, destBatch, tech, false, allowTransparentShadows);
+            AddBatchToQueue(*alphaQueue, destBatch, tech, false, allowTransparentShadows, threadResult);
         }
     }
 }
@@ -2035,6 +2388,128 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
     buffer->BuildDepthHierarchy();
 }
 
+void View::GetClusteredLights()
+{
+    PROFILE(GetClusteredLights);
+    
+    // The light clusters do not know about drawable and zone light masks, so collect the visible geometries which may
+    // exclude lights. The main thread's octree query result vector is free, as the light queries have not started yet
+    PODVector<Drawable*>& maskedGeometries = tempDrawables_[0];
+    maskedGeometries.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+    {
+        if (GetLightMask(*i) != DEFAULT_LIGHTMASK)
+            maskedGeometries.Push(*i);
+    }
+    
+    // Unshadowed point and spot lights that use the default textures and light mask can be evaluated from the light clusters,
+    // unless they touch a visible geometry that is excluded by its light mask. The lights are sorted by importance, so if
+    // there are too many, the least important stay as per-pixel lights
+    unsigned numLights = 0;
+    for (unsigned i = 0; i < lights_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        bool clustered = clusteredLights_.Size() < MAX_CLUSTERED_LIGHTS && !light->GetPerVertex() && light->GetLightType() !=
+            LIGHT_DIRECTIONAL && !(drawShadows_ && light->GetCastShadows()) && !light->GetRampTexture() &&
+            !light->GetShapeTexture() && light->GetLightMask() == DEFAULT_LIGHTMASK;
+        
+        if (clustered && maskedGeometries.Size())
+        {
+            const BoundingBox& lightBox = light->GetWorldBoundingBox();
+            for (unsigned j = 0; j < maskedGeometries.Size(); ++j)
+            {
+                Drawable* drawable = maskedGeometries[j];
+                if (!(GetLightMask(drawable) & light->GetLightMask()) && lightBox.IsInsideFast(drawable->GetWorldBoundingBox()))
+                {
+                    clustered = false;
+                    break;
+                }
+            }
+        }
+        
+        if (clustered)
+            clusteredLights_.Push(light);
+        else
+            lights_[numLights++] = light;
+    }
+    lights_.Resize(numLights);
+    
+    if (clusteredLights_.Empty())
+        return;
+    
+    // The clusters divide the view into screen space tiles and exponentially distributed depth slices
+    const Matrix3x4& view = camera_->GetView();
+    Matrix4 projection = camera_->GetProjection(false);
+    float sliceNear = Max(camera_->GetNearClip(), camera_->GetFarClip() * 0.0001f);
+    float zScale = (float)LIGHT_CLUSTERS_Z / logf(camera_->GetFarClip() / sliceNear);
+    clusterViewProj_ = projection * view;
+    clusterParams_ = Vector4((float)LIGHT_CLUSTERS_X, (float)LIGHT_CLUSTERS_Y, (float)LIGHT_CLUSTERS_Z, zScale);
+    
+    clusterRanges_.Resize(clusteredLights_.Size());
+    clusterLightCounts_.Resize(LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z);
+    clusterLightIndices_.Resize(LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z * MAX_LIGHTS_PER_CLUSTER);
+    
+    for (unsigned i = 0; i < clusteredLights_.Size(); ++i)
+    {
+        LightClusterRange& range = clusterRanges_[i];
+        BoundingBox viewBox = clusteredLights_[i]->GetWorldBoundingBox().Transformed(view);
+        viewBox.min_.z_ = Max(viewBox.min_.z_, sliceNear);
+        viewBox.max_.z_ = Max(viewBox.max_.z_, sliceNear);
+        
+        range.minZ_ = Clamp((int)floorf(logf(viewBox.min_.z_ / sliceNear) * zScale), 0, LIGHT_CLUSTERS_Z - 1);
+        range.maxZ_ = Clamp((int)floorf(logf(viewBox.max_.z_ / sliceNear) * zScale), 0, LIGHT_CLUSTERS_Z - 1);
+        
+        // Project the corners of the view space box to get the screen space extent
+        Vector2 minPos(M_INFINITY, M_INFINITY);
+        Vector2 maxPos(-M_INFINITY, -M_INFINITY);
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            Vector3 corner((j & 1) ? viewBox.max_.x_ : viewBox.min_.x_, (j & 2) ? viewBox.max_.y_ : viewBox.min_.y_, (j & 4) ?
+                viewBox.max_.z_ : viewBox.min_.z_);
+            Vector3 projected = projection * corner;
+            minPos.x_ = Min(minPos.x_, projected.x_);
+            minPos.y_ = Min(minPos.y_, projected.y_);
+            maxPos.x_ = Max(maxPos.x_, projected.x_);
+            maxPos.y_ = Max(maxPos.y_, projected.y_);
+        }
+        
+        range.minX_ = Clamp((int)floorf((minPos.x_ * 0.5f + 0.5f) * LIGHT_CLUSTERS_X), 0, LIGHT_CLUSTERS_X - 1);
+        range.maxX_ = Clamp((int)floorf((maxPos.x_ * 0.5f + 0.5f) * LIGHT_CLUSTERS_X), 0, LIGHT_CLUSTERS_X - 1);
+        range.minY_ = Clamp((int)floorf((minPos.y_ * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y), 0, LIGHT_CLUSTERS_Y - 1);
+        range.maxY_ = Clamp((int)floorf((maxPos.y_ * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y), 0, LIGHT_CLUSTERS_Y - 1);
+    }
+}
+
+void View::AssignLightClusters(unsigned firstSlice, unsigned lastSlice)
+{
+    const unsigned clustersPerSlice = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+    
+    for (unsigned i = firstSlice * clustersPerSlice; i < lastSlice * clustersPerSlice; ++i)
+        clusterLightCounts_[i] = 0;
+    
+    for (unsigned i = 0; i < clusterRanges_.Size(); ++i)
+    {
+        const LightClusterRange& range = clusterRanges_[i];
+        int minZ = Max(range.minZ_, (int)firstSlice);
+        int maxZ = Min(range.maxZ_, (int)lastSlice - 1);
+        
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            for (int y = range.minY_; y <= range.maxY_; ++y)
+            {
+                for (int x = range.minX_; x <= range.maxX_; ++x)
+                {
+                    unsigned cluster = (z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x;
+                    unsigned& count = clusterLightCounts_[cluster];
+                    // If the cluster is full, drop the least important lights
+                    if (count < MAX_LIGHTS_PER_CLUSTER)
+                        clusterLightIndices_[cluster * MAX_LIGHTS_PER_CLUSTER + count++] = (unsigned short)i;
+                }
+            }
+        }
+    }
+}
+
 void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
 {
     Light* light = query.light_;
@@ -2102,16 +2577,28 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     // Determine number of shadow cameras and setup their initial positions
     SetupShadowCameras(query);
     
-    // Process each split for shadow casters
+    // If the light's cached shadow map is up to date, its shadow casters do not need to be processed or rendered
+    ShadowMapCache* cache = query.shadowMapCache_;
     query.shadowCasters_.Clear();
+    if (cache && cache->valid_)
+    {
+        for (unsigned i = 0; i < query.numSplits_; ++i)
+        {
+            query.shadowCasterBegin_[i] = query.shadowCasterEnd_[i] = 0;
+            query.shadowCasterBox_[i] = cache->shadowCasterBox_[i];
+        }
+        return;
+    }
+    
+    // Process each split for shadow casters
     for (unsigned i = 0; i < query.numSplits_; ++i)
     {
         Camera* shadowCamera = query.shadowCameras_[i];
         const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
         query.shadowCasterBegin_[i] = query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
         
-        // For point light check that the face is visible: if not, can skip the split
-        if (type == LIGHT_POINT && frustum.IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
+        // For point light check that the face is visible: if not, can skip the split. A cached shadow map needs all faces
+        if (type == LIGHT_POINT && !cache && frustum.IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
             continue;
         
         // For directional light check that the split is inside the visible scene: if not, can skip the split
@@ -2147,6 +2634,8 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
     const Matrix3x4& lightView = shadowCamera->GetView();
     const Matrix4& lightProj = shadowCamera->GetProjection();
     LightType type = light->GetLightType();
+    // A cached shadow map must not depend on the camera, so do not cull its shadow casters by the view
+    bool cached = query.shadowMapCache_ != 0;
     
     query.shadowCasterBox_[splitIndex].defined_ = false;
     
@@ -2163,7 +2652,7 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
     BoundingBox lightViewFrustumBox(lightViewFrustum);
      
     // Check for degenerate split frustum: in that case there is no need to get shadow casters
-    if (lightViewFrustum.vertices_[0] == lightViewFrustum.vertices_[4])
+    if (!cached && lightViewFrustum.vertices_[0] == lightViewFrustum.vertices_[4])
         return;
     
     BoundingBox lightViewBox;
@@ -2191,6 +2680,9 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
             maxShadowDistance = drawDistance;
         if (maxShadowDistance > 0.0f)
         {
+            // Shadow distance depends on the camera, so the shadow map can not be cached on this frame
+            query.shadowMapCache_ = 0;
+            cached = false;
             if (!batchesUpdated)
             {
                 drawable->UpdateBatches(frame_);
@@ -2208,7 +2700,8 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
         // Project shadow caster bounding box to light view space for visibility check
         lightViewBox = drawable->GetWorldBoundingBox().Transformed(lightView);
         
-        if (IsShadowCasterVisible(drawable, lightViewBox, shadowCamera, lightView, lightViewFrustum, lightViewFrustumBox))
+        if (cached || IsShadowCasterVisible(drawable, lightViewBox, shadowCamera, lightView, lightViewFrustum,
+            lightViewFrustumBox))
         {
             // Merge to shadow caster bounding box and add to the list
             if (type == LIGHT_DIRECTIONAL)
@@ -2291,6 +2784,89 @@ IntRect View::GetShadowMapViewport(Light* light, unsigned splitIndex, Texture2D*
     return IntRect();
 }
 
+ShadowMapCache* View::GetShadowMapCache(Light* light)
+{
+    // Directional light splits follow the camera, so they can not be cached
+    if (light->GetLightType() == LIGHT_DIRECTIONAL || !light->GetCastShadows() || light->GetPerVertex())
+        return 0;
+    
+    ShadowMapCache& cache = shadowMapCache_[light];
+    unsigned hash = GetShadowMapCacheHash(light);
+    
+    // If the shadow map size has changed, for example due to automatic size reduction, a new shadow map is needed
+    IntVector2 size = renderer_->GetLightShadowMapSize(light, camera_, viewSize_.x_, viewSize_.y_);
+    if (size != cache.size_)
+    {
+        cache.shadowMap_.Reset();
+        cache.size_ = size;
+    }
+    
+    // The shadow map can be reused if it was up to date on the previous frame, and neither the light nor the shadow casters
+    // within its range have changed since
+    cache.valid_ = cache.light_.Get() == light && cache.shadowMap_ && !cache.shadowMap_->IsDataLost() && cache.hash_ == hash &&
+        cache.frameNumber_ + 1 == frame_.frameNumber_;
+    
+    if (cache.valid_)
+    {
+        const PODVector<Drawable*>& changedCasters = octree_->GetChangedShadowCasters();
+        const PODVector<BoundingBox>& changedBoxes = octree_->GetChangedShadowCasterBoxes();
+        
+        // Shadow casters that have moved out of the light, or have been removed, are found from the previous shadow casters
+        for (PODVector<Drawable*>::ConstIterator i = changedCasters.Begin(); i != changedCasters.End() && cache.valid_; ++i)
+        {
+            if (cache.shadowCasters_.Contains(*i))
+                cache.valid_ = false;
+        }
+        
+        // Shadow casters that have moved into the light, or have been added, are found from their new bounding boxes
+        if (light->GetLightType() == LIGHT_SPOT)
+        {
+            const Frustum& lightFrustum = light->GetFrustum();
+            for (PODVector<BoundingBox>::ConstIterator i = changedBoxes.Begin(); i != changedBoxes.End() && cache.valid_; ++i)
+            {
+                if (lightFrustum.IsInsideFast(*i) != OUTSIDE)
+                    cache.valid_ = false;
+            }
+        }
+        else
+        {
+            Sphere lightSphere(light->GetNode()->GetWorldPosition(), light->GetRange());
+            for (PODVector<BoundingBox>::ConstIterator i = changedBoxes.Begin(); i != changedBoxes.End() && cache.valid_; ++i)
+            {
+                if (lightSphere.IsInsideFast(*i) != OUTSIDE)
+                    cache.valid_ = false;
+            }
+        }
+    }
+    
+    cache.light_ = light;
+    cache.hash_ = hash;
+    return &cache;
+}
+
+Texture2D* View::GetCachedShadowMap(LightQueryResult& query)
+{
+    ShadowMapCache& cache = *query.shadowMapCache_;
+    if (cache.valid_)
+        return cache.shadowMap_;
+    
+    if (!cache.shadowMap_)
+    {
+        cache.shadowMap_ = renderer_->CreateShadowMap(cache.size_.x_, cache.size_.y_);
+        if (!cache.shadowMap_)
+            return 0;
+    }
+    
+    // Store the shadow casters that will be rendered, for checking whether they change on the following frames
+    cache.shadowCasters_.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = query.shadowCasters_.Begin(); i != query.shadowCasters_.End(); ++i)
+        cache.shadowCasters_.Insert(*i);
+    for (unsigned i = 0; i < query.numSplits_; ++i)
+        cache.shadowCasterBox_[i] = query.shadowCasterBox_[i];
+    
+    return cache.shadowMap_;
+}
+
 void View::SetupShadowCameras(LightQueryResult& query)
 {
     Light* light = query.light_;
@@ -2649,27 +3225,40 @@ void View::CheckMaterialForAuxView(Material* material)
     material->MarkForAuxView(frame_.frameNumber_);
 }
 
-void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
+void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows,
+    BatchWorkResult* threadResult)
 {
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
     
     // Convert to instanced if possible
-    if (allowInstancing && batch.geometryType_ == GEOM_STATIC && batch.geometry_->GetIndexBuffer() && !batch.overrideView_)
-        batch.geometryType_ = GEOM_INSTANCED;
+    if (allowInstancing && batch.geometry_->GetIndexBuffer() && !batch.overrideView_)
+    {
+        if (batch.geometryType_ == GEOM_STATIC)
+            batch.geometryType_ = GEOM_INSTANCED;
+        else if (batch.geometryType_ == GEOM_SKINNED && renderer_->GetSkinningTexture())
+            batch.geometryType_ = GEOM_SKINNED_INSTANCED;
+    }
+    
+    bool mainThread = threadResult == 0;
     
-    if (batch.geometryType_ == GEOM_INSTANCED)
+    if (batch.geometryType_ == GEOM_INSTANCED || batch.geometryType_ == GEOM_SKINNED_INSTANCED)
     {
         BatchGroupKey key(batch);
         
-        HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchQueue.batchGroups_.Find(key);
+        FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchQueue.batchGroups_.Find(key);
         if (i == batchQueue.batchGroups_.End())
         {
             // Create a new group based on the batch
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
             BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows);
+            newGroup.instances_.SetAllocator(mainThread ? frameAllocators_[0] : threadResult->frameAllocator_);
+            newGroup.geometryType_ = batch.geometryType_ == GEOM_INSTANCED ? GEOM_STATIC : GEOM_SKINNED;
+            if (!renderer_->SetBatchShaders(newGroup, tech, allowShadows, mainThread))
+            {
+                DeferBatch(*threadResult, batchQueue, batch, tech, allowInstancing, allowShadows);
+                return;
+            }
             newGroup.CalculateSortKey();
             i = batchQueue.batchGroups_.Insert(MakePair(key, newGroup));
         }
@@ -2678,20 +3267,37 @@ void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech
         i->second_.AddTransforms(batch);
         // Convert to using instancing shaders when the instancing limit is reached
         if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
-        {
-            i->second_.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second_, tech, allowShadows);
-            i->second_.CalculateSortKey();
-        }
+            SetInstancingShaders(i->second_, tech, allowShadows, mainThread);
     }
     else
     {
-        renderer_->SetBatchShaders(batch, tech, allowShadows);
+        if (!renderer_->SetBatchShaders(batch, tech, allowShadows, mainThread))
+        {
+            DeferBatch(*threadResult, batchQueue, batch, tech, allowInstancing, allowShadows);
+            return;
+        }
         batch.CalculateSortKey();
         batchQueue.batches_.Push(batch);
     }
 }
 
+void View::SetInstancingShaders(BatchGroup& group, Technique* tech, bool allowShadows, bool mainThread)
+{
+    ShaderVariation* vertexShader = group.vertexShader_;
+    ShaderVariation* pixelShader = group.pixelShader_;
+    GeometryType geometryType = group.geometryType_;
+    
+    group.geometryType_ = geometryType == GEOM_SKINNED ? GEOM_SKINNED_INSTANCED : GEOM_INSTANCED;
+    // Outside the main thread missing shaders can not be reported, so keep the non-instanced shaders in that case
+    if (!renderer_->SetBatchShaders(group, tech, allowShadows, mainThread))
+    {
+        group.geometryType_ = geometryType;
+        group.vertexShader_ = vertexShader;
+        group.pixelShader_ = pixelShader;
+    }
+    group.CalculateSortKey();
+}
+
 void View::PrepareInstancingBuffer()
 {
     PROFILE(PrepareInstancingBuffer);
@@ -2733,6 +3339,195 @@ void View::PrepareInstancingBuffer()
     }
 }
 
+void View::PrepareSkinningTexture()
+{
+    skinnedGroups_.Clear();
+    
+    for (HashMap<StringHash, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+        CollectSkinnedGroups(i->second_, skinnedGroups_);
+    
+    for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+    {
+        for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
+            CollectSkinnedGroups(i->shadowSplits_[j].shadowBatches_, skinnedGroups_);
+        CollectSkinnedGroups(i->litBaseBatches_, skinnedGroups_);
+        CollectSkinnedGroups(i->litBatches_, skinnedGroups_);
+    }
+    
+    if (skinnedGroups_.Empty())
+        return;
+    
+    PROFILE(PrepareSkinningTexture);
+    
+    // Copy each set of skin matrices once to its own palette, even if the object is drawn in several passes.
+    // A palette is 3 texels per skin matrix, and may not cross a row
+    float invWidth = 1.0f / (float)SKINNING_TEXTURE_WIDTH;
+    unsigned row = 0;
+    unsigned column = 0;
+    skinningPalettes_.Clear();
+    skinningInstanceData_.Clear();
+    
+    for (PODVector<BatchGroup*>::Iterator i = skinnedGroups_.Begin(); i != skinnedGroups_.End(); ++i)
+    {
+        BatchGroup& group = **i;
+        unsigned numSkinMatrices = Min((int)group.numWorldTransforms_, MAX_SKIN_MATRICES);
+        
+        for (FramePODVector<InstanceData>::Iterator j = group.instances_.Begin(); j != group.instances_.End(); ++j)
+        {
+            if (skinningPalettes_.Contains(j->worldTransform_))
+                continue;
+            
+            if (column + numSkinMatrices * 3 > SKINNING_TEXTURE_WIDTH)
+            {
+                ++row;
+                column = 0;
+            }
+            if (skinningData_.Size() < (row + 1) * SKINNING_TEXTURE_WIDTH)
+                skinningData_.Resize((row + 1) * SKINNING_TEXTURE_WIDTH);
+            memcpy(&skinningData_[row * SKINNING_TEXTURE_WIDTH + column], j->worldTransform_, numSkinMatrices *
+                sizeof(Matrix3x4));
+            
+            // The instance data holds the texture coordinates of the first skin matrix and the texel width. Store the row
+            // for now, as the texture height is not yet known
+            Matrix3x4 data = Matrix3x4::ZERO;
+            data.m00_ = ((float)column + 0.5f) * invWidth;
+            data.m01_ = (float)row;
+            data.m02_ = invWidth;
+            skinningPalettes_[j->worldTransform_] = skinningInstanceData_.Size();
+            skinningInstanceData_.Push(data);
+            
+            column += numSkinMatrices * 3;
+        }
+    }
+    
+    // If the texture can not be resized, the rows beyond its size will not be uploaded
+    unsigned numRows = row + 1;
+    renderer_->ResizeSkinningTexture(numRows);
+    Texture2D* skinningTexture = renderer_->GetSkinningTexture();
+    int textureHeight = skinningTexture->GetHeight();
+    skinningTexture->SetData(0, 0, 0, SKINNING_TEXTURE_WIDTH, Min((int)numRows, textureHeight), &skinningData_[0]);
+    
+    // Finally point the instances to their instance data instead of the skin matrices
+    for (PODVector<BatchGroup*>::Iterator i = skinnedGroups_.Begin(); i != skinnedGroups_.End(); ++i)
+    {
+        BatchGroup& group = **i;
+        FramePODVector<InstanceData>& instances = group.instances_;
+        
+        // If some of the group's palettes were not uploaded, set the skin matrices per object instead. The shaders are
+        // already loaded, so the technique is not needed
+        if (numRows > (unsigned)textureHeight)
+        {
+            bool uploaded = true;
+            for (FramePODVector<InstanceData>::ConstIterator j = instances.Begin(); j != instances.End() && uploaded; ++j)
+                uploaded = skinningInstanceData_[skinningPalettes_[j->worldTransform_]].m01_ < (float)textureHeight;
+            
+            if (!uploaded)
+            {
+                group.geometryType_ = GEOM_SKINNED;
+                renderer_->SetBatchShaders(group, 0, true);
+                group.CalculateSortKey();
+                continue;
+            }
+        }
+        
+        for (FramePODVector<InstanceData>::Iterator j = instances.Begin(); j != instances.End(); ++j)
+            j->worldTransform_ = &skinningInstanceData_[skinningPalettes_[j->worldTransform_]];
+    }
+    
+    float invHeight = 1.0f / (float)textureHeight;
+    for (PODVector<Matrix3x4>::Iterator i = skinningInstanceData_.Begin(); i != skinningInstanceData_.End(); ++i)
+        i->m01_ = (i->m01_ + 0.5f) * invHeight;
+}
+
+void View::PrepareLightClusterTexture()
+{
+    if (clusteredLights_.Empty())
+        return;
+    
+    PROFILE(PrepareLightClusterTexture);
+    
+    // The texture begins with the cluster table, followed by the light data and finally the light lists of the clusters.
+    // Texture coordinates are stored as texels, so that they do not depend on the texture height
+    const unsigned numClusters = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z;
+    const unsigned tableRows = (numClusters + LIGHT_CLUSTER_TEXTURE_WIDTH - 1) / LIGHT_CLUSTER_TEXTURE_WIDTH;
+    const unsigned lightsPerRow = LIGHT_CLUSTER_TEXTURE_WIDTH / 4;
+    unsigned lightRows = (clusteredLights_.Size() + lightsPerRow - 1) / lightsPerRow;
+    lightClusterData_.Resize((tableRows + lightRows) * LIGHT_CLUSTER_TEXTURE_WIDTH);
+    
+    // Each light takes 4 texels, with the same layout as vertex lights, and specular intensity in the last texel
+    for (unsigned i = 0; i < clusteredLights_.Size(); ++i)
+    {
+        Light* light = clusteredLights_[i];
+        Node* lightNode = light->GetNode();
+        
+        float invRange = 1.0f / Max(light->GetRange(), M_EPSILON);
+        float cutoff, invCutoff;
+        if (light->GetLightType() == LIGHT_SPOT)
+        {
+            cutoff = Cos(light->GetFov() * 0.5f);
+            invCutoff = 1.0f / (1.0f - cutoff);
+        }
+        else
+        {
+            // Make the spot attenuation always saturate to 1 for point lights
+            cutoff = -2.0f;
+            invCutoff = 1.0f;
+        }
+        
+        float fade = 1.0f;
+        float fadeEnd = light->GetDrawDistance();
+        float fadeStart = light->GetFadeDistance();
+        if (fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+        
+        Color color = light->GetEffectiveColor() * fade;
+        float specIntensity = renderer_->GetSpecularLighting() ? light->GetEffectiveSpecularIntensity() : 0.0f;
+        
+        Vector4* dest = &lightClusterData_[(tableRows + i / lightsPerRow) * LIGHT_CLUSTER_TEXTURE_WIDTH + (i % lightsPerRow) * 4];
+        dest[0] = Vector4(color.r_, color.g_, color.b_, invRange);
+        dest[1] = Vector4(-(lightNode->GetWorldDirection()), cutoff);
+        dest[2] = Vector4(lightNode->GetWorldPosition(), invCutoff);
+        dest[3] = Vector4(specIntensity, 0.0f, 0.0f, 0.0f);
+    }
+    
+    // A light list holds the texel coordinates of each light's data, and may not cross a row
+    unsigned row = tableRows + lightRows;
+    unsigned column = 0;
+    for (unsigned i = 0; i < numClusters; ++i)
+    {
+        unsigned count = clusterLightCounts_[i];
+        if (!count)
+        {
+            lightClusterData_[i] = Vector4::ZERO;
+            continue;
+        }
+        
+        if (column + count > LIGHT_CLUSTER_TEXTURE_WIDTH)
+        {
+            ++row;
+            column = 0;
+        }
+        if (lightClusterData_.Size() < (row + 1) * LIGHT_CLUSTER_TEXTURE_WIDTH)
+            lightClusterData_.Resize((row + 1) * LIGHT_CLUSTER_TEXTURE_WIDTH);
+        
+        lightClusterData_[i] = Vector4((float)column, (float)row, (float)count, 0.0f);
+        
+        const unsigned short* indices = &clusterLightIndices_[i * MAX_LIGHTS_PER_CLUSTER];
+        Vector4* dest = &lightClusterData_[row * LIGHT_CLUSTER_TEXTURE_WIDTH + column];
+        for (unsigned j = 0; j < count; ++j)
+            dest[j] = Vector4((float)((indices[j] % lightsPerRow) * 4), (float)(tableRows + indices[j] / lightsPerRow), 0.0f, 0.0f);
+        
+        column += count;
+    }
+    
+    // If the texture can not be resized, the rows beyond its size will not be uploaded
+    unsigned numRows = lightClusterData_.Size() / LIGHT_CLUSTER_TEXTURE_WIDTH;
+    renderer_->ResizeLightClusterTexture(numRows);
+    Texture2D* lightClusterTexture = renderer_->GetLightClusterTexture();
+    lightClusterTexture->SetData(0, 0, 0, LIGHT_CLUSTER_TEXTURE_WIDTH, Min((int)numRows, lightClusterTexture->GetHeight()),
+        &lightClusterData_[0]);
+}
+
 void View::SetupLightVolumeBatch(Batch& batch)
 {
     Light* light = batch.lightQueue_->light_;
@@ -2780,6 +3575,14 @@ void View::SetupLightVolumeBatch(Batch& batch)
 
 void View::RenderShadowMap(const LightBatchQueue& queue)
 {
+    // If the shadow map is cached and up to date, there is nothing to render
+    ShadowMapCache* cache = queue.shadowMapCache_;
+    if (cache && cache->valid_)
+    {
+        cache->frameNumber_ = frame_.frameNumber_;
+        return;
+    }
+    
     PROFILE(RenderShadowMap);
     
     Texture2D* shadowMap = queue.shadowMap_;
@@ -2829,6 +3632,13 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
     
     graphics_->SetColorWrite(true);
     graphics_->SetDepthBias(0.0f, 0.0f);
+    
+    if (cache)
+    {
+        shadowMap->ClearDataLost();
+        cache->valid_ = true;
+        cache->frameNumber_ = frame_.frameNumber_;
+    }
 }
 
 RenderSurface* View::GetDepthStencil(RenderSurface* renderTarget)
@@ -42,16 +42,48 @@ class RenderPath;
 class RenderSurface;
 class Technique;
 class Texture2D;
+class View;
 class Viewport;
 class Zone;
 struct RenderPathCommand;
 struct WorkItem;
 
+/// Shadow map of a point or spot light kept between frames, along with the shadow casters rendered into it.
+struct ShadowMapCache
+{
+    /// Construct.
+    ShadowMapCache() :
+        hash_(0),
+        frameNumber_(0),
+        valid_(false)
+    {
+    }
+    
+    /// Light.
+    WeakPtr<Light> light_;
+    /// Shadow map.
+    SharedPtr<Texture2D> shadowMap_;
+    /// Requested shadow map size.
+    IntVector2 size_;
+    /// Hash of the light parameters the shadow map was rendered with.
+    unsigned hash_;
+    /// Frame number on which the shadow map was last known to be up to date.
+    unsigned frameNumber_;
+    /// Shadow casters rendered into the shadow map.
+    HashSet<Drawable*> shadowCasters_;
+    /// Combined bounding box of shadow casters in light projection space.
+    BoundingBox shadowCasterBox_[MAX_LIGHT_SPLITS];
+    /// Up to date flag. If set, the shadow casters do not need to be processed or rendered again on this frame.
+    bool valid_;
+};
+
 /// Intermediate light processing result.
 struct LightQueryResult
 {
     /// Light.
     Light* light_;
+    /// Shadow map cache, or null if the light's shadow map is not cached.
+    ShadowMapCache* shadowMapCache_;
     /// Lit geometries.
     PODVector<Drawable*> litGeometries_;
     /// Shadow casters.
@@ -85,10 +117,29 @@ struct ScenePassInfo
     bool useScissor_;
     /// Vertex light flag.
     bool vertexLights_;
+    /// Clustered lights flag.
+    bool clusteredLights_;
     /// Batch queue.
     BatchQueue* batchQueue_;
 };
 
+/// Range of light clusters touched by a clustered light.
+struct LightClusterRange
+{
+    /// Minimum X cell.
+    int minX_;
+    /// Maximum X cell.
+    int maxX_;
+    /// Minimum Y cell.
+    int minY_;
+    /// Maximum Y cell.
+    int maxY_;
+    /// Minimum depth slice.
+    int minZ_;
+    /// Maximum depth slice.
+    int maxZ_;
+};
+
 /// Per-thread geometry, light and scene range collection structure.
 struct PerThreadSceneResult
 {
@@ -102,6 +153,47 @@ struct PerThreadSceneResult
     float maxZ_;
 };
 
+/// Batch that could not be finished in a worker thread, to be added to its queue in the main thread.
+struct DeferredBatch
+{
+    /// Batch.
+    Batch batch_;
+    /// Technique.
+    Technique* tech_;
+    /// Destination batch queue.
+    BatchQueue* queue_;
+    /// Allow instancing flag.
+    bool allowInstancing_;
+    /// Allow shadows flag.
+    bool allowShadows_;
+};
+
+/// Batch generation results of one work item. Merged in work item order, so the result does not depend on which thread executed which item.
+struct BatchWorkResult
+{
+    /// Construct.
+    BatchWorkResult() :
+        view_(0),
+        frameAllocator_(0)
+    {
+    }
+    
+    /// View that the batches are generated for.
+    View* view_;
+    /// Base pass batch queues, one for each scene pass.
+    Vector<BatchQueue> baseQueues_;
+    /// Lit transparent batches.
+    BatchQueue alphaQueue_;
+    /// Batches to be finished in the main thread.
+    PODVector<DeferredBatch> deferredBatches_;
+    /// Materials to check for auxiliary views.
+    PODVector<Material*> auxViewMaterials_;
+    /// Vertex lit drawables, whose base pass batches are built in the main thread.
+    PODVector<Drawable*> vertexLitDrawables_;
+    /// Frame allocator of the executing thread for instance data.
+    FrameAllocator* frameAllocator_;
+};
+
 static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 
 /// 3D rendering view. Includes the main view(s) and any auxiliary views, but not shadow cameras.
@@ -109,6 +201,9 @@ class URHO3D_API View : public Object
 {
     friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetLightBatchesWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex);
+    friend void AssignLightClustersWork(const WorkItem* item, unsigned threadIndex);
     
     OBJECT(View);
     
@@ -153,6 +248,8 @@ public:
     void SetCameraShaderParameters(Camera* camera, bool setProjectionMatrix, bool overrideView);
     /// Set G-buffer offset and inverse size shader parameters. Called by Batch and internally by View.
     void SetGBufferShaderParameters(const IntVector2& texSize, const IntRect& viewRect);
+    /// Release the cached shadow maps.
+    void ResetShadowMapCache();
     
 private:
     /// Query the octree for drawable objects.
@@ -161,8 +258,18 @@ private:
     void GetBatches();
     /// Update geometries and sort batches.
     void UpdateGeometries();
-    /// Get pixel lit batches for a certain light and drawable.
-    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue);
+    /// Get shadow and pixel lit batches for a light in a worker thread.
+    void GetLightBatches(LightQueryResult& query, BatchWorkResult& threadResult);
+    /// Get pixel lit batches for a certain light and drawable. Pass the work item result when called from a worker thread.
+    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, BatchWorkResult* threadResult = 0);
+    /// Get base pass batches for a drawable. Pass the work item result when called from a worker thread.
+    void GetBaseBatches(Drawable* drawable, BatchWorkResult* threadResult = 0);
+    /// Clear the batch results for the given number of work items.
+    void PrepareBatchResults(unsigned count);
+    /// Finish deferred batches and check materials for auxiliary views after batches were built in worker threads.
+    void FinishThreadBatches();
+    /// Merge a work item batch queue into a view batch queue.
+    void MergeBatchQueue(BatchQueue& dest, BatchQueue& src);
     /// Execute render commands.
     void ExecuteRenderPathCommands();
     /// Set rendertargets for current render command.
@@ -191,6 +298,10 @@ private:
     void DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders);
     /// Query for lit geometries and shadow casters for a light.
     void ProcessLight(LightQueryResult& query, unsigned threadIndex);
+    /// Separate the lights that can be evaluated from the light clusters, and calculate the clusters they touch.
+    void GetClusteredLights();
+    /// Assign clustered lights to the light clusters of a range of depth slices.
+    void AssignLightClusters(unsigned firstSlice, unsigned lastSlice);
     /// Process shadow casters' visibilities and build their combined view- or projection-space bounding box.
     void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex);
     /// Set up initial shadow camera view(s).
@@ -205,16 +316,27 @@ private:
     bool IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView, const Frustum& lightViewFrustum, const BoundingBox& lightViewFrustumBox);
     /// Return the viewport for a shadow map split.
     IntRect GetShadowMapViewport(Light* light, unsigned splitIndex, Texture2D* shadowMap);
+    /// Return the shadow map cache for a light and check whether it can be reused on this frame. Return null if the light's shadow map can not be cached.
+    ShadowMapCache* GetShadowMapCache(Light* light);
+    /// Return the cached shadow map for a processed light, and store its shadow casters if the shadow map needs to be rendered again.
+    Texture2D* GetCachedShadowMap(LightQueryResult& query);
     /// Find and set a new zone for a drawable when it has moved.
     void FindZone(Drawable* drawable);
     /// Return material technique, considering the drawable's LOD distance.
     Technique* GetTechnique(Drawable* drawable, Material* material);
     /// Check if material should render an auxiliary view (if it has a camera attached.)
     void CheckMaterialForAuxView(Material* material);
-    /// Choose shaders for a batch and add it to queue.
-    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Choose shaders for a batch and add it to queue. Pass the work item result when called from a worker thread.
+    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true,
+        BatchWorkResult* threadResult = 0);
+    /// Switch a batch group to instancing shaders when it reaches the instancing limit.
+    void SetInstancingShaders(BatchGroup& group, Technique* tech, bool allowShadows, bool mainThread);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
+    /// Fill the skinning texture with the skin matrices of instanced skinned geometry.
+    void PrepareSkinningTexture();
+    /// Fill the light cluster texture with the clustered lights and the light lists of each cluster.
+    void PrepareLightClusterTexture();
     /// Set up a light volume rendering batch.
     void SetupLightVolumeBatch(Batch& batch);
     /// Render a shadow map.
@@ -310,6 +432,8 @@ private:
     bool deferredAmbient_;
     /// Forward light base pass optimization flag. If in use, combine the base pass and first light for all opaque objects.
     bool useLitBase_;
+    /// Clustered forward lighting flag. If in use, unshadowed point and spot lights are added in the base passes from the light clusters.
+    bool useClusteredLights_;
     /// Has scene passes flag. If no scene passes, view can be defined without a valid scene or camera to only perform quad rendering.
     bool hasScenePasses_;
     /// Renderpath.
@@ -318,6 +442,12 @@ private:
     Vector<PODVector<Drawable*> > tempDrawables_;
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Work item batch generation results.
+    Vector<BatchWorkResult> batchResults_;
+    /// Number of work item batch results in use.
+    unsigned numBatchResults_;
+    /// Per-thread frame allocators.
+    PODVector<FrameAllocator*> frameAllocators_;
     /// Visible zones.
     PODVector<Zone*> zones_;
     /// Visible geometry objects.
@@ -338,6 +468,32 @@ private:
     HashMap<StringHash, Texture2D*> renderTargets_;
     /// Intermediate light processing results.
     Vector<LightQueryResult> lightQueryResults_;
+    /// Cached point and spot light shadow maps.
+    HashMap<Light*, ShadowMapCache> shadowMapCache_;
+    /// Temporary vertex light list for base pass batch generation.
+    PODVector<Light*> tempVertexLights_;
+    /// Batch groups with instanced skinned geometry.
+    PODVector<BatchGroup*> skinnedGroups_;
+    /// Skinning texture palette indices by skin matrices.
+    HashMap<const Matrix3x4*, unsigned> skinningPalettes_;
+    /// Skinning texture data.
+    PODVector<Vector4> skinningData_;
+    /// Skinning texture coordinates of the palettes, used as instance data.
+    PODVector<Matrix3x4> skinningInstanceData_;
+    /// Lights evaluated from the light clusters instead of per-pixel light queues.
+    PODVector<Light*> clusteredLights_;
+    /// Light cluster ranges of the clustered lights.
+    PODVector<LightClusterRange> clusterRanges_;
+    /// Number of lights in each light cluster.
+    PODVector<unsigned> clusterLightCounts_;
+    /// Clustered light indices of each light cluster.
+    PODVector<unsigned short> clusterLightIndices_;
+    /// Light cluster texture data.
+    PODVector<Vector4> lightClusterData_;
+    /// View-projection matrix for light cluster lookup.
+    Matrix4 clusterViewProj_;
+    /// Light cluster counts and depth slice scale.
+    Vector4 clusterParams_;
     /// Info for scene render passes defined by the renderpath.
     Vector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
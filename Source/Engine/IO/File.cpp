@@ -31,6 +31,14 @@
 #include <cstdio>
 #include <lz4.h>
 
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "DebugNew.h"
 
 namespace Urho3D
@@ -68,6 +76,11 @@ File::File(Context* context) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    mappedData_(0),
+    mappedSize_(0),
+    #ifdef WIN32
+    mappingHandle_(0),
+    #endif
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -85,6 +98,11 @@ File::File(Context* context, const String& fileName, FileMode mode) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    mappedData_(0),
+    mappedSize_(0),
+    #ifdef WIN32
+    mappingHandle_(0),
+    #endif
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -103,6 +121,11 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    mappedData_(0),
+    mappedSize_(0),
+    #ifdef WIN32
+    mappingHandle_(0),
+    #endif
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -485,6 +508,19 @@ void File::Close()
     readBuffer_.Reset();
     inputBuffer_.Reset();
 
+    if (mappedData_)
+    {
+        #ifdef WIN32
+        UnmapViewOfFile(mappedData_);
+        CloseHandle((HANDLE)mappingHandle_);
+        mappingHandle_ = 0;
+        #else
+        munmap(mappedData_, mappedSize_);
+        #endif
+        mappedData_ = 0;
+        mappedSize_ = 0;
+    }
+
     if (handle_)
     {
         fclose((FILE*)handle_);
@@ -496,6 +532,51 @@ void File::Close()
     }
 }
 
+const unsigned char* File::Map()
+{
+    // Only uncompressed files opened from the filesystem or a package can be mapped
+    if (!handle_ || mode_ != FILE_READ || compressed_ || !size_)
+        return 0;
+
+    // The mapping must start at a page (Windows: allocation granularity) boundary, so round the package offset down
+    #ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    unsigned granularity = info.dwAllocationGranularity;
+    #else
+    unsigned granularity = (unsigned)sysconf(_SC_PAGESIZE);
+    #endif
+    unsigned start = offset_ - offset_ % granularity;
+
+    if (!mappedData_)
+    {
+        unsigned mappedSize = size_ + offset_ - start;
+
+        #ifdef WIN32
+        HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno((FILE*)handle_));
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+        if (!mappingHandle)
+            return 0;
+        void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, start, mappedSize);
+        if (!data)
+        {
+            CloseHandle(mappingHandle);
+            return 0;
+        }
+        mappingHandle_ = mappingHandle;
+        #else
+        void* data = mmap(0, mappedSize, PROT_READ, MAP_PRIVATE, fileno((FILE*)handle_), start);
+        if (data == MAP_FAILED)
+            return 0;
+        #endif
+
+        mappedData_ = data;
+        mappedSize_ = mappedSize;
+    }
+
+    return (const unsigned char*)mappedData_ + (offset_ - start);
+}
+
 void File::Flush()
 {
     if (handle_)
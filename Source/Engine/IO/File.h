@@ -89,6 +89,8 @@ public:
     void* GetHandle() const { return handle_; }
     /// Return whether the file originates from a package.
     bool IsPackaged() const { return offset_ != 0; }
+    /// Map the file contents into memory for reading. Return null if not supported, e.g. for compressed package files. The mapping stays valid until the file is closed.
+    const unsigned char* Map();
     
 private:
     /// File name.
@@ -113,6 +115,14 @@ private:
     unsigned offset_;
     /// Content checksum.
     unsigned checksum_;
+    /// Memory mapping of the file contents, rounded down to the page boundary.
+    void* mappedData_;
+    /// Size of the memory mapping.
+    unsigned mappedSize_;
+    #ifdef WIN32
+    /// File mapping object handle.
+    void* mappingHandle_;
+    #endif
     /// Compression flag.
     bool compressed_;
     /// Synchronization needed before read -flag.
@@ -21,15 +21,16 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Context.h"
+#include "CoreEvents.h"
 #include "File.h"
 #include "IOEvents.h"
 #include "Log.h"
-#include "Mutex.h"
 #include "ProcessUtils.h"
-#include "Timer.h"
 
 #include <cstdio>
+#include <cstdlib>
 
 #ifdef ANDROID
 #include <android/log.h>
@@ -52,25 +53,108 @@ const char* logLevelPrefixes[] =
     0
 };
 
+/// Number of messages that can be queued before writing. Must be a power of two.
+static const unsigned LOG_QUEUE_SIZE = 4096;
+/// Interval in milliseconds for flushing the log file when no errors are written.
+static const unsigned LOG_FLUSH_INTERVAL = 100;
+/// Number of written messages kept for the log message events. When twice as many are waiting, for example because no frames are run, the oldest are dropped.
+static const unsigned MAX_PENDING_EVENTS = 4096;
+
 static Log* logInstance = 0;
+static bool exitHandlerRegistered = false;
+
+/// %Log message queued for writing.
+struct LogRecord
+{
+    /// Sequence number that tells whether the slot is free for queuing or ready for writing.
+    volatile int sequence_;
+    /// Message.
+    String message_;
+    /// Message level.
+    int level_;
+    /// Raw output flag.
+    bool raw_;
+};
 
 Log::Log(Context* context) :
     Object(context),
+    records_(new LogRecord[LOG_QUEUE_SIZE]),
+    queuePosition_(0),
+    writePosition_(0),
+    writerWaiting_(0),
 #ifdef _DEBUG
     level_(LOG_DEBUG),
 #else
     level_(LOG_INFO),
 #endif
     timeStamp_(true),
-    inWrite_(false),
-    quiet_(false)
+    quiet_(false),
+    needFlush_(false)
 {
+    for (unsigned i = 0; i < LOG_QUEUE_SIZE; ++i)
+        records_[i].sequence_ = i;
+
     logInstance = this;
+    if (!exitHandlerRegistered)
+    {
+        atexit(FlushQueued);
+        exitHandlerRegistered = true;
+    }
+
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(Log, HandleBeginFrame));
+
+    // If the writer thread can not be started, messages are written immediately in the calling thread instead
+    Run();
 }
 
 Log::~Log()
 {
-    logInstance = 0;
+    // Wake up the writer thread so that it sees the stop request
+    shouldRun_ = false;
+    writeCondition_.Set();
+    Stop();
+
+    {
+        MutexLock lock(writeMutex_);
+        WriteQueuedMessages();
+        logInstance = 0;
+    }
+
+    Close();
+    delete[] records_;
+    records_ = 0;
+}
+
+void Log::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        bool wait = false;
+        {
+            MutexLock lock(writeMutex_);
+            if (!WriteQueuedMessages())
+            {
+                // Flush the log file before waiting, as no periodic flush happens while idle
+                if (logFile_ && needFlush_)
+                {
+                    logFile_->Flush();
+                    needFlush_ = false;
+                    flushTimer_.Reset();
+                }
+
+                // Announce the wait before checking the queue once more: a message published after the check sees the flag
+                // and wakes the writer up, and a message published before it is written on the next round
+                AtomicCompareExchange(&writerWaiting_, 1, 0);
+                const LogRecord& record = records_[writePosition_ & (LOG_QUEUE_SIZE - 1)];
+                wait = AtomicLoad(&record.sequence_) != (int)(writePosition_ + 1);
+                if (!wait)
+                    AtomicStore(&writerWaiting_, 0);
+            }
+        }
+
+        if (wait)
+            writeCondition_.Wait();
+    }
 }
 
 void Log::Open(const String& fileName)
@@ -78,6 +162,9 @@ void Log::Open(const String& fileName)
     #if !defined(ANDROID) && !defined(IOS)
     if (fileName.Empty())
         return;
+
+    MutexLock lock(writeMutex_);
+
     if (logFile_ && logFile_->IsOpen())
     {
         if (logFile_->GetName() == fileName)
@@ -100,11 +187,18 @@ void Log::Open(const String& fileName)
 void Log::Close()
 {
     #if !defined(ANDROID) && !defined(IOS)
+    MutexLock lock(writeMutex_);
+
+    // Write messages queued so far before closing
+    WriteQueuedMessages();
+
     if (logFile_ && logFile_->IsOpen())
     {
         logFile_->Close();
         logFile_.Reset();
     }
+
+    needFlush_ = false;
     #endif
 }
 
@@ -125,100 +219,238 @@ void Log::SetQuiet(bool quiet)
     quiet_ = quiet;
 }
 
+void Log::Flush()
+{
+    {
+        MutexLock lock(writeMutex_);
+        WriteQueuedMessages();
+
+        if (logFile_ && needFlush_)
+        {
+            logFile_->Flush();
+            needFlush_ = false;
+            flushTimer_.Reset();
+        }
+    }
+
+    SendMessageEvents();
+}
+
+String Log::GetLastMessage() const
+{
+    MutexLock lock(eventMutex_);
+    return lastMessage_;
+}
+
 void Log::Write(int level, const String& message)
 {
     assert(level >= LOG_DEBUG && level < LOG_NONE);
 
-    // Do not log if message level excluded or if currently sending a log event
-    if (!logInstance || logInstance->level_ > level || logInstance->inWrite_)
+    // Do not log if message level excluded
+    if (!logInstance || logInstance->level_ > level)
         return;
 
-    String formattedMessage = logLevelPrefixes[level];
-    formattedMessage += ": " + message;
-    logInstance->lastMessage_ = message;
+    logInstance->QueueMessage(level, message, false);
+}
 
-    if (logInstance->timeStamp_)
-        formattedMessage = "[" + Time::GetTimeStamp() + "] " + formattedMessage;
+void Log::WriteRaw(const String& message, bool error)
+{
+    if (!logInstance)
+        return;
 
-    #if defined(ANDROID)
-    int androidLevel = ANDROID_LOG_DEBUG + level;
-    __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
-    #elif defined(IOS)
-    SDL_IOS_LogMessage(message.CString());
-    #else
-    if (logInstance->quiet_)
-    {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (level == LOG_ERROR)
-            PrintUnicodeLine(formattedMessage, true);
-    }
-    else
-        PrintUnicodeLine(formattedMessage, level == LOG_ERROR);
-    #endif
+    logInstance->QueueMessage(error ? LOG_ERROR : LOG_INFO, message, true);
+}
 
-    if (logInstance->logFile_)
+void Log::FlushQueued()
+{
+    if (!logInstance)
+        return;
+
+    MutexLock lock(logInstance->writeMutex_);
+    logInstance->WriteQueuedMessages();
+    if (logInstance->logFile_ && logInstance->needFlush_)
     {
-        logInstance->logFile_->WriteLine(formattedMessage);
         logInstance->logFile_->Flush();
+        logInstance->needFlush_ = false;
     }
+}
 
-    logInstance->inWrite_ = true;
-
-    using namespace LogMessage;
-
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = formattedMessage;
-    eventData[P_LEVEL] = level;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+void Log::QueueMessage(int level, const String& message, bool raw)
+{
+    for (;;)
+    {
+        unsigned position = (unsigned)AtomicLoad(&queuePosition_);
+        LogRecord& record = records_[position & (LOG_QUEUE_SIZE - 1)];
+        int difference = (int)((unsigned)AtomicLoad(&record.sequence_) - position);
+
+        if (!difference)
+        {
+            // The slot is free: claim it by advancing the queue position. If another thread got there first, retry
+            if (AtomicCompareExchange(&queuePosition_, (int)(position + 1), (int)position) == (int)position)
+            {
+                record.message_ = message;
+                record.level_ = level;
+                record.raw_ = raw;
+                // Publish the message to the writer. Wake the writer up only if it is waiting, as setting the condition
+                // takes a lock. Only one thread succeeds in clearing the flag
+                AtomicStore(&record.sequence_, (int)(position + 1));
+                if (AtomicCompareExchange(&writerWaiting_, 0, 1) == 1)
+                    writeCondition_.Set();
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The ring buffer is full: help the writer thread by writing the queued messages in this thread
+            MutexLock lock(writeMutex_);
+            WriteQueuedMessages();
+        }
+    }
 
-    logInstance->inWrite_ = false;
+    if (!IsStarted())
+    {
+        MutexLock lock(writeMutex_);
+        WriteQueuedMessages();
+    }
 }
 
-void Log::WriteRaw(const String& message, bool error)
+unsigned Log::WriteQueuedMessages()
 {
-    // Prevent recursion during log event
-    if (!logInstance || logInstance->inWrite_)
-        return;
-
-    logInstance->lastMessage_ = message;
+    Vector<Pair<int, String> > writtenMessages;
+    String lastMessage;
+    String timeStamp;
+    bool errorWritten = false;
 
-    #if defined(ANDROID)
-    if (logInstance->quiet_)
+    for (;;)
     {
-        if (error)
-            __android_log_print(ANDROID_LOG_ERROR, "Urho3D", message.CString());
+        LogRecord& record = records_[writePosition_ & (LOG_QUEUE_SIZE - 1)];
+        if (AtomicLoad(&record.sequence_) != (int)(writePosition_ + 1))
+            break;
+
+        String message;
+        message.Swap(record.message_);
+        int level = record.level_;
+        bool raw = record.raw_;
+        bool error = level == LOG_ERROR;
+
+        // Release the slot for queuing before the output, so that messages logged during the output can not deadlock
+        AtomicStore(&record.sequence_, (int)(writePosition_ + LOG_QUEUE_SIZE));
+        ++writePosition_;
+
+        if (!raw)
+        {
+            String formattedMessage = logLevelPrefixes[level];
+            formattedMessage += ": " + message;
+            if (timeStamp_)
+            {
+                // Get the timestamp once per batch, as the messages have been queued at nearly the same time
+                if (timeStamp.Empty())
+                    timeStamp = "[" + Time::GetTimeStamp() + "] ";
+                formattedMessage = timeStamp + formattedMessage;
+            }
+
+            #if defined(ANDROID)
+            int androidLevel = ANDROID_LOG_DEBUG + level;
+            __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
+            #elif defined(IOS)
+            SDL_IOS_LogMessage(message.CString());
+            #else
+            if (quiet_)
+            {
+                // If in quiet mode, still print the error message to the standard error stream
+                if (error)
+                    PrintUnicodeLine(formattedMessage, true);
+            }
+            else
+                PrintUnicodeLine(formattedMessage, error);
+            #endif
+
+            if (logFile_)
+            {
+                logFile_->WriteLine(formattedMessage);
+                needFlush_ = true;
+            }
+
+            writtenMessages.Push(MakePair(level, formattedMessage));
+        }
+        else
+        {
+            #if defined(ANDROID)
+            if (quiet_)
+            {
+                if (error)
+                    __android_log_print(ANDROID_LOG_ERROR, "Urho3D", message.CString());
+            }
+            else
+                __android_log_print(error ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Urho3D", message.CString());
+            #elif defined(IOS)
+            SDL_IOS_LogMessage(message.CString());
+            #else
+            if (quiet_)
+            {
+                // If in quiet mode, still print the error message to the standard error stream
+                if (error)
+                    PrintUnicode(message, true);
+            }
+            else
+                PrintUnicode(message, error);
+            #endif
+
+            if (logFile_)
+            {
+                logFile_->Write(message.CString(), message.Length());
+                needFlush_ = true;
+            }
+
+            writtenMessages.Push(MakePair(level, message));
+        }
+
+        errorWritten |= error;
+        lastMessage.Swap(message);
     }
-    else
-        __android_log_print(error ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Urho3D", message.CString());
-    #elif defined(IOS)
-    SDL_IOS_LogMessage(message.CString());
-    #else
-    if (logInstance->quiet_)
+
+    // Flush the log file immediately after errors, otherwise periodically
+    if (logFile_ && needFlush_ && (errorWritten || flushTimer_.GetMSec(false) >= LOG_FLUSH_INTERVAL))
     {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (error)
-            PrintUnicode(message, true);
+        logFile_->Flush();
+        needFlush_ = false;
+        flushTimer_.Reset();
     }
-    else
-        PrintUnicode(message, error);
-    #endif
 
-    if (logInstance->logFile_)
+    if (writtenMessages.Empty())
+        return 0;
+
+    MutexLock lock(eventMutex_);
+    pendingEvents_.Push(writtenMessages);
+    if (pendingEvents_.Size() >= 2 * MAX_PENDING_EVENTS)
+        pendingEvents_.Erase(0, pendingEvents_.Size() - MAX_PENDING_EVENTS);
+    lastMessage_ = lastMessage;
+    return writtenMessages.Size();
+}
+
+void Log::SendMessageEvents()
+{
+    // Take the pending messages first: messages logged by the event handlers are sent on the next frame
+    Vector<Pair<int, String> > messages;
     {
-        logInstance->logFile_->Write(message.CString(), message.Length());
-        logInstance->logFile_->Flush();
+        MutexLock lock(eventMutex_);
+        messages.Swap(pendingEvents_);
     }
 
-    logInstance->inWrite_ = true;
-
     using namespace LogMessage;
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = message;
-    eventData[P_LEVEL] = error ? LOG_ERROR : LOG_INFO;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+    for (Vector<Pair<int, String> >::ConstIterator i = messages.Begin(); i != messages.End(); ++i)
+    {
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_MESSAGE] = i->second_;
+        eventData[P_LEVEL] = i->first_;
+        SendEvent(E_LOGMESSAGE, eventData);
+    }
+}
 
-    logInstance->inWrite_ = false;
+void Log::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    SendMessageEvents();
 }
 
 }
@@ -22,8 +22,12 @@
 
 #pragma once
 
+#include "Condition.h"
+#include "Mutex.h"
 #include "Object.h"
 #include "StringUtils.h"
+#include "Thread.h"
+#include "Timer.h"
 
 namespace Urho3D
 {
@@ -40,18 +44,22 @@ static const int LOG_ERROR = 3;
 static const int LOG_NONE = 4;
 
 class File;
+struct LogRecord;
 
-/// Logging subsystem.
-class URHO3D_API Log : public Object
+/// Logging subsystem. Messages can be written from any thread. They are queued into a lock-free ring buffer, written to the console and the log file by a background thread, and sent as log message events on the main thread at the beginning of the next frame. If no frames are run, only the latest messages are kept for the events.
+class URHO3D_API Log : public Object, public Thread
 {
     OBJECT(Log);
 
 public:
     /// Construct.
     Log(Context* context);
-    /// Destruct. Close the log file if open.
+    /// Destruct. Write the queued messages and close the log file if open.
     virtual ~Log();
 
+    /// Write the queued messages in the background.
+    virtual void ThreadFunction();
+
     /// Open the log file.
     void Open(const String& fileName);
     /// Close the log file.
@@ -62,13 +70,15 @@ public:
     void SetTimeStamp(bool enable);
     /// Set quiet mode ie. only print error entries to standard error stream (which is normally redirected to console also). Output to log file is not affected by this mode.
     void SetQuiet(bool quiet);
+    /// Write all queued messages now and send their log message events. Must only be called from the main thread.
+    void Flush();
 
     /// Return logging level.
     int GetLevel() const { return level_; }
     /// Return whether log messages are timestamped.
     bool GetTimeStamp() const { return timeStamp_; }
-    /// Return last log message.
-    String GetLastMessage() const { return lastMessage_; }
+    /// Return last log message that has been written.
+    String GetLastMessage() const;
     /// Return whether log is in quiet mode (only errors printed to standard error stream).
     bool IsQuiet() const { return quiet_; }
 
@@ -76,20 +86,49 @@ public:
     static void Write(int level, const String& message);
     /// Write raw output to the log.
     static void WriteRaw(const String& message, bool error = false);
+    /// Write the queued messages and flush the log file without sending log message events. Can be called from any thread. Called by ErrorExit() and when the process exits without destructing the log.
+    static void FlushQueued();
 
 private:
+    /// Queue a message to the ring buffer. If the buffer is full, write the queued messages in the calling thread.
+    void QueueMessage(int level, const String& message, bool raw);
+    /// Write the queued messages to the console and the log file and flush the log file if necessary. Return number of messages written. The write mutex must be held.
+    unsigned WriteQueuedMessages();
+    /// Send the log message events of the messages written so far.
+    void SendMessageEvents();
+    /// Handle beginning of frame. Send the log message events.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Ring buffer of queued messages.
+    LogRecord* records_;
+    /// Next ring buffer position to queue to. Advanced atomically by the writing threads.
+    volatile int queuePosition_;
+    /// Next ring buffer position to write from. Only accessed with the write mutex held.
+    unsigned writePosition_;
+    /// Mutex for writing the queued messages to the console and the log file.
+    Mutex writeMutex_;
+    /// Condition for waking up the writer thread when messages are queued.
+    Condition writeCondition_;
+    /// Writer thread waiting flag. Set by the writer thread before waiting and cleared by the thread that wakes it up.
+    volatile int writerWaiting_;
+    /// Mutex for the written messages waiting for their log message events and the last message.
+    mutable Mutex eventMutex_;
+    /// Written messages waiting for their log message events, with their levels.
+    Vector<Pair<int, String> > pendingEvents_;
     /// Log file.
     SharedPtr<File> logFile_;
     /// Last log message.
     String lastMessage_;
+    /// Timer for flushing the log file periodically.
+    Timer flushTimer_;
     /// Logging level.
     int level_;
     /// Timestamp log messages flag.
     bool timeStamp_;
-    /// In write flag to prevent recursion.
-    bool inWrite_;
     /// Quiet mode flag.
     bool quiet_;
+    /// Log file has unflushed data flag.
+    bool needFlush_;
 };
 
 #ifdef URHO3D_LOGGING
@@ -56,10 +56,10 @@ namespace Urho3D
 {
 
 const int SCREEN_JOYSTICK_START_ID = 0x40000000;
-const ShortStringHash VAR_BUTTON_KEY_BINDING("VAR_BUTTON_KEY_BINDING");
-const ShortStringHash VAR_BUTTON_MOUSE_BUTTON_BINDING("VAR_BUTTON_MOUSE_BUTTON_BINDING");
-const ShortStringHash VAR_LAST_KEYSYM("VAR_LAST_KEYSYM");
-const ShortStringHash VAR_SCREEN_JOYSTICK_ID("VAR_SCREEN_JOYSTICK_ID");
+const ShortStringHash VAR_BUTTON_KEY_BINDING(ShortStringHash::CalculateLiteral("VAR_BUTTON_KEY_BINDING"));
+const ShortStringHash VAR_BUTTON_MOUSE_BUTTON_BINDING(ShortStringHash::CalculateLiteral("VAR_BUTTON_MOUSE_BUTTON_BINDING"));
+const ShortStringHash VAR_LAST_KEYSYM(ShortStringHash::CalculateLiteral("VAR_LAST_KEYSYM"));
+const ShortStringHash VAR_SCREEN_JOYSTICK_ID(ShortStringHash::CalculateLiteral("VAR_SCREEN_JOYSTICK_ID"));
 
 /// Convert SDL keycode if necessary.
 int ConvertSDLKeyCode(int keySym, int scanCode)
@@ -1073,7 +1073,7 @@ void Input::HandleSDLEvent(void* sdlEvent)
             {
                 using namespace TextInput;
 
-                VariantMap textInputEventData;
+                InlineVariantMap<3> textInputEventData;
 
                 textInputEventData[P_TEXT] = textInput_;
                 textInputEventData[P_BUTTONS] = mouseButtonDown_;
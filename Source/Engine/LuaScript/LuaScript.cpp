@@ -224,8 +224,8 @@ void LuaScript::ScriptSubscribeToEvent(void* sender, const String& eventName, co
         LuaFunctionVector& functions = objectHandleFunctions_[object][eventType];
 
         // Fix issue #256
-        HashSet<Object*>* receivers = context_->GetEventReceivers(object, eventType);
-        if ((!receivers || !receivers->Contains(this)) && !functions.Empty())
+        EventReceiverGroup* receivers = context_->GetEventReceivers(object, eventType);
+        if ((!receivers || !receivers->receivers_.Contains(this)) && !functions.Empty())
             functions.Clear();
 
         SubscribeToEvent(object, eventType, HANDLER(LuaScript, HandleObjectEvent));
@@ -24,6 +24,13 @@
 
 #include "Str.h"
 
+// Use constexpr where supported, so that hashes of string literals are calculated at compile time
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define URHO3D_CONSTEXPR constexpr
+#else
+#define URHO3D_CONSTEXPR
+#endif
+
 namespace Urho3D
 {
 
@@ -44,7 +51,7 @@ public:
     }
     
     /// Construct with an initial value.
-    explicit StringHash(unsigned value) :
+    explicit URHO3D_CONSTEXPR StringHash(unsigned value) :
         value_(value)
     {
     }
@@ -95,11 +102,19 @@ public:
     
     /// Calculate hash value case-insensitively from a C string.
     static unsigned Calculate(const char* str);
+    /// Calculate hash value case-insensitively from a string literal. Same result as Calculate(), but evaluated at compile time when the compiler supports constexpr.
+    static URHO3D_CONSTEXPR unsigned CalculateLiteral(const char* str, unsigned hash = 0)
+    {
+        return *str ? CalculateLiteral(str + 1, LiteralChar(*str) + (hash << 6) + (hash << 16) - hash) : hash;
+    }
     
     /// Zero hash.
     static const StringHash ZERO;
     
 private:
+    /// Convert a character to lowercase for hashing. Matches tolower() in the "C" locale.
+    static URHO3D_CONSTEXPR unsigned char LiteralChar(char c) { return (unsigned char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c); }
+    
     /// Hash value.
     unsigned value_;
 };
@@ -127,7 +142,7 @@ public:
     }
     
     /// Construct with an initial value.
-    explicit ShortStringHash(unsigned short value) :
+    explicit URHO3D_CONSTEXPR ShortStringHash(unsigned short value) :
         value_(value)
     {
     }
@@ -178,6 +193,8 @@ public:
     
     /// Calculate hash value case-insensitively from a C string.
     static unsigned short Calculate(const char* str);
+    /// Calculate hash value case-insensitively from a string literal. Same result as Calculate(), but evaluated at compile time when the compiler supports constexpr.
+    static URHO3D_CONSTEXPR unsigned short CalculateLiteral(const char* str) { return (unsigned short)StringHash::CalculateLiteral(str); }
     
     /// Zero hash.
     static const ShortStringHash ZERO;
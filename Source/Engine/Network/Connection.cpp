@@ -64,6 +64,7 @@ Connection::Connection(Context* context, bool isClient, kNet::SharedPtr<kNet::Me
     Object(context),
     position_(Vector3::ZERO),
     connection_(connection),
+    interpolationDelay_(0.0f),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
@@ -221,6 +222,13 @@ void Connection::SendServerUpdate()
     if (!scene_ || !sceneLoaded_)
         return;
     
+    // Send the update tick first so that the client can timestamp the following transform updates
+    Network* network = GetSubsystem<Network>();
+    msg_.Clear();
+    msg_.WriteUInt(network->GetUpdateTick());
+    msg_.WriteVLE(network->GetUpdateFps());
+    SendMessage(MSG_SERVERTICK, false, false, msg_, SERVERTICK_CONTENT_ID);
+    
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -249,6 +257,8 @@ void Connection::SendClientUpdate()
     msg_.WriteFloat(controls_.pitch_);
     msg_.WriteVariantMap(controls_.extraData_);
     msg_.WriteVector3(position_);
+    // Report the render delay, so that the server can evaluate the client's actions at the state it was seeing
+    msg_.WriteFloat(scene_->GetSnapshotInterpolation() ? scene_->GetInterpolationDelay() : 0.0f);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 }
 
@@ -331,9 +341,7 @@ void Connection::ProcessPendingLatestData()
         {
             MemoryBuffer msg(current->second_);
             msg.ReadNetID(); // Skip the node ID
-            node->ReadLatestDataUpdate(msg);
-            // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
-            // Furthermore it would propagate to components and child nodes, which is not desired in this case
+            ReadNodeLatestData(node, msg);
             nodeLatestData_.Erase(current);
         }
     }
@@ -401,6 +409,10 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer &msg)
             ProcessRemoteEvent(msgID, msg);
             break;
             
+        case MSG_SERVERTICK:
+            ProcessServerTick(msgID, msg);
+            break;
+            
         default:
             processed = false;
             break;
@@ -621,11 +633,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             unsigned nodeID = msg.ReadNetID();
             Node* node = scene_->GetNode(nodeID);
             if (node)
-            {
-                node->ReadLatestDataUpdate(msg);
-                // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
-                // Furthermore it would propagate to components and child nodes, which is not desired in this case
-            }
+                ReadNodeLatestData(node, msg);
             else
             {
                 // Latest data messages may be received out-of-order relative to node creation, so cache if necessary
@@ -901,6 +909,7 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
     
     SetControls(newControls);
     SetPosition(msg.ReadVector3());
+    interpolationDelay_ = Max(msg.ReadFloat(), 0.0f);
 }
 
 void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
@@ -983,6 +992,43 @@ void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessServerTick(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        LOGWARNING("Received unexpected ServerTick message from client " + ToString());
+        return;
+    }
+    
+    if (!scene_)
+        return;
+    
+    unsigned tick = msg.ReadUInt();
+    unsigned updateFps = msg.ReadVLE();
+    scene_->SetServerTick(tick, updateFps ? 1.0f / (float)updateFps : 0.0f);
+}
+
+void Connection::ReadNodeLatestData(Node* node, MemoryBuffer& msg)
+{
+    unsigned short shortTick = msg.ReadUShort();
+    node->ReadLatestDataUpdate(msg);
+    // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
+    // Furthermore it would propagate to components and child nodes, which is not desired in this case
+    
+    // Record a snapshot of the received transform. The full tick is reconstructed as the one nearest to the latest
+    // full tick received, which requires at least one ServerTick message to have arrived
+    if (scene_->GetSnapshotInterpolation() && scene_->HasServerTick())
+    {
+        SmoothedTransform* transform = node->GetComponent<SmoothedTransform>();
+        if (transform)
+        {
+            unsigned serverTick = scene_->GetServerTick();
+            unsigned tick = serverTick + (short)(shortTick - (unsigned short)serverTick);
+            transform->AddSnapshot(tick);
+        }
+    }
+}
+
 kNet::MessageConnection* Connection::GetMessageConnection() const
 {
     return const_cast<kNet::MessageConnection*>(connection_.ptr());
@@ -998,6 +1044,11 @@ bool Connection::IsConnected() const
     return connection_->GetConnectionState() == kNet::ConnectionOK;
 }
 
+float Connection::GetRoundTripTime() const
+{
+    return connection_->RoundTripTime();
+}
+
 String Connection::GetAddress() const
 {
     kNet::EndPoint endPoint = connection_->RemoteEndPoint();
@@ -1190,6 +1241,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
+            // Write the update tick truncated to 16 bits, the client reconstructs it from the latest full tick
+            msg_.WriteUShort((unsigned short)GetSubsystem<Network>()->GetUpdateTick());
             node->WriteLatestDataUpdate(msg_);
             
             SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
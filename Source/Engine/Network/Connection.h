@@ -158,6 +158,10 @@ public:
     bool IsSceneLoaded() const { return sceneLoaded_; }
     /// Return whether to log data in/out statistics.
     bool GetLogStatistics() const { return logStatistics_; }
+    /// Return round trip time in milliseconds.
+    float GetRoundTripTime() const;
+    /// Return the client's snapshot interpolation delay in seconds, as reported with its controls. Zero if the client does not use snapshot interpolation.
+    float GetInterpolationDelay() const { return interpolationDelay_; }
     /// Return remote address.
     String GetAddress() const;
     /// Return remote port.
@@ -197,6 +201,10 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a ServerTick message from the server. Called by Network.
+    void ProcessServerTick(int msgID, MemoryBuffer& msg);
+    /// Read the truncated server tick of a node latest data message and record a transform snapshot for the node.
+    void ReadNodeLatestData(Node* node, MemoryBuffer& msg);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
@@ -238,6 +246,8 @@ private:
     String sceneFileName_;
     /// Statistics timer.
     Timer statsTimer_;
+    /// Client's snapshot interpolation delay.
+    float interpolationDelay_;
     /// Client connection flag.
     bool isClient_;
     /// Connection pending flag.
@@ -0,0 +1,336 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Connection.h"
+#include "Context.h"
+#include "Drawable.h"
+#include "Geometry.h"
+#include "LagCompensation.h"
+#include "Network.h"
+#include "NetworkEvents.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Sort.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const unsigned DEFAULT_HISTORY_SIZE = 64;
+static const float DEFAULT_MAX_REWIND = 1.0f;
+static const float DEFAULT_TICK_INTERVAL = 1.0f / 30.0f;
+
+static inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
+{
+    return lhs.distance_ < rhs.distance_;
+}
+
+LagCompensation::LagCompensation(Context* context) :
+    Component(context),
+    historySize_(DEFAULT_HISTORY_SIZE),
+    maxRewind_(DEFAULT_MAX_REWIND),
+    latestTick_(0)
+{
+    SubscribeToEvent(E_NETWORKUPDATESENT, HANDLER(LagCompensation, HandleNetworkUpdateSent));
+}
+
+LagCompensation::~LagCompensation()
+{
+}
+
+void LagCompensation::RegisterObject(Context* context)
+{
+    context->RegisterFactory<LagCompensation>(NETWORK_CATEGORY);
+    
+    ACCESSOR_ATTRIBUTE(LagCompensation, VAR_INT, "History Size", GetHistorySize, SetHistorySize, unsigned, DEFAULT_HISTORY_SIZE, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(LagCompensation, VAR_FLOAT, "Max Rewind", GetMaxRewind, SetMaxRewind, float, DEFAULT_MAX_REWIND, AM_DEFAULT);
+}
+
+void LagCompensation::SetHistorySize(unsigned size)
+{
+    size = Max((int)size, 2);
+    if (size == historySize_)
+        return;
+    
+    historySize_ = size;
+    
+    // Existing histories are discarded, as the ring buffers have to be reallocated
+    for (HashMap<unsigned, NodeTransformHistory>::Iterator i = histories_.Begin(); i != histories_.End(); ++i)
+    {
+        i->second_.samples_.Resize(historySize_);
+        i->second_.first_ = 0;
+        i->second_.count_ = 0;
+    }
+    
+    MarkNetworkUpdate();
+}
+
+void LagCompensation::SetMaxRewind(float time)
+{
+    maxRewind_ = Max(time, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void LagCompensation::AddNode(Node* node)
+{
+    if (!node || histories_.Contains(node->GetID()))
+        return;
+    
+    NodeTransformHistory& history = histories_[node->GetID()];
+    history.node_ = node;
+    history.samples_.Resize(historySize_);
+}
+
+void LagCompensation::RemoveNode(Node* node)
+{
+    if (node)
+        histories_.Erase(node->GetID());
+}
+
+void LagCompensation::RemoveAllNodes()
+{
+    histories_.Clear();
+}
+
+void LagCompensation::Record(unsigned tick)
+{
+    PROFILE(RecordTransformHistory);
+    
+    latestTick_ = tick;
+    
+    for (HashMap<unsigned, NodeTransformHistory>::Iterator i = histories_.Begin(); i != histories_.End();)
+    {
+        HashMap<unsigned, NodeTransformHistory>::Iterator current = i++;
+        NodeTransformHistory& history = current->second_;
+        Node* node = history.node_;
+        if (!node)
+        {
+            histories_.Erase(current);
+            continue;
+        }
+        
+        TransformHistorySample sample;
+        sample.tick_ = tick;
+        sample.position_ = node->GetWorldPosition();
+        sample.rotation_ = node->GetWorldRotation();
+        sample.scale_ = node->GetWorldScale();
+        
+        unsigned size = history.samples_.Size();
+        if (history.count_)
+        {
+            TransformHistorySample& last = history.samples_[(history.first_ + history.count_ - 1) % size];
+            // An unchanged transform needs no new sample, the previous sample stays valid until the next change
+            if (last.position_ == sample.position_ && last.rotation_ == sample.rotation_ && last.scale_ == sample.scale_)
+                continue;
+            if (last.tick_ == tick)
+            {
+                last = sample;
+                continue;
+            }
+            
+            // If the node was stationary for a while, close the stationary period at the previous tick so that
+            // interpolation does not spread the change over the whole period
+            if (tick - last.tick_ > 1)
+            {
+                TransformHistorySample stationary = last;
+                stationary.tick_ = tick - 1;
+                if (history.count_ < size)
+                    history.samples_[(history.first_ + history.count_++) % size] = stationary;
+                else
+                {
+                    history.samples_[history.first_] = stationary;
+                    history.first_ = (history.first_ + 1) % size;
+                }
+            }
+        }
+        
+        if (history.count_ < size)
+            history.samples_[(history.first_ + history.count_++) % size] = sample;
+        else
+        {
+            // Ring buffer full: overwrite the oldest sample
+            history.samples_[history.first_] = sample;
+            history.first_ = (history.first_ + 1) % size;
+        }
+    }
+}
+
+void LagCompensation::Raycast(PODVector<RayQueryResult>& result, const Ray& ray, Connection* connection, RayQueryLevel level,
+    float maxDistance, unsigned viewMask) const
+{
+    RaycastAtTick(result, ray, GetRewindTick(connection), level, maxDistance, viewMask);
+}
+
+void LagCompensation::RaycastAtTick(PODVector<RayQueryResult>& result, const Ray& ray, double tick, RayQueryLevel level,
+    float maxDistance, unsigned viewMask) const
+{
+    PROFILE(LagCompensatedRaycast);
+    
+    result.Clear();
+    
+    PODVector<Node*> nodes;
+    PODVector<Drawable*> drawables;
+    
+    for (HashMap<unsigned, NodeTransformHistory>::ConstIterator i = histories_.Begin(); i != histories_.End(); ++i)
+    {
+        const NodeTransformHistory& history = i->second_;
+        Node* trackedNode = history.node_;
+        if (!trackedNode)
+            continue;
+        
+        // Only the tracked node is rewound. Its child nodes keep their present transforms relative to it
+        Matrix3x4 correction = GetHistoryTransform(history, tick) * trackedNode->GetWorldTransform().Inverse();
+        
+        trackedNode->GetChildren(nodes, true);
+        nodes.Push(trackedNode);
+        
+        for (PODVector<Node*>::ConstIterator j = nodes.Begin(); j != nodes.End(); ++j)
+        {
+            Node* node = *j;
+            node->GetDerivedComponents<Drawable>(drawables);
+            if (drawables.Empty())
+                continue;
+            
+            Matrix3x4 worldTransform = correction * node->GetWorldTransform();
+            Matrix3x4 inverse = worldTransform.Inverse();
+            
+            for (PODVector<Drawable*>::ConstIterator k = drawables.Begin(); k != drawables.End(); ++k)
+            {
+                Drawable* drawable = *k;
+                if (!drawable->IsEnabledEffective() || !(drawable->GetViewMask() & viewMask))
+                    continue;
+                
+                Vector3 normal = -ray.direction_;
+                float distance;
+                
+                if (level == RAY_AABB)
+                    distance = ray.HitDistance(drawable->GetBoundingBox().Transformed(worldTransform));
+                else
+                {
+                    // The local ray direction is not normalized, so local hit distances equal world distances
+                    Ray localRay = ray.Transformed(inverse);
+                    distance = localRay.HitDistance(drawable->GetBoundingBox());
+                    
+                    if (level == RAY_TRIANGLE && distance < maxDistance)
+                    {
+                        distance = M_INFINITY;
+                        
+                        const Vector<SourceBatch>& batches = drawable->GetBatches();
+                        for (unsigned l = 0; l < batches.Size(); ++l)
+                        {
+                            Geometry* geometry = batches[l].geometry_;
+                            if (geometry)
+                            {
+                                Vector3 geometryNormal;
+                                float geometryDistance = geometry->GetHitDistance(localRay, &geometryNormal);
+                                if (geometryDistance < maxDistance && geometryDistance < distance)
+                                {
+                                    distance = geometryDistance;
+                                    normal = (worldTransform * Vector4(geometryNormal, 0.0f)).Normalized();
+                                }
+                            }
+                        }
+                    }
+                }
+                
+                if (distance < maxDistance)
+                {
+                    RayQueryResult hit;
+                    hit.position_ = ray.origin_ + distance * ray.direction_;
+                    hit.normal_ = normal;
+                    hit.distance_ = distance;
+                    hit.drawable_ = drawable;
+                    hit.node_ = node;
+                    hit.subObject_ = M_MAX_UNSIGNED;
+                    result.Push(hit);
+                }
+            }
+        }
+    }
+    
+    Sort(result.Begin(), result.End(), CompareRayQueryResults);
+}
+
+bool LagCompensation::HasNode(Node* node) const
+{
+    return node && histories_.Contains(node->GetID());
+}
+
+double LagCompensation::GetRewindTick(Connection* connection) const
+{
+    Network* network = GetSubsystem<Network>();
+    float tickInterval = network ? 1.0f / (float)network->GetUpdateFps() : DEFAULT_TICK_INTERVAL;
+    
+    // The client sees server state that is one round trip old by the time its action arrives, plus its own render delay
+    float rewind = 0.0f;
+    if (connection)
+        rewind += connection->GetRoundTripTime() * 0.001f + connection->GetInterpolationDelay();
+    rewind = Min(rewind, maxRewind_);
+    
+    return (double)latestTick_ - (double)(rewind / tickInterval);
+}
+
+bool LagCompensation::GetWorldTransform(Node* node, double tick, Matrix3x4& dest) const
+{
+    if (!node)
+        return false;
+    
+    HashMap<unsigned, NodeTransformHistory>::ConstIterator i = histories_.Find(node->GetID());
+    if (i == histories_.End() || i->second_.node_ != node)
+        return false;
+    
+    dest = GetHistoryTransform(i->second_, tick);
+    return true;
+}
+
+void LagCompensation::HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData)
+{
+    Network* network = GetSubsystem<Network>();
+    if (network && network->IsServerRunning() && IsEnabledEffective())
+        Record(network->GetUpdateTick());
+}
+
+Matrix3x4 LagCompensation::GetHistoryTransform(const NodeTransformHistory& history, double tick) const
+{
+    if (!history.count_)
+        return history.node_ ? history.node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+    
+    // Find the newest sample at or before the tick. Ticks older than the history use the oldest sample
+    unsigned index = history.count_ - 1;
+    while (index > 0 && (double)history.GetSample(index).tick_ > tick)
+        --index;
+    
+    const TransformHistorySample& sample = history.GetSample(index);
+    if (index == history.count_ - 1 || tick <= (double)sample.tick_)
+        return Matrix3x4(sample.position_, sample.rotation_, sample.scale_);
+    
+    const TransformHistorySample& next = history.GetSample(index + 1);
+    float t = (float)((tick - (double)sample.tick_) / (double)(next.tick_ - sample.tick_));
+    return Matrix3x4(sample.position_.Lerp(next.position_, t), sample.rotation_.Slerp(next.rotation_, t),
+        sample.scale_.Lerp(next.scale_, t));
+}
+
+}
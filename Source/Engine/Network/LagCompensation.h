@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Component.h"
+#include "OctreeQuery.h"
+
+namespace Urho3D
+{
+
+class Connection;
+
+/// World transform of a node at a server network tick.
+struct TransformHistorySample
+{
+    /// Server network tick.
+    unsigned tick_;
+    /// World position.
+    Vector3 position_;
+    /// World rotation.
+    Quaternion rotation_;
+    /// World scale.
+    Vector3 scale_;
+};
+
+/// Transform history ring buffer of a tracked node.
+struct NodeTransformHistory
+{
+    /// Construct with defaults.
+    NodeTransformHistory() :
+        first_(0),
+        count_(0)
+    {
+    }
+    
+    /// Return sample by age index, 0 being the oldest.
+    const TransformHistorySample& GetSample(unsigned index) const { return samples_[(first_ + index) % samples_.Size()]; }
+    
+    /// Tracked node.
+    WeakPtr<Node> node_;
+    /// Ring buffer storage.
+    PODVector<TransformHistorySample> samples_;
+    /// Index of the oldest sample.
+    unsigned first_;
+    /// Number of valid samples.
+    unsigned count_;
+};
+
+/// %Network lag compensation component. Records a per-tick world transform history of tracked nodes on the server, and performs raycasts against their transforms at the time a client saw them. Should be created into the root scene node.
+class URHO3D_API LagCompensation : public Component
+{
+    OBJECT(LagCompensation);
+    
+public:
+    /// Construct.
+    LagCompensation(Context* context);
+    /// Destruct.
+    virtual ~LagCompensation();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+    
+    /// Set number of history samples stored per node. Samples are only stored when the node's transform changes, so stationary nodes consume no history.
+    void SetHistorySize(unsigned size);
+    /// Set maximum time in seconds that a query can rewind.
+    void SetMaxRewind(float time);
+    /// Start tracking a node.
+    void AddNode(Node* node);
+    /// Stop tracking a node.
+    void RemoveNode(Node* node);
+    /// Stop tracking all nodes.
+    void RemoveAllNodes();
+    /// Record the world transforms of tracked nodes at a server network tick. Called automatically after each network update on the server.
+    void Record(unsigned tick);
+    /// Raycast against tracked nodes' drawables at the transforms seen by a client connection, sorted by distance.
+    void Raycast(PODVector<RayQueryResult>& result, const Ray& ray, Connection* connection, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, unsigned viewMask = DEFAULT_VIEWMASK) const;
+    /// Raycast against tracked nodes' drawables at the transforms of a server network tick (which may be fractional), sorted by distance.
+    void RaycastAtTick(PODVector<RayQueryResult>& result, const Ray& ray, double tick, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, unsigned viewMask = DEFAULT_VIEWMASK) const;
+    
+    /// Return number of history samples stored per node.
+    unsigned GetHistorySize() const { return historySize_; }
+    /// Return maximum rewind time in seconds.
+    float GetMaxRewind() const { return maxRewind_; }
+    /// Return number of tracked nodes.
+    unsigned GetNumNodes() const { return histories_.Size(); }
+    /// Return whether a node is tracked.
+    bool HasNode(Node* node) const;
+    /// Return the latest recorded server network tick.
+    unsigned GetLatestTick() const { return latestTick_; }
+    /// Return the server network tick that a client connection was seeing, accounting for its round trip time and the snapshot interpolation delay reported by the client. Clamped to the maximum rewind time.
+    double GetRewindTick(Connection* connection) const;
+    /// Return the world transform of a tracked node at a server network tick. Return false if the node is not tracked.
+    bool GetWorldTransform(Node* node, double tick, Matrix3x4& dest) const;
+    
+private:
+    /// Handle network update sent event.
+    void HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData);
+    /// Return the interpolated transform of a history at a tick.
+    Matrix3x4 GetHistoryTransform(const NodeTransformHistory& history, double tick) const;
+    
+    /// Transform histories by node ID.
+    HashMap<unsigned, NodeTransformHistory> histories_;
+    /// History samples per node.
+    unsigned historySize_;
+    /// Maximum rewind time.
+    float maxRewind_;
+    /// Latest recorded tick.
+    unsigned latestTick_;
+};
+
+}
@@ -25,6 +25,7 @@
 #include "CoreEvents.h"
 #include "FileSystem.h"
 #include "HttpRequest.h"
+#include "LagCompensation.h"
 #include "Log.h"
 #include "MemoryBuffer.h"
 #include "Network.h"
@@ -47,7 +48,8 @@ Network::Network(Context* context) :
     Object(context),
     updateFps_(DEFAULT_UPDATE_FPS),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
-    updateAcc_(0.0f)
+    updateAcc_(0.0f),
+    updateTick_(0)
 {
     network_ = new kNet::Network();
     
@@ -101,6 +103,10 @@ u32 Network::ComputeContentID(kNet::message_id_t msgId, const char* data, size_t
         // Return fixed content ID for controls
         return CONTROLS_CONTENT_ID;
         
+    case MSG_SERVERTICK:
+        // Return fixed content ID for the server tick
+        return SERVERTICK_CONTENT_ID;
+        
     case MSG_NODELATESTDATA:
     case MSG_COMPONENTLATESTDATA:
         {
@@ -404,6 +410,8 @@ void Network::PostUpdate(float timeStep)
         
         if (IsServerRunning())
         {
+            ++updateTick_;
+            
             // Collect and prepare all networked scenes
             {
                 PROFILE(PrepareServerUpdate);
@@ -496,6 +504,7 @@ void Network::OnServerDisconnected()
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
+    LagCompensation::RegisterObject(context);
 }
 
 }
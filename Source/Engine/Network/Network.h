@@ -96,6 +96,8 @@ public:
 
     /// Return network update FPS.
     int GetUpdateFps() const { return updateFps_; }
+    /// Return the number of server network updates sent so far. Used to timestamp transform snapshots.
+    unsigned GetUpdateTick() const { return updateTick_; }
     /// Return a client or server connection by kNet MessageConnection, or null if none exist.
     Connection* GetConnection(kNet::MessageConnection* connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -140,6 +142,8 @@ private:
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Server network update tick counter.
+    unsigned updateTick_;
     /// Package cache directory.
     String packageCacheDir_;
 };
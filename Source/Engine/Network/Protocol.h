@@ -61,9 +61,13 @@ static const int MSG_REMOVECOMPONENT = 0x13;
 static const int MSG_REMOTEEVENT = 0x14;
 /// Client->server and server->client: remote node event.
 static const int MSG_REMOTENODEEVENT = 0x15;
+/// Server->client: server network update tick number and update rate.
+static const int MSG_SERVERTICK = 0x16;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
+/// Fixed content ID for server tick update.
+static const unsigned SERVERTICK_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
 
@@ -569,7 +569,11 @@ void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap&
 
 void PhysicsWorld::PreStep(float timeStep)
 {
-    // Send pre-step event
+    // Call the fixed update of logic components, then send pre-step event
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateLogicComponents(LU_FIXEDUPDATE, timeStep);
+
     using namespace PhysicsPreStep;
 
     VariantMap& eventData = GetEventDataMap();
@@ -595,8 +599,12 @@ void PhysicsWorld::PostStep(float timeStep)
 
     SendCollisionEvents();
 
-    // Send post-step event
-    using namespace PhysicsPreStep;
+    // Call the fixed post-update of logic components, then send post-step event
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateLogicComponents(LU_FIXEDPOSTUPDATE, timeStep);
+
+    using namespace PhysicsPostStep;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_WORLD] = this;
@@ -161,12 +161,12 @@ public:
     /// Return an SDL surface from the image, or null if failed. Only RGB images are supported. Specify rect to only return partial image. You must free the surface yourself.
     SDL_Surface* GetSDLSurface(const IntRect& rect = IntRect::ZERO) const;
 
-private:
-    /// Decode an image using stb_image.
+    /// Decode an image using stb_image. Does not log, so is safe to call from worker threads.
     static unsigned char* GetImageData(Deserializer& source, int& width, int& height, unsigned& components);
     /// Free an image file's pixel data.
     static void FreeImageData(unsigned char* pixelData);
 
+private:
     /// Width.
     int width_;
     /// Height.
@@ -47,7 +47,6 @@ bool Resource::Save(Serializer& dest) const
 void Resource::SetName(const String& name)
 {
     name_ = name;
-    nameHash_ = name;
 }
 
 void Resource::SetMemoryUse(unsigned size)
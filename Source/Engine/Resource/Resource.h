@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "InternedString.h"
 #include "Object.h"
 #include "Timer.h"
 
@@ -56,17 +57,15 @@ public:
     /// Return name.
     const String& GetName() const { return name_; }
     /// Return name hash.
-    StringHash GetNameHash() const { return nameHash_; }
+    StringHash GetNameHash() const { return name_.GetHash(); }
     /// Return memory use in bytes, possibly approximate.
     unsigned GetMemoryUse() const { return memoryUse_; }
     /// Return time since last use in milliseconds. If referred to elsewhere than in the resource cache, returns always zero.
     unsigned GetUseTimer();
     
 private:
-    /// Name.
-    String name_;
-    /// Name hash.
-    StringHash nameHash_;
+    /// Name. Interned, so that copies share the storage and the hash is calculated only once.
+    InternedString name_;
     /// Last used timer.
     Timer useTimer_;
     /// Memory use in bytes.
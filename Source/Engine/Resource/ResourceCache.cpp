@@ -432,13 +432,20 @@ Resource* ResourceCache::GetResource(ShortStringHash type, const String& name, b
 
 Resource* ResourceCache::GetResource(ShortStringHash type, const char* nameIn, bool sendEventOnFailure)
 {
+    // Names from resource references are normally already sanitated. Check for an exact match among the loaded resources
+    // first, so that repeated requests during scene load do not need to allocate temporary strings
+    StringHash nameHash(nameIn);
+    const SharedPtr<Resource>& existingExact = FindResource(type, nameHash);
+    if (existingExact && existingExact->GetName() == nameIn)
+        return existingExact;
+    
     String name = SanitateResourceName(nameIn);
     
     // If empty name, return null pointer immediately
     if (name.Empty())
         return 0;
     
-    StringHash nameHash(name);
+    nameHash = StringHash(name);
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
     if (existing)
         return existing;
@@ -647,7 +654,7 @@ void ResourceCache::StoreResourceDependency(Resource* resource, const String& de
     if (!resource || !autoReloadResources_)
         return;
     
-    StringHash nameHash(resource->GetName());
+    StringHash nameHash = resource->GetNameHash();
     HashSet<StringHash>& dependents = dependentResources_[dependency];
     dependents.Insert(nameHash);
 }
@@ -657,7 +664,7 @@ void ResourceCache::ResetDependencies(Resource* resource)
     if (!resource || !autoReloadResources_)
         return;
     
-    StringHash nameHash(resource->GetName());
+    StringHash nameHash = resource->GetNameHash();
     
     for (HashMap<StringHash, HashSet<StringHash> >::Iterator i = dependentResources_.Begin(); i !=
         dependentResources_.End();)
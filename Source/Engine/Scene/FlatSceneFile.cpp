@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Context.h"
+#include "File.h"
+#include "FlatSceneFile.h"
+#include "Log.h"
+#include "Node.h"
+#include "Profiler.h"
+#include "Scene.h"
+
+#include <cstring>
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Return whether a range lies within a block of the given size.
+static bool IsInRange(unsigned offset, unsigned size, unsigned total)
+{
+    return offset <= total && size <= total - offset;
+}
+
+/// Return whether a table of records lies within a block of the given size.
+static bool IsTableInRange(unsigned offset, unsigned count, unsigned recordSize, unsigned total)
+{
+    return offset <= total && count <= (total - offset) / recordSize;
+}
+
+FlatSceneFile::FlatSceneFile(Context* context) :
+    Resource(context),
+    fileData_(0),
+    fileSize_(0),
+    header_(0),
+    nodes_(0),
+    components_(0),
+    data_(0)
+{
+}
+
+FlatSceneFile::~FlatSceneFile()
+{
+}
+
+void FlatSceneFile::RegisterObject(Context* context)
+{
+    context->RegisterFactory<FlatSceneFile>();
+}
+
+bool FlatSceneFile::Load(Deserializer& source)
+{
+    PROFILE(LoadFlatSceneFile);
+
+    Release();
+
+    unsigned dataSize = source.GetSize();
+    if (dataSize < sizeof(FlatSceneHeader))
+    {
+        LOGERROR(source.GetName() + " is not a valid flat scene file");
+        return false;
+    }
+
+    // Use the file contents in place if possible. The file is kept open for the mapping, so it must be held by a shared
+    // pointer, as resource cache files are. The tables must also be aligned, which is not guaranteed for package files
+    File* file = dynamic_cast<File*>(&source);
+    if (file && file->Refs() > 0)
+    {
+        const unsigned char* mappedData = file->Map();
+        if (mappedData && !((size_t)mappedData & 3))
+        {
+            mappedFile_ = file;
+            if (Initialize(mappedData, dataSize))
+                return true;
+            Release();
+            return false;
+        }
+    }
+
+    buffer_ = new unsigned char[dataSize];
+    if (source.Read(buffer_.Get(), dataSize) != dataSize)
+    {
+        LOGERROR("Could not read flat scene file " + source.GetName());
+        Release();
+        return false;
+    }
+
+    if (Initialize(buffer_.Get(), dataSize))
+        return true;
+    Release();
+    return false;
+}
+
+bool FlatSceneFile::Save(Serializer& dest) const
+{
+    if (!fileData_)
+    {
+        LOGERROR("Can not save empty flat scene file");
+        return false;
+    }
+
+    return dest.Write(fileData_, fileSize_) == fileSize_;
+}
+
+bool FlatSceneFile::Initialize(const unsigned char* fileData, unsigned fileSize)
+{
+    const FlatSceneHeader* header = reinterpret_cast<const FlatSceneHeader*>(fileData);
+    if (memcmp(header->fileID_, "USCF", 4))
+    {
+        LOGERROR(GetName() + " is not a valid flat scene file");
+        return false;
+    }
+
+    if (!header->numNodes_ || !IsTableInRange(header->typesOffset_, header->numTypes_, sizeof(FlatSceneType), fileSize) ||
+        !IsTableInRange(header->nodesOffset_, header->numNodes_, sizeof(FlatSceneNode), fileSize) ||
+        !IsTableInRange(header->componentsOffset_, header->numComponents_, sizeof(FlatSceneComponent), fileSize) ||
+        !IsInRange(header->dataOffset_, header->dataSize_, fileSize) || ((header->typesOffset_ | header->nodesOffset_ |
+        header->componentsOffset_) & 3))
+    {
+        LOGERROR("Corrupt table offsets in flat scene file " + GetName());
+        return false;
+    }
+
+    const FlatSceneType* types = reinterpret_cast<const FlatSceneType*>(fileData + header->typesOffset_);
+    const FlatSceneNode* nodes = reinterpret_cast<const FlatSceneNode*>(fileData + header->nodesOffset_);
+    const FlatSceneComponent* components = reinterpret_cast<const FlatSceneComponent*>(fileData + header->componentsOffset_);
+    const unsigned char* data = fileData + header->dataOffset_;
+    unsigned dataSize = header->dataSize_;
+
+    // Check the records up front so that loading can trust them
+    for (unsigned i = 0; i < header->numTypes_; ++i)
+    {
+        if (!IsInRange(types[i].attributeTypesOffset_, types[i].numAttributes_, dataSize) ||
+            !IsTableInRange(types[i].attributeNamesOffset_, types[i].numAttributes_, sizeof(unsigned), dataSize))
+        {
+            LOGERROR("Corrupt type record in flat scene file " + GetName());
+            return false;
+        }
+    }
+
+    ShortStringHash nodeType = Node::GetTypeStatic();
+    for (unsigned i = 0; i < header->numNodes_; ++i)
+    {
+        const FlatSceneNode& node = nodes[i];
+        if (node.type_ >= header->numTypes_ || (i && node.parent_ >= i) || !IsInRange(node.firstComponent_,
+            node.numComponents_, header->numComponents_) || !IsInRange(node.dataOffset_, node.dataSize_, dataSize))
+        {
+            LOGERROR("Corrupt node record in flat scene file " + GetName());
+            return false;
+        }
+
+        // Only the root may be a scene, child nodes are always created as plain nodes
+        ShortStringHash type(types[node.type_].type_);
+        if (type != nodeType && (i || type != Scene::GetTypeStatic()))
+        {
+            LOGERROR("Unsupported node type in flat scene file " + GetName());
+            return false;
+        }
+    }
+
+    for (unsigned i = 0; i < header->numComponents_; ++i)
+    {
+        const FlatSceneComponent& component = components[i];
+        if (component.type_ >= header->numTypes_ || !IsInRange(component.dataOffset_, component.dataSize_, dataSize))
+        {
+            LOGERROR("Corrupt component record in flat scene file " + GetName());
+            return false;
+        }
+    }
+
+    // Match the saved attributes to the registered ones by name once per type, so that loading needs no lookups. Attributes
+    // that have since been removed or changed type are skipped, and attributes added since keep their current values
+    types_.Resize(header->numTypes_);
+    for (unsigned i = 0; i < header->numTypes_; ++i)
+    {
+        FlatSceneTypeInfo& info = types_[i];
+        info.type_ = ShortStringHash(types[i].type_);
+        info.attributeTypes_ = data + types[i].attributeTypesOffset_;
+        info.numAttributes_ = types[i].numAttributes_;
+        info.attributeIndices_.Resize(info.numAttributes_);
+        info.registered_ = !context_->GetTypeName(info.type_).Empty();
+
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(info.type_);
+        const unsigned char* nameHashes = data + types[i].attributeNamesOffset_;
+        unsigned startIndex = 0;
+        for (unsigned j = 0; j < info.numAttributes_; ++j)
+        {
+            // The data section is not aligned, so copy the hash
+            unsigned nameHash;
+            memcpy(&nameHash, nameHashes + j * sizeof(unsigned), sizeof nameHash);
+
+            unsigned match = M_MAX_UNSIGNED;
+            if (attributes)
+            {
+                // The attributes are usually still in the saved order, so continue the search after the previous match
+                unsigned numRegistered = attributes->Size();
+                for (unsigned k = 0; k < numRegistered; ++k)
+                {
+                    unsigned index = (startIndex + k) % numRegistered;
+                    const AttributeInfo& attr = attributes->At(index);
+                    if ((attr.mode_ & AM_FILE) && StringHash(attr.name_).Value() == nameHash)
+                    {
+                        if (attr.type_ == info.attributeTypes_[j])
+                            match = index;
+                        startIndex = index + 1;
+                        break;
+                    }
+                }
+            }
+
+            if (match == M_MAX_UNSIGNED && info.registered_)
+                LOGWARNING("Skipping removed or changed attribute " + String(j) + " of " + context_->GetTypeName(info.type_) +
+                    " in flat scene file " + GetName());
+            info.attributeIndices_[j] = match;
+        }
+    }
+
+    fileData_ = fileData;
+    fileSize_ = fileSize;
+    header_ = header;
+    nodes_ = nodes;
+    components_ = components;
+    data_ = data;
+
+    SetMemoryUse(sizeof(FlatSceneFile) + fileSize);
+    return true;
+}
+
+void FlatSceneFile::Release()
+{
+    mappedFile_.Reset();
+    buffer_.Reset();
+    types_.Clear();
+    fileData_ = 0;
+    fileSize_ = 0;
+    header_ = 0;
+    nodes_ = 0;
+    components_ = 0;
+    data_ = 0;
+}
+
+}
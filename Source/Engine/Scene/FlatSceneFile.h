@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ArrayPtr.h"
+#include "Resource.h"
+
+namespace Urho3D
+{
+
+class File;
+struct AttributeInfo;
+
+/// Flat scene file header. All offsets are from the beginning of the file. The tables that follow are 4-byte aligned so that they can be used in place from a memory mapping.
+struct FlatSceneHeader
+{
+    /// File ID "USCF".
+    char fileID_[4];
+    /// Number of type records.
+    unsigned numTypes_;
+    /// Type table offset.
+    unsigned typesOffset_;
+    /// Number of node records.
+    unsigned numNodes_;
+    /// Node table offset.
+    unsigned nodesOffset_;
+    /// Number of component records.
+    unsigned numComponents_;
+    /// Component table offset.
+    unsigned componentsOffset_;
+    /// Attribute data section offset.
+    unsigned dataOffset_;
+    /// Attribute data section size.
+    unsigned dataSize_;
+};
+
+/// Flat scene type record. Describes the saved attribute layout of a node or component type.
+struct FlatSceneType
+{
+    /// Type name hash.
+    unsigned type_;
+    /// Number of saved attributes.
+    unsigned numAttributes_;
+    /// Offset of the attribute types within the data section, one byte each.
+    unsigned attributeTypesOffset_;
+    /// Offset of the attribute name hashes within the data section, four bytes each.
+    unsigned attributeNamesOffset_;
+};
+
+/// Flat scene node record. Nodes are stored depth-first, the first node being the root.
+struct FlatSceneNode
+{
+    /// Node ID.
+    unsigned id_;
+    /// Type record index.
+    unsigned type_;
+    /// Parent node index. Always less than the node's own index, except for the root.
+    unsigned parent_;
+    /// Number of child nodes.
+    unsigned numChildren_;
+    /// Index of the first component record.
+    unsigned firstComponent_;
+    /// Number of component records.
+    unsigned numComponents_;
+    /// Offset of the attribute data within the data section.
+    unsigned dataOffset_;
+    /// Size of the attribute data.
+    unsigned dataSize_;
+};
+
+/// Flat scene component record.
+struct FlatSceneComponent
+{
+    /// Component ID.
+    unsigned id_;
+    /// Type record index.
+    unsigned type_;
+    /// Offset of the attribute data within the data section.
+    unsigned dataOffset_;
+    /// Size of the attribute data.
+    unsigned dataSize_;
+};
+
+/// Flat scene type resolved against the currently registered attributes.
+struct FlatSceneTypeInfo
+{
+    /// Type name hash.
+    ShortStringHash type_;
+    /// Saved attribute types.
+    const unsigned char* attributeTypes_;
+    /// Number of saved attributes.
+    unsigned numAttributes_;
+    /// Index of the registered attribute with the same name and type for each saved attribute, or M_MAX_UNSIGNED if there is no match and the value should be skipped. Indices stay valid when more attributes are registered, unlike pointers into the attribute vector.
+    PODVector<unsigned> attributeIndices_;
+    /// Whether the type has an object factory. If not, component data is loaded into an UnknownComponent as is.
+    bool registered_;
+};
+
+/// %Scene or prefab in the flat binary format. Can be memory-mapped and instantiated any number of times.
+class URHO3D_API FlatSceneFile : public Resource
+{
+    OBJECT(FlatSceneFile);
+
+public:
+    /// Construct.
+    FlatSceneFile(Context* context);
+    /// Destruct.
+    virtual ~FlatSceneFile();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource. Maps the file into memory if possible, otherwise reads it into a buffer. Mapping requires a file held by a shared pointer. Return true if successful.
+    virtual bool Load(Deserializer& source);
+    /// Save resource. Return true if successful.
+    virtual bool Save(Serializer& dest) const;
+
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return header_ ? header_->numNodes_ : 0; }
+    /// Return number of components.
+    unsigned GetNumComponents() const { return header_ ? header_->numComponents_ : 0; }
+    /// Return number of types.
+    unsigned GetNumTypes() const { return types_.Size(); }
+    /// Return node records.
+    const FlatSceneNode* GetNodes() const { return nodes_; }
+    /// Return component records.
+    const FlatSceneComponent* GetComponents() const { return components_; }
+    /// Return the attribute data section.
+    const unsigned char* GetData() const { return data_; }
+    /// Return resolved type by index.
+    const FlatSceneTypeInfo& GetTypeInfo(unsigned index) const { return types_[index]; }
+    /// Return type of the root node.
+    ShortStringHash GetRootType() const { return nodes_ ? types_[nodes_[0].type_].type_ : ShortStringHash(); }
+    /// Return whether the contents are used directly from a memory mapping.
+    bool IsMapped() const { return mappedFile_.NotNull(); }
+
+private:
+    /// Validate the tables and resolve the types. Return true if successful.
+    bool Initialize(const unsigned char* fileData, unsigned fileSize);
+    /// Release the contents.
+    void Release();
+
+    /// Mapped file.
+    SharedPtr<File> mappedFile_;
+    /// Contents when not mapped.
+    SharedArrayPtr<unsigned char> buffer_;
+    /// File contents.
+    const unsigned char* fileData_;
+    /// File size.
+    unsigned fileSize_;
+    /// File header.
+    const FlatSceneHeader* header_;
+    /// Node records.
+    const FlatSceneNode* nodes_;
+    /// Component records.
+    const FlatSceneComponent* components_;
+    /// Attribute data section.
+    const unsigned char* data_;
+    /// Resolved types.
+    Vector<FlatSceneTypeInfo> types_;
+};
+
+}
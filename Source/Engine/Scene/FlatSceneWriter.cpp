@@ -0,0 +1,388 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Component.h"
+#include "Context.h"
+#include "FlatSceneWriter.h"
+#include "Log.h"
+#include "Scene.h"
+#include "XMLElement.h"
+
+#include <cstring>
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Size of the type and ID written in front of the attributes by Component::Save().
+static const unsigned COMPONENT_HEADER_SIZE = sizeof(unsigned short) + sizeof(unsigned);
+
+FlatSceneWriter::FlatSceneWriter(Context* context) :
+    context_(context)
+{
+}
+
+FlatSceneWriter::~FlatSceneWriter()
+{
+}
+
+bool FlatSceneWriter::Build(const Node* node)
+{
+    Clear();
+    if (!node)
+        return false;
+
+    return AddNode(node, 0);
+}
+
+bool FlatSceneWriter::BuildFromBinary(Deserializer& source)
+{
+    Clear();
+
+    // Scene files begin with a file ID, node data directly with the node ID
+    unsigned startPosition = source.GetPosition();
+    if (source.ReadFileID() == "USCN")
+        return AddBinaryNode(source, Scene::GetTypeStatic(), 0);
+
+    source.Seek(startPosition);
+    return AddBinaryNode(source, Node::GetTypeStatic(), 0);
+}
+
+bool FlatSceneWriter::BuildFromXML(const XMLElement& source)
+{
+    Clear();
+    if (source.IsNull())
+    {
+        LOGERROR("Could not build flat scene, null source element");
+        return false;
+    }
+
+    return AddXMLNode(source, source.GetName() == "scene" ? Scene::GetTypeStatic() : Node::GetTypeStatic(), 0);
+}
+
+bool FlatSceneWriter::Write(Serializer& dest) const
+{
+    if (nodes_.Empty())
+    {
+        LOGERROR("Could not write flat scene, no nodes");
+        return false;
+    }
+
+    FlatSceneHeader header;
+    memcpy(header.fileID_, "USCF", 4);
+    header.numTypes_ = types_.Size();
+    header.typesOffset_ = sizeof(FlatSceneHeader);
+    header.numNodes_ = nodes_.Size();
+    header.nodesOffset_ = header.typesOffset_ + types_.Size() * sizeof(FlatSceneType);
+    header.numComponents_ = components_.Size();
+    header.componentsOffset_ = header.nodesOffset_ + nodes_.Size() * sizeof(FlatSceneNode);
+    header.dataOffset_ = header.componentsOffset_ + components_.Size() * sizeof(FlatSceneComponent);
+    header.dataSize_ = data_.GetSize();
+
+    bool success = dest.Write(&header, sizeof header) == sizeof header;
+    if (!types_.Empty())
+        success &= dest.Write(&types_[0], types_.Size() * sizeof(FlatSceneType)) == types_.Size() * sizeof(FlatSceneType);
+    success &= dest.Write(&nodes_[0], nodes_.Size() * sizeof(FlatSceneNode)) == nodes_.Size() * sizeof(FlatSceneNode);
+    if (!components_.Empty())
+    {
+        success &= dest.Write(&components_[0], components_.Size() * sizeof(FlatSceneComponent)) == components_.Size() *
+            sizeof(FlatSceneComponent);
+    }
+    if (data_.GetSize())
+        success &= dest.Write(data_.GetData(), data_.GetSize()) == data_.GetSize();
+
+    if (!success)
+        LOGERROR("Could not write flat scene, writing to stream failed");
+    return success;
+}
+
+void FlatSceneWriter::Clear()
+{
+    types_.Clear();
+    typeIndices_.Clear();
+    nodes_.Clear();
+    components_.Clear();
+    data_.Clear();
+}
+
+bool FlatSceneWriter::AddNode(const Node* node, unsigned parent)
+{
+    unsigned index = AddNodeRecord(node->GetID(), node->GetType(), parent);
+    if (!node->Animatable::Save(data_))
+        return false;
+    nodes_[index].dataSize_ = data_.GetPosition() - nodes_[index].dataOffset_;
+
+    const Vector<SharedPtr<Component> >& components = node->GetComponents();
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        Component* component = components[i];
+        if (component->IsTemporary())
+            continue;
+
+        // Save as usual and strip the type and ID, which go to the component record
+        componentBuffer_.Clear();
+        if (!component->Save(componentBuffer_))
+            return false;
+
+        FlatSceneComponent record;
+        record.id_ = component->GetID();
+        record.type_ = GetTypeIndex(component->GetType());
+        record.dataOffset_ = data_.GetPosition();
+        record.dataSize_ = componentBuffer_.GetSize() - COMPONENT_HEADER_SIZE;
+        data_.Write(componentBuffer_.GetData() + COMPONENT_HEADER_SIZE, record.dataSize_);
+        components_.Push(record);
+        ++nodes_[index].numComponents_;
+    }
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        Node* child = children[i];
+        if (child->IsTemporary())
+            continue;
+
+        ++nodes_[index].numChildren_;
+        if (!AddNode(child, index))
+            return false;
+    }
+
+    return true;
+}
+
+bool FlatSceneWriter::AddBinaryNode(Deserializer& source, ShortStringHash type, unsigned parent)
+{
+    unsigned index = AddNodeRecord(source.ReadUInt(), type, parent);
+
+    // Node attributes are not length-prefixed, so decode them to find their end
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+    if (attributes)
+    {
+        for (unsigned i = 0; i < attributes->Size(); ++i)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+
+            if (source.IsEof())
+            {
+                LOGERROR("Could not convert binary node data, stream at end");
+                return false;
+            }
+            data_.WriteVariantData(source.ReadVariant(attr.type_));
+        }
+    }
+    nodes_[index].dataSize_ = data_.GetPosition() - nodes_[index].dataOffset_;
+
+    // Component data is copied as is
+    unsigned numComponents = source.ReadVLE();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        componentBuffer_.SetData(source, source.ReadVLE());
+        if (componentBuffer_.GetSize() < COMPONENT_HEADER_SIZE)
+        {
+            LOGERROR("Could not convert binary component data, stream at end");
+            return false;
+        }
+
+        ShortStringHash compType = componentBuffer_.ReadShortStringHash();
+        FlatSceneComponent record;
+        record.id_ = componentBuffer_.ReadUInt();
+        record.type_ = GetTypeIndex(compType);
+        record.dataOffset_ = data_.GetPosition();
+        record.dataSize_ = componentBuffer_.GetSize() - COMPONENT_HEADER_SIZE;
+        data_.Write(componentBuffer_.GetData() + COMPONENT_HEADER_SIZE, record.dataSize_);
+        components_.Push(record);
+        ++nodes_[index].numComponents_;
+    }
+
+    unsigned numChildren = source.ReadVLE();
+    nodes_[index].numChildren_ = numChildren;
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (!AddBinaryNode(source, Node::GetTypeStatic(), index))
+            return false;
+    }
+
+    return true;
+}
+
+bool FlatSceneWriter::AddXMLNode(const XMLElement& source, ShortStringHash type, unsigned parent)
+{
+    unsigned index = AddNodeRecord(source.GetInt("id"), type, parent);
+    WriteXMLAttributes(source, type);
+    nodes_[index].dataSize_ = data_.GetPosition() - nodes_[index].dataOffset_;
+
+    XMLElement compElem = source.GetChild("component");
+    while (compElem)
+    {
+        String typeName = compElem.GetAttribute("type");
+        ShortStringHash compType(typeName);
+
+        // Without the registered attributes there is no binary layout to convert to
+        if (context_->GetTypeName(compType).Empty())
+            LOGWARNING("Skipping component of unknown type " + typeName);
+        else
+        {
+            FlatSceneComponent record;
+            record.id_ = compElem.GetInt("id");
+            record.type_ = GetTypeIndex(compType);
+            record.dataOffset_ = data_.GetPosition();
+            WriteXMLAttributes(compElem, compType);
+            record.dataSize_ = data_.GetPosition() - record.dataOffset_;
+            components_.Push(record);
+            ++nodes_[index].numComponents_;
+        }
+
+        compElem = compElem.GetNext("component");
+    }
+
+    XMLElement childElem = source.GetChild("node");
+    while (childElem)
+    {
+        ++nodes_[index].numChildren_;
+        if (!AddXMLNode(childElem, Node::GetTypeStatic(), index))
+            return false;
+
+        childElem = childElem.GetNext("node");
+    }
+
+    return true;
+}
+
+unsigned FlatSceneWriter::AddNodeRecord(unsigned id, ShortStringHash type, unsigned parent)
+{
+    FlatSceneNode record;
+    record.id_ = id;
+    // Get the type index first, as adding a new type writes to the data section
+    record.type_ = GetTypeIndex(type);
+    record.parent_ = parent;
+    record.numChildren_ = 0;
+    record.firstComponent_ = components_.Size();
+    record.numComponents_ = 0;
+    record.dataOffset_ = data_.GetPosition();
+    record.dataSize_ = 0;
+    nodes_.Push(record);
+    return nodes_.Size() - 1;
+}
+
+void FlatSceneWriter::WriteXMLAttributes(const XMLElement& source, ShortStringHash type)
+{
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+    if (!attributes)
+        return;
+
+    Vector<XMLElement> attrElems;
+    Vector<String> attrNames;
+    XMLElement attrElem = source.GetChild("attribute");
+    while (attrElem)
+    {
+        attrElems.Push(attrElem);
+        attrNames.Push(attrElem.GetAttribute("name"));
+        attrElem = attrElem.GetNext("attribute");
+    }
+
+    // The binary format stores every file attribute in order. XML omits default values, so fill them in
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        Variant value;
+        for (unsigned j = 0; j < attrNames.Size(); ++j)
+        {
+            if (attr.name_.Compare(attrNames[j], false))
+                continue;
+
+            // If enums specified, do enum lookup and int assignment. Otherwise read the variant directly
+            if (attr.enumNames_)
+            {
+                String enumName = attrElems[j].GetAttribute("value");
+                const char** enumPtr = attr.enumNames_;
+                int enumValue = 0;
+                while (*enumPtr && enumName.Compare(*enumPtr, false))
+                {
+                    ++enumPtr;
+                    ++enumValue;
+                }
+                if (*enumPtr)
+                    value = enumValue;
+                else
+                    LOGWARNING("Unknown enum value " + enumName + " in attribute " + attr.name_);
+            }
+            else
+                value = attrElems[j].GetVariantValue(attr.type_);
+            break;
+        }
+
+        if (value.GetType() != attr.type_)
+            value = attr.defaultValue_;
+        data_.WriteVariantData(value);
+    }
+}
+
+unsigned FlatSceneWriter::GetTypeIndex(ShortStringHash type)
+{
+    HashMap<ShortStringHash, unsigned>::ConstIterator i = typeIndices_.Find(type);
+    if (i != typeIndices_.End())
+        return i->second_;
+
+    FlatSceneType record;
+    record.type_ = type.Value();
+    record.numAttributes_ = 0;
+    record.attributeTypesOffset_ = data_.GetPosition();
+
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+    if (attributes)
+    {
+        for (unsigned j = 0; j < attributes->Size(); ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (attr.mode_ & AM_FILE)
+            {
+                data_.WriteUByte((unsigned char)attr.type_);
+                ++record.numAttributes_;
+            }
+        }
+    }
+
+    // The name hashes allow matching the attributes by name when loading, even if the registered attributes have changed
+    record.attributeNamesOffset_ = data_.GetPosition();
+    if (attributes)
+    {
+        for (unsigned j = 0; j < attributes->Size(); ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (attr.mode_ & AM_FILE)
+                data_.WriteStringHash(StringHash(attr.name_));
+        }
+    }
+
+    unsigned index = types_.Size();
+    types_.Push(record);
+    typeIndices_[type] = index;
+    return index;
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "FlatSceneFile.h"
+#include "HashMap.h"
+#include "VectorBuffer.h"
+
+namespace Urho3D
+{
+
+class Context;
+class Deserializer;
+class Node;
+class Serializer;
+class XMLElement;
+
+/// Builds a flat scene file from a node hierarchy, or converts scene data from the binary and XML formats.
+class URHO3D_API FlatSceneWriter
+{
+public:
+    /// Construct.
+    FlatSceneWriter(Context* context);
+    /// Destruct.
+    ~FlatSceneWriter();
+
+    /// Build from a node and its components and child nodes. Temporary objects are skipped. Return true if successful.
+    bool Build(const Node* node);
+    /// Build from binary data, as saved by Scene::Save() or Node::Save(). Return true if successful.
+    bool BuildFromBinary(Deserializer& source);
+    /// Build from XML data, as saved by Scene::SaveXML() or Node::SaveXML(). Components of unregistered types are skipped. Return true if successful.
+    bool BuildFromXML(const XMLElement& source);
+    /// Write the flat scene file. Return true if successful.
+    bool Write(Serializer& dest) const;
+    /// Clear the built contents.
+    void Clear();
+
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+    /// Return number of components.
+    unsigned GetNumComponents() const { return components_.Size(); }
+
+private:
+    /// Add a node and its components and child nodes.
+    bool AddNode(const Node* node, unsigned parent);
+    /// Add a node from binary data.
+    bool AddBinaryNode(Deserializer& source, ShortStringHash type, unsigned parent);
+    /// Add a node from XML data.
+    bool AddXMLNode(const XMLElement& source, ShortStringHash type, unsigned parent);
+    /// Add a node record and return its index.
+    unsigned AddNodeRecord(unsigned id, ShortStringHash type, unsigned parent);
+    /// Convert XML attributes to binary and write them to the data section.
+    void WriteXMLAttributes(const XMLElement& source, ShortStringHash type);
+    /// Return the type record index, adding the record with the registered file attributes if new.
+    unsigned GetTypeIndex(ShortStringHash type);
+
+    /// Execution context.
+    Context* context_;
+    /// Type records.
+    PODVector<FlatSceneType> types_;
+    /// Type record indices by type.
+    HashMap<ShortStringHash, unsigned> typeIndices_;
+    /// Node records.
+    PODVector<FlatSceneNode> nodes_;
+    /// Component records.
+    PODVector<FlatSceneComponent> components_;
+    /// Attribute data section.
+    VectorBuffer data_;
+    /// Component serialization buffer.
+    VectorBuffer componentBuffer_;
+};
+
+}
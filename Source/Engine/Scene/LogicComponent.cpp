@@ -23,10 +23,7 @@
 #include "Precompiled.h"
 #include "Log.h"
 #include "LogicComponent.h"
-#include "PhysicsEvents.h"
-#include "PhysicsWorld.h"
 #include "Scene.h"
-#include "SceneEvents.h"
 
 namespace Urho3D
 {
@@ -34,13 +31,15 @@ namespace Urho3D
 LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
-    currentEventMask_(0),
-    delayedStartCalled_(false)
+    updateLists_(0),
+    delayedStartCalled_(false),
+    threadedUpdate_(false)
 {
 }
 
 LogicComponent::~LogicComponent()
 {
+    SetUpdateLists(updateScene_, 0);
 }
 
 void LogicComponent::OnSetEnabled()
@@ -57,6 +56,15 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+void LogicComponent::SetThreadedUpdate(bool enable)
+{
+    if (threadedUpdate_ != enable)
+    {
+        threadedUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -70,6 +78,7 @@ void LogicComponent::OnNodeSet(Node* node)
     {
         // We are being detached from a node: execute user-defined stop function and prepare for destruction
         Stop();
+        SetUpdateLists(updateScene_, 0);
     }
 }
 
@@ -87,105 +96,69 @@ void LogicComponent::UpdateEventSubscription()
     }
     
     bool enabled = IsEnabledEffective();
+    // Delayed start is always called from the main thread, so use the threaded lists only after it
+    bool threaded = threadedUpdate_ && delayedStartCalled_;
+    unsigned char lists = 0;
     
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
-    }
-    
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+    if (enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_))
+        lists |= 1 << (threaded ? LU_THREADEDUPDATE : LU_UPDATE);
+    if (enabled && (updateEventMask_ & USE_POSTUPDATE))
+        lists |= 1 << (threaded ? LU_THREADEDPOSTUPDATE : LU_POSTUPDATE);
+    if (enabled && (updateEventMask_ & USE_FIXEDUPDATE))
+        lists |= 1 << LU_FIXEDUPDATE;
+    if (enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE))
+        lists |= 1 << LU_FIXEDPOSTUPDATE;
     
-    PhysicsWorld* world = scene->GetComponent<PhysicsWorld>();
-    if (!world)
-        return;
+    // If moved to another scene, leave the old scene's lists first
+    if (updateScene_ != scene)
+        SetUpdateLists(updateScene_, 0);
+    SetUpdateLists(scene, lists);
+}
 
-    bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
+void LogicComponent::SetUpdateLists(Scene* scene, unsigned char lists)
+{
+    if (!scene)
     {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
+        updateLists_ = 0;
+        updateScene_.Reset();
+        return;
     }
     
-    bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
+    for (unsigned i = 0; i < MAX_LOGIC_UPDATE_LISTS; ++i)
     {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
-    }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
+        unsigned char bit = (unsigned char)(1 << i);
+        if ((lists & bit) && !(updateLists_ & bit))
+            scene->AddLogicUpdate(this, (LogicUpdateList)i);
+        else if (!(lists & bit) && (updateLists_ & bit))
+            scene->RemoveLogicUpdate(this, (LogicUpdateList)i);
     }
+    
+    updateLists_ = lists;
+    if (lists)
+        updateScene_ = scene;
+    else
+        updateScene_.Reset();
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallUpdate(float timeStep)
 {
-    using namespace SceneUpdate;
-    
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
         DelayedStart();
         delayedStartCalled_ = true;
         
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
+        // If did not need actual update events, leave the update list now. If threaded, move to the threaded lists;
+        // the threaded update list is processed after this one, so the first update will be called from there
+        if (threadedUpdate_ || !(updateEventMask_ & USE_UPDATE))
         {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
+            UpdateEventSubscription();
             return;
         }
     }
     
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
-}
-
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
-{
-    using namespace ScenePostUpdate;
-    
-    // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
-
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPreStep;
-    
-    // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
-}
-
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPostStep;
-    
-    // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    Update(timeStep);
 }
 
 }
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Bitmask for using the scene update event.
 static const unsigned char USE_UPDATE = 0x1;
 /// Bitmask for using the scene post-update event.
@@ -36,11 +38,13 @@ static const unsigned char USE_FIXEDUPDATE = 0x4;
 /// Bitmask for using the physics post-update event.
 static const unsigned char USE_FIXEDPOSTUPDATE = 0x8;
 
-/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
+/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class. The scene calls the update functions directly from its update lists instead of sending events.
 class URHO3D_API LogicComponent : public Component
 {
     OBJECT(LogicComponent);
     
+    friend class Scene;
+    
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -65,9 +69,13 @@ class URHO3D_API LogicComponent : public Component
     
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
+    /// Set whether Update() and PostUpdate() may be called from worker threads in parallel with other components. They may then only modify the component's own state and its node's transform, and may not create or remove nodes or components, or send events. DelayedStart() and the fixed updates are always called from the main thread. Not an attribute; should be called eg. in the subclass constructor.
+    void SetThreadedUpdate(bool enable);
     
     /// Return what update events are subscribed to.
     unsigned char GetUpdateEventMask() const { return updateEventMask_; }
+    /// Return whether Update() and PostUpdate() may be called from worker threads.
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
     
@@ -76,23 +84,23 @@ protected:
     virtual void OnNodeSet(Node* node);
     
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's update lists based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
+    /// Add to/remove from the scene's update lists according to a bitmask of LogicUpdateList values.
+    void SetUpdateLists(Scene* scene, unsigned char lists);
+    /// Call the delayed start function if not called yet, then the update function. Called by Scene.
+    void CallUpdate(float timeStep);
     
+    /// Scene whose update lists the component is in.
+    WeakPtr<Scene> updateScene_;
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
-    /// Current event subscription mask.
-    unsigned char currentEventMask_;
+    /// Current update list mask.
+    unsigned char updateLists_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Threaded update flag.
+    bool threadedUpdate_;
 };
 
 }
@@ -23,6 +23,8 @@
 #include "Precompiled.h"
 #include "Component.h"
 #include "Context.h"
+#include "FlatSceneFile.h"
+#include "FlatSceneWriter.h"
 #include "Log.h"
 #include "MemoryBuffer.h"
 #include "ObjectAnimation.h"
@@ -233,6 +235,15 @@ bool Node::SaveXML(Serializer& dest) const
     return xml->Save(dest);
 }
 
+bool Node::SaveFlat(Serializer& dest) const
+{
+    FlatSceneWriter writer(context_);
+    if (!writer.Build(this))
+        return false;
+
+    return writer.Write(dest);
+}
+
 void Node::SetName(const String& name)
 {
     if (name != name_)
@@ -1284,6 +1295,100 @@ bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readC
     return true;
 }
 
+bool Node::Load(const FlatSceneFile& source, SceneResolver& resolver, bool rewriteIDs, CreateMode mode, const Variant* decodedValues)
+{
+    // Remove all children and components first in case this is not a fresh load
+    RemoveAllChildren();
+    RemoveAllComponents();
+
+    unsigned numNodes = source.GetNumNodes();
+    if (!numNodes)
+        return false;
+    if (source.GetRootType() != GetType())
+    {
+        LOGERROR("Could not load " + GetTypeName() + " from flat scene file " + source.GetName() + ", root type mismatch");
+        return false;
+    }
+
+    const FlatSceneNode* nodes = source.GetNodes();
+    const FlatSceneComponent* components = source.GetComponents();
+    const unsigned char* data = source.GetData();
+
+    // The records are in depth-first order, so a parent is always created before its children. Unless already decoded,
+    // attribute values are decoded into per-type scratch variants which keep their string storage from one object to the next
+    PODVector<Node*> loadedNodes(numNodes);
+    PODVector<unsigned> valueOffsets;
+    Vector<Variant> values;
+    Variant* valuesStart = 0;
+    if (!decodedValues)
+    {
+        valueOffsets.Resize(source.GetNumTypes());
+        unsigned numValues = 0;
+        for (unsigned i = 0; i < valueOffsets.Size(); ++i)
+        {
+            valueOffsets[i] = numValues;
+            numValues += source.GetTypeInfo(i).numAttributes_;
+        }
+        values.Resize(numValues);
+        valuesStart = numValues ? &values[0] : 0;
+    }
+
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        const FlatSceneNode& nodeRecord = nodes[i];
+        Node* node = this;
+        if (i)
+        {
+            node = loadedNodes[nodeRecord.parent_]->CreateChild(rewriteIDs ? 0 : nodeRecord.id_, (mode == REPLICATED &&
+                nodeRecord.id_ < FIRST_LOCAL_ID) ? REPLICATED : LOCAL);
+        }
+        loadedNodes[i] = node;
+        resolver.AddNode(nodeRecord.id_, node);
+
+        node->children_.Reserve(nodeRecord.numChildren_ < numNodes ? nodeRecord.numChildren_ : numNodes);
+        node->components_.Reserve(nodeRecord.numComponents_);
+
+        const FlatSceneTypeInfo& nodeType = source.GetTypeInfo(nodeRecord.type_);
+        if (decodedValues)
+        {
+            node->SetFlatAttributes(nodeType, decodedValues);
+            decodedValues += nodeType.numAttributes_;
+        }
+        else if (!node->LoadFlatAttributes(nodeType, data + nodeRecord.dataOffset_, nodeRecord.dataSize_, valuesStart +
+            valueOffsets[nodeRecord.type_]))
+            return false;
+
+        for (unsigned j = 0; j < nodeRecord.numComponents_; ++j)
+        {
+            const FlatSceneComponent& compRecord = components[nodeRecord.firstComponent_ + j];
+            const FlatSceneTypeInfo& compType = source.GetTypeInfo(compRecord.type_);
+            // Decoded values exist only for registered types
+            const Variant* compValues = decodedValues;
+            if (decodedValues && compType.registered_)
+                decodedValues += compType.numAttributes_;
+            Component* newComponent = node->SafeCreateComponent(String::EMPTY, compType.type_, (mode == REPLICATED &&
+                compRecord.id_ < FIRST_LOCAL_ID) ? REPLICATED : LOCAL, rewriteIDs ? 0 : compRecord.id_);
+            if (!newComponent)
+                continue;
+
+            resolver.AddComponent(compRecord.id_, newComponent);
+            // Do not abort if component fails to load, as the next component's data is independent. Unregistered types
+            // keep their data as is in an UnknownComponent
+            if (compType.registered_ && compValues)
+                newComponent->SetFlatAttributes(compType, compValues);
+            else if (compType.registered_)
+                newComponent->LoadFlatAttributes(compType, data + compRecord.dataOffset_, compRecord.dataSize_, valuesStart +
+                    valueOffsets[compRecord.type_]);
+            else
+            {
+                MemoryBuffer compBuffer(data + compRecord.dataOffset_, compRecord.dataSize_);
+                newComponent->Load(compBuffer);
+            }
+        }
+    }
+
+    return true;
+}
 
 void Node::PrepareNetworkUpdate()
 {
@@ -31,6 +31,7 @@ namespace Urho3D
 
 class Component;
 class Connection;
+class FlatSceneFile;
 class Scene;
 class SceneResolver;
 
@@ -86,6 +87,8 @@ public:
 
     /// Save to an XML file. Return true if successful.
     bool SaveXML(Serializer& dest) const;
+    /// Save to a flat scene file. Return true if successful.
+    bool SaveFlat(Serializer& dest) const;
     /// Set name of the scene node. Names are not required to be unique.
     void SetName(const String& name);
     /// Set position in parent space. If the scene node is on the root level (is child of the scene itself), this is same as world space.
@@ -399,6 +402,8 @@ public:
     bool Load(Deserializer& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false, CreateMode mode = REPLICATED);
     /// Load components from XML data and optionally load child nodes.
     bool LoadXML(const XMLElement& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false, CreateMode mode = REPLICATED);
+    /// Load components and child nodes from a flat scene file. The root node type must match. If decoded attribute values are given, they are used in record order instead of decoding the attribute data.
+    bool Load(const FlatSceneFile& source, SceneResolver& resolver, bool rewriteIDs = false, CreateMode mode = REPLICATED, const Variant* decodedValues = 0);
     /// Return the depended on nodes to order network updates.
     const PODVector<Node*>& GetDependencyNodes() const { return dependencyNodes_; }
     /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
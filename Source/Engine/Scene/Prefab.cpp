@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Context.h"
+#include "FileSystem.h"
+#include "FlatSceneFile.h"
+#include "FlatSceneWriter.h"
+#include "Log.h"
+#include "Node.h"
+#include "Prefab.h"
+#include "Profiler.h"
+#include "Serializable.h"
+#include "XMLFile.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+Prefab::Prefab(Context* context) :
+    Resource(context)
+{
+}
+
+Prefab::~Prefab()
+{
+}
+
+void Prefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<Prefab>();
+}
+
+bool Prefab::Load(Deserializer& source)
+{
+    PROFILE(LoadPrefab);
+
+    flatFile_.Reset();
+    values_.Clear();
+
+    SharedPtr<FlatSceneFile> flatFile(new FlatSceneFile(context_));
+    flatFile->SetName(GetName());
+
+    String fileID = source.ReadFileID();
+    source.Seek(0);
+    if (fileID == "USCF")
+    {
+        if (!flatFile->Load(source))
+            return false;
+    }
+    else
+    {
+        // Convert XML or binary data to the flat format. This also resolves the component types and matches the XML
+        // attributes by name, so that instantiation only needs to apply the values
+        FlatSceneWriter writer(context_);
+        bool success;
+        if (fileID[0] == '<' || GetExtension(source.GetName()) == ".xml")
+        {
+            SharedPtr<XMLFile> xml(new XMLFile(context_));
+            success = xml->Load(source) && writer.BuildFromXML(xml->GetRoot());
+        }
+        else
+            success = writer.BuildFromBinary(source);
+
+        VectorBuffer buffer;
+        if (!success || !writer.Write(buffer))
+        {
+            LOGERROR("Could not load prefab " + GetName());
+            return false;
+        }
+        buffer.Seek(0);
+        if (!flatFile->Load(buffer))
+            return false;
+    }
+
+    if (flatFile->GetRootType() != Node::GetTypeStatic())
+    {
+        LOGERROR(GetName() + " is not a node prefab");
+        return false;
+    }
+
+    // Decode the attribute values of all nodes and components in the order Node::Load() applies them. Unregistered component
+    // types have no values and are loaded from the flat file data instead
+    unsigned numNodes = flatFile->GetNumNodes();
+    const FlatSceneNode* nodes = flatFile->GetNodes();
+    const FlatSceneComponent* components = flatFile->GetComponents();
+    const unsigned char* data = flatFile->GetData();
+
+    unsigned numValues = 0;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        numValues += flatFile->GetTypeInfo(nodes[i].type_).numAttributes_;
+        for (unsigned j = 0; j < nodes[i].numComponents_; ++j)
+        {
+            const FlatSceneTypeInfo& compType = flatFile->GetTypeInfo(components[nodes[i].firstComponent_ + j].type_);
+            if (compType.registered_)
+                numValues += compType.numAttributes_;
+        }
+    }
+
+    values_.Resize(numValues);
+    Variant* values = numValues ? &values_[0] : 0;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        const FlatSceneNode& nodeRecord = nodes[i];
+        const FlatSceneTypeInfo& nodeType = flatFile->GetTypeInfo(nodeRecord.type_);
+        bool success = Serializable::ReadFlatAttributes(nodeType, data + nodeRecord.dataOffset_, nodeRecord.dataSize_, values);
+        values += nodeType.numAttributes_;
+
+        for (unsigned j = 0; j < nodeRecord.numComponents_ && success; ++j)
+        {
+            const FlatSceneComponent& compRecord = components[nodeRecord.firstComponent_ + j];
+            const FlatSceneTypeInfo& compType = flatFile->GetTypeInfo(compRecord.type_);
+            if (compType.registered_)
+            {
+                success = Serializable::ReadFlatAttributes(compType, data + compRecord.dataOffset_, compRecord.dataSize_, values);
+                values += compType.numAttributes_;
+            }
+        }
+
+        if (!success)
+        {
+            LOGERROR("Could not load prefab " + GetName() + ", attribute data truncated");
+            values_.Clear();
+            return false;
+        }
+    }
+
+    flatFile_ = flatFile;
+    SetMemoryUse(flatFile->GetMemoryUse() + numValues * sizeof(Variant));
+    return true;
+}
+
+bool Prefab::Save(Serializer& dest) const
+{
+    if (!flatFile_)
+    {
+        LOGERROR("Can not save empty prefab");
+        return false;
+    }
+
+    return flatFile_->Save(dest);
+}
+
+unsigned Prefab::GetNumNodes() const
+{
+    return flatFile_ ? flatFile_->GetNumNodes() : 0;
+}
+
+unsigned Prefab::GetNumComponents() const
+{
+    return flatFile_ ? flatFile_->GetNumComponents() : 0;
+}
+
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Resource.h"
+
+namespace Urho3D
+{
+
+class FlatSceneFile;
+
+/// %Object prefab resource. Parses a node hierarchy saved in XML, binary or flat binary format once, and keeps the attribute values decoded for fast repeated instantiation with Scene::Instantiate().
+class URHO3D_API Prefab : public Resource
+{
+    OBJECT(Prefab);
+
+public:
+    /// Construct.
+    Prefab(Context* context);
+    /// Destruct.
+    virtual ~Prefab();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource. The format is detected from the data. Return true if successful.
+    virtual bool Load(Deserializer& source);
+    /// Save resource in the flat binary format. Return true if successful.
+    virtual bool Save(Serializer& dest) const;
+
+    /// Return the node hierarchy in the flat binary format.
+    FlatSceneFile* GetFlatFile() const { return flatFile_; }
+    /// Return decoded attribute values of the nodes and components in record order, or null if not loaded.
+    const Variant* GetValues() const { return values_.Size() ? &values_[0] : 0; }
+    /// Return number of nodes.
+    unsigned GetNumNodes() const;
+    /// Return number of components.
+    unsigned GetNumComponents() const;
+
+private:
+    /// Node hierarchy in the flat binary format.
+    SharedPtr<FlatSceneFile> flatFile_;
+    /// Decoded attribute values.
+    Vector<Variant> values_;
+};
+
+}
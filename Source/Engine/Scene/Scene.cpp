@@ -25,9 +25,12 @@
 #include "Context.h"
 #include "CoreEvents.h"
 #include "File.h"
+#include "FlatSceneFile.h"
 #include "Log.h"
+#include "LogicComponent.h"
 #include "ObjectAnimation.h"
 #include "PackageFile.h"
+#include "Prefab.h"
 #include "Profiler.h"
 #include "ReplicationState.h"
 #include "Scene.h"
@@ -52,6 +55,43 @@ static const int ASYNC_LOAD_MIN_FPS = 30;
 static const int ASYNC_LOAD_MAX_MSEC = (int)(1000.0f / ASYNC_LOAD_MIN_FPS);
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const float DEFAULT_INTERPOLATION_DELAY = 0.1f;
+static const float DEFAULT_MAX_EXTRAPOLATION = 0.25f;
+static const float DEFAULT_SERVER_TICK_INTERVAL = 1.0f / 30.0f;
+/// Server tick estimate error in ticks beyond which the client clock is reset instead of corrected gradually.
+static const double SERVER_TICK_RESET_THRESHOLD = 10.0;
+/// Fraction of the server tick estimate error corrected per received tick.
+static const double SERVER_TICK_CORRECTION = 0.1;
+
+void LogicUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+    {
+        LogicComponent* component = *start;
+        if (component)
+            component->Update(timeStep);
+        ++start;
+    }
+}
+
+void LogicPostUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+    {
+        LogicComponent* component = *start;
+        if (component)
+            component->PostUpdate(timeStep);
+        ++start;
+    }
+}
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -64,6 +104,13 @@ Scene::Scene(Context* context) :
     elapsedTime_(0),
     smoothingConstant_(DEFAULT_SMOOTHING_CONSTANT),
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
+    interpolationDelay_(DEFAULT_INTERPOLATION_DELAY),
+    maxExtrapolation_(DEFAULT_MAX_EXTRAPOLATION),
+    serverTickInterval_(DEFAULT_SERVER_TICK_INTERVAL),
+    serverTick_(0),
+    clientTick_(0.0),
+    snapshotInterpolation_(false),
+    serverTickReceived_(false),
     updateEnabled_(true),
     asyncLoading_(false),
     threadedUpdate_(false)
@@ -83,9 +130,9 @@ Scene::~Scene()
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -104,6 +151,10 @@ void Scene::RegisterObject(Context* context)
     ATTRIBUTE(Scene, VAR_INT, "Next Local Component ID", localComponentID_, FIRST_LOCAL_ID, AM_FILE | AM_NOEDIT);
     ATTRIBUTE(Scene, VAR_VARIANTMAP, "Variables", vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     ACCESSOR_ATTRIBUTE(Scene, VAR_STRING, "Variable Names", GetVarNamesAttr, SetVarNamesAttr, String, String::EMPTY, AM_FILE | AM_NOEDIT);
+    // Snapshot interpolation is a client-side setting, so it is neither saved nor replicated
+    ACCESSOR_ATTRIBUTE(Scene, VAR_BOOL, "Snapshot Interpolation", GetSnapshotInterpolation, SetSnapshotInterpolation, bool, false, AM_EDIT);
+    ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Interpolation Delay", GetInterpolationDelay, SetInterpolationDelay, float, DEFAULT_INTERPOLATION_DELAY, AM_EDIT);
+    ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Max Extrapolation", GetMaxExtrapolation, SetMaxExtrapolation, float, DEFAULT_MAX_EXTRAPOLATION, AM_EDIT);
 }
 
 bool Scene::Load(Deserializer& source, bool setInstanceDefault)
@@ -174,6 +225,49 @@ bool Scene::LoadXML(const XMLElement& source, bool setInstanceDefault)
         return false;
 }
 
+bool Scene::LoadFlat(Deserializer& source)
+{
+    SharedPtr<FlatSceneFile> file(new FlatSceneFile(context_));
+    if (!file->Load(source))
+        return false;
+
+    LOGINFO("Loading scene from " + source.GetName());
+
+    if (LoadFlat(file))
+    {
+        FinishLoading(&source);
+        return true;
+    }
+    else
+        return false;
+}
+
+bool Scene::LoadFlat(FlatSceneFile* source)
+{
+    PROFILE(LoadSceneFlat);
+
+    StopAsyncLoading();
+
+    if (!source)
+        return false;
+
+    Clear();
+
+    // The object counts are known up front, so size the ID maps once instead of growing them
+    replicatedNodes_.Reserve(source->GetNumNodes());
+    replicatedComponents_.Reserve(source->GetNumComponents());
+
+    SceneResolver resolver;
+    if (Node::Load(*source, resolver))
+    {
+        resolver.Resolve();
+        ApplyAttributes();
+        return true;
+    }
+    else
+        return false;
+}
+
 void Scene::MarkNetworkUpdate()
 {
     if (!networkUpdate_)
@@ -188,7 +282,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -386,6 +480,54 @@ Node* Scene::InstantiateXML(Deserializer& source, const Vector3& position, const
     return InstantiateXML(xml->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    PROFILE(InstantiatePrefab);
+
+    if (!prefab || !prefab->GetFlatFile())
+        return 0;
+
+    SceneResolver resolver;
+    // Rewrite IDs when instantiating
+    Node* node = CreateChild(0, mode);
+    if (node->Load(*prefab->GetFlatFile(), resolver, true, mode, prefab->GetValues()))
+    {
+        resolver.Resolve();
+        node->ApplyAttributes();
+        node->SetTransform(position, rotation);
+        return node;
+    }
+    else
+    {
+        node->Remove();
+        return 0;
+    }
+}
+
+Node* Scene::InstantiateFlat(FlatSceneFile* source, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    PROFILE(InstantiateFlat);
+
+    if (!source)
+        return 0;
+
+    SceneResolver resolver;
+    // Rewrite IDs when instantiating
+    Node* node = CreateChild(0, mode);
+    if (node->Load(*source, resolver, true, mode))
+    {
+        resolver.Resolve();
+        node->ApplyAttributes();
+        node->SetTransform(position, rotation);
+        return node;
+    }
+    else
+    {
+        node->Remove();
+        return 0;
+    }
+}
+
 void Scene::Clear(bool clearReplicated, bool clearLocal)
 {
     StopAsyncLoading();
@@ -438,6 +580,41 @@ void Scene::SetSnapThreshold(float threshold)
     Node::MarkNetworkUpdate();
 }
 
+void Scene::SetSnapshotInterpolation(bool enable)
+{
+    snapshotInterpolation_ = enable;
+}
+
+void Scene::SetInterpolationDelay(float delay)
+{
+    interpolationDelay_ = Max(delay, 0.0f);
+}
+
+void Scene::SetMaxExtrapolation(float time)
+{
+    maxExtrapolation_ = Max(time, 0.0f);
+}
+
+void Scene::SetServerTick(unsigned tick, float tickInterval)
+{
+    if (tickInterval > 0.0f)
+        serverTickInterval_ = tickInterval;
+
+    // Ticks may arrive out of order or be lost; only newer ticks move the clock
+    if (serverTickReceived_ && (int)(tick - serverTick_) <= 0)
+        return;
+
+    // Correct the client's estimate of the server clock gradually to hide network jitter, unless the error is large
+    double error = (double)tick - clientTick_;
+    if (!serverTickReceived_ || fabs(error) > SERVER_TICK_RESET_THRESHOLD)
+        clientTick_ = (double)tick;
+    else
+        clientTick_ += error * SERVER_TICK_CORRECTION;
+
+    serverTick_ = tick;
+    serverTickReceived_ = true;
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -476,7 +653,7 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End())
             return i->second_;
         else
@@ -484,7 +661,7 @@ Node* Scene::GetNode(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         if (i != localNodes_.End())
             return i->second_;
         else
@@ -496,7 +673,7 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End())
             return i->second_;
         else
@@ -504,7 +681,7 @@ Component* Scene::GetComponent(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         if (i != localComponents_.End())
             return i->second_;
         else
@@ -512,6 +689,11 @@ Component* Scene::GetComponent(unsigned id) const
     }
 }
 
+double Scene::GetRenderTick() const
+{
+    return clientTick_ - (double)(interpolationDelay_ / serverTickInterval_);
+}
+
 float Scene::GetAsyncProgress() const
 {
     if (!asyncLoading_ || !asyncProgress_.totalNodes_)
@@ -536,15 +718,23 @@ void Scene::Update(float timeStep)
 
     PROFILE(UpdateScene);
 
+    // Advance the server clock estimate in real time for snapshot interpolation
+    if (serverTickReceived_)
+        clientTick_ += (double)(timeStep / serverTickInterval_);
+
     timeStep *= timeScale_;
 
+    // Update variable timestep logic. Logic components are called directly before the event is sent. Fill the event
+    // data only afterward, as the components may use the same event data map for their own events
+    UpdateLogicComponents(LU_UPDATE, timeStep);
+    UpdateLogicComponents(LU_THREADEDUPDATE, timeStep);
+
     using namespace SceneUpdate;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
-    // Update variable timestep logic
     SendEvent(E_SCENEUPDATE, eventData);
 
     // Update scene attribute animation.
@@ -560,6 +750,8 @@ void Scene::Update(float timeStep)
         float constant = 1.0f - Clamp(powf(2.0f, -timeStep * smoothingConstant_), 0.0f, 1.0f);
         float squaredSnapThreshold = snapThreshold_ * snapThreshold_;
 
+        UpdateSmoothedTransforms(constant, squaredSnapThreshold);
+
         using namespace UpdateSmoothing;
 
         smoothingData_[P_CONSTANT] = constant;
@@ -568,7 +760,14 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateLogicComponents(LU_POSTUPDATE, timeStep);
+    UpdateLogicComponents(LU_THREADEDPOSTUPDATE, timeStep);
+
+    VariantMap& postUpdateData = GetEventDataMap();
+    postUpdateData[P_SCENE] = this;
+    postUpdateData[P_TIMESTEP] = timeStep;
+
+    SendEvent(E_SCENEPOSTUPDATE, postUpdateData);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -606,6 +805,117 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::AddLogicUpdate(LogicComponent* component, LogicUpdateList list)
+{
+    logicUpdates_[list].Add(component);
+}
+
+void Scene::RemoveLogicUpdate(LogicComponent* component, LogicUpdateList list)
+{
+    logicUpdates_[list].Remove(component);
+}
+
+void Scene::UpdateLogicComponents(LogicUpdateList list, float timeStep)
+{
+    DenseList<LogicComponent>& components = logicUpdates_[list];
+    if (components.Empty())
+        return;
+
+    // Perform the threaded lists in worker threads, if they exist. Components in these lists may not add or remove
+    // components or nodes, so the list stays unchanged while the work is in progress
+    if (list == LU_THREADEDUPDATE || list == LU_THREADEDPOSTUPDATE)
+    {
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue && queue->GetNumThreads())
+        {
+            PROFILE(UpdateLogicThreaded);
+
+            BeginThreadedUpdate();
+            components.BeginIteration();
+
+            const PODVector<LogicComponent*>& items = components.GetItems();
+            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+            int componentsPerItem = items.Size() / numWorkItems;
+
+            PODVector<LogicComponent*>::ConstIterator start = items.Begin();
+            for (int i = 0; i < numWorkItems; ++i)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = list == LU_THREADEDUPDATE ? LogicUpdateWork : LogicPostUpdateWork;
+                item->aux_ = &timeStep;
+
+                PODVector<LogicComponent*>::ConstIterator end = items.End();
+                if (i < numWorkItems - 1 && end - start > componentsPerItem)
+                    end = start + componentsPerItem;
+
+                item->start_ = (void*)&(*start);
+                item->end_ = (void*)&(*end);
+                queue->AddWorkItem(item);
+
+                start = end;
+            }
+
+            queue->Complete(M_MAX_UNSIGNED);
+            components.EndIteration();
+            EndThreadedUpdate();
+            return;
+        }
+    }
+
+    // Components may destroy the scene during the update calls, in which case the list can not be accessed anymore
+    WeakPtr<Scene> self(this);
+    components.BeginIteration();
+
+    // Components added during the iteration will be called only on the next update
+    unsigned numComponents = components.Size();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        LogicComponent* component = components[i];
+        if (!component)
+            continue;
+
+        switch (list)
+        {
+        case LU_UPDATE:
+            component->CallUpdate(timeStep);
+            break;
+
+        case LU_THREADEDUPDATE:
+            component->Update(timeStep);
+            break;
+
+        case LU_POSTUPDATE:
+        case LU_THREADEDPOSTUPDATE:
+            component->PostUpdate(timeStep);
+            break;
+
+        case LU_FIXEDUPDATE:
+            component->FixedUpdate(timeStep);
+            break;
+
+        default:
+            component->FixedPostUpdate(timeStep);
+            break;
+        }
+
+        if (self.Expired())
+            return;
+    }
+
+    components.EndIteration();
+}
+
+void Scene::AddSmoothedTransform(SmoothedTransform* transform)
+{
+    smoothedTransforms_.Add(transform);
+}
+
+void Scene::RemoveSmoothedTransform(SmoothedTransform* transform)
+{
+    smoothedTransforms_.Remove(transform);
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -697,7 +1007,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -711,7 +1021,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -748,7 +1058,7 @@ void Scene::ComponentAdded(Component* component)
     unsigned id = component->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -759,7 +1069,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -832,10 +1142,10 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
@@ -953,6 +1263,24 @@ void Scene::FinishAsyncLoading()
     SendEvent(E_ASYNCLOADFINISHED, eventData);
 }
 
+void Scene::UpdateSmoothedTransforms(float constant, float squaredSnapThreshold)
+{
+    if (smoothedTransforms_.Empty())
+        return;
+
+    smoothedTransforms_.BeginIteration();
+
+    unsigned numTransforms = smoothedTransforms_.Size();
+    for (unsigned i = 0; i < numTransforms; ++i)
+    {
+        SmoothedTransform* transform = smoothedTransforms_[i];
+        if (transform)
+            transform->UpdateSmoothing(constant, squaredSnapThreshold);
+    }
+
+    smoothedTransforms_.EndIteration();
+}
+
 void Scene::FinishLoading(Deserializer* source)
 {
     if (source)
@@ -981,6 +1309,8 @@ void RegisterSceneLibrary(Context* context)
     SmoothedTransform::RegisterObject(context);
     UnknownComponent::RegisterObject(context);
     SplinePath::RegisterObject(context);
+    FlatSceneFile::RegisterObject(context);
+    Prefab::RegisterObject(context);
 }
 
 }
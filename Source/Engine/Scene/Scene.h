@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include "DenseList.h"
+#include "FlatHashMap.h"
 #include "HashSet.h"
 #include "Mutex.h"
 #include "Node.h"
@@ -32,13 +34,29 @@ namespace Urho3D
 {
 
 class File;
+class FlatSceneFile;
+class LogicComponent;
 class PackageFile;
+class Prefab;
+class SmoothedTransform;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
 static const unsigned FIRST_LOCAL_ID = 0x01000000;
 static const unsigned LAST_LOCAL_ID = 0xffffffff;
 
+/// Direct update lists for logic components.
+enum LogicUpdateList
+{
+    LU_UPDATE = 0,
+    LU_THREADEDUPDATE,
+    LU_POSTUPDATE,
+    LU_THREADEDPOSTUPDATE,
+    LU_FIXEDUPDATE,
+    LU_FIXEDPOSTUPDATE,
+    MAX_LOGIC_UPDATE_LISTS
+};
+
 /// Asynchronous loading progress of a scene.
 struct AsyncProgress
 {
@@ -85,6 +103,10 @@ public:
     bool LoadXML(Deserializer& source);
     /// Save to an XML file. Return true if successful.
     bool SaveXML(Serializer& dest) const;
+    /// Load from a flat scene file. Removes all existing child nodes and components first. Return true if successful.
+    bool LoadFlat(Deserializer& source);
+    /// Load from an already loaded flat scene file. Removes all existing child nodes and components first. Return true if successful.
+    bool LoadFlat(FlatSceneFile* source);
     /// Load from a binary file asynchronously. Return true if started successfully.
     bool LoadAsync(File* file);
     /// Load from an XML file asynchronously. Return true if started successfully.
@@ -97,6 +119,10 @@ public:
     Node* InstantiateXML(const XMLElement& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from XML data. Return root node if successful.
     Node* InstantiateXML(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a prefab resource. The prefab's attribute values are already decoded, so this is the fastest way to create many copies of an object. Return root node if successful.
+    Node* Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate scene content from a flat scene file saved from a node. The file can be instantiated any number of times. Return root node if successful.
+    Node* InstantiateFlat(FlatSceneFile* source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Clear scene completely of either replicated, local or all nodes and components.
     void Clear(bool clearReplicated = true, bool clearLocal = true);
     /// Enable or disable scene update.
@@ -109,6 +135,14 @@ public:
     void SetSmoothingConstant(float constant);
     /// Set network client motion smoothing snap threshold.
     void SetSnapThreshold(float threshold);
+    /// Set whether network clients interpolate between timestamped transform snapshots instead of exponential smoothing.
+    void SetSnapshotInterpolation(bool enable);
+    /// Set network client snapshot interpolation render delay in seconds.
+    void SetInterpolationDelay(float delay);
+    /// Set maximum time in seconds to extrapolate past the latest transform snapshot.
+    void SetMaxExtrapolation(float time);
+    /// Set latest server network tick and tick interval in seconds. Called by Connection on the client.
+    void SetServerTick(unsigned tick, float tickInterval);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -142,6 +176,20 @@ public:
     float GetSmoothingConstant() const { return smoothingConstant_; }
     /// Return motion smoothing snap threshold.
     float GetSnapThreshold() const { return snapThreshold_; }
+    /// Return whether snapshot interpolation is used for network client motion.
+    bool GetSnapshotInterpolation() const { return snapshotInterpolation_; }
+    /// Return snapshot interpolation render delay in seconds.
+    float GetInterpolationDelay() const { return interpolationDelay_; }
+    /// Return maximum snapshot extrapolation time in seconds.
+    float GetMaxExtrapolation() const { return maxExtrapolation_; }
+    /// Return latest received server network tick.
+    unsigned GetServerTick() const { return serverTick_; }
+    /// Return whether a server network tick has been received.
+    bool HasServerTick() const { return serverTickReceived_; }
+    /// Return server network tick interval in seconds.
+    float GetServerTickInterval() const { return serverTickInterval_; }
+    /// Return the delayed server network tick at which snapshots are currently being rendered, including the fraction.
+    double GetRenderTick() const;
     /// Return required package files.
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
     /// Return a node user variable name, or empty if not registered.
@@ -157,6 +205,20 @@ public:
     void DelayedMarkedDirty(Component* component);
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
+    /// Add a logic component to a direct update list. Called by LogicComponent.
+    void AddLogicUpdate(LogicComponent* component, LogicUpdateList list);
+    /// Remove a logic component from a direct update list. Called by LogicComponent.
+    void RemoveLogicUpdate(LogicComponent* component, LogicUpdateList list);
+    /// Call the logic components in a direct update list. The threaded lists are processed in worker threads if available. Fixed update lists are called by PhysicsWorld.
+    void UpdateLogicComponents(LogicUpdateList list, float timeStep);
+    /// Add a smoothed transform to the smoothing update list. Called by SmoothedTransform.
+    void AddSmoothedTransform(SmoothedTransform* transform);
+    /// Remove a smoothed transform from the smoothing update list. Called by SmoothedTransform.
+    void RemoveSmoothedTransform(SmoothedTransform* transform);
+    /// Return number of logic components in a direct update list.
+    unsigned GetNumLogicUpdates(LogicUpdateList list) const { return logicUpdates_[list].Size(); }
+    /// Return number of smoothed transforms in the smoothing update list.
+    unsigned GetNumSmoothedTransforms() const { return smoothedTransforms_.Size(); }
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -195,15 +257,17 @@ private:
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
     void FinishSaving(Serializer* dest) const;
+    /// Update the smoothed transforms.
+    void UpdateSmoothedTransforms(float constant, float squaredSnapThreshold);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -224,6 +288,10 @@ private:
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Logic component direct update lists.
+    DenseList<LogicComponent> logicUpdates_[MAX_LOGIC_UPDATE_LISTS];
+    /// Smoothed transforms that are in the middle of smoothing.
+    DenseList<SmoothedTransform> smoothedTransforms_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -242,6 +310,20 @@ private:
     float smoothingConstant_;
     /// Motion smoothing snap threshold.
     float snapThreshold_;
+    /// Snapshot interpolation render delay.
+    float interpolationDelay_;
+    /// Maximum snapshot extrapolation time.
+    float maxExtrapolation_;
+    /// Server network tick interval.
+    float serverTickInterval_;
+    /// Latest received server network tick.
+    unsigned serverTick_;
+    /// Estimated current server network tick, advanced each update and corrected as ticks are received.
+    double clientTick_;
+    /// Snapshot interpolation flag.
+    bool snapshotInterpolation_;
+    /// Server network tick received flag.
+    bool serverTickReceived_;
     /// Update enabled flag.
     bool updateEnabled_;
     /// Asynchronous loading flag.
@@ -23,18 +23,203 @@
 #include "Precompiled.h"
 #include "Context.h"
 #include "Deserializer.h"
+#include "FlatSceneFile.h"
 #include "Log.h"
+#include "MemoryBuffer.h"
 #include "ReplicationState.h"
 #include "SceneEvents.h"
 #include "Serializable.h"
 #include "Serializer.h"
 #include "XMLElement.h"
 
+#include <cstring>
+
 #include "DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Decode a scalar attribute value. Return the position after the value, or null if truncated.
+template <class T> static const unsigned char* ReadFlatScalar(const unsigned char* data, const unsigned char* end, Variant& dest)
+{
+    if ((unsigned)(end - data) < sizeof(T))
+        return 0;
+
+    T value;
+    memcpy(&value, data, sizeof value);
+    dest = value;
+    return data + sizeof value;
+}
+
+/// Decode a fixed-size attribute value stored as an array of components. Return the position after the value, or null if truncated.
+template <class T, class U, unsigned N> static const unsigned char* ReadFlatValue(const unsigned char* data,
+    const unsigned char* end, Variant& dest)
+{
+    if ((unsigned)(end - data) < sizeof(U) * N)
+        return 0;
+
+    U values[N];
+    memcpy(values, data, sizeof values);
+    dest = T(values);
+    return data + sizeof values;
+}
+
+/// Decode a null-terminated string. Return the position after the terminator, or null if truncated.
+static const unsigned char* ReadFlatString(const unsigned char* data, const unsigned char* end, String& dest)
+{
+    const unsigned char* terminator = (const unsigned char*)memchr(data, 0, end - data);
+    if (!terminator)
+        return 0;
+
+    dest = (const char*)data;
+    return terminator + 1;
+}
+
+/// Decode a variable-length encoded unsigned integer as written by Serializer::WriteVLE(). Return the position after it, or null if truncated.
+static const unsigned char* ReadFlatVLE(const unsigned char* data, const unsigned char* end, unsigned& dest)
+{
+    dest = 0;
+    for (unsigned shift = 0; data < end; shift += 7)
+    {
+        unsigned char byte = *data++;
+        // The fourth byte uses all 8 bits
+        if (shift == 21)
+        {
+            dest |= (unsigned)byte << shift;
+            return data;
+        }
+        dest |= (unsigned)(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return data;
+    }
+
+    return 0;
+}
+
+/// Decode a binary format attribute value directly from memory. Strings and resource references reuse the storage of the destination variant. Return the position after the value, or null if truncated.
+static const unsigned char* ReadFlatAttribute(const unsigned char* data, const unsigned char* end, VariantType type,
+    Variant& dest)
+{
+    switch (type)
+    {
+    case VAR_INT:
+        return ReadFlatScalar<int>(data, end, dest);
+
+    case VAR_BOOL:
+        if (data >= end)
+            return 0;
+        dest = *data != 0;
+        return data + 1;
+
+    case VAR_FLOAT:
+        return ReadFlatScalar<float>(data, end, dest);
+
+    case VAR_VECTOR2:
+        return ReadFlatValue<Vector2, float, 2>(data, end, dest);
+
+    case VAR_VECTOR3:
+        return ReadFlatValue<Vector3, float, 3>(data, end, dest);
+
+    case VAR_VECTOR4:
+        return ReadFlatValue<Vector4, float, 4>(data, end, dest);
+
+    case VAR_QUATERNION:
+        return ReadFlatValue<Quaternion, float, 4>(data, end, dest);
+
+    case VAR_COLOR:
+        return ReadFlatValue<Color, float, 4>(data, end, dest);
+
+    case VAR_INTRECT:
+        return ReadFlatValue<IntRect, int, 4>(data, end, dest);
+
+    case VAR_INTVECTOR2:
+        return ReadFlatValue<IntVector2, int, 2>(data, end, dest);
+
+    case VAR_MATRIX3:
+        return ReadFlatValue<Matrix3, float, 9>(data, end, dest);
+
+    case VAR_MATRIX3X4:
+        return ReadFlatValue<Matrix3x4, float, 12>(data, end, dest);
+
+    case VAR_MATRIX4:
+        return ReadFlatValue<Matrix4, float, 16>(data, end, dest);
+
+    case VAR_STRING:
+        {
+            String value;
+            dest.Swap(value);
+            data = ReadFlatString(data, end, value);
+            dest.Swap(value);
+            return data;
+        }
+
+    case VAR_RESOURCEREF:
+        {
+            if ((unsigned)(end - data) < sizeof(unsigned short))
+                return 0;
+            ResourceRef value;
+            dest.Swap(value);
+            unsigned short typeHash;
+            memcpy(&typeHash, data, sizeof typeHash);
+            value.type_ = ShortStringHash(typeHash);
+            data = ReadFlatString(data + sizeof typeHash, end, value.name_);
+            dest.Swap(value);
+            return data;
+        }
+
+    case VAR_RESOURCEREFLIST:
+        {
+            if ((unsigned)(end - data) < sizeof(unsigned short))
+                return 0;
+            ResourceRefList value;
+            dest.Swap(value);
+            unsigned short typeHash;
+            memcpy(&typeHash, data, sizeof typeHash);
+            value.type_ = ShortStringHash(typeHash);
+            unsigned numNames;
+            data = ReadFlatVLE(data + sizeof typeHash, end, numNames);
+            if (data && numNames <= (unsigned)(end - data))
+            {
+                value.names_.Resize(numNames);
+                for (unsigned i = 0; i < numNames && data; ++i)
+                    data = ReadFlatString(data, end, value.names_[i]);
+            }
+            else
+                data = 0;
+            dest.Swap(value);
+            return data;
+        }
+
+        // Serializing pointers is not supported. Read as null
+    case VAR_VOIDPTR:
+    case VAR_PTR:
+        if ((unsigned)(end - data) < sizeof(unsigned))
+            return 0;
+        dest = (void*)0;
+        return data + sizeof(unsigned);
+
+    case VAR_VARIANTMAP:
+        // Empty maps, such as unused node variables, are common enough to bypass the generic path
+        if (data < end && !*data)
+        {
+            if (dest.GetType() == VAR_VARIANTMAP)
+                dest.GetVariantMapPtr()->Clear();
+            else
+                dest = Variant::emptyVariantMap;
+            return data + 1;
+        }
+        // Fall through
+
+    default:
+        {
+            // Buffers, variant vectors and maps go through the generic deserializer
+            MemoryBuffer buffer(data, (unsigned)(end - data));
+            dest = buffer.ReadVariant(type);
+            return data + buffer.GetPosition();
+        }
+    }
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     networkState_(0),
@@ -295,6 +480,48 @@ bool Serializable::Save(Serializer& dest) const
     return true;
 }
 
+bool Serializable::LoadFlatAttributes(const FlatSceneTypeInfo& type, const unsigned char* data, unsigned size, Variant* values)
+{
+    if (!ReadFlatAttributes(type, data, size, values))
+    {
+        LOGERROR("Could not load " + GetTypeName() + ", attribute data truncated");
+        return false;
+    }
+
+    SetFlatAttributes(type, values);
+    return true;
+}
+
+void Serializable::SetFlatAttributes(const FlatSceneTypeInfo& type, const Variant* values)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return;
+
+    for (unsigned i = 0; i < type.numAttributes_; ++i)
+    {
+        // The indices were resolved when the flat file was loaded. Skip ones that no longer fit, for example after attributes
+        // have been removed
+        unsigned index = type.attributeIndices_[i];
+        if (index < attributes->Size() && attributes->At(index).type_ == type.attributeTypes_[i])
+            OnSetAttribute(attributes->At(index), values[i]);
+    }
+}
+
+bool Serializable::ReadFlatAttributes(const FlatSceneTypeInfo& type, const unsigned char* data, unsigned size, Variant* values)
+{
+    const unsigned char* end = data + size;
+
+    for (unsigned i = 0; i < type.numAttributes_; ++i)
+    {
+        data = ReadFlatAttribute(data, end, (VariantType)type.attributeTypes_[i], values[i]);
+        if (!data)
+            return false;
+    }
+
+    return true;
+}
+
 bool Serializable::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
     if (source.IsNull())
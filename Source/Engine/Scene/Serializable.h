@@ -36,6 +36,7 @@ class Serializer;
 class XMLElement;
 
 struct DirtyBits;
+struct FlatSceneTypeInfo;
 struct NetworkState;
 struct ReplicationState;
 
@@ -62,6 +63,8 @@ public:
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false);
     /// Save as binary data. Return true if successful.
     virtual bool Save(Serializer& dest) const;
+    /// Set attributes from flat scene attribute values decoded by ReadFlatAttributes(), one per saved attribute. Attributes that are not registered for this type are skipped.
+    virtual void SetFlatAttributes(const FlatSceneTypeInfo& type, const Variant* values);
     /// Load from XML data. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false);
     /// Save as XML data. Return true if successful.
@@ -73,6 +76,10 @@ public:
     /// Mark for attribute check on the next network update.
     virtual void MarkNetworkUpdate() {}
 
+    /// Load from flat scene attribute data laid out as described by the type. The values array holds one variant per saved attribute and is reused between objects of the same type to avoid reallocating. Return true if successful.
+    bool LoadFlatAttributes(const FlatSceneTypeInfo& type, const unsigned char* data, unsigned size, Variant* values);
+    /// Decode flat scene attribute data laid out as described by the type into one variant per saved attribute. Return false if the data is truncated.
+    static bool ReadFlatAttributes(const FlatSceneTypeInfo& type, const unsigned char* data, unsigned size, Variant* values);
     /// Set attribute by index. Return true if successfully set.
     bool SetAttribute(unsigned index, const Variant& value);
     /// Set attribute by name. Return true if successfully set.
@@ -127,6 +134,21 @@ private:
     bool temporary_;
 };
 
+/// Store a value returned by an attribute getter function into a variant.
+template <class U> inline void MoveAttributeValue(Variant& dest, U& value) { dest = value; }
+/// Store a string returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, String& value) { dest.Swap(value); }
+/// Store a buffer returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, PODVector<unsigned char>& value) { dest.Swap(value); }
+/// Store a resource reference returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, ResourceRef& value) { dest.Swap(value); }
+/// Store a resource reference list returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, ResourceRefList& value) { dest.Swap(value); }
+/// Store a variant vector returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, VariantVector& value) { dest.Swap(value); }
+/// Store a variant map returned by an attribute getter function into a variant. Swaps the temporary instead of copying it.
+inline void MoveAttributeValue(Variant& dest, VariantMap& value) { dest.Swap(value); }
+
 /// Template implementation of the attribute accessor invoke helper class.
 template <class T, class U> class AttributeAccessorImpl : public AttributeAccessor
 {
@@ -148,7 +170,8 @@ public:
     {
         assert(ptr);
         const T* classPtr = static_cast<const T*>(ptr);
-        dest = (classPtr->*getFunction_)();
+        U value = (classPtr->*getFunction_)();
+        MoveAttributeValue(dest, value);
     }
 
     /// Invoke setter function.
@@ -194,7 +217,8 @@ public:
     {
         assert(ptr);
         T* classPtr = static_cast<T*>(ptr);
-        (classPtr->*setFunction_)(value.Get<U>());
+        // Pass the value by reference to avoid copying it
+        (classPtr->*setFunction_)(value.Get<const U&>());
     }
 
     /// Class-specific pointer to getter function.
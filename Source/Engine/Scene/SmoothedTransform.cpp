@@ -35,13 +35,13 @@ SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
-    smoothingMask_(SMOOTH_NONE),
-    subscribed_(false)
+    smoothingMask_(SMOOTH_NONE)
 {
 }
 
 SmoothedTransform::~SmoothedTransform()
 {
+    UnsubscribeFromSmoothing();
 }
 
 void SmoothedTransform::RegisterObject(Context* context)
@@ -89,12 +89,123 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
         }
     }
 
-    // If smoothing has completed, unsubscribe from the update event
-    if (!smoothingMask_)
+    // If smoothing has completed, stop receiving smoothing updates
+    if (!smoothingMask_ && snapshots_.Empty())
+        UnsubscribeFromSmoothing();
+}
+
+void SmoothedTransform::UpdateSnapshots(double renderTick, float maxExtrapolation, float squaredSnapThreshold)
+{
+    if (snapshots_.Empty())
+    {
+        UnsubscribeFromSmoothing();
+        return;
+    }
+    
+    // Snapshots drive the transform directly, so any pending exponential smoothing is superseded
+    smoothingMask_ = SMOOTH_NONE;
+    
+    // Discard snapshots that are no longer needed: keep the newest one at or before the render tick
+    unsigned first = 0;
+    while (first + 1 < snapshots_.Size() && (double)snapshots_[first + 1].tick_ <= renderTick)
+        ++first;
+    if (first)
+        snapshots_.Erase(0, first);
+    
+    const TransformSnapshot& oldest = snapshots_.Front();
+    Vector3 position;
+    Quaternion rotation;
+    bool finished = false;
+    
+    if (renderTick <= (double)oldest.tick_ || snapshots_.Size() == 1)
+    {
+        // Not yet reached the first snapshot, or nothing to interpolate towards: hold the snapshot
+        position = oldest.position_;
+        rotation = oldest.rotation_;
+        finished = snapshots_.Size() == 1 && renderTick >= (double)oldest.tick_;
+    }
+    else
+    {
+        const TransformSnapshot& next = snapshots_[1];
+        float span = (float)(next.tick_ - oldest.tick_);
+        float t = (float)(renderTick - (double)oldest.tick_) / span;
+        
+        // If the distance between snapshots exceeds the snap threshold, jump instead of interpolating
+        if ((next.position_ - oldest.position_).LengthSquared() > squaredSnapThreshold)
+        {
+            const TransformSnapshot& nearest = t < 1.0f ? oldest : next;
+            position = nearest.position_;
+            rotation = nearest.rotation_;
+            finished = t >= 1.0f;
+        }
+        else
+        {
+            // Past the newest snapshot: extrapolate along the last motion up to the maximum extrapolation
+            if (t > 1.0f)
+            {
+                t = Min(t, 1.0f + maxExtrapolation / span);
+                finished = t >= 1.0f + maxExtrapolation / span;
+            }
+            position = oldest.position_.Lerp(next.position_, t);
+            rotation = oldest.rotation_.Slerp(next.rotation_, t);
+        }
+    }
+    
+    if (node_)
+    {
+        node_->SetPosition(position);
+        node_->SetRotation(rotation);
+    }
+    
+    // When extrapolation has run out, stop updating until new snapshots arrive
+    if (finished)
+    {
+        snapshots_.Erase(0, snapshots_.Size() - 1);
+        UnsubscribeFromSmoothing();
+    }
+}
+
+void SmoothedTransform::AddSnapshot(unsigned tick)
+{
+    // Find the insertion point. Snapshots may arrive out of order
+    unsigned index = snapshots_.Size();
+    while (index > 0 && (int)(snapshots_[index - 1].tick_ - tick) > 0)
+        --index;
+    
+    if (index > 0 && snapshots_[index - 1].tick_ == tick)
+    {
+        // Same tick received again, overwrite
+        TransformSnapshot& snapshot = snapshots_[index - 1];
+        snapshot.position_ = targetPosition_;
+        snapshot.rotation_ = targetRotation_;
+    }
+    else
     {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
-        subscribed_ = false;
+        // If the buffer is full, drop the oldest snapshot, unless the new one would be the oldest
+        if (snapshots_.Size() >= MAX_TRANSFORM_SNAPSHOTS)
+        {
+            if (!index)
+                return;
+            snapshots_.Erase(0);
+            --index;
+        }
+        
+        TransformSnapshot snapshot;
+        snapshot.tick_ = tick;
+        snapshot.position_ = targetPosition_;
+        snapshot.rotation_ = targetRotation_;
+        snapshots_.Insert(index, snapshot);
     }
+    
+    SubscribeToSmoothing();
+}
+
+void SmoothedTransform::ClearSnapshots()
+{
+    snapshots_.Clear();
+    
+    if (!smoothingMask_)
+        UnsubscribeFromSmoothing();
 }
 
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
@@ -103,11 +214,7 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
     smoothingMask_ |= SMOOTH_POSITION;
 
     // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    SubscribeToSmoothing();
 
     SendEvent(E_TARGETPOSITION);
 }
@@ -117,11 +224,7 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
 
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    SubscribeToSmoothing();
 
     SendEvent(E_TARGETROTATION);
 }
@@ -166,15 +269,49 @@ void SmoothedTransform::OnNodeSet(Node* node)
         targetPosition_ = node->GetPosition();
         targetRotation_ = node->GetRotation();
     }
+    else
+        UnsubscribeFromSmoothing();
 }
 
-void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
+void SmoothedTransform::UpdateSmoothing(float constant, float squaredSnapThreshold)
 {
-    using namespace UpdateSmoothing;
+    // Use snapshot interpolation if enabled and snapshots have been received, else fall back to exponential smoothing
+    Scene* scene = smoothingScene_;
+    if (scene && scene->GetSnapshotInterpolation() && !snapshots_.Empty())
+    {
+        float maxExtrapolation = scene->GetMaxExtrapolation() / scene->GetServerTickInterval();
+        UpdateSnapshots(scene->GetRenderTick(), maxExtrapolation, squaredSnapThreshold);
+    }
+    else
+    {
+        // Buffered snapshots are not consumed while snapshot interpolation is off, so discard them. Otherwise they would
+        // keep the smoothing update subscribed
+        snapshots_.Clear();
+        Update(constant, squaredSnapThreshold);
+    }
+}
 
-    float constant = eventData[P_CONSTANT].GetFloat();
-    float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
+void SmoothedTransform::SubscribeToSmoothing()
+{
+    if (!smoothingScene_)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+        {
+            scene->AddSmoothedTransform(this);
+            smoothingScene_ = scene;
+        }
+    }
+}
+
+void SmoothedTransform::UnsubscribeFromSmoothing()
+{
+    Scene* scene = smoothingScene_;
+    if (scene)
+    {
+        scene->RemoveSmoothedTransform(this);
+        smoothingScene_.Reset();
+    }
 }
 
 }
@@ -27,18 +27,35 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// No ongoing smoothing.
 static const unsigned SMOOTH_NONE = 0;
 /// Ongoing position smoothing.
 static const unsigned SMOOTH_POSITION = 1;
 /// Ongoing rotation smoothing.
 static const unsigned SMOOTH_ROTATION = 2;
+/// Maximum number of buffered transform snapshots.
+static const unsigned MAX_TRANSFORM_SNAPSHOTS = 32;
+
+/// Network transform snapshot timestamped with a server network tick.
+struct TransformSnapshot
+{
+    /// Server network tick.
+    unsigned tick_;
+    /// Position in parent space.
+    Vector3 position_;
+    /// Rotation in parent space.
+    Quaternion rotation_;
+};
 
 /// Transform smoothing component for network updates.
 class URHO3D_API SmoothedTransform : public Component
 {
     OBJECT(SmoothedTransform);
     
+    friend class Scene;
+    
 public:
     /// Construct.
     SmoothedTransform(Context* context);
@@ -49,6 +66,12 @@ public:
     
     /// Update smoothing.
     void Update(float constant, float squaredSnapThreshold);
+    /// Update snapshot interpolation. Render tick and maximum extrapolation are measured in server network ticks.
+    void UpdateSnapshots(double renderTick, float maxExtrapolation, float squaredSnapThreshold);
+    /// Record the current target position and rotation as a snapshot at a server network tick.
+    void AddSnapshot(unsigned tick);
+    /// Remove all buffered snapshots.
+    void ClearSnapshots();
     /// Set target position in parent space.
     void SetTargetPosition(const Vector3& position);
     /// Set target rotation in parent space.
@@ -67,24 +90,34 @@ public:
     /// Return target rotation in world space.
     Quaternion GetTargetWorldRotation() const;
     /// Return whether smoothing is in progress.
-    bool IsInProgress() const { return smoothingMask_ != 0; }
+    bool IsInProgress() const { return smoothingMask_ != 0 || !snapshots_.Empty(); }
+    /// Return number of buffered snapshots.
+    unsigned GetNumSnapshots() const { return snapshots_.Size(); }
+    /// Return buffered snapshots, sorted by tick.
+    const PODVector<TransformSnapshot>& GetSnapshots() const { return snapshots_; }
     
 protected:
     /// Handle scene node being assigned at creation.
     virtual void OnNodeSet(Node* node);
     
 private:
-    /// Handle smoothing update event.
-    void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Update either snapshot interpolation or smoothing. Called by Scene.
+    void UpdateSmoothing(float constant, float squaredSnapThreshold);
+    /// Add to the scene's smoothing update list if not yet added.
+    void SubscribeToSmoothing();
+    /// Remove from the scene's smoothing update list.
+    void UnsubscribeFromSmoothing();
     
+    /// Buffered snapshots sorted by tick.
+    PODVector<TransformSnapshot> snapshots_;
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
     /// Active smoothing operations bitmask.
     unsigned char smoothingMask_;
-    /// Subscribed to smoothing update event flag.
-    bool subscribed_;
+    /// Scene whose smoothing update list the component is in.
+    WeakPtr<Scene> smoothingScene_;
 };
 
 }
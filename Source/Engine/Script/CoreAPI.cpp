@@ -752,6 +752,16 @@ static void DestructAttributeInfo(AttributeInfo* ptr)
     ptr->~AttributeInfo();
 }
 
+static const String& AttributeInfoGetName(AttributeInfo* ptr)
+{
+    return ptr->name_;
+}
+
+static void AttributeInfoSetName(const String& name, AttributeInfo* ptr)
+{
+    ptr->name_ = name;
+}
+
 static CScriptArray* AttributeInfoGetEnumNames(AttributeInfo* ptr)
 {
     Vector<String> enumNames;
@@ -861,9 +871,10 @@ void RegisterObject(asIScriptEngine* engine)
     engine->RegisterObjectBehaviour("AttributeInfo", asBEHAVE_CONSTRUCT, "void f(const AttributeInfo&in)", asFUNCTION(ConstructAttributeInfoCopy), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectBehaviour("AttributeInfo", asBEHAVE_DESTRUCT, "void f()", asFUNCTION(DestructAttributeInfo), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("AttributeInfo", "AttributeInfo& opAssign(const AttributeInfo&in)", asMETHODPR(AttributeInfo, operator =, (const AttributeInfo&), AttributeInfo&), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AttributeInfo", "const String& get_name() const", asFUNCTION(AttributeInfoGetName), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("AttributeInfo", "void set_name(const String&in)", asFUNCTION(AttributeInfoSetName), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("AttributeInfo", "Array<String>@ get_enumNames() const", asFUNCTION(AttributeInfoGetEnumNames), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectProperty("AttributeInfo", "VariantType type", offsetof(AttributeInfo, type_));
-    engine->RegisterObjectProperty("AttributeInfo", "String name", offsetof(AttributeInfo, name_));
     engine->RegisterObjectProperty("AttributeInfo", "Variant defaultValue", offsetof(AttributeInfo, defaultValue_));
     engine->RegisterObjectProperty("AttributeInfo", "uint mode", offsetof(AttributeInfo, mode_));
 
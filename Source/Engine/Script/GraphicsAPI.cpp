@@ -291,6 +291,8 @@ static void RegisterRenderPath(asIScriptEngine* engine)
     engine->RegisterEnumValue("TextureUnit", "TU_DEPTHBUFFER", TU_DEPTHBUFFER);
     engine->RegisterEnumValue("TextureUnit", "TU_LIGHTBUFFER", TU_LIGHTBUFFER);
     engine->RegisterEnumValue("TextureUnit", "TU_VOLUMEMAP", TU_VOLUMEMAP);
+    engine->RegisterEnumValue("TextureUnit", "TU_SKINMATRICES", TU_SKINMATRICES);
+    engine->RegisterEnumValue("TextureUnit", "TU_LIGHTCLUSTERS", TU_LIGHTCLUSTERS);
     engine->RegisterEnumValue("TextureUnit", "MAX_MATERIAL_TEXTURE_UNITS", MAX_MATERIAL_TEXTURE_UNITS);
     engine->RegisterEnumValue("TextureUnit", "MAX_TEXTURE_UNITS", MAX_TEXTURE_UNITS);
     
@@ -336,6 +338,7 @@ static void RegisterRenderPath(asIScriptEngine* engine)
     engine->RegisterObjectProperty("RenderPathCommand", "bool useFogColor", offsetof(RenderPathCommand, useFogColor_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool markToStencil", offsetof(RenderPathCommand, markToStencil_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool vertexLights", offsetof(RenderPathCommand, vertexLights_));
+    engine->RegisterObjectProperty("RenderPathCommand", "bool clusteredLights", offsetof(RenderPathCommand, clusteredLights_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool useLitBase", offsetof(RenderPathCommand, useLitBase_));
     engine->RegisterObjectProperty("RenderPathCommand", "String vertexShaderName", offsetof(RenderPathCommand, vertexShaderName_));
     engine->RegisterObjectProperty("RenderPathCommand", "String pixelShaderName", offsetof(RenderPathCommand, pixelShaderName_));
@@ -1069,6 +1072,7 @@ static void RegisterParticleEmitter(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ParticleEmitter", "bool get_emitting() const", asMETHOD(ParticleEmitter, IsEmitting), asCALL_THISCALL);
     engine->RegisterObjectMethod("ParticleEmitter", "void set_numParticles(uint) const", asMETHOD(ParticleEmitter, SetNumParticles), asCALL_THISCALL);
     engine->RegisterObjectMethod("ParticleEmitter", "uint get_numParticles() const", asMETHOD(ParticleEmitter, GetNumParticles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ParticleEmitter", "uint get_numActiveParticles() const", asMETHOD(ParticleEmitter, GetNumActiveParticles), asCALL_THISCALL);
     engine->RegisterObjectMethod("ParticleEmitter", "void set_emissionRate(float)", asMETHOD(ParticleEmitter, SetEmissionRate), asCALL_THISCALL);
     engine->RegisterObjectMethod("ParticleEmitter", "void set_minEmissionRate(float)", asMETHOD(ParticleEmitter, SetMinEmissionRate), asCALL_THISCALL);
     engine->RegisterObjectMethod("ParticleEmitter", "void set_maxEmissionRate(float)", asMETHOD(ParticleEmitter, SetMaxEmissionRate), asCALL_THISCALL);
@@ -1182,6 +1186,16 @@ static void RegisterTerrain(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Terrain", "bool get_smoothing() const", asMETHOD(Terrain, GetSmoothing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_heightMap(Image@+)", asMETHOD(Terrain, SetHeightMap), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "Image@+ get_heightMap() const", asMETHOD(Terrain, GetHeightMap), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void SetPagedHeightMap(const String&in, const IntVector2&in, int)", asMETHOD(Terrain, SetPagedHeightMap), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "bool get_paged() const", asMETHOD(Terrain, IsPaged), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "const String& get_pageNamePattern() const", asMETHOD(Terrain, GetPageNamePattern), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "const IntVector2& get_numPages() const", asMETHOD(Terrain, GetNumPages), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "int get_pageSize() const", asMETHOD(Terrain, GetPageSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void set_pageLoadDistance(float)", asMETHOD(Terrain, SetPageLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "float get_pageLoadDistance() const", asMETHOD(Terrain, GetPageLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void set_maxPages(uint)", asMETHOD(Terrain, SetMaxPages), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "uint get_maxPages() const", asMETHOD(Terrain, GetMaxPages), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "uint get_numResidentPages() const", asMETHOD(Terrain, GetNumResidentPages), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_patchSize(int)", asMETHOD(Terrain, SetPatchSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "int get_patchSize() const", asMETHOD(Terrain, GetPatchSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_spacing(const Vector3&in)", asMETHOD(Terrain, SetSpacing), asCALL_THISCALL);
@@ -1346,6 +1360,8 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "int get_maxShadowMaps() const", asMETHOD(Renderer, GetMaxShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_reuseShadowMaps(bool)", asMETHOD(Renderer, SetReuseShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "bool get_reuseShadowMaps() const", asMETHOD(Renderer, GetReuseShadowMaps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_cacheShadowMaps(bool)", asMETHOD(Renderer, SetCacheShadowMaps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_cacheShadowMaps() const", asMETHOD(Renderer, GetCacheShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_dynamicInstancing(bool)", asMETHOD(Renderer, SetDynamicInstancing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "bool get_dynamicInstancing() const", asMETHOD(Renderer, GetDynamicInstancing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_minInstances(int)", asMETHOD(Renderer, SetMinInstances), asCALL_THISCALL);
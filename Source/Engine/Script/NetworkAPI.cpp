@@ -24,6 +24,7 @@
 #include "APITemplates.h"
 #include "Controls.h"
 #include "HttpRequest.h"
+#include "LagCompensation.h"
 #include "Network.h"
 #include "NetworkPriority.h"
 #include "Protocol.h"
@@ -102,6 +103,8 @@ static void RegisterConnection(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Connection", "bool get_connected() const", asMETHOD(Connection, IsConnected), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "bool get_connectPending() const", asMETHOD(Connection, IsConnectPending), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "bool get_sceneLoaded() const", asMETHOD(Connection, IsSceneLoaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "float get_roundTripTime() const", asMETHOD(Connection, GetRoundTripTime), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "float get_interpolationDelay() const", asMETHOD(Connection, GetInterpolationDelay), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "String get_address() const", asMETHOD(Connection, GetAddress), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "uint16 get_port() const", asMETHOD(Connection, GetPort), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "uint get_numDownloads() const", asMETHOD(Connection, GetNumDownloads), asCALL_THISCALL);
@@ -116,6 +119,38 @@ static void RegisterConnection(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Node", "Connection@+ get_owner() const", asMETHOD(Node, GetOwner), asCALL_THISCALL);
 }
 
+static CScriptArray* LagCompensationRaycast(const Ray& ray, Connection* connection, RayQueryLevel level, float maxDistance, unsigned viewMask, LagCompensation* ptr)
+{
+    PODVector<RayQueryResult> result;
+    ptr->Raycast(result, ray, connection, level, maxDistance, viewMask);
+    return VectorToArray<RayQueryResult>(result, "Array<RayQueryResult>");
+}
+
+static CScriptArray* LagCompensationRaycastAtTick(const Ray& ray, double tick, RayQueryLevel level, float maxDistance, unsigned viewMask, LagCompensation* ptr)
+{
+    PODVector<RayQueryResult> result;
+    ptr->RaycastAtTick(result, ray, tick, level, maxDistance, viewMask);
+    return VectorToArray<RayQueryResult>(result, "Array<RayQueryResult>");
+}
+
+static void RegisterLagCompensation(asIScriptEngine* engine)
+{
+    RegisterComponent<LagCompensation>(engine, "LagCompensation");
+    engine->RegisterObjectMethod("LagCompensation", "void AddNode(Node@+)", asMETHOD(LagCompensation, AddNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "void RemoveNode(Node@+)", asMETHOD(LagCompensation, RemoveNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "void RemoveAllNodes()", asMETHOD(LagCompensation, RemoveAllNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "bool HasNode(Node@+) const", asMETHOD(LagCompensation, HasNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "double GetRewindTick(Connection@+) const", asMETHOD(LagCompensation, GetRewindTick), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "Array<RayQueryResult>@ Raycast(const Ray&in, Connection@+, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, uint viewMask = DEFAULT_VIEWMASK) const", asFUNCTION(LagCompensationRaycast), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("LagCompensation", "Array<RayQueryResult>@ RaycastAtTick(const Ray&in, double, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, uint viewMask = DEFAULT_VIEWMASK) const", asFUNCTION(LagCompensationRaycastAtTick), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("LagCompensation", "void set_historySize(uint)", asMETHOD(LagCompensation, SetHistorySize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "uint get_historySize() const", asMETHOD(LagCompensation, GetHistorySize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "void set_maxRewind(float)", asMETHOD(LagCompensation, SetMaxRewind), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "float get_maxRewind() const", asMETHOD(LagCompensation, GetMaxRewind), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "uint get_numNodes() const", asMETHOD(LagCompensation, GetNumNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LagCompensation", "uint get_latestTick() const", asMETHOD(LagCompensation, GetLatestTick), asCALL_THISCALL);
+}
+
 static void RegisterHttpRequest(asIScriptEngine* engine)
 {
     engine->RegisterEnum("HttpRequestState");
@@ -203,6 +238,7 @@ void RegisterNetwork(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Network", "HttpRequest@ MakeHttpRequest(const String&in, const String&in verb = String(), Array<String>@+ headers = null, const String&in postData = String())", asFUNCTION(NetworkMakeHttpRequest), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Network", "void set_updateFps(int)", asMETHOD(Network, SetUpdateFps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "int get_updateFps() const", asMETHOD(Network, GetUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "uint get_updateTick() const", asMETHOD(Network, GetUpdateTick), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_packageCacheDir(const String&in)", asMETHOD(Network, SetPackageCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "const String& get_packageCacheDir() const", asMETHOD(Network, GetPackageCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "bool get_serverRunning() const", asMETHOD(Network, IsServerRunning), asCALL_THISCALL);
@@ -216,6 +252,7 @@ void RegisterNetworkAPI(asIScriptEngine* engine)
     RegisterControls(engine);
     RegisterNetworkPriority(engine);
     RegisterConnection(engine);
+    RegisterLagCompensation(engine);
     RegisterHttpRequest(engine);
     RegisterNetwork(engine);
 }
@@ -276,7 +276,7 @@ void Script::DumpAPI(DumpMode mode)
                 if (attrs[j].mode_ & AM_NOEDIT)
                     continue;
                 // Prepend each word in the attribute name with % to prevent unintended links
-                Vector<String> nameParts = attrs[j].name_.Split(' ');
+                Vector<String> nameParts = attrs[j].name_.GetString().Split(' ');
                 for (unsigned k = 0; k < nameParts.Size(); ++k)
                 {
                     if (nameParts[k].Length() > 1 && IsAlpha(nameParts[k][0]))
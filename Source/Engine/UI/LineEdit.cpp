@@ -33,7 +33,7 @@
 namespace Urho3D
 {
 
-ShortStringHash VAR_DRAGDROPCONTENT("DragDropContent");
+ShortStringHash VAR_DRAGDROPCONTENT(ShortStringHash::CalculateLiteral("DragDropContent"));
 
 extern const char* UI_CATEGORY;
 
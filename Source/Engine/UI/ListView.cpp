@@ -49,7 +49,7 @@ template<> HighlightMode Variant::Get<HighlightMode>() const
     return (HighlightMode)GetInt();
 }
 
-static const ShortStringHash expandedHash("Expanded");
+static const ShortStringHash expandedHash(ShortStringHash::CalculateLiteral("Expanded"));
 
 extern const char* UI_CATEGORY;
 
@@ -63,7 +63,7 @@ void SetItemExpanded(UIElement* item, bool enable)
     item->SetVar(expandedHash, enable);
 }
 
-static const ShortStringHash hierarchyParentHash("HierarchyParent");
+static const ShortStringHash hierarchyParentHash(ShortStringHash::CalculateLiteral("HierarchyParent"));
 
 bool GetItemHierarchyParent(UIElement* item)
 {
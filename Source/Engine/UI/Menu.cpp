@@ -34,7 +34,7 @@
 namespace Urho3D
 {
 
-const ShortStringHash VAR_SHOW_POPUP("ShowPopup");
+const ShortStringHash VAR_SHOW_POPUP(ShortStringHash::CalculateLiteral("ShowPopup"));
 extern ShortStringHash VAR_ORIGIN;
 
 extern const char* UI_CATEGORY;
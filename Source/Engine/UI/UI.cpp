@@ -62,10 +62,10 @@
 namespace Urho3D
 {
 
-ShortStringHash VAR_ORIGIN("Origin");
-const ShortStringHash VAR_ORIGINAL_PARENT("OriginalParent");
-const ShortStringHash VAR_ORIGINAL_CHILD_INDEX("OriginalChildIndex");
-const ShortStringHash VAR_PARENT_CHANGED("ParentChanged");
+ShortStringHash VAR_ORIGIN(ShortStringHash::CalculateLiteral("Origin"));
+const ShortStringHash VAR_ORIGINAL_PARENT(ShortStringHash::CalculateLiteral("OriginalParent"));
+const ShortStringHash VAR_ORIGINAL_CHILD_INDEX(ShortStringHash::CalculateLiteral("OriginalChildIndex"));
+const ShortStringHash VAR_PARENT_CHANGED(ShortStringHash::CalculateLiteral("ParentChanged"));
 
 const float DEFAULT_DOUBLECLICK_INTERVAL = 0.5f;
 const float DEFAULT_DRAGBEGIN_INTERVAL = 0.5f;
@@ -1452,7 +1452,7 @@ void UI::HandleDropFile(StringHash eventType, VariantMap& eventData)
 
         using namespace UIDropFile;
 
-        VariantMap uiEventData;
+        InlineVariantMap<6> uiEventData;
         uiEventData[P_FILENAME] = eventData[P_FILENAME];
         uiEventData[P_X] = screenPos.x_;
         uiEventData[P_Y] = screenPos.y_;
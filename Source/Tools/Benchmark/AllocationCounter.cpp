@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Atomic.h"
+
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <new>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define THROW_BAD_ALLOC
+#define THROW_NOTHING noexcept
+#else
+#define THROW_BAD_ALLOC throw(std::bad_alloc)
+#define THROW_NOTHING throw()
+#endif
+
+// Replace the global allocation functions to count heap allocations. DebugNew.h is not included on purpose, as the
+// counting must apply to all allocations made by the engine
+static volatile int numHeapAllocations = 0;
+
+unsigned GetNumHeapAllocations()
+{
+    return (unsigned)AtomicLoad(&numHeapAllocations);
+}
+
+static void* CountedAllocate(size_t size)
+{
+    AtomicAdd(&numHeapAllocations, 1);
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size) THROW_BAD_ALLOC
+{
+    return CountedAllocate(size);
+}
+
+void* operator new[](size_t size) THROW_BAD_ALLOC
+{
+    return CountedAllocate(size);
+}
+
+void operator delete(void* ptr) THROW_NOTHING
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) THROW_NOTHING
+{
+    free(ptr);
+}
@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Batch.h"
+#include "FileSystem.h"
+#include "Geometry.h"
+#include "Material.h"
+#include "ProcessUtils.h"
+#include "ResourceCache.h"
+#include "Sort.h"
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+static bool CompareBatchesState(Batch* lhs, Batch* rhs)
+{
+    if (lhs->sortKey_ != rhs->sortKey_)
+        return lhs->sortKey_ < rhs->sortKey_;
+    else
+        return lhs->distance_ < rhs->distance_;
+}
+
+static bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+{
+    if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ < rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+void RunBatchSortBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numBatches = Max(GetIntOption(arguments, "-batches", 100000), 1);
+    unsigned numMaterials = Max(GetIntOption(arguments, "-materials", 100), 1);
+    unsigned numGeometries = Max(GetIntOption(arguments, "-geometries", 100), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 20), 1);
+
+    PrintLine("Batch sort: " + String(numBatches) + " batches, " + String(numMaterials) + " materials, " +
+        String(numGeometries) + " geometries, " + String(iterations) + " iterations");
+
+    // Materials look up their default technique from the resource cache
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+
+    Vector<SharedPtr<Material> > materials;
+    for (unsigned i = 0; i < numMaterials; ++i)
+        materials.Push(SharedPtr<Material>(new Material(context)));
+    Vector<SharedPtr<Geometry> > geometries;
+    for (unsigned i = 0; i < numGeometries; ++i)
+        geometries.Push(SharedPtr<Geometry>(new Geometry(context)));
+
+    SetRandomSeed(1);
+    BatchQueue queue;
+    queue.Clear(0);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch batch;
+        batch.distance_ = Random(1000.0f);
+        batch.geometry_ = geometries[Rand() % numGeometries];
+        batch.material_ = materials[Rand() % numMaterials];
+        batch.pass_ = 0;
+        batch.vertexShader_ = 0;
+        batch.pixelShader_ = 0;
+        batch.isBase_ = (Rand() & 1) != 0;
+        batch.CalculateSortKey();
+        queue.batches_.Push(batch);
+    }
+
+    // Reference: the previous comparison sorts by distance and then by state
+    PODVector<Batch*> sorted(numBatches);
+    HiresTimer timer;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numBatches; ++j)
+            sorted[j] = &queue.batches_[j];
+        Sort(sorted.Begin(), sorted.End(), CompareBatchesFrontToBack);
+        Sort(sorted.Begin(), sorted.End(), CompareBatchesState);
+    }
+    PrintResult("Comparison sort", timer.GetUSec(true) / iterations, numBatches);
+
+    // The first sort allocates the sort buffers
+    queue.SortFrontToBack();
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+        queue.SortFrontToBack();
+    PrintResult("Front to back", timer.GetUSec(true) / iterations, numBatches);
+
+    queue.SortBackToFront();
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+        queue.SortBackToFront();
+    PrintResult("Back to front", timer.GetUSec(true) / iterations, numBatches);
+}
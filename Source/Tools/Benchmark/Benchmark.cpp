@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include "Benchmark.h"
+
+#include <cstdio>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "DebugNew.h"
+
+/// Registered benchmark.
+struct BenchmarkInfo
+{
+    /// Name given on the command line.
+    const char* name_;
+    /// Entry point.
+    BenchmarkFunction function_;
+    /// Description for the usage text.
+    const char* description_;
+};
+
+static const BenchmarkInfo benchmarks[] =
+{
+    { "events", RunEventBenchmark, "Event dispatch to many receivers. Options: -receivers <num> -iterations <num>" },
+    { "logic", RunLogicBenchmark, "Scene update of logic components and smoothed transforms. Options: -components <num> -frames <num> -threads <num>" },
+    { "batchsort", RunBatchSortBenchmark, "Batch queue state and distance sorting. Options: -batches <num> -materials <num> -geometries <num> -iterations <num>" },
+    { "render", RunRenderBenchmark, "Scene rendering with per-stage timings. Options: -objects <num> -lights <num> -frames <num> -threads <num> -shadows <0|1> -cacheshadows <0|1> -moving <num> -renderpath <file>" },
+    { "terrain", RunTerrainBenchmark, "Terrain geometry creation from a generated heightmap. Options: -size <num> -patchsize <num> -iterations <num> -threads <num>" },
+    { "particles", RunParticleBenchmark, "Particle emitter simulation and vertex buffer update. Options: -emitters <num> -particles <num> -frames <num> -threads <num> -sorted <0|1>" },
+    { "log", RunLogBenchmark, "Logging from one or more threads to the log file. Options: -messages <num> -threads <num> -file <name>" },
+    { "containers", RunContainerBenchmark, "Hash map and hash set operations with chained and flat storage. Options: -elements <num> -iterations <num>" },
+    { "strings", RunStringBenchmark, "Name string copies, resource requests, scene load from XML and attribute access. Options: -objects <num> -iterations <num>" },
+    { "scene", RunSceneBenchmark, "Scene save and load in the XML, binary and flat binary formats. Options: -objects <num> -iterations <num>" },
+    { "refcount", RunRefCountBenchmark, "Shared and weak pointer copies and plain versus atomic reference counts. Options: -objects <num> -iterations <num>" },
+    { "prefab", RunPrefabBenchmark, "Object instantiation from binary, XML, flat binary and prefab resource. Options: -instances <num> -iterations <num>" },
+    { 0, 0, 0 }
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    const BenchmarkInfo* benchmark = 0;
+    if (arguments.Size())
+    {
+        for (const BenchmarkInfo* info = benchmarks; info->name_; ++info)
+        {
+            if (!arguments[0].Compare(info->name_, false))
+            {
+                benchmark = info;
+                break;
+            }
+        }
+    }
+
+    if (!benchmark)
+    {
+        String usage = "Usage: Benchmark <name> [options]\n\nAvailable benchmarks:\n";
+        for (const BenchmarkInfo* info = benchmarks; info->name_; ++info)
+            usage += String(info->name_) + ": " + String(info->description_) + "\n";
+        ErrorExit(usage);
+    }
+
+    Vector<String> options;
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+        options.Push(arguments[i]);
+
+    // The Time subsystem initializes the high-resolution timer
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    benchmark->function_(context, options);
+}
+
+int GetIntOption(const Vector<String>& arguments, const String& name, int defaultValue)
+{
+    for (unsigned i = 0; i + 1 < arguments.Size(); ++i)
+    {
+        if (!arguments[i].Compare(name, false))
+            return ToInt(arguments[i + 1]);
+    }
+
+    return defaultValue;
+}
+
+String GetStringOption(const Vector<String>& arguments, const String& name, const String& defaultValue)
+{
+    for (unsigned i = 0; i + 1 < arguments.Size(); ++i)
+    {
+        if (!arguments[i].Compare(name, false))
+            return arguments[i + 1];
+    }
+
+    return defaultValue;
+}
+
+void PrintResult(const String& name, long long usec, unsigned operations)
+{
+    char buffer[256];
+    if (operations && usec > 0)
+    {
+        sprintf(buffer, "%s: %.3f ms (%.0f /sec)", name.CString(), (double)usec / 1000.0, (double)operations * 1000000.0 /
+            (double)usec);
+    }
+    else
+        sprintf(buffer, "%s: %.3f ms", name.CString(), (double)usec / 1000.0);
+    PrintLine(buffer);
+}
@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Context.h"
+
+using namespace Urho3D;
+
+/// Benchmark entry point. Receives the command line arguments following the benchmark name.
+typedef void (*BenchmarkFunction)(Context* context, const Vector<String>& arguments);
+
+/// Return an integer option value from the command line, or the default if not specified.
+int GetIntOption(const Vector<String>& arguments, const String& name, int defaultValue);
+/// Return a string option value from the command line, or the default if not specified.
+String GetStringOption(const Vector<String>& arguments, const String& name, const String& defaultValue);
+/// Print a timing result. Operations per second are printed if the operation count is nonzero.
+void PrintResult(const String& name, long long usec, unsigned operations = 0);
+/// Return the number of heap allocations made through operator new since the program started.
+unsigned GetNumHeapAllocations();
+
+/// Event dispatch benchmark.
+void RunEventBenchmark(Context* context, const Vector<String>& arguments);
+/// Logic component and smoothed transform update benchmark.
+void RunLogicBenchmark(Context* context, const Vector<String>& arguments);
+/// Batch queue sorting benchmark.
+void RunBatchSortBenchmark(Context* context, const Vector<String>& arguments);
+/// Scene rendering benchmark with per-stage timings.
+void RunRenderBenchmark(Context* context, const Vector<String>& arguments);
+/// Terrain geometry creation benchmark.
+void RunTerrainBenchmark(Context* context, const Vector<String>& arguments);
+/// Particle emitter simulation and vertex buffer update benchmark.
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments);
+/// Logging throughput benchmark.
+void RunLogBenchmark(Context* context, const Vector<String>& arguments);
+/// Hash map and hash set operation benchmark.
+void RunContainerBenchmark(Context* context, const Vector<String>& arguments);
+/// String copy, resource request and scene load benchmark.
+void RunStringBenchmark(Context* context, const Vector<String>& arguments);
+/// Scene save and load benchmark.
+void RunSceneBenchmark(Context* context, const Vector<String>& arguments);
+/// Shared and weak pointer reference counting benchmark.
+void RunRefCountBenchmark(Context* context, const Vector<String>& arguments);
+/// Prefab instancing benchmark.
+void RunPrefabBenchmark(Context* context, const Vector<String>& arguments);
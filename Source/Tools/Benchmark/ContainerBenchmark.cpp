@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "FlatHashMap.h"
+#include "FlatHashSet.h"
+#include "HashMap.h"
+#include "HashSet.h"
+#include "MathDefs.h"
+#include "ProcessUtils.h"
+#include "Random.h"
+#include "StringHash.h"
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+/// Object with a typical size for the pointer set benchmark.
+struct BenchmarkObject
+{
+    /// Object data.
+    unsigned char data_[64];
+};
+
+/// Run the map operations for one map type and key set.
+template <class T, class U> void RunMapBenchmark(const String& name, const PODVector<T>& keys, const PODVector<T>& missingKeys,
+    unsigned iterations)
+{
+    unsigned numKeys = keys.Size();
+    unsigned sum = 0;
+
+    // Look up the keys in random order
+    PODVector<T> lookupKeys(keys);
+    PODVector<T> lookupMissingKeys(missingKeys);
+    SetRandomSeed(1);
+    for (unsigned i = numKeys - 1; i > 0; --i)
+    {
+        Swap(lookupKeys[i], lookupKeys[Rand() % (i + 1)]);
+        Swap(lookupMissingKeys[i], lookupMissingKeys[Rand() % (i + 1)]);
+    }
+
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        U map;
+        for (unsigned j = 0; j < numKeys; ++j)
+            map[keys[j]] = j;
+        sum += map.Size();
+    }
+    PrintResult(name + " insert", timer.GetUSec(true), numKeys * iterations);
+
+    U map;
+    for (unsigned j = 0; j < numKeys; ++j)
+        map[keys[j]] = j;
+
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numKeys; ++j)
+        {
+            typename U::ConstIterator k = map.Find(lookupKeys[j]);
+            if (k != map.End())
+                sum += k->second_;
+        }
+    }
+    PrintResult(name + " find", timer.GetUSec(true), numKeys * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numKeys; ++j)
+            sum += map.Contains(lookupMissingKeys[j]) ? 1 : 0;
+    }
+    PrintResult(name + " find missing", timer.GetUSec(true), numKeys * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (typename U::ConstIterator k = map.Begin(); k != map.End(); ++k)
+            sum += k->second_;
+    }
+    PrintResult(name + " iterate", timer.GetUSec(true), numKeys * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        U copy(map);
+        for (unsigned j = 0; j < numKeys; ++j)
+            copy.Erase(keys[j]);
+        sum += copy.Size();
+    }
+    PrintResult(name + " copy and erase", timer.GetUSec(true), numKeys * iterations);
+
+    // Use the result so that the loops are not optimized away
+    if (sum == M_MAX_UNSIGNED)
+        PrintLine("");
+}
+
+/// Run the set insert and lookup pattern of event sending, where a new set is filled and queried once.
+template <class T> void RunSetBenchmark(const String& name, const PODVector<BenchmarkObject*>& pointers, unsigned iterations)
+{
+    unsigned numPointers = pointers.Size();
+    unsigned sum = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        T set;
+        for (unsigned j = 0; j < numPointers; j += 2)
+            set.Insert(pointers[j]);
+        for (unsigned j = 0; j < numPointers; ++j)
+            sum += set.Contains(pointers[j]) ? 1 : 0;
+    }
+    PrintResult(name + " fill and query", timer.GetUSec(true), numPointers * iterations);
+
+    if (sum == M_MAX_UNSIGNED)
+        PrintLine("");
+}
+
+void RunContainerBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numElements = Max(GetIntOption(arguments, "-elements", 1000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 1000), 1);
+
+    PrintLine("Containers: " + String(numElements) + " elements, " + String(iterations) + " iterations");
+
+    // Sequential IDs, like scene nodes and components
+    PODVector<unsigned> ids(numElements);
+    PODVector<unsigned> missingIds(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+    {
+        ids[i] = i + 1;
+        missingIds[i] = numElements + i + 1;
+    }
+    RunMapBenchmark<unsigned, HashMap<unsigned, unsigned> >("HashMap<unsigned>", ids, missingIds, iterations);
+    RunMapBenchmark<unsigned, FlatHashMap<unsigned, unsigned> >("FlatHashMap<unsigned>", ids, missingIds, iterations);
+
+    // Name hashes, like event types
+    PODVector<StringHash> hashes(numElements);
+    PODVector<StringHash> missingHashes(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+    {
+        hashes[i] = StringHash("Event" + String(i));
+        missingHashes[i] = StringHash("Missing" + String(i));
+    }
+    RunMapBenchmark<StringHash, HashMap<StringHash, unsigned> >("HashMap<StringHash>", hashes, missingHashes, iterations);
+    RunMapBenchmark<StringHash, FlatHashMap<StringHash, unsigned> >("FlatHashMap<StringHash>", hashes, missingHashes,
+        iterations);
+
+    // Object pointers, like the event receivers already processed during an event send
+    PODVector<BenchmarkObject> objects(numElements);
+    PODVector<BenchmarkObject*> pointers(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+        pointers[i] = &objects[i];
+    RunSetBenchmark<HashSet<BenchmarkObject*> >("HashSet<Object*>", pointers, iterations);
+    RunSetBenchmark<FlatHashSet<BenchmarkObject*> >("FlatHashSet<Object*>", pointers, iterations);
+}
@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ProcessUtils.h"
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+EVENT(E_BENCHMARKEVENT, BenchmarkEvent)
+{
+    PARAM(P_VALUE, Value);                  // int
+}
+
+EVENT(E_BENCHMARKPARAMETERS, BenchmarkParameters)
+{
+    PARAM(P_X, X);                          // int
+    PARAM(P_Y, Y);                          // int
+    PARAM(P_BUTTONS, Buttons);              // int
+    PARAM(P_QUALIFIERS, Qualifiers);        // int
+    PARAM(P_ELEMENT, Element);              // void ptr
+    PARAM(P_NAME, Name);                    // String
+}
+
+/// Fill event parameters like an input or UI event, then read them back like a handler. Return the sum of the integer parameters.
+static int FillAndReadParameters(VariantMap& eventData, int value)
+{
+    using namespace BenchmarkParameters;
+
+    eventData[P_X] = value;
+    eventData[P_Y] = value;
+    eventData[P_BUTTONS] = value;
+    eventData[P_QUALIFIERS] = value;
+    eventData[P_ELEMENT] = (void*)0;
+    eventData[P_NAME] = "Button";
+
+    return eventData[P_X].GetInt() + eventData[P_Y].GetInt() + eventData[P_BUTTONS].GetInt() +
+        eventData[P_QUALIFIERS].GetInt() + (int)eventData[P_NAME].GetString().Length();
+}
+
+/// Event receiver which accumulates the received values.
+class BenchmarkReceiver : public Object
+{
+    OBJECT(BenchmarkReceiver);
+
+public:
+    /// Construct.
+    BenchmarkReceiver(Context* context) :
+        Object(context),
+        sum_(0),
+        unsubscribe_(false)
+    {
+    }
+
+    /// Subscribe to the benchmark event from any sender.
+    void Subscribe() { SubscribeToEvent(E_BENCHMARKEVENT, HANDLER(BenchmarkReceiver, HandleBenchmarkEvent)); }
+    /// Subscribe to the benchmark event from a specific sender.
+    void Subscribe(Object* sender) { SubscribeToEvent(sender, E_BENCHMARKEVENT, HANDLER(BenchmarkReceiver, HandleBenchmarkEvent)); }
+
+    /// Handle the benchmark event.
+    void HandleBenchmarkEvent(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace BenchmarkEvent;
+
+        sum_ += eventData[P_VALUE].GetInt();
+        if (unsubscribe_)
+            UnsubscribeFromEvent(eventType);
+    }
+
+    /// Accumulated value.
+    int sum_;
+    /// Unsubscribe on receiving the event flag.
+    bool unsubscribe_;
+};
+
+/// Event sender.
+class BenchmarkSender : public Object
+{
+    OBJECT(BenchmarkSender);
+
+public:
+    /// Construct.
+    BenchmarkSender(Context* context) :
+        Object(context)
+    {
+    }
+
+    /// Send the benchmark event.
+    void Send(int value)
+    {
+        using namespace BenchmarkEvent;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_VALUE] = value;
+        SendEvent(E_BENCHMARKEVENT, eventData);
+    }
+};
+
+void RunEventBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numReceivers = Max(GetIntOption(arguments, "-receivers", 10000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 100), 1);
+
+    PrintLine("Event dispatch: " + String(numReceivers) + " receivers, " + String(iterations) + " iterations");
+
+    SharedPtr<BenchmarkSender> sender(new BenchmarkSender(context));
+    Vector<SharedPtr<BenchmarkReceiver> > receivers;
+    receivers.Resize(numReceivers);
+    for (unsigned i = 0; i < numReceivers; ++i)
+        receivers[i] = new BenchmarkReceiver(context);
+
+    HiresTimer timer;
+
+    // Non-specific events
+    for (unsigned i = 0; i < numReceivers; ++i)
+        receivers[i]->Subscribe();
+    PrintResult("Subscribe", timer.GetUSec(true), numReceivers);
+
+    for (unsigned i = 0; i < iterations; ++i)
+        sender->Send(1);
+    PrintResult("Send to all receivers", timer.GetUSec(true), numReceivers * iterations);
+
+    // Every other receiver unsubscribes while the event is being sent
+    for (unsigned i = 0; i < numReceivers; i += 2)
+        receivers[i]->unsubscribe_ = true;
+    timer.Reset();
+    sender->Send(1);
+    PrintResult("Send with unsubscribes", timer.GetUSec(true), numReceivers);
+
+    for (unsigned i = 0; i < numReceivers; ++i)
+        receivers[i]->UnsubscribeFromEvent(E_BENCHMARKEVENT);
+    PrintResult("Unsubscribe", timer.GetUSec(true), numReceivers);
+
+    // Events from a specific sender
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        receivers[i]->unsubscribe_ = false;
+        receivers[i]->Subscribe(sender);
+    }
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+        sender->Send(1);
+    PrintResult("Send to specific receivers", timer.GetUSec(true), numReceivers * iterations);
+
+    // Verify that each receiver got the expected events
+    int expected = iterations * 2 + 1;
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        if (receivers[i]->sum_ != expected)
+            ErrorExit("Receiver " + String(i) + " received " + String(receivers[i]->sum_) + " events, expected " +
+                String(expected));
+    }
+
+    receivers.Clear();
+    PrintResult("Destroy receivers", timer.GetUSec(true), numReceivers);
+
+    // Event parameter maps filled per send, as in local event data instead of GetEventDataMap()
+    unsigned numMaps = numReceivers * iterations;
+    int sum = 0;
+    unsigned allocations = GetNumHeapAllocations();
+    timer.Reset();
+    for (unsigned i = 0; i < numMaps; ++i)
+    {
+        VariantMap eventData;
+        sum += FillAndReadParameters(eventData, 1);
+    }
+    PrintResult("Parameter map", timer.GetUSec(true), numMaps);
+    PrintLine("Heap allocations per map: " + String((float)(GetNumHeapAllocations() - allocations) / numMaps));
+
+    allocations = GetNumHeapAllocations();
+    timer.Reset();
+    for (unsigned i = 0; i < numMaps; ++i)
+    {
+        InlineVariantMap<6> eventData;
+        sum += FillAndReadParameters(eventData, 1);
+    }
+    PrintResult("Inline parameter map", timer.GetUSec(true), numMaps);
+    PrintLine("Heap allocations per map: " + String((float)(GetNumHeapAllocations() - allocations) / numMaps));
+
+    if (sum != (int)numMaps * 20)
+        ErrorExit("Parameter maps returned " + String(sum) + ", expected " + String(numMaps * 20));
+}
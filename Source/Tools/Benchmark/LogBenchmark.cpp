@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "FileSystem.h"
+#include "IOEvents.h"
+#include "Log.h"
+#include "ProcessUtils.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+/// Thread which writes log messages.
+class LogWriterThread : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    LogWriterThread(unsigned index, unsigned numMessages) :
+        index_(index),
+        numMessages_(numMessages)
+    {
+    }
+
+    /// Write the messages.
+    virtual void ThreadFunction()
+    {
+        for (unsigned i = 0; i < numMessages_; ++i)
+            LOGINFO("Benchmark message " + String(i) + " from thread " + String(index_));
+    }
+
+private:
+    /// Thread index.
+    unsigned index_;
+    /// Number of messages to write.
+    unsigned numMessages_;
+};
+
+/// Log message event receiver which counts the received messages.
+class LogMessageCounter : public Object
+{
+    OBJECT(LogMessageCounter);
+
+public:
+    /// Construct and subscribe to the log message event.
+    LogMessageCounter(Context* context) :
+        Object(context),
+        count_(0)
+    {
+        SubscribeToEvent(E_LOGMESSAGE, HANDLER(LogMessageCounter, HandleLogMessage));
+    }
+
+    /// Handle the log message event.
+    void HandleLogMessage(StringHash eventType, VariantMap& eventData) { ++count_; }
+
+    /// Received message count.
+    unsigned count_;
+};
+
+void RunLogBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numMessages = Max(GetIntOption(arguments, "-messages", 100000), 1);
+    unsigned numThreads = Max(GetIntOption(arguments, "-threads", 1), 0);
+    String fileName = GetStringOption(arguments, "-file", "Benchmark.log");
+
+    PrintLine("Log: " + String(numMessages) + " messages, " + String(numThreads) + " writing threads, log file " + fileName);
+
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new Log(context));
+    Log* log = context->GetSubsystem<Log>();
+    log->SetQuiet(true);
+    log->Open(fileName);
+    log->Flush();
+
+    SharedPtr<LogMessageCounter> counter(new LogMessageCounter(context));
+
+    HiresTimer timer;
+    if (!numThreads)
+    {
+        for (unsigned i = 0; i < numMessages; ++i)
+            LOGINFO("Benchmark message " + String(i) + " from thread 0");
+    }
+    else
+    {
+        Vector<SharedPtr<LogWriterThread> > threads;
+        unsigned messagesPerThread = (numMessages + numThreads - 1) / numThreads;
+        numMessages = messagesPerThread * numThreads;
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads.Push(SharedPtr<LogWriterThread>(new LogWriterThread(i, messagesPerThread)));
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Run();
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Stop();
+    }
+    PrintResult("Write", timer.GetUSec(false), numMessages);
+
+    log->Flush();
+    PrintResult("Write and flush", timer.GetUSec(true), numMessages);
+
+    // Without a frame loop, the log keeps only the latest messages for the events
+    PrintLine("Received " + String(counter->count_) + " log message events");
+
+    log->Close();
+    context->GetSubsystem<FileSystem>()->Delete(fileName);
+}
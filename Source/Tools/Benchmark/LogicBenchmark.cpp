@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "LogicComponent.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "SmoothedTransform.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+/// Logic component that rotates its node.
+class BenchmarkRotator : public LogicComponent
+{
+    OBJECT(BenchmarkRotator);
+
+public:
+    /// Construct.
+    BenchmarkRotator(Context* context) :
+        LogicComponent(context)
+    {
+        SetUpdateEventMask(USE_UPDATE);
+    }
+
+    /// Rotate the node.
+    virtual void Update(float timeStep)
+    {
+        node_->Yaw(90.0f * timeStep);
+    }
+};
+
+void RunLogicBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numComponents = Max(GetIntOption(arguments, "-components", 50000), 1);
+    unsigned frames = Max(GetIntOption(arguments, "-frames", 100), 1);
+    unsigned numThreads = Max(GetIntOption(arguments, "-threads", GetNumPhysicalCPUs() - 1), 0);
+    const float timeStep = 1.0f / 60.0f;
+
+    PrintLine("Logic update: " + String(numComponents) + " components, " + String(frames) + " frames, " + String(numThreads) +
+        " worker threads");
+
+    RegisterSceneLibrary(context);
+    context->RegisterFactory<BenchmarkRotator>();
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    PODVector<BenchmarkRotator*> rotators;
+    PODVector<SmoothedTransform*> transforms;
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        Node* node = scene->CreateChild(String::EMPTY, LOCAL);
+        rotators.Push(node->CreateComponent<BenchmarkRotator>(LOCAL));
+        transforms.Push(node->CreateComponent<SmoothedTransform>(LOCAL));
+    }
+    PrintResult("Create", timer.GetUSec(true), numComponents);
+
+    // The first update calls DelayedStart() for all components
+    scene->Update(timeStep);
+    PrintResult("First update", timer.GetUSec(true), numComponents);
+
+    for (unsigned i = 0; i < frames; ++i)
+        scene->Update(timeStep);
+    PrintResult("Update", timer.GetUSec(true), numComponents * frames);
+
+    for (unsigned i = 0; i < numComponents; ++i)
+        rotators[i]->SetThreadedUpdate(true);
+    timer.Reset();
+    for (unsigned i = 0; i < frames; ++i)
+        scene->Update(timeStep);
+    PrintResult("Threaded update", timer.GetUSec(true), numComponents * frames);
+
+    for (unsigned i = 0; i < numComponents; ++i)
+        rotators[i]->SetEnabled(false);
+
+    // Retarget the smoothed transforms on each frame, so that they all stay in the smoothing update list
+    timer.Reset();
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        Vector3 target((float)(i & 1), 0.0f, 0.0f);
+        for (unsigned j = 0; j < numComponents; ++j)
+            transforms[j]->SetTargetPosition(target);
+        scene->Update(timeStep);
+    }
+    PrintResult("Smoothing update", timer.GetUSec(true), numComponents * frames);
+
+    scene.Reset();
+    PrintResult("Destroy", timer.GetUSec(true), numComponents);
+}
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Camera.h"
+#include "FileSystem.h"
+#include "Graphics.h"
+#include "Octree.h"
+#include "ParticleEmitter.h"
+#include "ProcessUtils.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Timer.h"
+#include "Viewport.h"
+#include "WorkQueue.h"
+#include "XMLFile.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numEmitters = Max(GetIntOption(arguments, "-emitters", 100), 1);
+    unsigned numParticles = Max(GetIntOption(arguments, "-particles", 1000), 1);
+    unsigned frames = Max(GetIntOption(arguments, "-frames", 300), 1);
+    unsigned numThreads = Max(GetIntOption(arguments, "-threads", GetNumPhysicalCPUs() - 1), 0);
+    bool sorted = GetIntOption(arguments, "-sorted", 0) != 0;
+    const float timeStep = 1.0f / 60.0f;
+    const float timeToLive = 2.0f;
+
+    PrintLine("Particles: " + String(numEmitters) + " emitters, " + String(numParticles) + " particles each, " + String(frames) +
+        " frames, " + String(numThreads) + " worker threads, sorting " + String(sorted ? "on" : "off"));
+    #ifndef URHO3D_NULL_GRAPHICS
+    PrintLine("Note: not built with the null graphics backend, timings include GPU driver overhead");
+    #endif
+
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    String programDir = context->GetSubsystem<FileSystem>()->GetProgramDir();
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->AddResourceDir(programDir + "CoreData") || !cache->AddResourceDir(programDir + "Data"))
+        ErrorExit("Could not find the CoreData and Data resource directories");
+
+    Graphics* graphics = context->GetSubsystem<Graphics>();
+    if (!graphics->SetMode(1280, 720, false, false, false, false, false, 1))
+        ErrorExit("Could not set screen mode");
+
+    XMLFile* effect = cache->GetResource<XMLFile>("Particle/Smoke.xml");
+    if (!effect)
+        ErrorExit("Could not load particle effect Particle/Smoke.xml");
+
+    HiresTimer timer;
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+
+    // Place the emitters on a square grid and have them emit continuously at full capacity
+    unsigned gridSize = (unsigned)sqrtf((float)numEmitters) + 1;
+    float halfExtent = (float)gridSize * 2.0f;
+    for (unsigned i = 0; i < numEmitters; ++i)
+    {
+        Node* node = scene->CreateChild(String::EMPTY, LOCAL);
+        node->SetPosition(Vector3(4.0f * (float)(i % gridSize) - halfExtent, 0.0f, 4.0f * (float)(i / gridSize) - halfExtent));
+        ParticleEmitter* emitter = node->CreateComponent<ParticleEmitter>(LOCAL);
+        emitter->Load(effect);
+        emitter->SetNumParticles(numParticles);
+        emitter->SetEmissionRate((float)numParticles / timeToLive);
+        emitter->SetTimeToLive(timeToLive);
+        emitter->SetActiveTime(0.0f);
+        emitter->SetDampingForce(0.5f);
+        emitter->SetSorted(sorted);
+    }
+
+    Node* cameraNode = scene->CreateChild(String::EMPTY, LOCAL);
+    cameraNode->SetPosition(Vector3(0.0f, halfExtent, -halfExtent * 1.5f));
+    cameraNode->LookAt(Vector3::ZERO);
+    Camera* camera = cameraNode->CreateComponent<Camera>(LOCAL);
+    camera->SetFarClip(halfExtent * 8.0f);
+    Renderer* renderer = context->GetSubsystem<Renderer>();
+    SharedPtr<Viewport> viewport(new Viewport(context, scene, camera));
+    renderer->SetViewport(0, viewport);
+    PrintResult("Create scene", timer.GetUSec(true), numEmitters);
+
+    // Run until the emitters have reached their full particle count before timing
+    unsigned warmupFrames = (unsigned)(timeToLive / timeStep) + 1;
+    long long updateTime = 0;
+    long long renderTime = 0;
+    Time* time = context->GetSubsystem<Time>();
+
+    for (unsigned i = 0; i < warmupFrames + frames; ++i)
+    {
+        if (i == warmupFrames)
+        {
+            updateTime = 0;
+            renderTime = 0;
+        }
+
+        time->BeginFrame(timeStep);
+
+        // The scene update marks the emitters for update, and the view update simulates them in the octree update
+        // and rewrites the vertex buffers of the visible ones
+        timer.Reset();
+        scene->Update(timeStep);
+        renderer->Update(timeStep);
+        updateTime += timer.GetUSec(true);
+
+        if (graphics->BeginFrame())
+        {
+            renderer->Render();
+            graphics->EndFrame();
+        }
+        renderTime += timer.GetUSec(true);
+
+        time->EndFrame();
+    }
+
+    unsigned long long liveParticles = 0;
+    PODVector<ParticleEmitter*> emitters;
+    scene->GetComponents<ParticleEmitter>(emitters, true);
+    for (unsigned i = 0; i < emitters.Size(); ++i)
+        liveParticles += emitters[i]->GetNumActiveParticles();
+
+    PrintLine("Live particles: " + String((unsigned)liveParticles));
+    PrintResult("Update particles", updateTime, frames);
+    PrintResult("Render", renderTime, frames);
+
+    timer.Reset();
+    renderer->SetViewport(0, 0);
+    viewport.Reset();
+    scene.Reset();
+    PrintResult("Destroy scene", timer.GetUSec(true), numEmitters);
+}
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "FileSystem.h"
+#include "FlatSceneFile.h"
+#include "Graphics.h"
+#include "Light.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "Prefab.h"
+#include "ProcessUtils.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "StaticModel.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
+#include "XMLFile.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+void RunPrefabBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numInstances = Max(GetIntOption(arguments, "-instances", 10000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 5), 1);
+
+    PrintLine("Prefab instancing: " + String(numInstances) + " instances, " + String(iterations) + " iterations");
+
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    String programDir = context->GetSubsystem<FileSystem>()->GetProgramDir();
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->AddResourceDir(programDir + "CoreData") || !cache->AddResourceDir(programDir + "Data"))
+        ErrorExit("Could not find the CoreData and Data resource directories");
+
+    // A small object: a model with an attached second model and a light
+    SharedPtr<Scene> scene(new Scene(context));
+    Node* object = scene->CreateChild("Object");
+    StaticModel* model = object->CreateComponent<StaticModel>();
+    model->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+    model->SetMaterial(cache->GetResource<Material>("Materials/Stone.xml"));
+    Node* turret = object->CreateChild("Turret");
+    turret->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+    turret->SetScale(0.5f);
+    StaticModel* turretModel = turret->CreateComponent<StaticModel>();
+    turretModel->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
+    turretModel->SetMaterial(cache->GetResource<Material>("Materials/Jack.xml"));
+    Node* lamp = object->CreateChild("Lamp");
+    lamp->SetPosition(Vector3(0.0f, 2.0f, 0.0f));
+    Light* light = lamp->CreateComponent<Light>();
+    light->SetRange(5.0f);
+
+    VectorBuffer binary;
+    object->Save(binary);
+    VectorBuffer xmlData;
+    object->SaveXML(xmlData);
+    VectorBuffer flatData;
+    object->SaveFlat(flatData);
+    unsigned numNodes = object->GetNumChildren(true) + 1;
+
+    HiresTimer timer;
+    SharedPtr<Prefab> prefab(new Prefab(context));
+    prefab->SetName("Object.xml");
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        xmlData.Seek(0);
+        if (!prefab->Load(xmlData))
+            ErrorExit("Could not load prefab");
+    }
+    PrintResult("Load prefab from XML", timer.GetUSec(true), iterations);
+    if (prefab->GetNumNodes() != numNodes)
+        ErrorExit("Prefab has " + String(prefab->GetNumNodes()) + " nodes, expected " + String(numNodes));
+
+    SharedPtr<FlatSceneFile> flatFile(new FlatSceneFile(context));
+    flatData.Seek(0);
+    if (!flatFile->Load(flatData))
+        ErrorExit("Could not load flat scene file");
+
+    const char* methodNames[] = { "Instantiate binary", "Instantiate XML", "Instantiate flat", "Instantiate prefab" };
+    const unsigned numMethods = sizeof(methodNames) / sizeof(methodNames[0]);
+    PODVector<unsigned char> reference;
+    for (unsigned method = 0; method < numMethods; ++method)
+    {
+        long long spawnTime = 0;
+        unsigned allocations = 0;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            // Start each round from an empty scene so that the instances get the same IDs. Clearing is not timed
+            scene->Clear();
+            scene->CreateComponent<Octree>();
+            unsigned startAllocations = GetNumHeapAllocations();
+            timer.Reset();
+            for (unsigned j = 0; j < numInstances; ++j)
+            {
+                Vector3 position((float)(j % 100) * 2.0f, 0.0f, (float)(j / 100) * 2.0f);
+                Quaternion rotation((float)j, Vector3::UP);
+                Node* node;
+                switch (method)
+                {
+                case 0:
+                    binary.Seek(0);
+                    node = scene->Instantiate(binary, position, rotation);
+                    break;
+
+                case 1:
+                    xmlData.Seek(0);
+                    node = scene->InstantiateXML(xmlData, position, rotation);
+                    break;
+
+                case 2:
+                    node = scene->InstantiateFlat(flatFile, position, rotation);
+                    break;
+
+                default:
+                    node = scene->Instantiate(prefab, position, rotation);
+                    break;
+                }
+                if (!node)
+                    ErrorExit(String(methodNames[method]) + " failed");
+            }
+            spawnTime += timer.GetUSec(false);
+            allocations += GetNumHeapAllocations() - startAllocations;
+        }
+
+        // All methods must produce the same scene
+        VectorBuffer saved;
+        scene->Save(saved);
+        if (!method)
+            reference = saved.GetBuffer();
+        else if (saved.GetBuffer() != reference)
+            ErrorExit(String(methodNames[method]) + " result differs from binary");
+
+        PrintResult(methodNames[method], spawnTime, numInstances * iterations);
+        PrintLine("Heap allocations per instance: " + String((float)allocations / (numInstances * iterations)));
+    }
+
+    PrintLine("Nodes per instance: " + String(numNodes));
+}
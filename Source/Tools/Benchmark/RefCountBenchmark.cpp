@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Atomic.h"
+#include "ProcessUtils.h"
+#include "Ptr.h"
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+void RunRefCountBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numObjects = Max(GetIntOption(arguments, "-objects", 10000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 1000), 1);
+
+    #ifdef URHO3D_THREADSAFE_REFCOUNT
+    PrintLine("Reference counting: " + String(numObjects) + " objects, " + String(iterations) + " iterations, atomic counts");
+    #else
+    PrintLine("Reference counting: " + String(numObjects) + " objects, " + String(iterations) + " iterations, non-atomic counts");
+    #endif
+
+    Vector<SharedPtr<RefCounted> > objects(numObjects);
+    for (unsigned i = 0; i < numObjects; ++i)
+        objects[i] = new RefCounted();
+    Vector<WeakPtr<RefCounted> > weakObjects(numObjects);
+    for (unsigned i = 0; i < numObjects; ++i)
+        weakObjects[i] = objects[i];
+
+    HiresTimer timer;
+    unsigned sum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Vector<SharedPtr<RefCounted> > copy(objects);
+        sum += copy.Back().Refs();
+    }
+    PrintResult("Copy shared pointers", timer.GetUSec(true), numObjects * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Vector<WeakPtr<RefCounted> > copy(weakObjects);
+        sum += copy.Back().WeakRefs();
+    }
+    PrintResult("Copy weak pointers", timer.GetUSec(true), numObjects * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numObjects; ++j)
+        {
+            SharedPtr<RefCounted> locked = weakObjects[j].Lock();
+            sum += locked.Refs();
+        }
+    }
+    PrintResult("Lock weak pointers", timer.GetUSec(true), numObjects * iterations);
+
+    // Compare the plain and atomic count operations directly, regardless of the build option
+    PODVector<int> counts(numObjects);
+    for (unsigned i = 0; i < numObjects; ++i)
+        counts[i] = 1;
+    volatile int* plainCounts = &counts[0];
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numObjects; ++j)
+            ++plainCounts[j];
+        for (unsigned j = 0; j < numObjects; ++j)
+        {
+            if (!--plainCounts[j])
+                ++sum;
+        }
+    }
+    PrintResult("Plain increment and decrement", timer.GetUSec(true), numObjects * iterations);
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numObjects; ++j)
+            AtomicAddRelaxed(&counts[j], 1);
+        for (unsigned j = 0; j < numObjects; ++j)
+        {
+            if (!AtomicAddAcquireRelease(&counts[j], -1))
+                ++sum;
+        }
+    }
+    PrintResult("Atomic increment and decrement", timer.GetUSec(true), numObjects * iterations);
+
+    weakObjects.Clear();
+    objects.Clear();
+    PrintResult("Destroy objects", timer.GetUSec(true), numObjects);
+
+    // Use the results so that the loops are not optimized away
+    if (sum == M_MAX_UNSIGNED)
+        PrintLine("");
+}
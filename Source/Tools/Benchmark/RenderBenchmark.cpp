@@ -0,0 +1,302 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Camera.h"
+#include "FileSystem.h"
+#include "Graphics.h"
+#include "Light.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "ProcessUtils.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "StaticModel.h"
+#include "Timer.h"
+#include "Viewport.h"
+#include "WorkQueue.h"
+#include "XMLFile.h"
+
+#include "Benchmark.h"
+
+#include <cstdio>
+
+#include "DebugNew.h"
+
+/// Accumulated Graphics statistics.
+struct RenderStats
+{
+    /// Construct with zero values.
+    RenderStats() :
+        batches_(0),
+        primitives_(0),
+        stateChanges_(0),
+        shaderChanges_(0),
+        parameterUpdates_(0),
+        textureChanges_(0),
+        bufferChanges_(0),
+        uploadBytes_(0)
+    {
+    }
+
+    /// Batches drawn.
+    unsigned long long batches_;
+    /// Primitives drawn.
+    unsigned long long primitives_;
+    /// Render state changes.
+    unsigned long long stateChanges_;
+    /// Shader changes.
+    unsigned long long shaderChanges_;
+    /// Shader parameter updates.
+    unsigned long long parameterUpdates_;
+    /// Texture changes.
+    unsigned long long textureChanges_;
+    /// Vertex and index buffer changes.
+    unsigned long long bufferChanges_;
+    /// Bytes uploaded to buffers and textures.
+    unsigned long long uploadBytes_;
+};
+
+static void PrintProfilerBlocks(const ProfilerBlock* block, unsigned frames, unsigned depth, unsigned maxDepth)
+{
+    for (unsigned i = 0; i < block->children_.Size(); ++i)
+    {
+        const ProfilerBlock* child = block->children_[i];
+        if (!child->intervalCount_)
+            continue;
+
+        String indent;
+        for (unsigned j = 0; j < depth; ++j)
+            indent += "  ";
+        PrintResult(indent + String(child->name_), child->intervalTime_ / frames);
+        if (depth + 1 < maxDepth)
+            PrintProfilerBlocks(child, frames, depth + 1, maxDepth);
+    }
+}
+
+static void PrintStat(const char* name, unsigned long long value, unsigned frames)
+{
+    char buffer[256];
+    sprintf(buffer, "%s: %.1f / frame", name, (double)value / (double)frames);
+    PrintLine(buffer);
+}
+
+void RunRenderBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numObjects = Max(GetIntOption(arguments, "-objects", 10000), 1);
+    unsigned numLights = Max(GetIntOption(arguments, "-lights", 8), 0);
+    unsigned frames = Max(GetIntOption(arguments, "-frames", 100), 1);
+    unsigned numThreads = Max(GetIntOption(arguments, "-threads", GetNumPhysicalCPUs() - 1), 0);
+    bool shadows = GetIntOption(arguments, "-shadows", 1) != 0;
+    bool cacheShadows = GetIntOption(arguments, "-cacheshadows", 0) != 0;
+    unsigned numMoving = Max(GetIntOption(arguments, "-moving", 0), 0);
+    String renderPathName = GetStringOption(arguments, "-renderpath", "RenderPaths/Forward.xml");
+    const float timeStep = 1.0f / 60.0f;
+
+    PrintLine("Rendering: " + String(numObjects) + " objects, " + String(numLights) + " point lights, " + String(frames) +
+        " frames, " + String(numThreads) + " worker threads, shadows " + String(shadows ? (cacheShadows ? "cached" : "on") : "off") +
+        ", " + String(numMoving) + " moving objects, " + renderPathName);
+    #ifndef URHO3D_NULL_GRAPHICS
+    PrintLine("Note: not built with the null graphics backend, timings include GPU driver overhead");
+    #endif
+
+    WorkQueue* workQueue = context->GetSubsystem<WorkQueue>();
+    if (numThreads)
+        workQueue->CreateThreads(numThreads);
+    context->RegisterSubsystem(new Profiler(context));
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    String programDir = context->GetSubsystem<FileSystem>()->GetProgramDir();
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->AddResourceDir(programDir + "CoreData") || !cache->AddResourceDir(programDir + "Data"))
+        ErrorExit("Could not find the CoreData and Data resource directories");
+
+    Graphics* graphics = context->GetSubsystem<Graphics>();
+    if (!graphics->SetMode(1280, 720, false, false, false, false, false, 1))
+        ErrorExit("Could not set screen mode");
+
+    Renderer* renderer = context->GetSubsystem<Renderer>();
+    renderer->SetDrawShadows(shadows);
+    renderer->SetCacheShadowMaps(cacheShadows);
+    Profiler* profiler = context->GetSubsystem<Profiler>();
+    Time* time = context->GetSubsystem<Time>();
+
+    HiresTimer timer;
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+
+    // Place the objects on a square grid
+    Model* model = cache->GetResource<Model>("Models/Box.mdl");
+    Material* material = cache->GetResource<Material>("Materials/DefaultGrey.xml");
+    unsigned gridSize = (unsigned)sqrtf((float)numObjects) + 1;
+    float halfExtent = (float)gridSize;
+    PODVector<Node*> movingNodes;
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        Node* node = scene->CreateChild(String::EMPTY, LOCAL);
+        if (i < numMoving)
+            movingNodes.Push(node);
+        node->SetPosition(Vector3(2.0f * (float)(i % gridSize) - halfExtent, 0.0f, 2.0f * (float)(i / gridSize) - halfExtent));
+        StaticModel* object = node->CreateComponent<StaticModel>(LOCAL);
+        object->SetModel(model);
+        object->SetMaterial(material);
+        object->SetCastShadows(true);
+    }
+
+    Node* lightNode = scene->CreateChild(String::EMPTY, LOCAL);
+    lightNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    Light* light = lightNode->CreateComponent<Light>(LOCAL);
+    light->SetLightType(LIGHT_DIRECTIONAL);
+    light->SetCastShadows(true);
+
+    for (unsigned i = 0; i < numLights; ++i)
+    {
+        float angle = 360.0f * (float)i / (float)numLights;
+        Node* pointNode = scene->CreateChild(String::EMPTY, LOCAL);
+        pointNode->SetPosition(Vector3(Cos(angle) * halfExtent * 0.5f, 3.0f, Sin(angle) * halfExtent * 0.5f));
+        Light* pointLight = pointNode->CreateComponent<Light>(LOCAL);
+        pointLight->SetLightType(LIGHT_POINT);
+        pointLight->SetRange(halfExtent * 0.5f);
+        pointLight->SetCastShadows(true);
+    }
+
+    Node* cameraNode = scene->CreateChild(String::EMPTY, LOCAL);
+    Camera* camera = cameraNode->CreateComponent<Camera>(LOCAL);
+    camera->SetFarClip(halfExtent * 4.0f);
+    SharedPtr<Viewport> viewport(new Viewport(context, scene, camera));
+    XMLFile* renderPathFile = cache->GetResource<XMLFile>(renderPathName);
+    if (!renderPathFile)
+        ErrorExit("Could not load render path " + renderPathName);
+    viewport->SetRenderPath(renderPathFile);
+    renderer->SetViewport(0, viewport);
+    PrintResult("Create scene", timer.GetUSec(true), numObjects);
+
+    RenderStats stats;
+    long long updateTime = 0;
+    long long renderTime = 0;
+    unsigned long long heapAllocations = 0;
+    unsigned peakFrameMemory = 0;
+
+    // The first frame loads the shaders and creates the shadow maps, so time it separately
+    for (unsigned i = 0; i <= frames; ++i)
+    {
+        // Orbit the camera so that the visible set changes on each frame
+        cameraNode->SetPosition(Vector3(0.0f, halfExtent * 0.5f, 0.0f));
+        cameraNode->SetRotation(Quaternion(30.0f, 360.0f * (float)i / (float)frames, 0.0f));
+        cameraNode->Translate(Vector3(0.0f, 0.0f, -halfExtent));
+        
+        // Bob the moving objects up and down, which invalidates the cached shadow maps of the lights they are in
+        for (unsigned j = 0; j < movingNodes.Size(); ++j)
+        {
+            Vector3 position = movingNodes[j]->GetPosition();
+            movingNodes[j]->SetPosition(Vector3(position.x_, (i & 1) ? 0.5f : 0.0f, position.z_));
+        }
+
+        unsigned startAllocations = GetNumHeapAllocations();
+        profiler->BeginFrame();
+        time->BeginFrame(timeStep);
+
+        timer.Reset();
+        renderer->Update(timeStep);
+        updateTime += timer.GetUSec(true);
+
+        // Statistics are reset when the frame begins, so collect the uploads from the view update phase first
+        #ifdef URHO3D_NULL_GRAPHICS
+        stats.uploadBytes_ += graphics->GetNumUploadBytes();
+        #endif
+
+        if (graphics->BeginFrame())
+        {
+            renderer->Render();
+            graphics->EndFrame();
+        }
+        renderTime += timer.GetUSec(true);
+
+        stats.batches_ += graphics->GetNumBatches();
+        stats.primitives_ += graphics->GetNumPrimitives();
+        #ifdef URHO3D_NULL_GRAPHICS
+        stats.stateChanges_ += graphics->GetNumStateChanges();
+        stats.shaderChanges_ += graphics->GetNumShaderChanges();
+        stats.parameterUpdates_ += graphics->GetNumParameterUpdates();
+        stats.textureChanges_ += graphics->GetNumTextureChanges();
+        stats.bufferChanges_ += graphics->GetNumBufferChanges();
+        stats.uploadBytes_ += graphics->GetNumUploadBytes();
+        #endif
+
+        // Check the frame allocator usage before the end of frame resets it
+        unsigned frameMemory = 0;
+        for (unsigned j = 0; j <= numThreads; ++j)
+            frameMemory += workQueue->GetFrameAllocator(j)->GetUsedSize();
+        if (frameMemory > peakFrameMemory)
+            peakFrameMemory = frameMemory;
+
+        time->EndFrame();
+        profiler->EndFrame();
+        heapAllocations += GetNumHeapAllocations() - startAllocations;
+
+        if (!i)
+        {
+            PrintResult("First frame", updateTime + renderTime);
+            updateTime = 0;
+            renderTime = 0;
+            stats = RenderStats();
+            heapAllocations = 0;
+            peakFrameMemory = 0;
+            profiler->BeginInterval();
+        }
+    }
+
+    PrintResult("Update views", updateTime, frames);
+    PrintResult("Render views", renderTime, frames);
+    PrintResult("Total", updateTime + renderTime, frames);
+
+    #ifdef URHO3D_PROFILING
+    PrintLine("\nStages, average per frame:");
+    PrintProfilerBlocks(profiler->GetRootBlock(), frames, 0, 5);
+    #endif
+
+    PrintLine("\nGraphics statistics:");
+    PrintStat("Batches", stats.batches_, frames);
+    PrintStat("Primitives", stats.primitives_, frames);
+    #ifdef URHO3D_NULL_GRAPHICS
+    PrintStat("State changes", stats.stateChanges_, frames);
+    PrintStat("Shader changes", stats.shaderChanges_, frames);
+    PrintStat("Parameter updates", stats.parameterUpdates_, frames);
+    PrintStat("Texture changes", stats.textureChanges_, frames);
+    PrintStat("Buffer changes", stats.bufferChanges_, frames);
+    PrintStat("Upload bytes", stats.uploadBytes_, frames);
+    #endif
+    PrintStat("Heap allocations", heapAllocations, frames);
+    PrintLine("Frame allocator peak: " + String(peakFrameMemory) + " bytes");
+
+    timer.Reset();
+    renderer->SetViewport(0, 0);
+    viewport.Reset();
+    scene.Reset();
+    PrintResult("Destroy scene", timer.GetUSec(true), numObjects);
+}
@@ -0,0 +1,250 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "File.h"
+#include "FileSystem.h"
+#include "FlatSceneFile.h"
+#include "FlatSceneWriter.h"
+#include "Graphics.h"
+#include "Light.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "ProcessUtils.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "StaticModel.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
+#include "XMLFile.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+/// Return the number of nodes in a hierarchy, including the root.
+static unsigned CountNodes(Node* node)
+{
+    unsigned count = 1;
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+        count += CountNodes(children[i]);
+    return count;
+}
+
+void RunSceneBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numObjects = Max(GetIntOption(arguments, "-objects", 10000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 10), 1);
+
+    PrintLine("Scene load: " + String(numObjects) + " objects, " + String(iterations) + " iterations");
+
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    String programDir = context->GetSubsystem<FileSystem>()->GetProgramDir();
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->AddResourceDir(programDir + "CoreData") || !cache->AddResourceDir(programDir + "Data"))
+        ErrorExit("Could not find the CoreData and Data resource directories");
+
+    const char* modelNames[] = { "Models/Box.mdl", "Models/Cone.mdl", "Models/Cylinder.mdl", "Models/Sphere.mdl" };
+    const char* materialNames[] = { "Materials/Stone.xml", "Materials/StoneTiled.xml", "Materials/Jack.xml" };
+    const unsigned numModels = sizeof(modelNames) / sizeof(modelNames[0]);
+    const unsigned numMaterials = sizeof(materialNames) / sizeof(materialNames[0]);
+
+    // Groups of ten objects under a parent node, with a light in every tenth object
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+    Node* group = 0;
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        if (i % 10 == 0)
+        {
+            group = scene->CreateChild("Group" + String(i / 10));
+            group->SetPosition(Vector3((float)(i % 1000), 0.0f, (float)(i / 1000) * 10.0f));
+        }
+        Node* node = group->CreateChild("Object" + String(i));
+        node->SetPosition(Vector3(0.0f, 0.0f, (float)(i % 10)));
+        node->SetRotation(Quaternion((float)i, Vector3::UP));
+        StaticModel* model = node->CreateComponent<StaticModel>();
+        model->SetModel(cache->GetResource<Model>(modelNames[i % numModels]));
+        model->SetMaterial(cache->GetResource<Material>(materialNames[i % numMaterials]));
+        if (i % 10 == 0)
+        {
+            Light* light = node->CreateComponent<Light>();
+            light->SetRange(10.0f);
+        }
+    }
+    unsigned numNodes = CountNodes(scene);
+
+    HiresTimer timer;
+    SharedPtr<XMLFile> xml(new XMLFile(context));
+    XMLElement root = xml->CreateRoot("scene");
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        root.RemoveChildren();
+        scene->SaveXML(root);
+    }
+    PrintResult("Save XML", timer.GetUSec(true), numNodes * iterations);
+
+    VectorBuffer binary;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        binary.Clear();
+        scene->Save(binary);
+    }
+    PrintResult("Save binary", timer.GetUSec(true), numNodes * iterations);
+
+    VectorBuffer flat;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        flat.Clear();
+        scene->SaveFlat(flat);
+    }
+    PrintResult("Save flat", timer.GetUSec(true), numNodes * iterations);
+
+    // Conversion from binary copies the component data as is, so the result must match saving directly
+    FlatSceneWriter writer(context);
+    VectorBuffer converted;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        binary.Seek(0);
+        converted.Clear();
+        if (!writer.BuildFromBinary(binary) || !writer.Write(converted))
+            ErrorExit("Could not convert binary scene to flat");
+    }
+    PrintResult("Convert binary to flat", timer.GetUSec(true), numNodes * iterations);
+    if (converted.GetBuffer() != flat.GetBuffer())
+        ErrorExit("Flat scene converted from binary differs from the saved one");
+
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        converted.Clear();
+        if (!writer.BuildFromXML(root) || !writer.Write(converted))
+            ErrorExit("Could not convert XML scene to flat");
+    }
+    PrintResult("Convert XML to flat", timer.GetUSec(true), numNodes * iterations);
+
+    // Load into a new scene each time, as when loading a level. The previous scene is destroyed outside the timing
+    long long loadTime = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context));
+        timer.Reset();
+        if (!loadedScene->LoadXML(root))
+            ErrorExit("Could not load scene from XML");
+        loadTime += timer.GetUSec(false);
+        if (CountNodes(loadedScene) != numNodes)
+            ErrorExit("Scene loaded from XML has " + String(CountNodes(loadedScene)) + " nodes, expected " + String(numNodes));
+    }
+    PrintResult("Load XML", loadTime, numNodes * iterations);
+
+    loadTime = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context));
+        binary.Seek(0);
+        timer.Reset();
+        if (!loadedScene->Load(binary))
+            ErrorExit("Could not load scene from binary");
+        loadTime += timer.GetUSec(false);
+        if (CountNodes(loadedScene) != numNodes)
+            ErrorExit("Scene loaded from binary has " + String(CountNodes(loadedScene)) + " nodes, expected " + String(numNodes));
+    }
+    PrintResult("Load binary", loadTime, numNodes * iterations);
+
+    loadTime = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context));
+        flat.Seek(0);
+        timer.Reset();
+        if (!loadedScene->LoadFlat(flat))
+            ErrorExit("Could not load scene from flat binary");
+        loadTime += timer.GetUSec(false);
+
+        // The loaded scene must save back to exactly the original binary data
+        if (!i)
+        {
+            VectorBuffer resaved;
+            loadedScene->Save(resaved);
+            if (resaved.GetBuffer() != binary.GetBuffer())
+                ErrorExit("Scene loaded from flat binary differs from the original");
+        }
+    }
+    PrintResult("Load flat", loadTime, numNodes * iterations);
+
+    // Loading from files, as levels are. The flat file is mapped into memory instead of read
+    String fileName = programDir + "SceneBenchmark.tmp";
+    {
+        File file(context, fileName, FILE_WRITE);
+        if (!file.IsOpen() || file.Write(binary.GetData(), binary.GetSize()) != binary.GetSize())
+            ErrorExit("Could not write " + fileName);
+    }
+    loadTime = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context));
+        timer.Reset();
+        File file(context, fileName);
+        if (!loadedScene->Load(file))
+            ErrorExit("Could not load scene from binary file");
+        loadTime += timer.GetUSec(false);
+    }
+    PrintResult("Load binary file", loadTime, numNodes * iterations);
+
+    {
+        File file(context, fileName, FILE_WRITE);
+        if (!file.IsOpen() || file.Write(flat.GetData(), flat.GetSize()) != flat.GetSize())
+            ErrorExit("Could not write " + fileName);
+    }
+    loadTime = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context));
+        timer.Reset();
+        SharedPtr<File> file(new File(context, fileName));
+        if (!loadedScene->LoadFlat(*file))
+            ErrorExit("Could not load scene from flat binary file");
+        loadTime += timer.GetUSec(false);
+        if (CountNodes(loadedScene) != numNodes)
+            ErrorExit("Scene loaded from flat binary file has " + String(CountNodes(loadedScene)) + " nodes, expected " +
+                String(numNodes));
+    }
+    bool mapped;
+    {
+        SharedPtr<File> file(new File(context, fileName));
+        SharedPtr<FlatSceneFile> flatFile(new FlatSceneFile(context));
+        mapped = flatFile->Load(*file) && flatFile->IsMapped();
+    }
+    context->GetSubsystem<FileSystem>()->Delete(fileName);
+    PrintResult(mapped ? "Load flat file (mapped)" : "Load flat file (read)", loadTime, numNodes * iterations);
+
+    VectorBuffer xmlData;
+    xml->Save(xmlData);
+    PrintLine("Sizes: XML " + String(xmlData.GetSize()) + " bytes, binary " + String(binary.GetSize()) + " bytes, flat " +
+        String(flat.GetSize()) + " bytes");
+}
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "FileSystem.h"
+#include "Graphics.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "ProcessUtils.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "StaticModel.h"
+#include "Timer.h"
+#include "XMLFile.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+void RunStringBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numObjects = Max(GetIntOption(arguments, "-objects", 1000), 1);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 100), 1);
+
+    PrintLine("Strings: " + String(numObjects) + " objects, " + String(iterations) + " iterations");
+
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    String programDir = context->GetSubsystem<FileSystem>()->GetProgramDir();
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->AddResourceDir(programDir + "CoreData") || !cache->AddResourceDir(programDir + "Data"))
+        ErrorExit("Could not find the CoreData and Data resource directories");
+
+    const char* modelNames[] = { "Models/Box.mdl", "Models/Cone.mdl", "Models/Cylinder.mdl", "Models/Sphere.mdl" };
+    const char* materialNames[] = { "Materials/Stone.xml", "Materials/StoneTiled.xml", "Materials/Jack.xml" };
+    const unsigned numModels = sizeof(modelNames) / sizeof(modelNames[0]);
+    const unsigned numMaterials = sizeof(materialNames) / sizeof(materialNames[0]);
+
+    // Short strings such as node, attribute and resource names
+    Vector<String> names(numObjects);
+    for (unsigned i = 0; i < numObjects; ++i)
+        names[i] = "Node" + String(i);
+    HiresTimer timer;
+    unsigned sum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Vector<String> copy(names);
+        sum += copy.Back().Length();
+    }
+    PrintResult("Copy names", timer.GetUSec(true), numObjects * iterations);
+
+    // Attribute descriptions are copied when queried from script and the editor
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numObjects; j += 10)
+        {
+            Vector<AttributeInfo> attributes(*context->GetAttributes(StaticModel::GetTypeStatic()));
+            sum += attributes.Size();
+        }
+    }
+    PrintResult("Copy attribute descriptions", timer.GetUSec(true), iterations * ((numObjects + 9) / 10));
+
+    // Resource requests by name, as made by resource reference attributes
+    for (unsigned i = 0; i < numModels; ++i)
+    {
+        if (!cache->GetResource<Model>(modelNames[i]))
+            ErrorExit("Could not load model " + String(modelNames[i]));
+    }
+    for (unsigned i = 0; i < numMaterials; ++i)
+    {
+        if (!cache->GetResource<Material>(materialNames[i]))
+            ErrorExit("Could not load material " + String(materialNames[i]));
+    }
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < numObjects; ++j)
+            sum += cache->GetResource<Model>(modelNames[j % numModels]) ? 1 : 0;
+    }
+    PrintResult("Get loaded resource", timer.GetUSec(true), numObjects * iterations);
+
+    // Scene load from XML: attribute lookup by name, resource requests and name strings
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        Node* node = scene->CreateChild(names[i]);
+        node->SetPosition(Vector3((float)(i % 100), 0.0f, (float)(i / 100)));
+        StaticModel* model = node->CreateComponent<StaticModel>();
+        model->SetModel(cache->GetResource<Model>(modelNames[i % numModels]));
+        model->SetMaterial(cache->GetResource<Material>(materialNames[i % numMaterials]));
+    }
+    SharedPtr<XMLFile> xml(new XMLFile(context));
+    XMLElement root = xml->CreateRoot("scene");
+    scene->SaveXML(root);
+
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        if (!scene->LoadXML(root))
+            ErrorExit("Could not load scene");
+    }
+    PrintResult("Load scene XML", timer.GetUSec(true), numObjects * iterations);
+
+    // Attribute reads and writes through the accessor functions, as when saving and replicating a scene
+    const Vector<AttributeInfo>& attributes = *context->GetAttributes(StaticModel::GetTypeStatic());
+    PODVector<StaticModel*> models;
+    scene->GetComponents<StaticModel>(models, true);
+    Variant value;
+    unsigned allocations = GetNumHeapAllocations();
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < models.Size(); ++j)
+        {
+            for (unsigned k = 0; k < attributes.Size(); ++k)
+            {
+                models[j]->OnGetAttribute(attributes[k], value);
+                models[j]->OnSetAttribute(attributes[k], value);
+            }
+        }
+    }
+    unsigned numAccesses = iterations * models.Size() * attributes.Size();
+    PrintResult("Get and set attributes", timer.GetUSec(true), numAccesses);
+    PrintLine("Heap allocations per attribute: " + String((float)(GetNumHeapAllocations() - allocations) / numAccesses));
+
+    // Use the result so that the loops are not optimized away
+    if (sum == M_MAX_UNSIGNED)
+        PrintLine("");
+}
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "FileSystem.h"
+#include "Graphics.h"
+#include "Image.h"
+#include "Octree.h"
+#include "ProcessUtils.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Terrain.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include "Benchmark.h"
+
+#include "DebugNew.h"
+
+void RunTerrainBenchmark(Context* context, const Vector<String>& arguments)
+{
+    int size = Max(GetIntOption(arguments, "-size", 2048), 4);
+    int patchSize = GetIntOption(arguments, "-patchsize", 32);
+    unsigned iterations = Max(GetIntOption(arguments, "-iterations", 5), 1);
+    unsigned numThreads = Max(GetIntOption(arguments, "-threads", GetNumPhysicalCPUs() - 1), 0);
+
+    PrintLine("Terrain creation: " + String(size + 1) + "x" + String(size + 1) + " heightmap, patch size " + String(patchSize) +
+        ", " + String(iterations) + " iterations, " + String(numThreads) + " worker threads");
+    #ifndef URHO3D_NULL_GRAPHICS
+    PrintLine("Note: not built with the null graphics backend, timings include GPU driver overhead");
+    #endif
+
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Graphics(context));
+    context->RegisterSubsystem(new Renderer(context));
+    RegisterSceneLibrary(context);
+
+    Graphics* graphics = context->GetSubsystem<Graphics>();
+    if (!graphics->SetMode(1280, 720, false, false, false, false, false, 1))
+        ErrorExit("Could not set screen mode");
+
+    // Generate a 16-bit heightmap with red as the MSB and green as the LSB
+    HiresTimer timer;
+    SharedPtr<Image> heightMap(new Image(context));
+    heightMap->SetSize(size + 1, size + 1, 2);
+    unsigned char* data = heightMap->GetData();
+    for (int y = 0; y <= size; ++y)
+    {
+        for (int x = 0; x <= size; ++x)
+        {
+            float height = 0.5f + 0.25f * Sin((float)x * 0.7f) * Cos((float)y * 0.9f) + 0.2f * Sin((float)(x + y) * 0.11f);
+            unsigned value = (unsigned)(Clamp(height, 0.0f, 1.0f) * 65535.0f);
+            *data++ = (unsigned char)(value >> 8);
+            *data++ = (unsigned char)(value & 0xff);
+        }
+    }
+    PrintResult("Generate heightmap", timer.GetUSec(true));
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+    Terrain* terrain = scene->CreateChild(String::EMPTY, LOCAL)->CreateComponent<Terrain>(LOCAL);
+    terrain->SetPatchSize(patchSize);
+    PrintResult("Create scene", timer.GetUSec(true));
+
+    // The first creation also creates the patch scene nodes, so time it separately
+    terrain->SetHeightMap(heightMap);
+    unsigned numPatches = terrain->GetNumPatches().x_ * terrain->GetNumPatches().y_;
+    PrintResult("First creation", timer.GetUSec(true), numPatches);
+
+    for (unsigned i = 0; i < iterations; ++i)
+        terrain->SetHeightMap(heightMap);
+    PrintResult("Recreation", timer.GetUSec(true) / iterations, numPatches);
+
+    scene.Reset();
+    PrintResult("Destroy scene", timer.GetUSec(true), numPatches);
+}
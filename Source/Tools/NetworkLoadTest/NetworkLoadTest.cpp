@@ -0,0 +1,479 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Connection.h"
+#include "Context.h"
+#include "CoreEvents.h"
+#include "Engine.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "Main.h"
+#include "Network.h"
+#include "NetworkEvents.h"
+#include "ProcessUtils.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Sort.h"
+
+#include <kNet.h>
+
+#include "NetworkLoadTest.h"
+
+#include "DebugNew.h"
+
+static const unsigned CTRL_FORWARD = 1;
+static const unsigned CTRL_BACK = 2;
+static const unsigned CTRL_LEFT = 4;
+static const unsigned CTRL_RIGHT = 8;
+
+static const unsigned TICK_HISTORY_SIZE = 256;
+static const float MOVE_SPEED = 5.0f;
+static const float CONNECT_TIMEOUT = 30.0f;
+static const float SAMPLE_INTERVAL = 1.0f;
+
+DEFINE_APPLICATION_MAIN(NetworkLoadTest);
+
+NetworkLoadTest::NetworkLoadTest(Context* context) :
+    Application(context),
+    tickStartTime_(0),
+    numClients_(16),
+    numNodes_(100),
+    port_(2345),
+    updateFps_(30),
+    duration_(10.0f),
+    latency_(0.0f),
+    jitter_(0.0f),
+    packetLoss_(0.0f),
+    measureTime_(0.0f),
+    sampleTimer_(0.0f),
+    totalTime_(0.0f),
+    snapshotInterpolation_(false),
+    measuring_(false)
+{
+}
+
+void NetworkLoadTest::Setup()
+{
+    const Vector<String>& arguments = GetArguments();
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-clients" && !value.Empty())
+        {
+            numClients_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-nodes" && !value.Empty())
+        {
+            numNodes_ = Max(ToInt(value), 0);
+            ++i;
+        }
+        else if (argument == "-port" && !value.Empty())
+        {
+            port_ = (unsigned short)ToUInt(value);
+            ++i;
+        }
+        else if (argument == "-duration" && !value.Empty())
+        {
+            duration_ = Max(ToFloat(value), 0.0f);
+            ++i;
+        }
+        else if (argument == "-updatefps" && !value.Empty())
+        {
+            updateFps_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-latency" && !value.Empty())
+        {
+            latency_ = Max(ToFloat(value), 0.0f);
+            ++i;
+        }
+        else if (argument == "-jitter" && !value.Empty())
+        {
+            jitter_ = Max(ToFloat(value), 0.0f);
+            ++i;
+        }
+        else if (argument == "-loss" && !value.Empty())
+        {
+            packetLoss_ = Clamp(ToFloat(value), 0.0f, 1.0f);
+            ++i;
+        }
+        else if (argument == "-interpolation")
+            snapshotInterpolation_ = true;
+        else if (argument == "-help" || argument == "-h")
+        {
+            ErrorExit("Usage: NetworkLoadTest [options]\n\n"
+                "Runs a headless server and a number of simulated clients over the loopback interface, "
+                "then prints server update time, bandwidth and update latency statistics.\n\n"
+                "Options:\n"
+                "-clients <num>     Number of simulated clients, default 16\n"
+                "-nodes <num>       Number of moving replicated nodes, default 100\n"
+                "-port <port>       Server port, default 2345\n"
+                "-duration <sec>    Measurement duration after all clients have loaded the scene, default 10\n"
+                "-updatefps <fps>   Network update rate, default 30\n"
+                "-latency <ms>      Simulated one-way latency for each connection\n"
+                "-jitter <ms>       Simulated uniformly random additional latency\n"
+                "-loss <ratio>      Simulated packet loss ratio between 0 and 1\n"
+                "-interpolation     Enable snapshot interpolation on the client scenes\n"
+                "-nolimit           Disable frame limiter\n"
+            );
+            return;
+        }
+    }
+
+    engineParameters_["Headless"] = true;
+    engineParameters_["LogName"] = GetSubsystem<FileSystem>()->GetAppPreferencesDir("urho3d", "logs") + "NetworkLoadTest.log";
+}
+
+void NetworkLoadTest::Start()
+{
+    Network* network = GetSubsystem<Network>();
+    network->SetUpdateFps(updateFps_);
+    if (!network->StartServer(port_))
+    {
+        ErrorExit("Could not start server on port " + String(port_));
+        return;
+    }
+
+    tickSendTimes_.Resize(TICK_HISTORY_SIZE);
+    for (unsigned i = 0; i < TICK_HISTORY_SIZE; ++i)
+        tickSendTimes_[i] = 0;
+
+    CreateScene();
+
+    SubscribeToEvent(E_CLIENTCONNECTED, HANDLER(NetworkLoadTest, HandleClientConnected));
+    SubscribeToEvent(E_CLIENTDISCONNECTED, HANDLER(NetworkLoadTest, HandleClientDisconnected));
+    SubscribeToEvent(network, E_NETWORKUPDATE, HANDLER(NetworkLoadTest, HandleNetworkUpdate));
+    SubscribeToEvent(network, E_NETWORKUPDATESENT, HANDLER(NetworkLoadTest, HandleNetworkUpdateSent));
+    SubscribeToEvent(E_UPDATE, HANDLER(NetworkLoadTest, HandleUpdate));
+
+    CreateClients();
+
+    LOGINFO("Started network load test with " + String(numClients_) + " clients and " + String(numNodes_) + " moving nodes");
+}
+
+void NetworkLoadTest::Stop()
+{
+    PrintReport();
+
+    for (unsigned i = 0; i < clients_.Size(); ++i)
+        clients_[i].network_->Disconnect();
+    clients_.Clear();
+
+    GetSubsystem<Network>()->StopServer();
+}
+
+void NetworkLoadTest::CreateScene()
+{
+    scene_ = new Scene(context_);
+
+    movingNodes_.Reserve(numNodes_);
+    for (unsigned i = 0; i < numNodes_; ++i)
+    {
+        Node* node = scene_->CreateChild("Mover");
+        movingNodes_.Push(WeakPtr<Node>(node));
+    }
+
+    UpdateServerNodes(0.0f);
+}
+
+void NetworkLoadTest::CreateClients()
+{
+    clients_.Resize(numClients_);
+
+    for (unsigned i = 0; i < numClients_; ++i)
+    {
+        SimulatedClient& client = clients_[i];
+
+        // Each client needs its own context, as the network subsystem supports only a single server connection
+        client.context_ = new Context();
+        client.context_->RegisterSubsystem(new FileSystem(client.context_));
+        client.context_->RegisterSubsystem(new ResourceCache(client.context_));
+        RegisterSceneLibrary(client.context_);
+
+        client.network_ = new Network(client.context_);
+        client.context_->RegisterSubsystem(client.network_);
+        client.network_->SetUpdateFps(updateFps_);
+
+        client.scene_ = new Scene(client.context_);
+        client.scene_->SetSnapshotInterpolation(snapshotInterpolation_);
+        client.phase_ = (float)i * 1.7f;
+
+        if (!client.network_->Connect("127.0.0.1", port_, client.scene_))
+        {
+            clients_.Resize(i);
+            ErrorExit("Simulated client " + String(i) + " could not connect to the server");
+            return;
+        }
+
+        ApplySimulatorSettings(client.network_->GetServerConnection());
+    }
+}
+
+void NetworkLoadTest::UpdateClients(float timeStep)
+{
+    long long now = clock_.GetUSec(false);
+
+    for (unsigned i = 0; i < clients_.Size(); ++i)
+    {
+        SimulatedClient& client = clients_[i];
+        client.network_->Update(timeStep);
+
+        // A new server tick means a state update arrived. Measure the time since the server sent it
+        Scene* scene = client.scene_;
+        if (scene->HasServerTick() && scene->GetServerTick() != client.lastTick_)
+        {
+            unsigned tick = scene->GetServerTick();
+            long long sendTime = tickSendTimes_[tick % TICK_HISTORY_SIZE];
+            if (measuring_ && sendTime)
+                latencies_.Push((float)(now - sendTime) / 1000.0f);
+            client.lastTick_ = tick;
+        }
+
+        // Drive the client's avatar with scripted controls
+        Connection* serverConnection = client.network_->GetServerConnection();
+        if (serverConnection)
+        {
+            float time = totalTime_ + client.phase_;
+            Controls controls;
+            controls.yaw_ = time * 45.0f;
+            controls.Set(CTRL_FORWARD, fmodf(time, 4.0f) < 3.0f);
+            controls.Set(CTRL_BACK, fmodf(time, 4.0f) >= 3.0f);
+            controls.Set(CTRL_LEFT, fmodf(time, 2.0f) < 0.5f);
+            controls.Set(CTRL_RIGHT, fmodf(time, 2.0f) >= 1.5f);
+            serverConnection->SetControls(controls);
+        }
+
+        scene->Update(timeStep);
+        client.network_->PostUpdate(timeStep);
+    }
+}
+
+void NetworkLoadTest::UpdateServerNodes(float timeStep)
+{
+    for (unsigned i = 0; i < movingNodes_.Size(); ++i)
+    {
+        Node* node = movingNodes_[i];
+        if (!node)
+            continue;
+
+        float radius = 5.0f + (float)(i % 20) * 2.0f;
+        float angle = totalTime_ * (30.0f + (float)(i % 7) * 10.0f) + (float)i * 37.0f;
+        node->SetPosition(Vector3(Cos(angle) * radius, (float)(i / 20), Sin(angle) * radius));
+        node->SetRotation(Quaternion(-angle, Vector3::UP));
+    }
+
+    for (HashMap<Connection*, WeakPtr<Node> >::Iterator i = avatars_.Begin(); i != avatars_.End(); ++i)
+    {
+        Node* node = i->second_;
+        if (!node)
+            continue;
+
+        const Controls& controls = i->first_->GetControls();
+        node->SetRotation(Quaternion(controls.yaw_, Vector3::UP));
+
+        Vector3 move = Vector3::ZERO;
+        if (controls.IsDown(CTRL_FORWARD))
+            move += Vector3::FORWARD;
+        if (controls.IsDown(CTRL_BACK))
+            move += Vector3::BACK;
+        if (controls.IsDown(CTRL_LEFT))
+            move += Vector3::LEFT;
+        if (controls.IsDown(CTRL_RIGHT))
+            move += Vector3::RIGHT;
+        if (move.LengthSquared() > 0.0f)
+            node->Translate(move.Normalized() * MOVE_SPEED * timeStep);
+    }
+}
+
+void NetworkLoadTest::ApplySimulatorSettings(Connection* connection)
+{
+    if (!connection || (latency_ <= 0.0f && jitter_ <= 0.0f && packetLoss_ <= 0.0f))
+        return;
+
+    kNet::NetworkSimulator& simulator = connection->GetMessageConnection()->NetworkSendSimulator();
+    simulator.enabled = true;
+    simulator.constantPacketSendDelay = latency_;
+    simulator.uniformRandomPacketSendDelay = jitter_;
+    simulator.packetLossRate = packetLoss_;
+}
+
+void NetworkLoadTest::PrintReport()
+{
+    if (!measuring_)
+    {
+        PrintLine("Network load test did not complete: not all clients loaded the scene");
+        return;
+    }
+
+    PrintLine("Network load test: " + String(numClients_) + " clients, " + String(numNodes_) + " moving nodes, " +
+        String(updateFps_) + " updates/sec, " + String(measureTime_) + " sec");
+    if (latency_ > 0.0f || jitter_ > 0.0f || packetLoss_ > 0.0f)
+    {
+        PrintLine("Simulated latency " + String(latency_) + " ms, jitter " + String(jitter_) +
+            " ms, packet loss " + String(packetLoss_ * 100.0f) + "%");
+    }
+
+    if (tickDurations_.Size())
+    {
+        float total = 0.0f;
+        float maximum = 0.0f;
+        for (unsigned i = 0; i < tickDurations_.Size(); ++i)
+        {
+            total += tickDurations_[i];
+            maximum = Max(maximum, tickDurations_[i]);
+        }
+        PrintLine("Server update time (ms): avg " + String(total / tickDurations_.Size()) + " max " +
+            String(maximum) + " (" + String(tickDurations_.Size()) + " updates)");
+    }
+
+    if (bytesOutSamples_.Size())
+    {
+        float totalOut = 0.0f;
+        float totalIn = 0.0f;
+        for (unsigned i = 0; i < bytesOutSamples_.Size(); ++i)
+        {
+            totalOut += bytesOutSamples_[i];
+            totalIn += bytesInSamples_[i];
+        }
+        PrintLine("Server bytes per client per sec: out " + String(totalOut / bytesOutSamples_.Size()) + " in " +
+            String(totalIn / bytesInSamples_.Size()));
+    }
+
+    if (latencies_.Size())
+    {
+        Sort(latencies_.Begin(), latencies_.End());
+        unsigned last = latencies_.Size() - 1;
+        PrintLine("Update latency (ms): p50 " + String(latencies_[last * 50 / 100]) + " p90 " +
+            String(latencies_[last * 90 / 100]) + " p99 " + String(latencies_[last * 99 / 100]) +
+            " max " + String(latencies_[last]) + " (" + String(latencies_.Size()) + " samples)");
+    }
+    else
+        PrintLine("Update latency: no samples");
+}
+
+void NetworkLoadTest::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    totalTime_ += timeStep;
+
+    UpdateServerNodes(timeStep);
+    UpdateClients(timeStep);
+
+    if (!measuring_)
+    {
+        // Start measuring once every client has received the scene
+        bool allLoaded = true;
+        for (unsigned i = 0; i < clients_.Size(); ++i)
+        {
+            Connection* serverConnection = clients_[i].network_->GetServerConnection();
+            if (!serverConnection || !serverConnection->IsSceneLoaded())
+            {
+                allLoaded = false;
+                break;
+            }
+        }
+
+        if (allLoaded)
+        {
+            LOGINFO("All clients loaded the scene, starting measurement");
+            measuring_ = true;
+        }
+        else if (totalTime_ > CONNECT_TIMEOUT)
+        {
+            LOGERROR("Timed out waiting for the simulated clients to load the scene");
+            engine_->Exit();
+        }
+        return;
+    }
+
+    measureTime_ += timeStep;
+    sampleTimer_ += timeStep;
+    if (sampleTimer_ >= SAMPLE_INTERVAL)
+    {
+        sampleTimer_ = fmodf(sampleTimer_, SAMPLE_INTERVAL);
+
+        Vector<SharedPtr<Connection> > connections = GetSubsystem<Network>()->GetClientConnections();
+        if (connections.Size())
+        {
+            float bytesOut = 0.0f;
+            float bytesIn = 0.0f;
+            for (unsigned i = 0; i < connections.Size(); ++i)
+            {
+                kNet::MessageConnection* connection = connections[i]->GetMessageConnection();
+                bytesOut += connection->BytesOutPerSec();
+                bytesIn += connection->BytesInPerSec();
+            }
+            bytesOutSamples_.Push(bytesOut / connections.Size());
+            bytesInSamples_.Push(bytesIn / connections.Size());
+        }
+    }
+
+    if (measureTime_ >= duration_)
+        engine_->Exit();
+}
+
+void NetworkLoadTest::HandleClientConnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientConnected;
+
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    ApplySimulatorSettings(connection);
+    connection->SetScene(scene_);
+
+    Node* avatar = scene_->CreateChild("Avatar");
+    avatar->SetOwner(connection);
+    avatars_[connection] = avatar;
+}
+
+void NetworkLoadTest::HandleClientDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientDisconnected;
+
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    HashMap<Connection*, WeakPtr<Node> >::Iterator i = avatars_.Find(connection);
+    if (i != avatars_.End())
+    {
+        if (i->second_)
+            i->second_->Remove();
+        avatars_.Erase(i);
+    }
+}
+
+void NetworkLoadTest::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    tickStartTime_ = clock_.GetUSec(false);
+}
+
+void NetworkLoadTest::HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData)
+{
+    long long now = clock_.GetUSec(false);
+    if (measuring_)
+        tickDurations_.Push((float)(now - tickStartTime_) / 1000.0f);
+
+    tickSendTimes_[GetSubsystem<Network>()->GetUpdateTick() % TICK_HISTORY_SIZE] = now;
+}
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Application.h"
+#include "Timer.h"
+
+namespace Urho3D
+{
+
+class Connection;
+class Network;
+class Node;
+class Scene;
+
+}
+
+using namespace Urho3D;
+
+/// Simulated client. Has its own context with network subsystem and scene, stepped manually from the main loop.
+struct SimulatedClient
+{
+    /// Construct.
+    SimulatedClient() :
+        network_(0),
+        lastTick_(0),
+        phase_(0.0f)
+    {
+    }
+
+    /// Client context.
+    SharedPtr<Context> context_;
+    /// Client scene.
+    SharedPtr<Scene> scene_;
+    /// Client network subsystem.
+    Network* network_;
+    /// Latest server tick seen by this client.
+    unsigned lastTick_;
+    /// Phase offset for the scripted controls.
+    float phase_;
+};
+
+/// NetworkLoadTest application runs a headless server and simulated clients over loopback, and reports server scaling statistics.
+class NetworkLoadTest : public Application
+{
+    OBJECT(NetworkLoadTest);
+
+public:
+    /// Construct.
+    NetworkLoadTest(Context* context);
+
+    /// Setup before engine initialization. Parse the command line.
+    virtual void Setup();
+    /// Setup after engine initialization. Start the server and connect the simulated clients.
+    virtual void Start();
+    /// Cleanup after the main loop. Print the report and disconnect the clients.
+    virtual void Stop();
+
+private:
+    /// Create the server scene with moving replicated nodes.
+    void CreateScene();
+    /// Create the simulated clients and connect them to the server.
+    void CreateClients();
+    /// Step the simulated clients: receive, update scene, send scripted controls.
+    void UpdateClients(float timeStep);
+    /// Move the server-side nodes.
+    void UpdateServerNodes(float timeStep);
+    /// Configure the kNet network simulator of a connection.
+    void ApplySimulatorSettings(Connection* connection);
+    /// Print the statistics report.
+    void PrintReport();
+    /// Handle the logic update event.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle a client connecting to the server.
+    void HandleClientConnected(StringHash eventType, VariantMap& eventData);
+    /// Handle a client disconnecting from the server.
+    void HandleClientDisconnected(StringHash eventType, VariantMap& eventData);
+    /// Handle the start of a server network update.
+    void HandleNetworkUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle the end of a server network update.
+    void HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData);
+
+    /// Server scene.
+    SharedPtr<Scene> scene_;
+    /// Server-side moving nodes.
+    Vector<WeakPtr<Node> > movingNodes_;
+    /// Server-side client avatar nodes by connection.
+    HashMap<Connection*, WeakPtr<Node> > avatars_;
+    /// Simulated clients.
+    Vector<SimulatedClient> clients_;
+    /// Clock for timestamping server updates and measuring tick time.
+    HiresTimer clock_;
+    /// Start time of the current server network update in microseconds.
+    long long tickStartTime_;
+    /// Send times of recent server ticks in microseconds, indexed by tick modulo the buffer size.
+    PODVector<long long> tickSendTimes_;
+    /// Measured server network update durations in milliseconds.
+    PODVector<float> tickDurations_;
+    /// Measured update latencies from server send to client receive in milliseconds.
+    PODVector<float> latencies_;
+    /// Sampled outgoing bytes per client per second on the server.
+    PODVector<float> bytesOutSamples_;
+    /// Sampled incoming bytes per client per second on the server.
+    PODVector<float> bytesInSamples_;
+    /// Number of simulated clients.
+    unsigned numClients_;
+    /// Number of moving nodes.
+    unsigned numNodes_;
+    /// Server port.
+    unsigned short port_;
+    /// Network update FPS.
+    int updateFps_;
+    /// Test duration in seconds, measured from when all clients have loaded the scene.
+    float duration_;
+    /// Simulated one-way latency in milliseconds.
+    float latency_;
+    /// Simulated uniformly random additional latency in milliseconds.
+    float jitter_;
+    /// Simulated packet loss ratio.
+    float packetLoss_;
+    /// Elapsed measurement time.
+    float measureTime_;
+    /// Time until the next bandwidth sample.
+    float sampleTimer_;
+    /// Elapsed time since start.
+    float totalTime_;
+    /// Snapshot interpolation flag for the client scenes.
+    bool snapshotInterpolation_;
+    /// Measurement started flag.
+    bool measuring_;
+};
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "Engine.h"
+#include "File.h"
+#include "FlatSceneWriter.h"
+#include "Log.h"
+#include "ProcessUtils.h"
+#include "XMLFile.h"
+
+#ifdef URHO3D_ANGELSCRIPT
+#include "Script.h"
+#endif
+
+#ifdef URHO3D_LUA
+#include "LuaScript.h"
+#endif
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+int main(int argc, char** argv)
+{
+    #ifdef WIN32
+    const Vector<String>& arguments = ParseArguments(GetCommandLineW());
+    #else
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    #endif
+
+    if (arguments.Size() < 2)
+        ErrorExit("Usage: SceneConverter <input file> <output file>\n\n"
+                  "Converts a scene or node saved in the XML or binary format to the flat binary format.\n"
+                  "The input format is detected from the file contents. Resources are not needed, as the\n"
+                  "conversion only uses the registered attributes of each node and component type.");
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    // Initialize in headless mode and instantiate the script subsystems if available so that the attributes of as many
+    // component types as possible are registered
+    VariantMap engineParameters;
+    engineParameters["Headless"] = true;
+    engineParameters["WorkerThreads"] = false;
+    engineParameters["LogName"] = String::EMPTY;
+    engineParameters["ResourcePaths"] = String::EMPTY;
+    engineParameters["AutoloadPaths"] = String::EMPTY;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize engine");
+    #ifdef URHO3D_ANGELSCRIPT
+    context->RegisterSubsystem(new Script(context));
+    #endif
+    #ifdef URHO3D_LUA
+    context->RegisterSubsystem(new LuaScript(context));
+    #endif
+
+    Log* log = context->GetSubsystem<Log>();
+    if (log)
+    {
+        log->SetLevel(LOG_WARNING);
+        log->SetTimeStamp(false);
+    }
+
+    File inFile(context, arguments[0], FILE_READ);
+    if (!inFile.IsOpen())
+        ErrorExit("Failed to open input file " + arguments[0]);
+
+    PrintLine("Converting " + arguments[0] + " to " + arguments[1]);
+
+    FlatSceneWriter writer(context);
+    String fileID = inFile.ReadFileID();
+    inFile.Seek(0);
+    if (fileID.StartsWith("<"))
+    {
+        XMLFile xml(context);
+        if (!xml.Load(inFile))
+            ErrorExit("Failed to parse XML file " + arguments[0]);
+        if (!writer.BuildFromXML(xml.GetRoot()))
+            ErrorExit("Failed to convert XML file " + arguments[0]);
+    }
+    else if (!writer.BuildFromBinary(inFile))
+        ErrorExit("Failed to convert binary file " + arguments[0]);
+
+    File outFile(context, arguments[1], FILE_WRITE);
+    if (!outFile.IsOpen())
+        ErrorExit("Failed to open output file " + arguments[1]);
+    if (!writer.Write(outFile))
+        ErrorExit("Failed to write output file " + arguments[1]);
+
+    PrintLine("Converted " + String(writer.GetNumNodes()) + " nodes and " + String(writer.GetNumComponents()) + " components");
+    return EXIT_SUCCESS;
+}